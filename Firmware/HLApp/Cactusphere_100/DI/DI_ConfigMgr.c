@@ -149,10 +149,8 @@ DI_ConfigMgr_CheckDuplicate(json_value* json, int* enablePort)
 
 // Apply new configuration
 SphereWarning
-DI_ConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
-    unsigned int payloadSize, vector item)
+DI_ConfigMgr_LoadAndApplyIfChanged(json_value* jsonObj, vector item)
 {	
-    json_value* jsonObj = json_parse(payload, payloadSize);
     json_value* desiredObj = json_GetKeyJson("desired", jsonObj);
     bool desireFlg = false;
     int enablePort = 0;
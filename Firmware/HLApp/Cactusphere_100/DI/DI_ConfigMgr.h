@@ -39,7 +39,10 @@ extern void	DI_ConfigMgr_Cleanup(void);
 
 // Apply new configuration
 extern SphereWarning	DI_ConfigMgr_LoadAndApplyIfChanged(
-    const unsigned char* payload, unsigned int payloadSize, vector item);
+    json_value* jsonObj, vector item);
+//
+// NOTE: jsonObj is the twin document, which is parsed once by the caller
+//       and shared with the other consumers of the twin.
 
 // Get configuratioin
 extern DI_FetchConfig*  DI_ConfigMgr_GetFetchConfig(void);
@@ -32,7 +32,7 @@
 #include "DI_WatchItem.h"
 #include "LibCloud.h"
 #include "LibDI.h"
-#include "StringBuf.h"
+#include "TelemetryFilter.h"
 #include "TelemetryItems.h"
 
 typedef struct DI_DataFetchScheduler {
@@ -41,10 +41,12 @@ typedef struct DI_DataFetchScheduler {
 // data member
     DI_FetchTargets*    mFetchTargets;  // acquisition targets of pulse conter
     DI_Watcher*         mWatcher;       // contact input watch targets
+    uint64_t            mLastWatchMs;   // time of the last contact input check
 } DI_DataFetchScheduler;
 
 #define DI_POLLING_VALUE_OFF  0
 #define DI_POLLING_VALUE_ON   1
+#define DI_WATCH_INTERVAL_MS  1000  // contact input check interval
 
 //
 // DI_DataFetchScheduler's private procedure/method
@@ -72,6 +74,21 @@ DI_DataFetchScheduler_DoDestroy(DataFetchSchedulerBase* me)
     DI_Watcher_Destroy(self->mWatcher);
 }
 
+static void
+DI_DataFetchScheduler_DoInit(DataFetchSchedulerBase* me,
+    vector fetchItemPtrs)
+{
+    // set the report-by-exception condition of pulse conters & polling
+    const DI_FetchItem**	fiCurs =
+        (const DI_FetchItem**)vector_get_data(fetchItemPtrs);
+
+    for (int i = 0, n = vector_size(fetchItemPtrs); i < n; ++i) {
+        const DI_FetchItem*	item = *fiCurs++;
+
+        (void)TelemetryFilter_SetSpec(me->mFilter, item->nameId, &item->filter);
+    }
+}
+
 static void
 DI_DataFetchScheduler_ClearFetchTargets(DataFetchSchedulerBase* me)
 {
@@ -91,6 +108,8 @@ DI_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
     // pulse conters & polling
     items = DI_FetchTargets_GetFetchItems(self->mFetchTargets);
     if (! vector_is_empty(items)) {
+        TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+            TelemetryItems_GetTimeMs());
         const DI_FetchItem** itemsCurs = (const DI_FetchItem**)vector_get_data(items);
 
         for (int i = 0, n = vector_size(items); i < n; i++) {
@@ -102,7 +121,8 @@ DI_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                 if (! DI_Lib_ReadPulseCount(item->pinID, &pulseCount)) {
                     continue;
                 };
-                StringBuf_AppendByPrintf(me->mStringBuf, "%lu", pulseCount);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->nameId, (uint32_t)pulseCount);
             } else {
                 unsigned int currentStatus = 0;
 
@@ -116,32 +136,50 @@ DI_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                 if (!item->isPollingActiveHigh) {
                     currentStatus = (currentStatus == GPIO_Value_Low ? DI_POLLING_VALUE_ON : DI_POLLING_VALUE_OFF);
                 }
-                StringBuf_AppendByPrintf(me->mStringBuf, "%ld", currentStatus);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->nameId, (uint32_t)currentStatus);
             }
-
-            TelemetryItems_Add(me->mTelemetryItems,
-                item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
         }
     }
 
     // contact inputs
+    self->mLastWatchMs = me->mLastRunMs;
     if (DI_Watcher_DoWatch(self->mWatcher)) {
         const vector	lastChanges = DI_Watcher_GetLastChanges(self->mWatcher);
 
+        TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+            TelemetryItems_GetTimeMs());
         for (int i = 0, n = vector_size(lastChanges); i < n; ++i) {
             DI_WatchItemStat* wiStat;
 
             vector_get_at(&wiStat, lastChanges, i);
 
-            StringBuf_AppendByPrintf(me->mStringBuf, "%ld", 1);
-            TelemetryItems_Add(me->mTelemetryItems,
-                wiStat->watchItem->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
+            TelemetryItems_AddUInt32(me->mTelemetryItems,
+                wiStat->watchItem->nameId, 1);
         }
     }
 }
 
+static bool
+DI_DataFetchScheduler_GetNextDeadline(
+    const DataFetchSchedulerBase* me, uint64_t* outDeadlineMs)
+{
+    // the earlier of the fetch timers and the next contact input check
+    const DI_DataFetchScheduler* self = (const DI_DataFetchScheduler*)me;
+    uint64_t	watchMs = self->mLastWatchMs + DI_WATCH_INTERVAL_MS;
+    bool	hasDeadline =
+        FetchTimers_GetNextDeadline(me->mFetchTimers, outDeadlineMs);
+
+    if (DI_Watcher_IsEmpty(self->mWatcher)) {
+        return hasDeadline;
+    }
+    if (! hasDeadline || watchMs < *outDeadlineMs) {
+        *outDeadlineMs = watchMs;
+    }
+
+    return true;
+}
+
 DataFetchScheduler*
 DI_DataFetchScheduler_New(void)
 {
@@ -169,9 +207,11 @@ DI_DataFetchScheduler_New(void)
     }
 
     super->DoDestroy = DI_DataFetchScheduler_DoDestroy;
-//	super->DoInit    = DI_DataFetchScheduler_DoInit;  // don't override
+    super->DoInit    = DI_DataFetchScheduler_DoInit;
     super->ClearFetchTargets = DI_DataFetchScheduler_ClearFetchTargets;
     super->DoSchedule        = DI_DataFetchScheduler_DoSchedule;
+    super->GetNextDeadline   = DI_DataFetchScheduler_GetNextDeadline;
+    newObj->mLastWatchMs     = 0;
 
     return super;
 err_delete_fetchTargets:
@@ -193,4 +233,17 @@ DI_DataFetchScheduler_Init(DataFetchScheduler* me,
 
     DataFetchScheduler_Init(me, fetchItemPtrs);
     DI_Watcher_Init(self->mWatcher, watchItems);
+    self->mLastWatchMs = FetchTimers_GetTimeMs();
+}
+
+void
+DI_DataFetchScheduler_Update(DataFetchScheduler* me,
+    vector fetchItemPtrs, vector watchItems)
+{
+    // apply the difference of pulse count acquisition and contact input
+    // monitoring targets, which keeps the counters of the unchanged pins
+    DI_DataFetchScheduler* self = (DI_DataFetchScheduler*)me;
+
+    DataFetchScheduler_Update(me, fetchItemPtrs);
+    DI_Watcher_Update(self->mWatcher, watchItems);
 }
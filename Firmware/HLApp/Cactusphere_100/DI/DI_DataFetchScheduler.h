@@ -32,5 +32,7 @@
 extern DataFetchScheduler* DI_DataFetchScheduler_New(void);
 extern void	DI_DataFetchScheduler_Init(DataFetchScheduler* me,
     vector fetchItemPtrs, vector watchItems);
+extern void	DI_DataFetchScheduler_Update(DataFetchScheduler* me,
+    vector fetchItemPtrs, vector watchItems);
 
 #endif  // _DI_DATA_FETCH_SCHEDULER_H_
@@ -47,6 +47,8 @@ const char CntMinPulseWidthDIKey[] = "cntMinPulseWidth_DI";
 const char CntMaxPulseCountDIKey[] = "cntMaxPulseCount_DI";
 const char PollIsActiveHighKey[]   = "pollIsActiveHigh_DI";
 const char PollIntervalDIKey[]     = "pollInterval_DI";
+const char DeadbandDIKey[]         = "deadband_DI";
+const char MaxSilenceDIKey[]       = "maxSilence_DI";
 
 #define DI_FETCH_PORT_OFFSET 1
 
@@ -62,6 +64,14 @@ const char PollIntervalDIKey[]     = "pollInterval_DI";
 #define DI_MAXCOUNT_MIN_VALUE     1
 #define DI_MAXCOUNT_MAX_VALUE     0x7FFFFFFF
 
+#define DI_DEADBAND_DEFAULT_VALUE 0
+#define DI_DEADBAND_MIN_VALUE     0
+#define DI_DEADBAND_MAX_VALUE     0x7FFFFFFF
+
+#define DI_MAXSILENCE_DEFAULT_VALUE 0
+#define DI_MAXSILENCE_MIN_VALUE     0
+#define DI_MAXSILENCE_MAX_VALUE     86400
+
 typedef enum {
     FEATURE_UNSELECT = -1,
     FEATURE_FALSE = 0,
@@ -133,13 +143,14 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
     const json_value* json, bool desire, vector propertyItem, const char* version)
 {
     DI_FetchItem config[NUM_DI] = {
-        // telemetryName, intervalSec, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
-        {"", 1, 0, false, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 1, false, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 2, false, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 3, false, false, false, false, 200, 0x7FFFFFFF}
+        // telemetryName, intervalSec, intervalMs, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
+        {"", 1, 0, 0, false, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1, 0, 1, false, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1, 0, 2, false, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1, 0, 3, false, false, false, false, 200, 0x7FFFFFFF}
     };
     bool overWrite[NUM_DI] = {false};
+    bool isConfigured[NUM_DI] = {false};
     bool ret = true;
 
     const size_t cntIsPulseHighDiLen   = strlen(CntIsPulseHighDIKey);
@@ -148,6 +159,8 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
     const size_t cntMaxPulseCountDiLen = strlen(CntMaxPulseCountDIKey);
     const size_t pollIsActiveHighDiLen = strlen(PollIsActiveHighKey);
     const size_t pollIntervalDiLen     = strlen(PollIntervalDIKey);
+    const size_t deadbandDiLen         = strlen(DeadbandDIKey);
+    const size_t maxSilenceDiLen       = strlen(MaxSilenceDIKey);
 
     char diCounterStr[PROPERTY_NAME_MAX_LEN];
     char diPollingStr[PROPERTY_NAME_MAX_LEN];
@@ -160,7 +173,7 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
         DI_FetchItem* tmp = (DI_FetchItem*)vector_get_data(me->mFetchItems);
         for (int i = 0; i < vector_size(me->mFetchItems); i++) {
             memcpy(&config[tmp->pinID], tmp, sizeof(DI_FetchItem));
-            overWrite[tmp->pinID] = true;
+            overWrite[tmp->pinID] = isConfigured[tmp->pinID] = true;
             tmp ++;
         }
     }
@@ -213,6 +226,7 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
                 config[i].intervalSec   = DI_INTERVAL_DEFAULT_VALUE;
                 config[i].minPulseWidth = DI_MINPULSE_DEFAULT_VALUE;
                 config[i].maxPulseCount = DI_MAXCOUNT_DEFAULT_VALUE;
+                memset(&config[i].filter, 0, sizeof(config[i].filter));
             }
             config[i].isPulseCounter = true;
             sprintf(config[i].telemetryName, "DI%d_count", i + DI_FETCH_PORT_OFFSET);
@@ -225,6 +239,7 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
                 config[i].intervalSec   = DI_INTERVAL_DEFAULT_VALUE;
                 config[i].minPulseWidth = DI_MINPULSE_DEFAULT_VALUE;
                 config[i].maxPulseCount = DI_MAXCOUNT_DEFAULT_VALUE;
+                memset(&config[i].filter, 0, sizeof(config[i].filter));
             }
             config[i].isPulseCounter = false;
             sprintf(config[i].telemetryName, "DI%d_PollingStatus", i + DI_FETCH_PORT_OFFSET);
@@ -348,11 +363,46 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
             } else {
                 ret = overWrite[pinid] = false;
             }
+        } else if (0 == strncmp(propertyName, DeadbandDIKey, deadbandDiLen)) {
+            uint32_t value = 0;
+
+            if ((pinid = strtol(&propertyName[deadbandDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET) < 0) {
+                continue;
+            }
+
+            // pulse counter only; a level is reported on change
+            if (DI_FetchConfig_GetIntValue(item, &value, 10,
+                                           DI_DEADBAND_DEFAULT_VALUE, DI_DEADBAND_MIN_VALUE, DI_DEADBAND_MAX_VALUE,
+                                           propertyItem, propertyName)) {
+                if (config[pinid].isPulseCounter) {
+                    config[pinid].filter.deadbandAbs = (float)value;
+                }
+            } else {
+                ret = overWrite[pinid] = false;
+            }
+        } else if (0 == strncmp(propertyName, MaxSilenceDIKey, maxSilenceDiLen)) {
+            uint32_t value = 0;
+
+            if ((pinid = strtol(&propertyName[maxSilenceDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET) < 0) {
+                continue;
+            }
+
+            if (DI_FetchConfig_GetIntValue(item, &value, 10,
+                                           DI_MAXSILENCE_DEFAULT_VALUE, DI_MAXSILENCE_MIN_VALUE, DI_MAXSILENCE_MAX_VALUE,
+                                           propertyItem, propertyName)) {
+                config[pinid].filter.maxSilenceSec = value;
+            } else {
+                ret = overWrite[pinid] = false;
+            }
         }
     }
 
     for (int i = 0; i < NUM_DI; i++) {
         if (overWrite[i]) {
+            if (! isConfigured[i]) {
+                // a new pin is to be set up
+                config[i].isCountClear = true;
+            }
             vector_add_last(me->mFetchItems, &config[i]);
         }
     }
@@ -363,7 +413,8 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, false);
             ++curs;
         }
     }
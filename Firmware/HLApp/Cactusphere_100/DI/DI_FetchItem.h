@@ -32,10 +32,17 @@
 #ifndef _STDBOOL_H
 #include <stdbool.h>
 #endif
+#ifndef _TELEMETRYITEMS_H_
+#include <TelemetryItems.h>
+#endif
+#ifndef _TELEMETRY_FILTER_H_
+#include <TelemetryFilter.h>
+#endif
 
 typedef struct DI_FetchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t    intervalSec;            // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;             // periodic acquisition interval (in milliseconds)
     uint32_t    pinID;                  // pin ID
     bool        isPulseCounter;         // pulse counter(true) / polling(false)
     bool        isCountClear;           // whether to clear the counter
@@ -43,6 +50,8 @@ typedef struct DI_FetchItem {
     bool        isPollingActiveHigh;    // whether the value notified by polling is Active High
     uint32_t    minPulseWidth;          // minimum length for settlement as pulse
     uint32_t    maxPulseCount;          // max pulse counter value
+    TelemetryNameId nameId;                 // interned telemetry name
+    TelemetryFilterSpec filter;             // report-by-exception condition
 } DI_FetchItem;
 
 #endif  // _DI_FETCH_ITEM_H
@@ -74,5 +74,5 @@ DI_FetchTargets_Add(DI_FetchTargets* me, const DI_FetchItem* target)
 void
 DI_FetchTargets_Clear(DI_FetchTargets* me)
 {
-    vector_clear(me->mTargets);
+    vector_remove_all(me->mTargets);
 }
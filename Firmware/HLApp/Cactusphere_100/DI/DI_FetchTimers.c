@@ -31,13 +31,15 @@
 void
 DI_FetchTimers_InitForTimer(FetchTimers* me, FetchItemBase* fetchItemBase)
 {
-    // configure and start the pulse counter for a pin
+    // configure and start the pulse counter for a pin which is new or
+    // changed; the others keep counting
     DI_FetchItem*	fetchTime = (DI_FetchItem*)fetchItemBase;
 
-    if (fetchTime->isCountClear) {
-        DI_Lib_ResetPulseCount(fetchTime->pinID, 0);
-        fetchTime->isCountClear = false;
+    if (! fetchTime->isCountClear) {
+        return;
     }
+    DI_Lib_ResetPulseCount(fetchTime->pinID, 0);
+    fetchTime->isCountClear = false;
     DI_Lib_ConfigPulseCounter(fetchTime->pinID, fetchTime->isPulseHigh,
         fetchTime->minPulseWidth, fetchTime->maxPulseCount);
 }
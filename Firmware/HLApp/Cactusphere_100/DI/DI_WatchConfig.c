@@ -142,7 +142,9 @@ DI_WatchConfig_LoadFromJSON(DI_WatchConfig* me,
             }
             bool value;
             if (json_GetBoolValue(item, &value)) {
-                config[pinid].isCountClear = (config[pinid].notifyChangeForHigh != value) ? true : false;
+                if (config[pinid].notifyChangeForHigh != value) {
+                    config[pinid].isCountClear = true;
+                }
                 config[pinid].notifyChangeForHigh = value;
                 PropertyItems_AddItem(propertyItem, propertyName, TYPE_BOOL, config[pinid].notifyChangeForHigh);
             } else {
@@ -162,7 +164,8 @@ DI_WatchConfig_LoadFromJSON(DI_WatchConfig* me,
         DI_WatchItem*	curs = (DI_WatchItem*)vector_get_data(me->mWatchItems);
 
         for (int i = 0, n = vector_size(me->mWatchItems); i < n; ++i) {
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, false);
             ++curs;
         }
     }
@@ -35,12 +35,16 @@
 #ifndef TELEMETRY_NAME_MAX_LEN
 #define TELEMETRY_NAME_MAX_LEN	32
 #endif
+#ifndef _TELEMETRYITEMS_H_
+#include <TelemetryItems.h>
+#endif
 
 typedef struct DI_WatchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t    pinID;                  // pin ID
     bool        notifyChangeForHigh;   // whether the input's normal level isn't high
     bool        isCountClear;          // whether to clear the counter
+    TelemetryNameId nameId;                // interned telemetry name
 } DI_WatchItem;
 
 #endif  // _DI_WATCHITEM_H_
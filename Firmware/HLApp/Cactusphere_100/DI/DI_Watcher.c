@@ -30,9 +30,25 @@
 // DI_Watcher data members
 struct DI_Watcher {
     vector	mBody;         // vector of DI_WatchItemStat
+    vector	mPrevBody;     // running DI_WatchItemStat during Update
     vector	mLastChanges;  // pointer vector of changed DI_WatchItemStat
 };
 
+static void
+DI_Watcher_CommitChanges(DI_Watcher* me)
+{
+    // the changes found last time have been notified
+    if (0 != vector_size(me->mLastChanges)) {
+        for (int i = 0, n = vector_size(me->mLastChanges); i < n; ++i) {
+            DI_WatchItemStat*	changed;
+
+            vector_get_at(&changed, me->mLastChanges, i);
+            changed->prevPulseCount = changed->currPulseCount;
+        }
+        vector_remove_all(me->mLastChanges);
+    }
+}
+
 // Initialization and cleanup
 DI_Watcher*
 DI_Watcher_New(void)
@@ -41,11 +57,16 @@ DI_Watcher_New(void)
 
     if (NULL != newObj) {
         newObj->mBody = vector_init(sizeof(DI_WatchItemStat));
+        newObj->mPrevBody = vector_init(sizeof(DI_WatchItemStat));
         newObj->mLastChanges = vector_init(sizeof(DI_WatchItemStat*));
-        if (NULL == newObj->mBody || NULL == newObj->mLastChanges) {
+        if (NULL == newObj->mBody || NULL == newObj->mPrevBody
+        || NULL == newObj->mLastChanges) {
             if (NULL != newObj->mBody) {
                 vector_destroy(newObj->mBody);
             }
+            if (NULL != newObj->mPrevBody) {
+                vector_destroy(newObj->mPrevBody);
+            }
             if (NULL != newObj->mLastChanges) {
                 vector_destroy(newObj->mLastChanges);
             }
@@ -79,20 +100,73 @@ DI_Watcher_Init(DI_Watcher* me, vector watchItems)
             // error !
             continue;  // ignore that target
         }
+        pseudo.pinID          = curs->pinID;
         pseudo.watchItem      = curs++;
         pseudo.prevPulseCount = pseudo.currPulseCount = 0;
         vector_add_last(me->mBody, &pseudo);
     }
 }
 
+void
+DI_Watcher_Update(DI_Watcher* me, vector watchItems)
+{
+    // take over the status of the unchanged contact inputs, and set up
+    // monitoring of the others
+    DI_WatchItem*	curs;
+    const DI_WatchItemStat*	prevStats;
+    vector	prevBody = me->mBody;
+    int	numPrev;
+
+    DI_Watcher_CommitChanges(me);
+    me->mBody     = me->mPrevBody;
+    me->mPrevBody = prevBody;
+    vector_remove_all(me->mBody);
+    prevStats = (const DI_WatchItemStat*)vector_get_data(prevBody);
+    numPrev   = vector_size(prevBody);
+
+    curs = (DI_WatchItem*)vector_get_data(watchItems);
+    for (int i = 0, n = vector_size(watchItems); i < n; ++i, ++curs) {
+        DI_WatchItemStat	pseudo;
+        int	j = 0;
+
+        while (j < numPrev && prevStats[j].pinID != curs->pinID) {
+            ++j;
+        }
+        if (j < numPrev && ! curs->isCountClear) {
+            pseudo = prevStats[j];
+        } else {
+            // configure pulse counter for monitoring contact input
+            DI_Lib_ResetPulseCount(curs->pinID, 0);
+            if (! DI_Lib_ConfigPulseCounter(curs->pinID,
+                    curs->notifyChangeForHigh, 200, 0xFFFFFFFF)) {
+                // error !
+                continue;  // ignore that target
+            }
+            curs->isCountClear    = false;
+            pseudo.prevPulseCount = pseudo.currPulseCount = 0;
+        }
+        pseudo.pinID     = curs->pinID;
+        pseudo.watchItem = curs;
+        vector_add_last(me->mBody, &pseudo);
+    }
+}
+
 void
 DI_Watcher_Destroy(DI_Watcher* me)
 {
     vector_destroy(me->mBody);
+    vector_destroy(me->mPrevBody);
     vector_destroy(me->mLastChanges);
     free(me);
 }
 
+// Attribute
+bool
+DI_Watcher_IsEmpty(const DI_Watcher* me)
+{
+    return vector_is_empty(me->mBody);
+}
+
 // Check update
 bool
 DI_Watcher_DoWatch(DI_Watcher* me)
@@ -101,15 +175,7 @@ DI_Watcher_DoWatch(DI_Watcher* me)
     // Return whether it has changed.
     DI_WatchItemStat*	curs;
 
-    if (0 != vector_size(me->mLastChanges)) {
-        for (int i = 0, n = vector_size(me->mLastChanges); i < n; ++i) {
-            DI_WatchItemStat*	changed;
-
-            vector_get_at(&changed, me->mLastChanges, i);
-            changed->prevPulseCount = changed->currPulseCount;
-        }
-        vector_clear(me->mLastChanges);
-    }
+    DI_Watcher_CommitChanges(me);
 
     curs = (DI_WatchItemStat*)vector_get_data(me->mBody);
     for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
@@ -28,6 +28,9 @@
 #ifndef _STDBOOL_H
 #include <stdbool.h>
 #endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
 
 #ifndef CONTAINERS_VECTOR_H
 #include <vector.h>
@@ -39,6 +42,7 @@ typedef struct DI_Watcher	DI_Watcher;
 // status of contact input monitoring target
 typedef struct DI_WatchItemStat {
     const DI_WatchItem*	watchItem;  // watching specification
+    uint32_t	pinID;              // pin ID of watchItem
     unsigned long	prevPulseCount; // previous counter value
     unsigned long	currPulseCount; // last counter value
 } DI_WatchItemStat;
@@ -46,10 +50,20 @@ typedef struct DI_WatchItemStat {
 // Initialization and cleanup
 extern DI_Watcher*	DI_Watcher_New(void);
 extern void	DI_Watcher_Init(DI_Watcher* me, vector watchItems);
+extern void	DI_Watcher_Update(DI_Watcher* me, vector watchItems);
 extern void	DI_Watcher_Destroy(DI_Watcher* me);
 
+// Attribute
+extern bool	DI_Watcher_IsEmpty(const DI_Watcher* me);
+
 // Check update
 extern bool	DI_Watcher_DoWatch(DI_Watcher* me);
 extern const vector	DI_Watcher_GetLastChanges(DI_Watcher* me);
 
+//
+// NOTE: DI_Watcher_Update() keeps watching the contact inputs of the pins
+//       watched already without isCountClear, together with their counter
+//       values, and sets up the others as DI_Watcher_Init() does.
+//
+
 #endif  // _DI_WATCHER_H_
@@ -87,9 +87,9 @@ DIO_DIFetchConfig_LoadFromJSON(DIO_DIFetchConfig* me, DIO_PropertyData* data,
     }
 
     DIO_DIFetchItem currentValue[NUM_DI] = {
-        // telemetryName, intervalSec, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
-        {"", DI_INTERVAL_DEFAULT_VALUE, 0, false, false, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE},
-        {"", DI_INTERVAL_DEFAULT_VALUE, 1, false, false, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE}
+        // telemetryName, intervalSec, intervalMs, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
+        {"", DI_INTERVAL_DEFAULT_VALUE, 0, 0, false, false, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE},
+        {"", DI_INTERVAL_DEFAULT_VALUE, 0, 1, false, false, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE}
     };
 
     if (! vector_is_empty(me->mFetchItems)) {
@@ -113,8 +113,8 @@ DIO_DIFetchConfig_LoadFromJSON(DIO_DIFetchConfig* me, DIO_PropertyData* data,
 
     for (uint32_t i = 0; i < NUM_DI; i++) {
         DIO_DIFetchItem config =
-        // telemetryName, intervalSec, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
-        {"", DI_INTERVAL_DEFAULT_VALUE, 0, false, true, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE};
+        // telemetryName, intervalSec, intervalMs, pinID, isPulseCounter, isCountClear, isPulseHigh, isPollingActiveHigh, minPulseWidth, maxPulseCount
+        {"", DI_INTERVAL_DEFAULT_VALUE, 0, 0, false, true, false, false, DI_MINPULSE_DEFAULT_VALUE, DI_MAXCOUNT_DEFAULT_VALUE};
 
         switch(data->diData[i].diFunctionType) {
             case DIFUNC_TYPE_PULSECOUNTER:
@@ -186,7 +186,8 @@ DIO_DIFetchConfig_LoadFromJSON(DIO_DIFetchConfig* me, DIO_PropertyData* data,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, false);
             ++curs;
         }
     }
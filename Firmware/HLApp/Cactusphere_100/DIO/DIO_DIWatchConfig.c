@@ -116,7 +116,8 @@ DIO_DIWatchConfig_LoadFromJSON(DIO_DIWatchConfig* me, DIO_PropertyData* data,
         DIO_DIWatchItem*	curs = (DIO_DIWatchItem*)vector_get_data(me->mWatchItems);
 
         for (int i = 0, n = vector_size(me->mWatchItems); i < n; ++i) {
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, false);
             ++curs;
         }
     }
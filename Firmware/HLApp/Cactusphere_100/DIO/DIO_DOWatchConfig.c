@@ -286,8 +286,9 @@ DIO_DOWatchConfig_AddConfig(DIO_DOWatchConfig* me, int pinId)
         }
 
         if (ret) {
+            item.nameId = TelemetryItems_AddDictionaryElem(
+                item.telemetryName, false);
             vector_add_last(me->mWatchItems, &item);
-            TelemetryItems_AddDictionaryElem(item.telemetryName, false);
         }
     } 
 
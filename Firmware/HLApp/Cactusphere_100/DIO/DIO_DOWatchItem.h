@@ -37,6 +37,7 @@
 #endif
 
 #include "DIO_PropertyItem.h"
+#include "TelemetryItems.h"
 
 typedef enum {
     DO_MODE_NOTSELECTED = 0,
@@ -100,6 +101,7 @@ typedef struct DIO_DOWatchItem {
         DIO_DORelatePulseTriggerConfig relatePulseTrigger;
     } config;
     bool isNotify;
+    TelemetryNameId nameId; // interned telemetry name
 } DIO_DOWatchItem;
 
 #endif  // _DIO_DOWATCHITEM_H_
@@ -34,7 +34,6 @@
 #include "DIO_DOWatchItem.h"
 #include "LibCloud.h"
 #include "LibDIO.h"
-#include "StringBuf.h"
 #include "TelemetryItems.h"
 
 typedef struct DIO_DataFetchScheduler {
@@ -95,6 +94,8 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
     // pulse conters & polling
     items = DIO_DIFetchTargets_GetFetchItems(self->mFetchTargets);
     if (! vector_is_empty(items)) {
+        TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+            TelemetryItems_GetTimeMs());
         const DIO_DIFetchItem** itemsCurs = (const DIO_DIFetchItem**)vector_get_data(items);
 
         for (int i = 0, n = vector_size(items); i < n; i++) {
@@ -106,7 +107,8 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                 if (! DIO_Lib_ReadPulseCount(item->pinID, &pulseCount)) {
                     continue;
                 };
-                StringBuf_AppendByPrintf(me->mStringBuf, "%lu", pulseCount);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->nameId, (uint32_t)pulseCount);
             } else {
                 unsigned int currentStatus = 0;
 
@@ -121,12 +123,9 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                     currentStatus = (currentStatus == GPIO_Value_Low ? DIO_POLLING_VALUE_ON : DIO_POLLING_VALUE_OFF);
                 }
                 
-                StringBuf_AppendByPrintf(me->mStringBuf, "%ld", currentStatus);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->nameId, (uint32_t)currentStatus);
             }
-
-            TelemetryItems_Add(me->mTelemetryItems,
-                item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
         }
     }
 
@@ -134,15 +133,15 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
     if (DIO_DIWatcher_DoWatch(self->mWatcher)) {
         const vector	lastChanges = DIO_DIWatcher_GetLastChanges(self->mWatcher);
 
+        TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+            TelemetryItems_GetTimeMs());
         for (int i = 0, n = vector_size(lastChanges); i < n; ++i) {
             DIO_DIWatchItemStat* wiStat;
 
             vector_get_at(&wiStat, lastChanges, i);
 
-            StringBuf_AppendByPrintf(me->mStringBuf, "%ld", 1);
-            TelemetryItems_Add(me->mTelemetryItems,
-                wiStat->watchItem->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
+            TelemetryItems_AddUInt32(me->mTelemetryItems,
+                wiStat->watchItem->nameId, 1);
         }
     }
 
@@ -150,7 +149,9 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
     items = DIO_DOWatcher_GetWatchItems(self->mDOWatcher);
     if (! vector_is_empty(items)) {
         DIO_DOWatchItem*    curs = (DIO_DOWatchItem*)vector_get_data(items);
-        
+
+        TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+            TelemetryItems_GetTimeMs());        
         for (int i = 0, n = vector_size(items); i < n; ++i) {
             unsigned int status;
 
@@ -159,10 +160,8 @@ DIO_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                     continue;
                 }
 
-                StringBuf_AppendByPrintf(me->mStringBuf, "%ld", status);
-                TelemetryItems_Add(me->mTelemetryItems,
-                    curs->telemetryName, StringBuf_GetStr(me->mStringBuf));
-                StringBuf_Clear(me->mStringBuf);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    curs->nameId, (uint32_t)status);
             }
 
             curs++;
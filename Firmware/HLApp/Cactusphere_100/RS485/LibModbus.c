@@ -51,31 +51,46 @@ static const char ModbusParityKey[PARITY_NUM][5] = {
 };
 
 static vector sModbusVec = NULL;
+static vector sPrevModbusVec = NULL;    // devices before the load
 
 // Add ModbusDev 
 static void Libmodbus_AddModbusDev(int devID, int boud, uint8_t parity, uint8_t stop) {
-    ModbusDev* modbusDev;
+    ModbusDev* modbusDev = ModbusDev_GetModbusDev(devID, sPrevModbusVec);
+
+    if (modbusDev != NULL && ModbusDev_IsSameParams(modbusDev, boud, parity, stop)) {
+        // take over the running one
+        vector_add_last(sModbusVec, modbusDev);
+        ModbusDev_Detach(modbusDev);
+        return;
+    }
     modbusDev = ModbusDev_NewModbusRTU(devID, boud, parity, stop);
-    vector_add_last(sModbusVec, modbusDev);
+    if (modbusDev != NULL) {
+        vector_add_last(sModbusVec, modbusDev);
+        free(modbusDev);  // copied into the vector
+    }
 }
 
 // Initialization
 void Libmodbus_ModbusDevInitialize(void) {
     sModbusVec = ModbusDev_Initialize();
+    sPrevModbusVec = ModbusDev_Initialize();
 }
 
 // Destroy
 void Libmodbus_ModbusDevDestroy(void) {
     if (sModbusVec != NULL) {
         Libmodbus_ModbusDevClear();
-        ModbusDev_Destroy(sModbusVec);
         vector_destroy(sModbusVec);
     }
+    if (sPrevModbusVec != NULL) {
+        vector_destroy(sPrevModbusVec);
+    }
 }
 
 // Clear
 void Libmodbus_ModbusDevClear(void) {
     if (sModbusVec != NULL) {
+        ModbusDev_Destroy(sModbusVec);
         vector_clear(sModbusVec);
     }
 }
@@ -84,6 +99,11 @@ void Libmodbus_ModbusDevClear(void) {
 bool Libmodbus_LoadFromJSON(const json_value* json) {
     json_value* configJson = NULL;
     bool ret = true;
+    vector prevVec = sPrevModbusVec;
+
+    // move the running devices aside, to take over the unchanged ones
+    sPrevModbusVec = sModbusVec;
+    sModbusVec = prevVec;
 
     for (unsigned int i = 0, n = json->u.object.length; i < n; ++i) {
         if (0 == strcmp(ModbusDevConfigKey, json->u.object.values[i].name)) {
@@ -143,12 +163,16 @@ bool Libmodbus_LoadFromJSON(const json_value* json) {
 
         if (baudrate < MIN_BAUDRATE || baudrate > MAX_BAUDRATE) {
             ret = false;
-        } else {
+        } else if (ModbusDev_GetModbusDev(devId, sModbusVec) == NULL) {
             Libmodbus_AddModbusDev(devId, baudrate, parity, stop);
         }
     }
 
 end:
+    // destroy the devices no longer configured or changed
+    ModbusDev_Destroy(sPrevModbusVec);
+    vector_remove_all(sPrevModbusVec);
+
     return ret;
 }
 
@@ -39,6 +39,9 @@ extern void Libmodbus_ModbusDevClear(void);
 
 // Regist
 extern bool Libmodbus_LoadFromJSON(const json_value* json);
+//
+// NOTE: The devices of the same device ID and parameters are taken over
+//       from the previous configuration, and the others are replaced.
 
 // Connect
 extern ModbusDev* Libmodbus_GetAndConnectLib(int devID);
@@ -41,31 +41,53 @@ const char ModbusTcpConfigKey[] = "ModbusTcpConfig";
 extern const char PortKey[];
 
 static vector sModbusTcpVec = NULL;
+static vector sPrevModbusTcpVec = NULL;     // devices before the load
 
 // Add ModbusTcpDev
 static void LibmodbusTcp_AddModbusDev(char* ip, int port) {
     ModbusTcpDev* modbusDev;
+    char id[21];
+
+    // the address and the port are all the parameters
+    snprintf(id, sizeof(id), "%s:%d", ip, port);
+    if (ModbusTcpDev_GetModbusDev(id, sModbusTcpVec) != NULL) {
+        return;
+    }
+    modbusDev = ModbusTcpDev_GetModbusDev(id, sPrevModbusTcpVec);
+    if (modbusDev != NULL) {
+        // take over the running one
+        vector_add_last(sModbusTcpVec, modbusDev);
+        ModbusTcpDev_Detach(modbusDev);
+        return;
+    }
     modbusDev = ModbusTcpDev_NewModbusTCP(ip, port);
-    vector_add_last(sModbusTcpVec, modbusDev);
+    if (modbusDev != NULL) {
+        vector_add_last(sModbusTcpVec, modbusDev);
+        free(modbusDev);  // copied into the vector
+    }
 }
 
 // Initialization
 void LibmodbusTcp_ModbusDevInitialize(void) {
     sModbusTcpVec = ModbusTcpDev_Initialize();
+    sPrevModbusTcpVec = ModbusTcpDev_Initialize();
 }
 
 // Destroy
 void LibmodbusTcp_ModbusDevDestroy(void) {
     if (sModbusTcpVec != NULL) {
         LibmodbusTcp_ModbusDevClear();
-        ModbusTcpDev_Destroy(sModbusTcpVec);
         vector_destroy(sModbusTcpVec);
     }
+    if (sPrevModbusTcpVec != NULL) {
+        vector_destroy(sPrevModbusTcpVec);
+    }
 }
 
 // Clear
 void LibmodbusTcp_ModbusDevClear(void) {
     if (sModbusTcpVec != NULL) {
+        ModbusTcpDev_Destroy(sModbusTcpVec);
         vector_clear(sModbusTcpVec);
     }
 }
@@ -73,23 +95,31 @@ void LibmodbusTcp_ModbusDevClear(void) {
 // Regist
 bool LibmodbusTcp_LoadFromJSON(const json_value* json) {
     json_value* configJson = NULL;
+    bool ret = true;
+    vector prevVec = sPrevModbusTcpVec;
+
+    // move the running devices aside, to take over the unchanged ones
+    sPrevModbusTcpVec = sModbusTcpVec;
+    sModbusTcpVec = prevVec;
 
     configJson = json_GetKeyJson((unsigned char*)ModbusTcpConfigKey, (json_value*)json);
 
     if (configJson == NULL) {
-        return false;
+        ret = false;
+        goto end;
     }
 
     for (unsigned int i = 0, n = configJson->u.object.length; i < n; ++i) {
         char ip[16];
-        int port;
+        int port = 0;
         char* e;
         json_value* configItem = configJson->u.object.values[i].value;
 
         memcpy(ip, configJson->u.object.values[i].name, sizeof(ip));
 
         if (strlen((const char*)ip) == 0) {
-            return false;
+            ret = false;
+            goto end;
         }
 
         for (unsigned int p = 0, q = configItem->u.object.length; p < q; ++p) {
@@ -106,12 +136,18 @@ bool LibmodbusTcp_LoadFromJSON(const json_value* json) {
             }
         }
         if (port == 0) {
-            return false;
+            ret = false;
+            goto end;
         }
         LibmodbusTcp_AddModbusDev(ip, port);
     }
 
-    return true;
+end:
+    // destroy the devices no longer configured
+    ModbusTcpDev_Destroy(sPrevModbusTcpVec);
+    vector_remove_all(sPrevModbusTcpVec);
+
+    return ret;
 }
 
 ModbusTcpDev* LibmodbusTcp_GetAndConnectLib(char* id) {
@@ -39,6 +39,9 @@ extern void LibmodbusTcp_ModbusDevClear(void);
 
 // Regist
 extern bool LibmodbusTcp_LoadFromJSON(const json_value* json);
+//
+// NOTE: The devices of the same address and port and parameters are taken over
+//       from the previous configuration, and the others are replaced.
 
 // Connect/Disconnect
 extern ModbusTcpDev* LibmodbusTcp_GetAndConnectLib(char* id);
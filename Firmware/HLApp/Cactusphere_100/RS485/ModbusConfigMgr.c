@@ -32,6 +32,7 @@
 #include <applibs/log.h>
 
 #include "json.h"
+#include "JsonArena.h"
 #include "LibModbus.h"
 #include "ModbusFetchConfig.h"
 #include "PropertyItems.h"
@@ -59,11 +60,10 @@ ModbusConfigMgr_Cleanup(void)
 
 // Apply new configuration
 SphereWarning
-ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
-    unsigned int payloadSize, vector item)
+ModbusConfigMgr_LoadAndApplyIfChanged(json_value* jsonObj,
+    JsonArena* arena, vector item)
 {
     SphereWarning ret = NO_ERROR;
-    json_value* jsonObj = json_parse(payload, payloadSize);
     json_value* desiredObj = NULL;
     json_value* modbusConfObj = NULL;
     json_value* telemetryConfObj = NULL;
@@ -91,9 +91,9 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
                 modbusConfObj = json_GetKeyJson("value", modbusConfObj);
             }
             PropertyItems_AddItem(item, "ModbusDevConfig", TYPE_STR, modbusConfObj->u.string.ptr);
-            modbusConfObj = json_parse(modbusConfObj->u.string.ptr, modbusConfObj->u.string.length);
+            modbusConfObj = JsonArena_ParseString(arena, modbusConfObj);
             if (modbusConfObj != NULL) {
-                Libmodbus_ModbusDevClear();
+                // keeps the devices of the same parameters
                 if (!Libmodbus_LoadFromJSON(modbusConfObj)) {
                     Log_Debug("ModbusDevConfig LoadToJsonError!\n");
                     ret = ILLEGAL_PROPERTY;
@@ -105,7 +105,9 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
         }
     }
 
-    if (telemetryConfObj != NULL) {
+    if (telemetryConfObj == NULL) {
+        ModbusFetchConfig_ClearChanges(sModbusConfigMgr.fetchConfig);
+    } else {
         if (telemetryConfObj->type == json_null) {
             PropertyItems_AddItem(item, "ModbusTelemetryConfig", TYPE_NULL);
             ModbusFetchConfig_LoadFromJSON(sModbusConfigMgr.fetchConfig, telemetryConfObj, "1.0");
@@ -114,7 +116,7 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
                 telemetryConfObj = json_GetKeyJson("value", telemetryConfObj);
             }
             PropertyItems_AddItem(item, "ModbusTelemetryConfig", TYPE_STR, telemetryConfObj->u.string.ptr);
-            telemetryConfObj = json_parse(telemetryConfObj->u.string.ptr, telemetryConfObj->u.string.length);
+            telemetryConfObj = JsonArena_ParseString(arena, telemetryConfObj);
             if (telemetryConfObj != NULL) {
                 if (!ModbusFetchConfig_LoadFromJSON(sModbusConfigMgr.fetchConfig, telemetryConfObj, "1.0")) {
                     Log_Debug("ModbusTelemetryConfig LoadToJsonError!\n");
@@ -28,6 +28,7 @@
 #include "ModbusFetchConfig.h"
 #include "cactusphere_error.h"
 
+typedef struct JsonArena	JsonArena;
 typedef struct ModbusConfigMgr	ModbusConfigMgr;
 
 // Initialization and cleanup
@@ -35,8 +36,11 @@ extern void	ModbusConfigMgr_Initialize(void);
 extern void	ModbusConfigMgr_Cleanup(void);
 
 // Apply new configuration
-extern SphereWarning ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
-    unsigned int payloadSize, vector item);
+extern SphereWarning ModbusConfigMgr_LoadAndApplyIfChanged(json_value* jsonObj,
+    JsonArena* arena, vector item);
+//
+// NOTE: jsonObj is the twin document parsed in arena, and the JSON text of
+//       the string-valued configurations in it is parsed in arena too.
 
 // Get configuratioin
 extern ModbusFetchConfig*
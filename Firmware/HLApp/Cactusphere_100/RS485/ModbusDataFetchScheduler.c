@@ -30,7 +30,8 @@
 #include "ModbusFetchItem.h"
 #include "ModbusFetchTargets.h"
 #include "ModbusDevConfig.h"
-#include "StringBuf.h"
+#include "TelemetryAggregator.h"
+#include "TelemetryFilter.h"
 #include "TelemetryItems.h"
 
 #define  MODBUS_ONESHOT_COMMAND_PARAM_NUM 4
@@ -64,6 +65,30 @@ ModbusDataFetchScheduler_DoDestroy(DataFetchSchedulerBase* me)
     ModbusFetchTargets_Destroy(self->mFetchTargets);
 }
 
+static void
+ModbusDataFetchScheduler_DoInit(DataFetchSchedulerBase* me,
+    vector fetchItemPtrs)
+{
+    ModbusDataFetchScheduler*	self = (ModbusDataFetchScheduler*)me;
+    const ModbusFetchItem**	fiCurs =
+        (const ModbusFetchItem**)vector_get_data(fetchItemPtrs);
+
+    ModbusFetchTargets_Prepare(self->mFetchTargets, fetchItemPtrs);
+    for (int i = 0, n = vector_size(fetchItemPtrs); i < n; ++i) {
+        const ModbusFetchItem*	item = *fiCurs++;
+
+        if (item->isChanged) {
+            // restart the window and the filter history of the item
+            TelemetryAggregator_RemoveWindow(me->mAggregator, item->nameId);
+            TelemetryFilter_RemoveSpec(me->mFilter, item->nameId);
+        }
+        (void)TelemetryAggregator_SetWindow(me->mAggregator, item->nameId,
+            item->reportIntervalSec * 1000,
+            FetchTimers_GetIntervalMs((const FetchItemBase*)item));
+        (void)TelemetryFilter_SetSpec(me->mFilter, item->nameId, &item->filter);
+    }
+}
+
 static void
 ModbusDataFetchScheduler_ClearFetchTargets(DataFetchSchedulerBase* me)
 {
@@ -89,11 +114,17 @@ ModbusDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
             const ModbusFetchItem** fiCurs =
                 (const ModbusFetchItem**)vector_get_data(fetchItems);
 
+            if (0 == vector_size(fetchItems)) {
+                continue;  // nothing to acquire in this tick
+            }
             ModbusDev* modbusdev = Libmodbus_GetAndConnectLib((int)devID);
 
             if (modbusdev == NULL) {
                 continue;
             }
+            // registers of a device are read back to back from here
+            TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+                TelemetryItems_GetTimeMs());
 
             for (int j = 0, m = vector_size(fetchItems); j < m; ++j) {
                 const ModbusFetchItem* item = *fiCurs++;
@@ -121,7 +152,8 @@ ModbusDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                     if (item->devider != 0) {
                         fVal /= item->devider;
                     }
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%f", fVal);
+                    TelemetryItems_AddFloat(me->mTelemetryItems,
+                        item->nameId, fVal);
                 } else {
                     unsigned long ulVal = tmpVal;
 
@@ -133,12 +165,9 @@ ModbusDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                         ulVal /= item->devider;
                     }
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%ld", ulVal);
+                    TelemetryItems_AddUInt32(me->mTelemetryItems,
+                        item->nameId, (uint32_t)ulVal);
                 }
-
-                TelemetryItems_Add(me->mTelemetryItems,
-                    item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-                StringBuf_Clear(me->mStringBuf);
             }
         }
     }
@@ -239,7 +268,7 @@ ModbusDataFetchScheduler_New(void)
     }
 
     super->DoDestroy = ModbusDataFetchScheduler_DoDestroy;
-//	super->DoInit    = ModbusDataFetchScheduler_DoInit;  // don't override
+    super->DoInit    = ModbusDataFetchScheduler_DoInit;
     super->ClearFetchTargets = ModbusDataFetchScheduler_ClearFetchTargets;
     super->DoSchedule        = ModbusDataFetchScheduler_DoSchedule;
 
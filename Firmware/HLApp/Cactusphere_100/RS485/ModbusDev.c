@@ -54,7 +54,7 @@ ModbusDev_Destroy(vector modbusDevVec) {
     ModbusDev* modbusDev = vector_get_data(modbusDevVec);
     for (int i = 0, n = vector_size(modbusDevVec); i < n; ++i) {
         ModbusDevRTU_Destroy(modbusDev->ctx);
-        free(modbusDev);
+        modbusDev->ctx = NULL;
         modbusDev++;
     }
 }
@@ -65,6 +65,9 @@ ModbusDev_NewModbusRTU(int devId, int baud, uint8_t parity, uint8_t stop) {
     ModbusDev* newObj;
 
     newObj = (ModbusDev*)malloc(sizeof(ModbusDev));
+    if (newObj == NULL) {
+        return NULL;
+    }
     newObj->ctx = ModbusDevRTU_Initialize(devId, baud, parity, stop);
 
     newObj->devId = devId;
@@ -85,6 +88,17 @@ ModbusDev_GetModbusDev(int devID, vector modbusDevVec) {
     return NULL;
 }
 
+// Reconfiguration
+bool
+ModbusDev_IsSameParams(const ModbusDev* me, int baud, uint8_t parity, uint8_t stop) {
+    return ModbusDevRTU_IsSameParams(me->ctx, baud, parity, stop);
+}
+
+void
+ModbusDev_Detach(ModbusDev* me) {
+    me->ctx = NULL;
+}
+
 // Connect
 bool 
 ModbusDev_Connect(ModbusDev* me) {
@@ -35,6 +35,11 @@ typedef struct ModbusDev ModbusDev;
 // Initialization and cleanup
 extern vector ModbusDev_Initialize(void);
 extern void ModbusDev_Destroy(vector modbusDevVec);
+//
+// NOTE: ModbusDev_Destroy() destroys the devices in the vector, and the
+//       vector is to be cleared then.  A device copied into another vector
+//       is to be detached from the original one, which then destroys
+//       nothing.
 
 // Create Modbus RTU
 extern ModbusDev* ModbusDev_NewModbusRTU(int devId, int baud, uint8_t parity, uint8_t stop);
@@ -42,6 +47,10 @@ extern ModbusDev* ModbusDev_NewModbusRTU(int devId, int baud, uint8_t parity, ui
 // Get ModbusDev*
 extern ModbusDev* ModbusDev_GetModbusDev(int devID, vector modbusDevVec);
 
+// Reconfiguration
+extern bool ModbusDev_IsSameParams(const ModbusDev* me, int baud, uint8_t parity, uint8_t stop);
+extern void ModbusDev_Detach(ModbusDev* me);
+
 // Connect
 extern bool ModbusDev_Connect(ModbusDev* me);
 
@@ -211,6 +211,12 @@ ModbusDevRTU_Destroy(ModbusCtx* me) {
     free(me);
 }
 
+// Attribute
+bool
+ModbusDevRTU_IsSameParams(const ModbusCtx* me, int baud, uint8_t parity, uint8_t stop) {
+    return (me->baud == baud && me->parity == parity && me->stop == stop);
+}
+
 // Connect
 bool 
 ModbusDevRTU_Connect(ModbusCtx* me) {
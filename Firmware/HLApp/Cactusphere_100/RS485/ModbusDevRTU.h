@@ -34,6 +34,9 @@ typedef struct ModbusCtx ModbusCtx;
 extern ModbusCtx* ModbusDevRTU_Initialize(int devId, int baud, uint8_t parity, uint8_t stop);
 extern void ModbusDevRTU_Destroy(ModbusCtx* me);
 
+// Attribute
+extern bool ModbusDevRTU_IsSameParams(const ModbusCtx* me, int baud, uint8_t parity, uint8_t stop);
+
 // Connect
 extern bool ModbusDevRTU_Connect(ModbusCtx* me);
 
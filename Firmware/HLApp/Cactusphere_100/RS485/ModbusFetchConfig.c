@@ -35,7 +35,10 @@
 struct ModbusFetchConfig {
     vector	mFetchItems;	// vector of Modbus RTU configuration
     vector	mFetchItemPtrs;	// vector of pointer which points mFetchItem's elem
+    vector	mPrevFetchItems;	// configuration before the last load
     char	version[32];	// version string (not using)
+    FetchPhasePolicy	mPhasePolicy;	// phase of the acquisition timers
+    TelemetryCacheEviction	mCacheEviction;	// eviction of the cache when full
 };
 
 // key Items
@@ -46,9 +49,18 @@ const char RegisterCountKey[]           = "registerCount";
 const char FuncCodeKey[]                = "funcCode";
 const char OffsetKey[]                  = "offset";
 const char IntervalKey[]                = "interval";
+const char IntervalMsKey[]              = "intervalMs";
 const char MultiplylKey[]               = "multiply";
 const char DeviderKey[]                 = "devider";
 const char AsFloatKey[]                 = "asFloat";
+const char DeadbandKey[]                = "deadband";
+const char DeadbandPercentKey[]         = "deadbandPercent";
+const char MaxSilenceKey[]              = "maxSilence";
+const char ReportIntervalKey[]          = "reportInterval";
+const char CachePriorityKey[]           = "cachePriority";
+const char CacheTtlKey[]                = "cacheTtl";
+const char PhasePolicyKey[]             = "phasePolicy";
+const char CacheEvictionKey[]           = "cacheEviction";
 
 #define SET_TELEMETRYCONF_DEVID    0x01
 #define SET_TELEMETRYCONF_REGADDR  0x02
@@ -76,7 +88,16 @@ ModbusFetchConfig_New(void)
             free(newObj);
             return NULL;
         }
+        newObj->mPrevFetchItems = vector_init(sizeof(ModbusFetchItem));
+        if (NULL == newObj->mPrevFetchItems) {
+            vector_destroy(newObj->mFetchItemPtrs);
+            vector_destroy(newObj->mFetchItems);
+            free(newObj);
+            return NULL;
+        }
         memset(newObj->version, 0, sizeof(newObj->version));
+        newObj->mPhasePolicy = FETCH_PHASE_NONE;
+        newObj->mCacheEviction = TelemetryCacheEviction_DropOldest;
     }
 
     return newObj;
@@ -85,11 +106,56 @@ ModbusFetchConfig_New(void)
 void
 ModbusFetchConfig_Destroy(ModbusFetchConfig* me)
 {
+    vector_destroy(me->mPrevFetchItems);
     vector_destroy(me->mFetchItemPtrs);
     vector_destroy(me->mFetchItems);
     free(me);
 }
 
+static bool
+ModbusFetchItem_IsSame(const ModbusFetchItem* lhs, const ModbusFetchItem* rhs)
+{
+    return (lhs->intervalSec == rhs->intervalSec
+        && lhs->intervalMs == rhs->intervalMs
+        && lhs->devID == rhs->devID
+        && lhs->regAddr == rhs->regAddr
+        && lhs->regCount == rhs->regCount
+        && lhs->funcCode == rhs->funcCode
+        && lhs->offset == rhs->offset
+        && lhs->multiplier == rhs->multiplier
+        && lhs->devider == rhs->devider
+        && lhs->asFloat == rhs->asFloat
+        && lhs->filter.deadbandAbs == rhs->filter.deadbandAbs
+        && lhs->filter.deadbandPct == rhs->filter.deadbandPct
+        && lhs->filter.maxSilenceSec == rhs->filter.maxSilenceSec
+        && lhs->reportIntervalSec == rhs->reportIntervalSec
+        && lhs->cachePriority == rhs->cachePriority
+        && lhs->cacheTtlSec == rhs->cacheTtlSec);
+}
+
+static bool
+ModbusFetchConfig_IsChanged(ModbusFetchConfig* me,
+    int index, const ModbusFetchItem* item)
+{
+    // look for the item of the same name in the previous configuration,
+    // at the same position first since most updates keep the order
+    const ModbusFetchItem*	prevItems =
+        (const ModbusFetchItem*)vector_get_data(me->mPrevFetchItems);
+    int	n = vector_size(me->mPrevFetchItems);
+
+    if (index < n
+    && 0 == strcmp(prevItems[index].telemetryName, item->telemetryName)) {
+        return ! ModbusFetchItem_IsSame(&prevItems[index], item);
+    }
+    for (int i = 0; i < n; ++i) {
+        if (0 == strcmp(prevItems[i].telemetryName, item->telemetryName)) {
+            return ! ModbusFetchItem_IsSame(&prevItems[i], item);
+        }
+    }
+
+    return true;  // new item
+}
+
 // Load Modbus RTU configuration from JSON
 bool
 ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
@@ -97,6 +163,7 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
 {
     json_value* configJson = NULL;
     bool ret = true;
+    vector prevItems = me->mPrevFetchItems;
 
     // clean up old configuration and load new content
     if (0 != vector_size(me->mFetchItems)) {
@@ -106,9 +173,16 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
             TelemetryItems_RemoveDictionaryElem(curs->telemetryName);
         }
         vector_clear(me->mFetchItemPtrs);
-        vector_clear(me->mFetchItems);
     }
 
+    // keep the old one to find the changed items
+    me->mPrevFetchItems = me->mFetchItems;
+    me->mFetchItems     = prevItems;
+    vector_remove_all(me->mFetchItems);
+
+    me->mPhasePolicy = FETCH_PHASE_NONE;
+    me->mCacheEviction = TelemetryCacheEviction_DropOldest;
+
     if (json->type == json_null) {
         goto end;
     }
@@ -116,7 +190,28 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
     for (unsigned int i = 0, n = json->u.object.length; i < n; ++i) {
         if (0 == strcmp(ModbusTelemetryConfigKey, json->u.object.values[i].name)) {
             configJson = json->u.object.values[i].value;
-            break;
+        } else if (0 == strcmp(PhasePolicyKey, json->u.object.values[i].name)) {
+            json_value* item = json->u.object.values[i].value;
+
+            if (item->type != json_string) {
+                ret = false;
+            } else if (0 == strcmp(item->u.string.ptr, "aligned")) {
+                me->mPhasePolicy = FETCH_PHASE_ALIGNED;
+            } else if (0 == strcmp(item->u.string.ptr, "staggered")) {
+                me->mPhasePolicy = FETCH_PHASE_STAGGERED;
+            } else if (0 != strcmp(item->u.string.ptr, "none")) {
+                ret = false;
+            }
+        } else if (0 == strcmp(CacheEvictionKey, json->u.object.values[i].name)) {
+            json_value* item = json->u.object.values[i].value;
+
+            if (item->type != json_string) {
+                ret = false;
+            } else if (0 == strcmp(item->u.string.ptr, "decimate")) {
+                me->mCacheEviction = TelemetryCacheEviction_Decimate;
+            } else if (0 != strcmp(item->u.string.ptr, "dropOldest")) {
+                ret = false;
+            }
         }
     }
 
@@ -143,9 +238,14 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
         pseudo.funcCode = 0;
         pseudo.offset = 0;
         pseudo.intervalSec = 1;
+        pseudo.intervalMs = 0;
         pseudo.multiplier = 0;
         pseudo.devider = 0;
         pseudo.asFloat = false;
+        memset(&pseudo.filter, 0, sizeof(pseudo.filter));
+        pseudo.reportIntervalSec = 0;
+        pseudo.cachePriority = 0;
+        pseudo.cacheTtlSec = 0;
 
         for (unsigned int p = 0, q = configItem->u.object.length; p < q; ++p) {
             if (0 == strcmp(configItem->u.object.values[p].name, DevIDKey)) {
@@ -195,7 +295,17 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
                 if (!ret_parse || pseudo.intervalSec < 1 || pseudo.intervalSec > 86400) {
                     ret = false;
                 } else {
-                    setFlag += SET_TELEMETRYCONF_INTERVAL;
+                    setFlag |= SET_TELEMETRYCONF_INTERVAL;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, IntervalMsKey)) {
+                // sub-second interval; takes precedence over "interval"
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.intervalMs, 10);
+                if (!ret_parse || pseudo.intervalMs < 100 || pseudo.intervalMs > 86400000) {
+                    pseudo.intervalMs = 0;
+                    ret = false;
+                } else {
+                    setFlag |= SET_TELEMETRYCONF_INTERVAL;
                 }
             } else if (0 == strcmp(configItem->u.object.values[p].name, OffsetKey)) {
                 json_value* item = configItem->u.object.values[p].value;
@@ -212,6 +322,51 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
             } else if (0 == strcmp(configItem->u.object.values[p].name, AsFloatKey)) {
                 json_value* item = configItem->u.object.values[p].value;
                 pseudo.asFloat = item->u.boolean;
+            } else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+                if (!json_GetDoubleValue(item, &value) || value < 0) {
+                    ret = false;
+                } else {
+                    pseudo.filter.deadbandAbs = (float)value;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandPercentKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+                if (!json_GetDoubleValue(item, &value) || value < 0 || value > 100) {
+                    ret = false;
+                } else {
+                    pseudo.filter.deadbandPct = (float)value;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, MaxSilenceKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.filter.maxSilenceSec, 10);
+                if (!ret_parse || pseudo.filter.maxSilenceSec > 86400) {
+                    pseudo.filter.maxSilenceSec = 0;
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, ReportIntervalKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.reportIntervalSec, 10);
+                if (!ret_parse || pseudo.reportIntervalSec > 86400) {
+                    pseudo.reportIntervalSec = 0;
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, CachePriorityKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                uint32_t value;
+                if (!json_GetNumericValue(item, &value, 10) || value > 3) {
+                    ret = false;
+                } else {
+                    pseudo.cachePriority = (uint8_t)value;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, CacheTtlKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.cacheTtlSec, 10);
+                if (!ret_parse || pseudo.cacheTtlSec > 7 * 86400) {
+                    pseudo.cacheTtlSec = 0;
+                    ret = false;
+                }
             }
         }
         
@@ -228,7 +383,9 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, curs->asFloat);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, curs->asFloat);
+            curs->isChanged = ModbusFetchConfig_IsChanged(me, i, curs);
             ++curs;
         }
     }
@@ -237,6 +394,16 @@ end:
     return ret;
 }
 
+void
+ModbusFetchConfig_ClearChanges(ModbusFetchConfig* me)
+{
+    ModbusFetchItem*	curs = (ModbusFetchItem*)vector_get_data(me->mFetchItems);
+
+    for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
+        curs++->isChanged = false;
+    }
+}
+
 // Get configuration
 vector
 ModbusFetchConfig_GetFetchItems(ModbusFetchConfig* me)
@@ -249,3 +416,15 @@ ModbusFetchConfig_GetFetchItemPtrs(ModbusFetchConfig* me)
 {
     return me->mFetchItemPtrs;
 }
+
+FetchPhasePolicy
+ModbusFetchConfig_GetPhasePolicy(ModbusFetchConfig* me)
+{
+    return me->mPhasePolicy;
+}
+
+TelemetryCacheEviction
+ModbusFetchConfig_GetCacheEviction(ModbusFetchConfig* me)
+{
+    return me->mCacheEviction;
+}
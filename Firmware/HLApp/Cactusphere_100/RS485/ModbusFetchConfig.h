@@ -31,6 +31,14 @@
 #include "vector.h"
 #endif
 
+#ifndef _FETCH_TIMERS_H_
+#include "FetchTimers.h"
+#endif
+
+#ifndef _TELEMETRY_ITEM_CACHE_H_
+#include "TelemetryItemCache.h"
+#endif
+
 typedef struct ModbusFetchConfig	ModbusFetchConfig;
 typedef struct _json_value	json_value;
 
@@ -41,9 +49,17 @@ extern void	ModbusFetchConfig_Destroy(ModbusFetchConfig* me);
 // Load Modbus RTU configuration from JSON
 extern bool	ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
     const json_value* json, const char* version);
+extern void	ModbusFetchConfig_ClearChanges(ModbusFetchConfig* me);
+//
+// NOTE: LoadFromJSON() marks the items which are new or differ from the
+//       previous configuration with isChanged, and ClearChanges() unmarks
+//       all of them when the configuration is kept as it is.
 
 // Get configuration
 extern vector	ModbusFetchConfig_GetFetchItems(ModbusFetchConfig* me);
 extern vector	ModbusFetchConfig_GetFetchItemPtrs(ModbusFetchConfig* me);
+extern FetchPhasePolicy	ModbusFetchConfig_GetPhasePolicy(ModbusFetchConfig* me);
+extern TelemetryCacheEviction	ModbusFetchConfig_GetCacheEviction(
+    ModbusFetchConfig* me);
 
 #endif  // _FETCH_CONFIG_H_
@@ -26,12 +26,15 @@
 #define _MODBUS_FETCH_ITEM_H_
 
 #include <FetchItemBase.h>
+#include <TelemetryFilter.h>
+#include <TelemetryItems.h>
 
 #include <stdbool.h>
 
 typedef struct ModbusFetchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t    intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds)
     uint32_t    devID;          // slave device ID
     uint32_t    regAddr;        // register address
     uint32_t    regCount;       // read register count
@@ -40,6 +43,12 @@ typedef struct ModbusFetchItem {
     uint32_t    multiplier;     // multiply value
     uint32_t    devider;        // divide value
     bool        asFloat;        // true:float, false: not float 
+    TelemetryNameId nameId;         // interned telemetry name
+    TelemetryFilterSpec filter;     // report-by-exception condition
+    uint32_t    reportIntervalSec;  // aggregation window (0: report each sample)
+    uint8_t     cachePriority;  // eviction class in the cache (0: evicted first)
+    uint32_t    cacheTtlSec;    // lifetime in the cache (0: unlimited)
+    bool        isChanged;      // new or changed by the last configuration
 } ModbusFetchItem;
 
 #endif  // _MODBUS_FETCH_ITEM_H_
@@ -53,7 +53,7 @@ ModbusFetchItemsPerDev_New(unsigned long devID)
         newObj->mFetchItems = vector_init(sizeof(ModbusFetchItem*));
         if (NULL == newObj->mFetchItems) {
             free(newObj);
-            return newObj;
+            return NULL;
         }
     }
 
@@ -89,6 +89,23 @@ DevID_Comparator(const void* const one, const void* const two)
     }
 }
 
+static void
+ModbusFetchTargets_DestroyGroups(ModbusFetchTargets* me)
+{
+    vector	devIDs = ModbusFetchTargets_GetDevIDs(me);
+    ModbusFetchItemsPerDev*	aGroup;
+
+    for (int i = 0, n = vector_size(devIDs); i < n; ++i) {
+        unsigned long	devID;
+
+        vector_get_at(&devID, devIDs, i);
+        if (dictionary_get(&aGroup, me->mTargetsDictByDevID, &devID)) {
+            ModbusFetchItemsPerDev_Destroy(aGroup);
+        }
+    }
+    dictionary_clear(me->mTargetsDictByDevID);
+}
+
 // Initialization and cleanup
 ModbusFetchTargets*
 ModbusFetchTargets_New(void)
@@ -112,19 +129,7 @@ ModbusFetchTargets_New(void)
 void
 ModbusFetchTargets_Destroy(ModbusFetchTargets* me)
 {
-    vector	devIDs = ModbusFetchTargets_GetDevIDs(me);
-    ModbusFetchItemsPerDev*	theGroup = NULL;
-
-    ModbusFetchTargets_Clear(me);
-
-    for (int i = 0, n = vector_size(devIDs); i < n; ++i) {
-        unsigned long	devID;
-        vector_get_at(&devID, devIDs, i);
-        if (dictionary_get(&theGroup, me->mTargetsDictByDevID, &devID)) {
-            ModbusFetchItemsPerDev_Destroy(theGroup);
-        }
-    }
-
+    ModbusFetchTargets_DestroyGroups(me);
     dictionary_destroy(me->mTargetsDictByDevID);
     free(me);
 }
@@ -150,19 +155,35 @@ ModbusFetchTargets_GetFetchItems(
 }
 
 // Manage acquisition targets
+void
+ModbusFetchTargets_Prepare(ModbusFetchTargets* me, vector fetchItemPtrs)
+{
+    // Make the group of each device with room for all of its items, so
+    // that adding the targets of a tick does not allocate memory.
+    const ModbusFetchItem**	curs =
+        (const ModbusFetchItem**)vector_get_data(fetchItemPtrs);
+
+    ModbusFetchTargets_DestroyGroups(me);
+    for (int i = 0, n = vector_size(fetchItemPtrs); i < n; ++i) {
+        ModbusFetchTargets_Add(me, *curs++);
+    }
+    ModbusFetchTargets_Clear(me);
+}
+
 void
 ModbusFetchTargets_Add(
     ModbusFetchTargets* me, const ModbusFetchItem* target)
 {
     ModbusFetchItemsPerDev*	theGroup = NULL;
+    unsigned long	devID = target->devID;  // key of the dictionary
 
-    if (! dictionary_get(&theGroup, me->mTargetsDictByDevID, (void*)&target->devID)) {
-        theGroup = ModbusFetchItemsPerDev_New(target->devID);
+    if (! dictionary_get(&theGroup, me->mTargetsDictByDevID, &devID)) {
+        theGroup = ModbusFetchItemsPerDev_New(devID);
         if (NULL == theGroup) {
             // ERROR!
             return;
         }
-        (void)dictionary_put(me->mTargetsDictByDevID, (void*)&target->devID, &theGroup);
+        (void)dictionary_put(me->mTargetsDictByDevID, &devID, &theGroup);
     }
 
     ModbusFetchItemsPerDev_Add(theGroup, target);
@@ -171,6 +192,7 @@ ModbusFetchTargets_Add(
 void
 ModbusFetchTargets_Clear(ModbusFetchTargets* me)
 {
+    // empty the groups keeping them for the next tick
     vector	devIDs = ModbusFetchTargets_GetDevIDs(me);
     ModbusFetchItemsPerDev*	aGroup;
 
@@ -179,8 +201,7 @@ ModbusFetchTargets_Clear(ModbusFetchTargets* me)
 
         vector_get_at(&devID, devIDs, i);
         if (dictionary_get(&aGroup, me->mTargetsDictByDevID, &devID)) {
-            ModbusFetchItemsPerDev_Destroy(aGroup);
+            vector_remove_all(aGroup->mFetchItems);
         }
     }
-    dictionary_clear(me->mTargetsDictByDevID);
 }
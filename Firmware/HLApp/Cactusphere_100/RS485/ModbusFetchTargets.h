@@ -42,8 +42,14 @@ extern vector	ModbusFetchTargets_GetFetchItems(
     ModbusFetchTargets* me, unsigned long devID);
 
 // Manage acquisition targets
+extern void	ModbusFetchTargets_Prepare(
+    ModbusFetchTargets* me, vector fetchItemPtrs);
 extern void	ModbusFetchTargets_Add(
     ModbusFetchTargets* me, const ModbusFetchItem* target);
 extern void	ModbusFetchTargets_Clear(ModbusFetchTargets* me);
+//
+// NOTE: ModbusFetchTargets_Clear() keeps the device groups made by
+//       ModbusFetchTargets_Prepare() with no items, and the device IDs of
+//       them are still returned by ModbusFetchTargets_GetDevIDs().
 
 #endif  // _MODBUS_FETCH_TARGETS_H_
@@ -32,6 +32,7 @@
 #include <applibs/log.h>
 
 #include "json.h"
+#include "JsonArena.h"
 #include "LibModbusTcp.h"
 #include "ModbusTcpFetchConfig.h"
 
@@ -58,10 +59,9 @@ ModbusTcpConfigMgr_Cleanup(void)
 
 // Apply new configuration
 void
-ModbusTcpConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
-    unsigned int payloadSize)
+ModbusTcpConfigMgr_LoadAndApplyIfChanged(json_value* jsonObj,
+    JsonArena* arena)
 {
-    json_value* jsonObj = json_parse(payload, payloadSize);
     json_value* desiredObj = NULL;
     json_value* modbusConfObj = NULL;
     json_value* telemetryConfObj = NULL;
@@ -79,9 +79,9 @@ ModbusTcpConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
 
     if (modbusConfObj != NULL) {
         modbusConfObj = json_GetKeyJson("value", modbusConfObj);
-        modbusConfObj = json_parse(modbusConfObj->u.string.ptr, modbusConfObj->u.string.length);
+        modbusConfObj = JsonArena_ParseString(arena, modbusConfObj);
         if (modbusConfObj != NULL) {
-            LibmodbusTcp_ModbusDevClear();
+            // keeps the devices of the same address and port
             if (!LibmodbusTcp_LoadFromJSON(modbusConfObj)) {
                 Log_Debug("ModbusTcpConfig LoadToJsonError!\n");
             }
@@ -93,7 +93,7 @@ ModbusTcpConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
 
     if (telemetryConfObj != NULL) {
         telemetryConfObj = json_GetKeyJson("value", telemetryConfObj);
-        telemetryConfObj = json_parse(telemetryConfObj->u.string.ptr, telemetryConfObj->u.string.length);
+        telemetryConfObj = JsonArena_ParseString(arena, telemetryConfObj);
         if (telemetryConfObj != NULL) {
             if (!ModbusTcpFetchConfig_LoadFromJSON(sModbusTcpConfigMgr.fetchConfig, telemetryConfObj, "1.0")) {
                 Log_Debug("ModbusTcpTelemetryConfig LoadToJsonError!\n");
@@ -27,6 +27,7 @@
 
 #include "ModbusTcpFetchConfig.h"
 
+typedef struct JsonArena	JsonArena;
 typedef struct ModbusTcpConfigMgr	ModbusTcpConfigMgr;
 
 // Initialization and cleanup
@@ -34,8 +35,11 @@ extern void	ModbusTcpConfigMgr_Initialize(void);
 extern void	ModbusTcpConfigMgr_Cleanup(void);
 
 // Apply new configuration
-extern void	ModbusTcpConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
-    unsigned int payloadSize);
+extern void	ModbusTcpConfigMgr_LoadAndApplyIfChanged(json_value* jsonObj,
+    JsonArena* arena);
+//
+// NOTE: jsonObj is the twin document parsed in arena, and the JSON text of
+//       the string-valued configurations in it is parsed in arena too.
 
 // Get configuratioin
 extern ModbusTcpFetchConfig*
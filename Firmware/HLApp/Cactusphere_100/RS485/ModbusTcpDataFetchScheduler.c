@@ -30,7 +30,6 @@
 #include "ModbusTcpDev.h"
 #include "ModbusTcpFetchItem.h"
 #include "ModbusTcpFetchTargets.h"
-#include "StringBuf.h"
 #include "TelemetryItems.h"
 
 typedef struct ModbusTcpDataFetchScheduler {
@@ -94,6 +93,8 @@ ModbusTcpDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
             if (modbusdev == NULL) {
                 continue;
             }
+            TelemetryItems_SetCaptureTime(me->mTelemetryItems,
+                TelemetryItems_GetTimeMs());
 
             for (int j = 0, m = vector_size(fetchItems); j < m; ++j) {
                 const ModbusTcpFetchItem* item = *fiCurs++;
@@ -116,7 +117,8 @@ ModbusTcpDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                         fVal /= item->devider;
                     }
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%f", fVal);
+                    TelemetryItems_AddFloat(me->mTelemetryItems,
+                        item->nameId, fVal);
                 }
                 else
                 {
@@ -130,12 +132,9 @@ ModbusTcpDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                         ulVal /= item->devider;
                     }
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%ld", ulVal);
+                    TelemetryItems_AddUInt32(me->mTelemetryItems,
+                        item->nameId, (uint32_t)ulVal);
                 }
-
-                TelemetryItems_Add(me->mTelemetryItems,
-                    item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-                StringBuf_Clear(me->mStringBuf);
             }
             LibmodbusTcp_Disconnect(modbusdev);
         }
@@ -52,7 +52,7 @@ ModbusTcpDev_Destroy(vector modbusDevVec) {
     ModbusTcpDev* modbusDev = vector_get_data(modbusDevVec);
     for (int i = 0, n = vector_size(modbusDevVec); i < n; ++i) {
         ModbusTCP_Destroy(modbusDev->ctx);
-        free(modbusDev);
+        modbusDev->ctx = NULL;
         modbusDev++;
     }
 }
@@ -63,6 +63,9 @@ ModbusTcpDev_NewModbusTCP(char* ip, int port) {
     ModbusTcpDev* newObj;
     
     newObj = (ModbusTcpDev*)malloc(sizeof(ModbusTcpDev));
+    if (newObj == NULL) {
+        return NULL;
+    }
     newObj->ctx = ModbusTCP_Initialize(ip, port);
 
     sprintf(newObj->id, "%s:%d", ip, port);
@@ -83,6 +86,12 @@ ModbusTcpDev_GetModbusDev(const char* id, vector modbusDevVec) {
     return NULL;
 }
 
+// Reconfiguration
+void
+ModbusTcpDev_Detach(ModbusTcpDev* me) {
+    me->ctx = NULL;
+}
+
 // Connect
 bool 
 ModbusTcpDev_Connect(ModbusTcpDev* me) {
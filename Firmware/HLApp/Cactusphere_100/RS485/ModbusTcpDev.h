@@ -34,6 +34,11 @@ typedef struct ModbusTcpDev ModbusTcpDev;
 // Initialization and cleanup
 extern vector ModbusTcpDev_Initialize(void);
 extern void ModbusTcpDev_Destroy(vector modbusDevVec);
+//
+// NOTE: ModbusTcpDev_Destroy() destroys the devices in the vector, and the
+//       vector is to be cleared then.  A device copied into another vector
+//       is to be detached from the original one, which then destroys
+//       nothing.
 
 // Create Modbus TCP 
 extern ModbusTcpDev* ModbusTcpDev_NewModbusTCP(char* ip, int port);
@@ -41,6 +46,9 @@ extern ModbusTcpDev* ModbusTcpDev_NewModbusTCP(char* ip, int port);
 // Get ModbusDev*
 extern ModbusTcpDev* ModbusTcpDev_GetModbusDev(const char* id, vector modbusTcpDevVec);
 
+// Reconfiguration
+extern void ModbusTcpDev_Detach(ModbusTcpDev* me);
+
 // Connect
 extern bool ModbusTcpDev_Connect(ModbusTcpDev* me);
 
@@ -123,6 +123,7 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
         pseudo.regAddr = 0;
         pseudo.offset = 0;
         pseudo.intervalSec = 1;
+        pseudo.intervalMs = 0;
         pseudo.multiplier = 0;
         pseudo.devider = 0;
         pseudo.asFloat = false;
@@ -199,7 +200,8 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, curs->asFloat);
+            curs->nameId = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, curs->asFloat);
             ++curs;
         }
 
@@ -26,12 +26,14 @@
 #define _MODBUS_TCP_FETCH_ITEM_H_
 
 #include <FetchItemBase.h>
+#include <TelemetryItems.h>
 
 #include <stdbool.h>
 
 typedef struct ModbusTcpFetchItem {
     char	    telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t	intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t	intervalMs;     // periodic acquisition interval (in milliseconds)
     char		ipAddr[16];	    // ip address
     uint32_t	port;			// port num
     uint32_t	unitID;         // unit id
@@ -40,6 +42,7 @@ typedef struct ModbusTcpFetchItem {
     uint32_t	multiplier;     // multiply value
     uint32_t	devider;        // divide value
     bool	    asFloat;        // true:float, false: not float 
+    TelemetryNameId	nameId;         // interned telemetry name
 } ModbusTcpFetchItem;
 
 #endif  // _MODBUS_FETCH_ITEM_H_
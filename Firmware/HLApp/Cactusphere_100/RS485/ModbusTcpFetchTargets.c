@@ -80,6 +80,12 @@ ModbusTcpFetchItemsPerDev_Add(
     vector_add_last(me->mFetchItems, (void*)&fetchItem);
 }
 
+static uint32_t
+ID_Hash(const void* const key)
+{
+    return dictionary_hash_string(key);
+}
+
 static int
 ID_Comparator(const void* const one, const void* const two)
 {
@@ -102,9 +108,9 @@ ModbusTcpFetchTargets_New(void)
         (ModbusTcpFetchTargets*)malloc(sizeof(ModbusTcpFetchTargets));
 
     if (NULL != newObj) {
-        newObj->mTargetsDictByDevID = dictionary_init(
+        newObj->mTargetsDictByDevID = dictionary_init_hash(
             MODBUS_TCP_ID_SIZE, sizeof(ModbusTcpFetchItemsPerDev*),
-            ID_Comparator);
+            ID_Hash, ID_Comparator);
         if (NULL == newObj->mTargetsDictByDevID) {
             free(newObj);
             return NULL;
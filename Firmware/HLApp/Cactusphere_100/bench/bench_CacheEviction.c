@@ -0,0 +1,348 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Outage simulation of the cache eviction policies
+//   A 12 hour network outage is cached into the compressed 50[KB] cache at
+//   a snapshot per second; 20 analog values (random walk), 4 counters and
+//   an alarm which fires every 15 minutes.  What the cache holds at the end
+//   is compared for each policy;
+//     span    : time from the oldest to the newest snapshot kept
+//     gap     : the longest time without a snapshot kept
+//     alarms  : alarm events kept of all the events
+//     counters: hours of the outage with a counter value kept
+//     error   : mean absolute error of an analog value over the whole
+//               outage, restored by holding the nearest value kept
+//     enqueue : mean and worst time of an enqueue
+// The same outage is also cached into the 64[KB] persistent store, which
+// has to refuse the policies it cannot apply (decimation and priorities)
+// and apply the rest.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TelemetryCacheStore.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define CACHE_BUF_SIZE	(50 * 1024)  // same as main.c
+#define STORE_SIZE  	(64 * 1024)  // same as main.c
+#define OUTAGE_SEC	(12 * 3600)
+#define NUM_ANALOGS	20
+#define NUM_COUNTERS	4
+#define ALARM_PERIOD_SEC	(15 * 60)
+#define NUM_ALARMS	(OUTAGE_SEC / ALARM_PERIOD_SEC)
+#define NUM_HOURS	(OUTAGE_SEC / 3600)
+
+typedef struct Policy {
+    const char*	name;
+    TelemetryCacheEviction	eviction;
+    uint8_t	counterPriority;
+    uint8_t	alarmPriority;
+    uint32_t	analogTtlSec;
+} Policy;
+
+typedef struct Result {
+    bool	isApplied;  // whether the cache accepted the whole policy
+    uint32_t	numFrames;
+    uint32_t	spanSec;
+    uint32_t	maxGapSec;
+    uint32_t	numAlarms;
+    uint32_t	numCounterHours;
+    double	meanError;
+    double	meanEnqueueUs;
+    double	maxEnqueueUs;
+} Result;
+
+static TelemetryNameId	sAnalogIds[NUM_ANALOGS];
+static TelemetryNameId	sCounterIds[NUM_COUNTERS];
+static TelemetryNameId	sAlarmId;
+static float	sTrace[OUTAGE_SEC];	// the first analog value of each second
+static float	sKept[OUTAGE_SEC];	// the value kept, or NAN
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t
+NextRandom(uint32_t* seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+static void
+SetupNames(void)
+{
+    char	name[16];
+
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < NUM_ANALOGS; ++i) {
+        snprintf(name, sizeof(name), "Analog%02d", i);
+        sAnalogIds[i] = TelemetryItems_AddDictionaryElem(name, true);
+    }
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+        snprintf(name, sizeof(name), "Counter%d", i);
+        sCounterIds[i] = TelemetryItems_AddDictionaryElem(name, false);
+    }
+    sAlarmId = TelemetryItems_AddDictionaryElem("Alarm", false);
+}
+
+static bool
+ApplyPolicy(TelemetryItemCache* cache, const Policy* policy)
+{
+    bool	isApplied = TelemetryItemCache_SetEviction(cache, policy->eviction);
+
+    for (int i = 0; i < NUM_ANALOGS; ++i) {
+        if (0 < policy->analogTtlSec) {
+            isApplied = TelemetryItemCache_SetItemPolicy(
+                cache, sAnalogIds[i], 0, policy->analogTtlSec) && isApplied;
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+        if (0 < policy->counterPriority) {
+            isApplied = TelemetryItemCache_SetItemPolicy(
+                cache, sCounterIds[i], policy->counterPriority, 0) && isApplied;
+        }
+    }
+    if (0 < policy->alarmPriority) {
+        isApplied = TelemetryItemCache_SetItemPolicy(
+            cache, sAlarmId, policy->alarmPriority, 0) && isApplied;
+    }
+
+    return isApplied;
+}
+
+static void
+Enqueue(TelemetryItemCache* cache, TelemetryItems* items, Result* result)
+{
+    // the same outage for every policy
+    float	analogs[NUM_ANALOGS];
+    uint32_t	seed = 1;
+    uint64_t	totalNs = 0, maxNs = 0;
+
+    for (int i = 0; i < NUM_ANALOGS; ++i) {
+        analogs[i] = 50.0f;
+    }
+    for (uint32_t t = 0; t < OUTAGE_SEC; ++t) {
+        uint64_t	startNs, elapsedNs;
+
+        TelemetryItems_Clear(items);
+        for (int i = 0; i < NUM_ANALOGS; ++i) {
+            analogs[i] += (float)((int)NextRandom(&seed) % 101 - 50) / 100.0f;
+            TelemetryItems_AddFloat(items, sAnalogIds[i], analogs[i]);
+        }
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            TelemetryItems_AddUInt32(items, sCounterIds[i], t * (uint32_t)(i + 1));
+        }
+        if (0 == (t + 1) % ALARM_PERIOD_SEC) {
+            TelemetryItems_AddBool(items, sAlarmId, true);
+        }
+        sTrace[t] = analogs[0];
+
+        startNs = NowNs();
+        TelemetryItemCache_EnqueueItems(cache, items, t);
+        elapsedNs = NowNs() - startNs;
+        totalNs += elapsedNs;
+        if (maxNs < elapsedNs) {
+            maxNs = elapsedNs;
+        }
+    }
+    result->meanEnqueueUs = (double)totalNs / OUTAGE_SEC / 1000.0;
+    result->maxEnqueueUs  = (double)maxNs / 1000.0;
+}
+
+static void
+Drain(TelemetryItemCache* cache, TelemetryItems* items, Result* result)
+{
+    bool	counterHours[NUM_HOURS] = { false };
+    uint32_t	ts, firstTs = 0, lastTs = 0;
+    float	held;
+    double	totalError = 0;
+    int	first = -1;
+
+    for (uint32_t t = 0; t < OUTAGE_SEC; ++t) {
+        sKept[t] = NAN;
+    }
+    while (TelemetryItemCache_DequeueItemsTo(cache, items, &ts)) {
+        if (0 == result->numFrames) {
+            firstTs = ts;
+        } else if (result->maxGapSec < ts - lastTs) {
+            result->maxGapSec = ts - lastTs;
+        }
+        lastTs = ts;
+        ++result->numFrames;
+        for (int i = 0, n = TelemetryItems_Count(items); i < n; ++i) {
+            TelemetryCacheElem	elem;
+
+            (void)TelemetryItems_ConvToCacheElemAt(items, i, &elem, NULL);
+            if (elem.nameId == sAnalogIds[0]) {
+                sKept[ts] = elem.value.f;
+            } else if (elem.nameId == sCounterIds[0]) {
+                counterHours[ts / 3600] = true;
+            } else if (elem.nameId == sAlarmId) {
+                ++result->numAlarms;
+            }
+        }
+    }
+    result->spanSec = lastTs - firstTs;
+    for (int h = 0; h < NUM_HOURS; ++h) {
+        result->numCounterHours += (counterHours[h] ? 1 : 0);
+    }
+
+    // hold the value kept last, or the first one before it
+    for (uint32_t t = 0; t < OUTAGE_SEC && first < 0; ++t) {
+        if (! isnan(sKept[t])) {
+            first = (int)t;
+        }
+    }
+    held = (0 <= first ? sKept[first] : 0.0f);
+    for (uint32_t t = 0; t < OUTAGE_SEC; ++t) {
+        if (! isnan(sKept[t])) {
+            held = sKept[t];
+        }
+        totalError += fabs((double)(sTrace[t] - held));
+    }
+    result->meanError = totalError / OUTAGE_SEC;
+}
+
+static Result
+Simulate(const Policy* policy, bool useStore)
+{
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    TelemetryItems*	items = TelemetryItems_New();
+    TelemetryCacheStore*	store = NULL;
+    char	path[] = "/tmp/bench_CacheEvictionXXXXXX";
+    int 	fd = -1;
+    Result	result;
+
+    memset(&result, 0, sizeof(result));
+    if (NULL == cache || NULL == items) {
+        fprintf(stderr, "setup failed\n");
+        exit(1);
+    }
+    if (useStore) {
+        fd    = mkstemp(path);
+        store = TelemetryCacheStore_New();
+        if (0 > fd || NULL == store
+        || ! TelemetryCacheStore_Open(store, fd, STORE_SIZE)) {
+            fprintf(stderr, "setup failed\n");
+            exit(1);
+        }
+        unlink(path);
+        TelemetryItemCache_AttachStore(cache, store);
+    } else if (! TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE)
+    || ! TelemetryItemCache_EnableCompression(cache, true)) {
+        fprintf(stderr, "setup failed\n");
+        exit(1);
+    }
+    result.isApplied = ApplyPolicy(cache, policy);
+    Enqueue(cache, items, &result);
+    Drain(cache, items, &result);
+
+    TelemetryItems_Destroy(items);
+    TelemetryItemCache_Destroy(cache);
+    if (NULL != store) {
+        TelemetryCacheStore_Destroy(store);
+        close(fd);
+    }
+
+    return result;
+}
+
+static void
+PrintResult(const char* backend, const Policy* policy, const Result* result)
+{
+    printf("%-6s %-18s %-7s %5u frames  span %5u s  gap %5u s  alarms %2u/%u"
+        "  counters %2u/%u h  error %6.2f  enqueue %5.1f us (max %7.1f us)\n",
+        backend, policy->name, result->isApplied ? "" : "refused",
+        result->numFrames, result->spanSec, result->maxGapSec,
+        result->numAlarms, NUM_ALARMS,
+        result->numCounterHours, NUM_HOURS, result->meanError,
+        result->meanEnqueueUs, result->maxEnqueueUs);
+}
+
+int
+main(void)
+{
+    static const Policy	sPolicies[] = {
+        { "dropOldest",        TelemetryCacheEviction_DropOldest, 0, 0, 0 },
+        { "ttl",               TelemetryCacheEviction_DropOldest, 1, 2, 300 },
+        { "priority",          TelemetryCacheEviction_DropOldest, 1, 2, 0 },
+        { "decimate",          TelemetryCacheEviction_Decimate,   0, 0, 0 },
+        { "decimate+priority", TelemetryCacheEviction_Decimate,   1, 2, 0 },
+        { "ttl only",          TelemetryCacheEviction_DropOldest, 0, 0, 300 },
+    };
+    enum { NUM_POLICIES = sizeof(sPolicies) / sizeof(sPolicies[0]) };
+    Result	results[NUM_POLICIES];
+    Result	storeResults[NUM_POLICIES];
+    int 	result = 0;
+
+    SetupNames();
+    for (int i = 0; i < NUM_POLICIES; ++i) {
+        results[i] = Simulate(&sPolicies[i], false);
+        PrintResult("memory", &sPolicies[i], &results[i]);
+    }
+    for (int i = 0; i < NUM_POLICIES; ++i) {
+        storeResults[i] = Simulate(&sPolicies[i], true);
+        PrintResult("store", &sPolicies[i], &storeResults[i]);
+    }
+    TelemetryItems_CleanupDictionary();
+
+    // the store applies dropping the oldest and the TTL, and refuses the
+    // others rather than accepting them with no effect
+    for (int i = 0; i < NUM_POLICIES; ++i) {
+        bool	isApplicable = (TelemetryCacheEviction_DropOldest
+            == sPolicies[i].eviction && 0 == sPolicies[i].counterPriority
+            && 0 == sPolicies[i].alarmPriority);
+
+        if (! results[i].isApplied) {
+            fprintf(stderr, "FAIL: %s is refused by the memory cache\n",
+                sPolicies[i].name);
+            result = 1;
+        } else if (storeResults[i].isApplied != isApplicable) {
+            fprintf(stderr, "FAIL: %s is %s by the store\n", sPolicies[i].name,
+                (isApplicable ? "refused" : "accepted"));
+            result = 1;
+        }
+    }
+
+    // decimation has to cover a longer time, and the priority has to keep
+    // more alarms than dropping the oldest
+    if (results[3].spanSec <= results[0].spanSec
+    || results[2].numAlarms <= results[0].numAlarms) {
+        fprintf(stderr, "FAIL: the eviction policy does not pay off\n");
+        result = 1;
+    }
+
+    return result;
+}
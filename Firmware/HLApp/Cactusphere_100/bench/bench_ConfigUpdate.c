@@ -0,0 +1,159 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Reconfiguration of a running scheduler, full vs differential
+//   8 slave devices x 30 registers, staggered as in bench_FetchPhase.  The
+//   interval of one register is changed CONFIG_DELAY_MS later, and the
+//   configuration is applied by DataFetchScheduler_Init() or
+//   DataFetchScheduler_Update().  The deadlines kept, the time to apply and
+//   the peak of items per run in the following 10 minutes are compared;
+//   the update has to keep the deadlines of all the other registers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DataFetchScheduler.h"
+#include "FetchTimers.h"
+#include "ModbusFetchItem.h"
+#include "ModbusStub.h"
+#include "TelemetryItems.h"
+
+#define NUM_DEVS	8
+#define ITEMS_PER_DEV	30
+#define FAST_ITEMS_PER_DEV	6
+#define NUM_ITEMS	(NUM_DEVS * ITEMS_PER_DEV)
+#define SIMULATED_MS	(10 * 60 * 1000)
+#define CHANGED_ITEM	0
+#define CONFIG_DELAY_MS	50
+
+static void
+GetDeadlines(DataFetchScheduler* scheduler, const ModbusFetchItem* items,
+    uint64_t* outDeadlines)
+{
+    // the heap is not in configuration order; index by the item
+    const FetchTimer*	timers =
+        (const FetchTimer*)vector_get_data(scheduler->mFetchTimers->mBody);
+
+    for (int i = 0, n = vector_size(scheduler->mFetchTimers->mBody); i < n; ++i) {
+        outDeadlines[(const ModbusFetchItem*)timers[i].fetchItem - items] =
+            timers[i].deadlineMs;
+    }
+}
+
+typedef struct ConfigUpdateResult {
+    int	numKept;            // deadlines kept by the reconfiguration
+    uint64_t	applyUs;    // time to apply the reconfiguration
+    DataFetchBusStats	stats;  // bus load after the reconfiguration
+} ConfigUpdateResult;
+
+static ConfigUpdateResult
+Reconfigure(DataFetchScheduler* scheduler, ModbusFetchItem* items,
+    vector fetchItemPtrs, bool isDifferential)
+{
+    static uint64_t	sBefore[NUM_ITEMS], sAfter[NUM_ITEMS];
+    static const struct timespec	sDelay = { 0, CONFIG_DELAY_MS * 1000000 };
+    ConfigUpdateResult	result;
+    uint64_t	startMs, nowMs, startUs;
+
+    // running configuration
+    items[CHANGED_ITEM].intervalSec = 10;
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        items[i].isChanged = true;
+    }
+    DataFetchScheduler_SetPhasePolicy(scheduler, FETCH_PHASE_STAGGERED);
+    DataFetchScheduler_Init(scheduler, fetchItemPtrs);
+    GetDeadlines(scheduler, items, sBefore);
+
+    // change the interval of a register a while later
+    nanosleep(&sDelay, NULL);
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        items[i].isChanged = false;
+    }
+    items[CHANGED_ITEM].intervalSec = 20;
+    items[CHANGED_ITEM].isChanged   = true;
+    startUs = ModbusStub_NowUs();
+    if (isDifferential) {
+        DataFetchScheduler_Update(scheduler, fetchItemPtrs);
+    } else {
+        DataFetchScheduler_Init(scheduler, fetchItemPtrs);
+    }
+    result.applyUs = ModbusStub_NowUs() - startUs;
+    GetDeadlines(scheduler, items, sAfter);
+
+    result.numKept = 0;
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        if (sBefore[i] == sAfter[i]) {
+            ++result.numKept;
+        }
+    }
+
+    // jump to each deadline as the rearmed fetch timer does
+    DataFetchScheduler_ResetBusStats(scheduler);
+    startMs = FetchTimers_GetTimeMs();
+    while (DataFetchScheduler_GetNextDeadline(scheduler, &nowMs)
+    && nowMs < startMs + SIMULATED_MS) {
+        DataFetchScheduler_Schedule(scheduler, nowMs);
+    }
+    result.stats = *DataFetchScheduler_GetBusStats(scheduler);
+
+    return result;
+}
+
+int
+main(void)
+{
+    static ModbusFetchItem	sFetchItems[NUM_ITEMS];
+    vector	fetchItemPtrs = vector_init(sizeof(ModbusFetchItem*));
+    DataFetchScheduler*	scheduler = Factory_CreateScheduler(MODBUS_RTU);
+    ConfigUpdateResult	results[2];
+
+    if (NULL == scheduler) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    ModbusStub_SetupFetchItems(sFetchItems,
+        NUM_DEVS, ITEMS_PER_DEV, FAST_ITEMS_PER_DEV, fetchItemPtrs);
+
+    for (int i = 0; i < 2; ++i) {
+        results[i] = Reconfigure(scheduler, sFetchItems, fetchItemPtrs, (1 == i));
+        printf("%s\tdeadlines kept %d/%d\tapply %llu us"
+            "\titems/run peak %u mean %.1f\n",
+            (1 == i) ? "update" : "init", results[i].numKept, NUM_ITEMS,
+            (unsigned long long)results[i].applyUs, results[i].stats.peakItems,
+            (double)results[i].stats.totalItems / results[i].stats.numRuns);
+    }
+
+    DataFetchScheduler_Destroy(scheduler);
+    vector_destroy(fetchItemPtrs);
+    TelemetryItems_CleanupDictionary();
+
+    if (results[1].numKept != NUM_ITEMS - 1) {
+        fprintf(stderr, "FAIL: the update restarts the unchanged timers\n");
+        return 1;
+    }
+
+    return 0;
+}
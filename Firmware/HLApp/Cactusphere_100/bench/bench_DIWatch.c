@@ -0,0 +1,243 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Report latency of the contact input edges, with stubbed LibDI
+//   Two contact inputs are watched, alone and together with a pulse
+//   counter of 60 s.  Edges come at random times over 10 minutes, and the
+//   main loop is simulated by jumping to the next deadline of the scheduler
+//   as the rearmed fetch timer does.  Each edge has to be reported within
+//   the contact input check interval of 1 s, as with the former 1 s tick;
+//   with no deadline the edges would never be reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DI_DataFetchScheduler.h"
+#include "DI_FetchItem.h"
+#include "DI_WatchItem.h"
+#include "FetchTimers.h"
+#include "LibDI.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define NUM_WATCHES	2
+#define SIMULATED_MS	(10 * 60 * 1000)
+#define NUM_EDGES	200
+#define MAX_LATENCY_MS	1000
+
+// LibDI stub; a pulse counter per pin, counted up by the simulated edges
+static unsigned long	sPulseCounts[NUM_DI];
+
+bool
+DI_Lib_ConfigPulseCounter(unsigned long pinId,
+    bool isPulseHigh, unsigned long minPulseWidth, unsigned long maxPulseCount)
+{
+    (void)isPulseHigh; (void)minPulseWidth; (void)maxPulseCount;
+    return (pinId < NUM_DI);
+}
+
+bool
+DI_Lib_ResetPulseCount(unsigned long pinId, unsigned long initVal)
+{
+    if (NUM_DI <= pinId) {
+        return false;
+    }
+    sPulseCounts[pinId] = initVal;
+    return true;
+}
+
+bool
+DI_Lib_ReadPulseCount(unsigned long pinId, unsigned long* outVal)
+{
+    if (NUM_DI <= pinId) {
+        return false;
+    }
+    *outVal = sPulseCounts[pinId];
+    return true;
+}
+
+bool
+DI_Lib_ReadPinLevel(unsigned long pinId, unsigned int* outVal)
+{
+    (void)pinId;
+    *outVal = 0;
+    return true;
+}
+
+typedef struct Edge {
+    uint64_t	timeMs;     // offset from the start
+    uint32_t	pinID;
+} Edge;
+
+static int
+Edge_Comparator(const void* lhs, const void* rhs)
+{
+    uint64_t	l = ((const Edge*)lhs)->timeMs;
+    uint64_t	r = ((const Edge*)rhs)->timeMs;
+
+    return (l < r) ? -1 : (l > r);
+}
+
+typedef struct WatchResult {
+    int 	numReported;    // edges reported
+    uint64_t	maxLatencyMs;   // longest time from an edge to its report
+    uint32_t	numRuns;        // scheduler runs
+} WatchResult;
+
+static WatchResult
+Simulate(DataFetchScheduler* scheduler, const DI_WatchItem* watchItems,
+    const Edge* edges)
+{
+    // jump to each deadline as the rearmed fetch timer does, counting up
+    // the pulse counters at the edges passed
+    uint64_t	pendingMs[NUM_DI] = { 0 };
+    bool	isPending[NUM_DI] = { false };
+    uint64_t	startMs = FetchTimers_GetTimeMs();
+    uint64_t	nowMs = startMs;
+    uint64_t	deadlineMs;
+    int 	nextEdge = 0;
+    WatchResult	result = { 0, 0, 0 };
+
+    while (DataFetchScheduler_GetNextDeadline(scheduler, &deadlineMs)
+    && nowMs < startMs + SIMULATED_MS) {
+        const TelemetryItems*	items;
+        TelemetryCacheElem	elem;
+        TelemetryValueType	type;
+
+        // the timer is armed at least 1 ms ahead
+        nowMs = (deadlineMs > nowMs) ? deadlineMs : nowMs + 1;
+
+        for (; nextEdge < NUM_EDGES
+        && startMs + edges[nextEdge].timeMs <= nowMs; ++nextEdge) {
+            uint32_t	pinID = edges[nextEdge].pinID;
+
+            ++sPulseCounts[pinID];
+            if (! isPending[pinID]) {
+                isPending[pinID] = true;
+                pendingMs[pinID] = startMs + edges[nextEdge].timeMs;
+            }
+        }
+        DataFetchScheduler_Schedule(scheduler, nowMs);
+        ++result.numRuns;
+
+        items = DataFetchScheduler_GetTelemetryItems(scheduler);
+        for (int i = 0, n = TelemetryItems_Count(items); i < n; ++i) {
+            TelemetryItems_ConvToCacheElemAt(items, i, &elem, &type);
+            for (int j = 0; j < NUM_WATCHES; ++j) {
+                uint32_t	pinID = watchItems[j].pinID;
+
+                if (elem.nameId == watchItems[j].nameId && isPending[pinID]) {
+                    if (result.maxLatencyMs < nowMs - pendingMs[pinID]) {
+                        result.maxLatencyMs = nowMs - pendingMs[pinID];
+                    }
+                    isPending[pinID] = false;
+                    ++result.numReported;
+                }
+            }
+        }
+    }
+    for (int j = 0; j < NUM_WATCHES; ++j) {
+        if (isPending[watchItems[j].pinID]) {
+            result.maxLatencyMs = UINT64_MAX;  // never reported
+        }
+    }
+
+    return result;
+}
+
+int
+main(void)
+{
+    static DI_FetchItem	sCounter;
+    DI_FetchItem*	counterPtr = &sCounter;
+    vector	watchItems = vector_init(sizeof(DI_WatchItem));
+    vector	noFetchItems = vector_init(sizeof(DI_FetchItem*));
+    vector	fetchItemPtrs = vector_init(sizeof(DI_FetchItem*));
+    DataFetchScheduler*	scheduler = Factory_CreateScheduler(DIGITAL_IN);
+    Edge	edges[NUM_EDGES];
+    int 	result = 0;
+
+    if (NULL == scheduler) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    TelemetryItems_InitDictionary();
+    for (uint32_t i = 0; i < NUM_WATCHES; ++i) {
+        DI_WatchItem	item;
+
+        memset(&item, 0, sizeof(item));
+        snprintf(item.telemetryName, sizeof(item.telemetryName),
+            "DI%u_Edge", i + 1);
+        item.pinID  = i;
+        item.nameId = TelemetryItems_AddDictionaryElem(item.telemetryName, false);
+        vector_add_last(watchItems, &item);
+    }
+    memset(&sCounter, 0, sizeof(sCounter));
+    snprintf(sCounter.telemetryName, sizeof(sCounter.telemetryName),
+        "DI%d_PulseCount", NUM_WATCHES + 1);
+    sCounter.intervalSec    = 60;
+    sCounter.pinID          = NUM_WATCHES;
+    sCounter.isPulseCounter = true;
+    sCounter.isCountClear   = true;
+    sCounter.nameId = TelemetryItems_AddDictionaryElem(sCounter.telemetryName, false);
+    vector_add_last(fetchItemPtrs, &counterPtr);
+
+    srand(1);
+    for (int i = 0; i < NUM_EDGES; ++i) {
+        edges[i].timeMs = (uint64_t)(rand() % (SIMULATED_MS - 2 * MAX_LATENCY_MS));
+        edges[i].pinID  = (uint32_t)(rand() % NUM_WATCHES);
+    }
+    qsort(edges, NUM_EDGES, sizeof(edges[0]), Edge_Comparator);
+
+    for (int i = 0; i < 2; ++i) {
+        WatchResult	watch;
+
+        DI_DataFetchScheduler_Init(scheduler,
+            (0 == i) ? noFetchItems : fetchItemPtrs, watchItems);
+        watch = Simulate(scheduler,
+            (const DI_WatchItem*)vector_get_data(watchItems), edges);
+        if (UINT64_MAX == watch.maxLatencyMs) {
+            printf("%s\tedges reported %d\tlatency max never\truns %u\n",
+                (0 == i) ? "watch only" : "watch+counter",
+                watch.numReported, watch.numRuns);
+        } else {
+            printf("%s\tedges reported %d\tlatency max %llu ms\truns %u\n",
+                (0 == i) ? "watch only" : "watch+counter", watch.numReported,
+                (unsigned long long)watch.maxLatencyMs, watch.numRuns);
+        }
+        if (0 == watch.numReported || MAX_LATENCY_MS < watch.maxLatencyMs) {
+            fprintf(stderr, "FAIL: the edges are reported late\n");
+            result = 1;
+        }
+    }
+
+    DataFetchScheduler_Destroy(scheduler);
+    vector_destroy(fetchItemPtrs);
+    vector_destroy(noFetchItems);
+    vector_destroy(watchItems);
+    TelemetryItems_CleanupDictionary();
+
+    return result;
+}
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Bus load simulation of the fetch timer phase policies
+//   8 slave devices x 30 registers; 24 registers of each device at 60[s]
+//   and 6 at 10[s].  The scheduler runs at each next deadline for 10
+//   minutes, and each register read busy-waits READ_COST_US (1/100 of a
+//   read at 9600[bps]) in the LibModbus stub.  The peak of items and bus
+//   time per run are compared; staggering has to lower the peak.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DataFetchScheduler.h"
+#include "ModbusFetchItem.h"
+#include "ModbusStub.h"
+#include "TelemetryItems.h"
+
+#define NUM_DEVS	8
+#define ITEMS_PER_DEV	30
+#define FAST_ITEMS_PER_DEV	6
+#define NUM_ITEMS	(NUM_DEVS * ITEMS_PER_DEV)
+#define SIMULATED_MS	(10 * 60 * 1000)
+#define READ_COST_US	200
+
+static DataFetchBusStats
+Simulate(DataFetchScheduler* scheduler, vector fetchItemPtrs,
+    FetchPhasePolicy policy)
+{
+    uint64_t	startMs, nowMs;
+
+    DataFetchScheduler_SetPhasePolicy(scheduler, policy);
+    DataFetchScheduler_Init(scheduler, fetchItemPtrs);
+    DataFetchScheduler_ResetBusStats(scheduler);
+    startMs = FetchTimers_GetTimeMs();
+
+    // jump to each deadline as the rearmed fetch timer does
+    while (DataFetchScheduler_GetNextDeadline(scheduler, &nowMs)
+    && nowMs < startMs + SIMULATED_MS) {
+        DataFetchScheduler_Schedule(scheduler, nowMs);
+    }
+
+    return *DataFetchScheduler_GetBusStats(scheduler);
+}
+
+int
+main(void)
+{
+    static const struct {
+        FetchPhasePolicy	policy;
+        const char*	name;
+    } sPolicies[] = {
+        { FETCH_PHASE_NONE,      "none" },
+        { FETCH_PHASE_ALIGNED,   "aligned" },
+        { FETCH_PHASE_STAGGERED, "staggered" },
+    };
+    static ModbusFetchItem	sFetchItems[NUM_ITEMS];
+    vector	fetchItemPtrs = vector_init(sizeof(ModbusFetchItem*));
+    DataFetchScheduler*	scheduler = Factory_CreateScheduler(MODBUS_RTU);
+    uint32_t	peakItems[3];
+
+    if (NULL == scheduler) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    ModbusStub_SetReadCost(READ_COST_US);
+    ModbusStub_SetupFetchItems(sFetchItems,
+        NUM_DEVS, ITEMS_PER_DEV, FAST_ITEMS_PER_DEV, fetchItemPtrs);
+
+    for (int i = 0; i < 3; ++i) {
+        DataFetchBusStats	stats =
+            Simulate(scheduler, fetchItemPtrs, sPolicies[i].policy);
+
+        printf("%s\t%u runs\titems/run peak %u mean %.1f"
+            "\tbus/run peak %u us mean %.0f us\n",
+            sPolicies[i].name, stats.numRuns, stats.peakItems,
+            (double)stats.totalItems / stats.numRuns,
+            stats.peakBusyUs, (double)stats.totalBusyUs / stats.numRuns);
+        peakItems[i] = stats.peakItems;
+    }
+
+    DataFetchScheduler_Destroy(scheduler);
+    vector_destroy(fetchItemPtrs);
+    TelemetryItems_CleanupDictionary();
+
+    if (peakItems[2] >= peakItems[0]) {
+        fprintf(stderr, "FAIL: staggering does not flatten the bus load\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Overhead of the pipeline metrics
+//   - each record call alone
+//   - the calls FetchTimerEventHandler() and LibCloud make in a tick
+//     (timestamps, counters, gauges and latencies of the tick, a
+//     scheduler, serialization and sending)
+// against the measured CPU time of the tick path without the metrics; 25
+// items filled in and serialized to JSON.  This ratio is dominated by the
+// five clock reads of a tick, which cost as much as a few items, and is
+// reported as is.
+// A tick on the device also waits for the Modbus transactions, which a host
+// cannot measure.  The test fails if the metrics take 1% or more of a tick
+// with the shortest transaction possible (a register read at the maximum
+// baud rate of LibModbus, with the 3.5 character gaps), i.e. the upper
+// bound of the overhead on a real bus.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Metrics.h"
+#include "TelemetryItems.h"
+
+#define ITEMS_PER_TICK	25
+#define CALL_ROUNDS	10000000
+#define TICK_ROUNDS	200000
+#define OVERHEAD_LIMIT	0.01
+
+// shortest Modbus RTU transaction; 8 bytes of request and 7 bytes of
+// response at 125200[bps] with 10 bits a character and the gap after each
+#define MAX_BAUDRATE	125200
+#define BUS_TRANSACTION_NS	\
+    ((8 + 7 + 2 * 3.5) * 10 * 1000000000.0 / MAX_BAUDRATE)
+
+static TelemetryNameId	sNameIds[ITEMS_PER_TICK];
+static volatile uint64_t	sSink;
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t
+CpuNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+SetupNames(void)
+{
+    char	name[24];
+
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        snprintf(name, sizeof(name), "Modbus_reg%02d", i);
+        sNameIds[i] = TelemetryItems_AddDictionaryElemOfType(
+            name, (TelemetryValueType)(i % 4));
+    }
+}
+
+// processor work of a tick without the metrics
+static size_t
+Tick(TelemetryItems* items, uint32_t round)
+{
+    TelemetryItems_Clear(items);
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        uint32_t	raw = round * 2654435761u + (uint32_t)i;
+
+        switch (i % 4) {
+        case TelemetryValueType_UInt32:
+            TelemetryItems_AddUInt32(items, sNameIds[i], raw);
+            break;
+        case TelemetryValueType_Int32:
+            TelemetryItems_AddInt32(items, sNameIds[i], (int32_t)raw);
+            break;
+        case TelemetryValueType_Float:
+            TelemetryItems_AddFloat(items, sNameIds[i],
+                (float)(raw % 100000) / 10.0f);
+            break;
+        case TelemetryValueType_Bool:
+            TelemetryItems_AddBool(items, sNameIds[i], 0 != (raw & 1));
+            break;
+        }
+    }
+
+    return strlen(TelemetryItems_ToJson(items));
+}
+
+// the metrics recorded in a tick with a scheduler and a message
+static void
+InstrumentTick(uint32_t round)
+{
+    uint64_t	tickStartUs = Metrics_GetTimeUs();
+    uint64_t	startUs = Metrics_GetTimeUs();
+
+    Metrics_RecordSince(MetricsLatency_Schedule, startUs);
+    Metrics_AddCount(MetricsCounter_ItemsAcquired, ITEMS_PER_TICK);
+    startUs = Metrics_GetTimeUs();
+    Metrics_RecordSince(MetricsLatency_Serialize, startUs);
+    Metrics_AddCount(MetricsCounter_MsgsSent, 1);
+    Metrics_RecordLatency(MetricsLatency_SendConfirm, 20000 + round % 1000);
+    Metrics_AddCount(MetricsCounter_Ticks, 1);
+    Metrics_SetGauge(MetricsGauge_CacheFrames, round % 100);
+    Metrics_SetGauge(MetricsGauge_InFlightMsgs, round % 4);
+    Metrics_SetGauge(MetricsGauge_SendWindow, 32);
+    Metrics_RecordSince(MetricsLatency_Tick, tickStartUs);
+}
+
+static double
+MeasureCall(int which)
+{
+    uint64_t	start = NowNs();
+
+    for (uint32_t i = 0; i < CALL_ROUNDS; ++i) {
+        switch (which) {
+        case 0:
+            sSink += Metrics_GetTimeUs();
+            break;
+        case 1:
+            Metrics_AddCount(MetricsCounter_Ticks, 1);
+            break;
+        case 2:
+            Metrics_SetGauge(MetricsGauge_CacheFrames, i & 0xff);
+            break;
+        case 3:
+            Metrics_RecordLatency(MetricsLatency_Tick, i & 0xfffff);
+            break;
+        }
+    }
+
+    return (double)(NowNs() - start) / CALL_ROUNDS;
+}
+
+int
+main(void)
+{
+    static const char*	CallNames[] = {
+        "Metrics_GetTimeUs", "Metrics_AddCount",
+        "Metrics_SetGauge", "Metrics_RecordLatency",
+    };
+    TelemetryItems*	items = TelemetryItems_New();
+    MetricsLatencyStats	stats;
+    uint64_t	start, tickNs, instrumentNs;
+    size_t	totalLen = 0;
+    double	ratio, cpuRatio;
+
+    SetupNames();
+    Metrics_Reset();
+
+    for (int i = 0; i < 4; ++i) {
+        printf("%s\t%.1f ns/op\n", CallNames[i], MeasureCall(i));
+    }
+    Metrics_Reset();
+
+    start = CpuNs();
+    for (uint32_t i = 0; i < TICK_ROUNDS; ++i) {
+        totalLen += Tick(items, i);
+    }
+    tickNs = CpuNs() - start;
+    start = CpuNs();
+    for (uint32_t i = 0; i < TICK_ROUNDS; ++i) {
+        InstrumentTick(i);
+    }
+    instrumentNs = CpuNs() - start;
+    sSink += totalLen;
+
+    cpuRatio = (double)instrumentNs / (double)tickNs;
+    ratio = (double)instrumentNs
+        / ((double)tickNs + BUS_TRANSACTION_NS * TICK_ROUNDS);
+    printf("tick (%d items, CPU time)\t%.1f ns/op\n",
+        ITEMS_PER_TICK, (double)tickNs / TICK_ROUNDS);
+    printf("metrics of a tick (CPU time)\t%.1f ns/op\t%.1f%% of the tick\n",
+        (double)instrumentNs / TICK_ROUNDS, cpuRatio * 100.0);
+    printf("tick with the shortest bus transaction\t%.1f ns/op"
+        "\tmetrics %.3f%%\n",
+        (double)tickNs / TICK_ROUNDS + BUS_TRANSACTION_NS, ratio * 100.0);
+
+    Metrics_GetLatencyStats(MetricsLatency_SendConfirm, &stats);
+    printf("%s\n", Metrics_ToJson("diagnostics"));
+
+    Metrics_Cleanup();
+    TelemetryItems_Destroy(items);
+    TelemetryItems_CleanupDictionary();
+
+    if (OVERHEAD_LIMIT <= ratio || TICK_ROUNDS != stats.count) {
+        fprintf(stderr, "FAIL: metrics overhead %.2f%% (limit %.0f%%)\n",
+            ratio * 100.0, OVERHEAD_LIMIT * 100.0);
+        return 1;
+    }
+
+    return 0;
+}
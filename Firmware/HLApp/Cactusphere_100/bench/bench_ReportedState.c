@@ -0,0 +1,248 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Reported state publishes of a connection and a twin update
+//   The versions and the EEPROM properties reported on authentication, and
+//   the responses of a twin update of NUM_TWIN_KEYS keys, are reported one
+//   publish per property as before and coalesced by ReportedState.  The
+//   publishes, the bytes sent and the CPU time to build them are compared;
+//   each coalesced patch has to be a JSON object of all the properties, and
+//   a patch which fails to be sent has to be kept for the next flush.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vector.h"
+#include "json.h"
+#include "LibCloud.h"
+#include "PropertyItems.h"
+#include "ReportedState.h"
+
+#define NUM_TWIN_KEYS	32
+#define NUM_ROUNDS	10000
+#define VALUE_MAX_LEN	64    // longest string value reported here
+
+// "{ \"<name>\": \"<value>\" }" of a property
+#define PROPERTY_STR_SIZE	(PROPERTY_NAME_MAX_LEN + VALUE_MAX_LEN + 16)
+
+// LibCloud stub; counts the reported state publishes
+static unsigned long	sNumPublishes;
+static unsigned long	sNumBytes;
+static bool	sIsPatchValid = true;
+static int	sNumExpected;   // properties of the patch to validate, if > 0
+static bool	sIsSendFailing;
+
+bool
+IoT_CentralLib_SendProperty(const char* jsonStr)
+{
+    if (sIsSendFailing) {
+        return false;
+    }
+    ++sNumPublishes;
+    sNumBytes += strlen(jsonStr);
+    if (0 < sNumExpected) {
+        json_value*	json = json_parse(jsonStr, strlen(jsonStr));
+
+        if (NULL == json || json_object != json->type ||
+            sNumExpected != (int)json->u.object.length) {
+            sIsPatchValid = false;
+        }
+        json_value_free(json);
+    }
+
+    return true;
+}
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static const char*	sConnectionProps[][2] = {
+    { "HLAppVersion", "2.1.0" },
+    { "RTAppVersion", "2.1.0" },
+    { "SerialNumber", "AT1234567890" },
+    { "EthMacAddr", "00:11:0C:12:34:56" },
+    { "ProductId", "0005" },
+    { "VendorId", "0001" },
+    { "WlanMacAddr", "00:11:0C:12:34:57" },
+    { "Generation", "1" },
+};
+#define NUM_CONNECTION_PROPS	\
+    (int)(sizeof(sConnectionProps) / sizeof(sConnectionProps[0]))
+
+static void
+SetupTwinResponse(ResponsePropertyItem* items)
+{
+    for (int i = 0; i < NUM_TWIN_KEYS; ++i) {
+        ResponsePropertyItem*	item = &items[i];
+
+        memset(item, 0, sizeof(*item));
+        switch (i % 3) {
+        case 0:
+            snprintf(item->propertyName, sizeof(item->propertyName),
+                "Modbus_dev%d_interval", i / 3 + 1);
+            item->type     = TYPE_NUM;
+            item->value.ul = 10;
+            break;
+        case 1:
+            snprintf(item->propertyName, sizeof(item->propertyName),
+                "Modbus_dev%d_enable", i / 3 + 1);
+            item->type    = TYPE_BOOL;
+            item->value.b = true;
+            break;
+        default:
+            snprintf(item->propertyName, sizeof(item->propertyName),
+                "Modbus_dev%d_map", i / 3 + 1);
+            item->type      = TYPE_STR;
+            item->value.str = "{\\\"reg\\\": 40001}";
+            break;
+        }
+    }
+}
+
+// one publish per property as SendPropertyResponse() used to do
+static void
+ReportEach(const ResponsePropertyItem* twinItems)
+{
+    char	propertyStr[PROPERTY_STR_SIZE];
+
+    for (int i = 0; i < NUM_CONNECTION_PROPS; ++i) {
+        snprintf(propertyStr, sizeof(propertyStr), "{ \"%s\": \"%.*s\" }",
+            sConnectionProps[i][0], VALUE_MAX_LEN, sConnectionProps[i][1]);
+        IoT_CentralLib_SendProperty(propertyStr);
+    }
+    for (int i = 0; i < NUM_TWIN_KEYS; ++i) {
+        const ResponsePropertyItem*	item = &twinItems[i];
+
+        switch (item->type) {
+        case TYPE_NUM:
+            snprintf(propertyStr, sizeof(propertyStr), "{ \"%.*s\": %u }",
+                PROPERTY_NAME_MAX_LEN, item->propertyName, item->value.ul);
+            break;
+        case TYPE_BOOL:
+            snprintf(propertyStr, sizeof(propertyStr), "{ \"%.*s\": %s }",
+                PROPERTY_NAME_MAX_LEN, item->propertyName,
+                item->value.b ? "true" : "false");
+            break;
+        default:
+            snprintf(propertyStr, sizeof(propertyStr), "{ \"%.*s\": \"%.*s\" }",
+                PROPERTY_NAME_MAX_LEN, item->propertyName,
+                VALUE_MAX_LEN, item->value.str);
+            break;
+        }
+        IoT_CentralLib_SendProperty(propertyStr);
+    }
+}
+
+// the connection and the twin update each flushed by the report timer
+static void
+ReportCoalesced(ReportedState* reported, vector twinItems, bool isValidated)
+{
+    for (int i = 0; i < NUM_CONNECTION_PROPS; ++i) {
+        ReportedState_SetString(
+            reported, sConnectionProps[i][0], sConnectionProps[i][1]);
+    }
+    sNumExpected = isValidated ? NUM_CONNECTION_PROPS : 0;
+    ReportedState_Flush(reported);
+
+    ReportedState_AddPropertyItems(reported, twinItems);
+    sNumExpected = isValidated ? NUM_TWIN_KEYS : 0;
+    ReportedState_Flush(reported);
+    sNumExpected = 0;
+}
+
+int
+main(void)
+{
+    static ResponsePropertyItem	sTwinItems[NUM_TWIN_KEYS];
+    vector	twinItems = vector_init(sizeof(ResponsePropertyItem));
+    ReportedState*	reported = ReportedState_New();
+    unsigned long	numPublishes[2], numBytes[2];
+    uint64_t	elapsedNs[2];
+    bool	isKept;
+
+    if (NULL == twinItems || NULL == reported) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    SetupTwinResponse(sTwinItems);
+    vector_add_last_multi(twinItems, sTwinItems, NUM_TWIN_KEYS);
+
+    for (int i = 0; i < 2; ++i) {
+        uint64_t	startNs;
+
+        sNumPublishes = sNumBytes = 0;
+        startNs = NowNs();
+        for (int j = 0; j < NUM_ROUNDS; ++j) {
+            if (0 == i) {
+                ReportEach(sTwinItems);
+            } else {
+                ReportCoalesced(reported, twinItems, (0 == j));
+            }
+        }
+        elapsedNs[i]    = NowNs() - startNs;
+        numPublishes[i] = sNumPublishes / NUM_ROUNDS;
+        numBytes[i]     = sNumBytes / NUM_ROUNDS;
+        printf("%s\tpublishes %lu\tbytes %lu\tbuild %.2f us\n",
+            (1 == i) ? "coalesced" : "each", numPublishes[i], numBytes[i],
+            (double)elapsedNs[i] / NUM_ROUNDS / 1000.0);
+    }
+
+    // a patch not handed over is kept, and sent whole by the next flush
+    ReportedState_AddPropertyItems(reported, twinItems);
+    sIsSendFailing = true;
+    isKept = ! ReportedState_Flush(reported) &&
+        ! ReportedState_IsEmpty(reported);
+    sIsSendFailing = false;
+    sNumExpected   = NUM_TWIN_KEYS;
+    isKept = isKept && ReportedState_Flush(reported) &&
+        ReportedState_IsEmpty(reported);
+    sNumExpected   = 0;
+
+    ReportedState_Destroy(reported);
+    vector_destroy(twinItems);
+
+    if (! sIsPatchValid) {
+        fprintf(stderr, "FAIL: a coalesced patch is not a JSON object "
+            "of all the properties\n");
+        return 1;
+    }
+    if (2 != numPublishes[1]) {
+        fprintf(stderr, "FAIL: the properties are not coalesced\n");
+        return 1;
+    }
+    if (! isKept) {
+        fprintf(stderr, "FAIL: the properties are dropped on a failed send\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Upload simulation of the send rate control
+//   Schedulers offer OFFERED_PER_SEC messages per second to a hub which
+//   confirms SERVICE_PER_SEC per second after BASE_RTT_MS.  A message which
+//   arrives while HUB_QUEUE_LIMIT messages are waiting is throttled and
+//   times out after TIMEOUT_MS, as IoT Hub does on its quota.  Messages
+//   which don't fit into the window are diverted to the cache and resent
+//   when the window opens.  The fixed window of 32 is compared with the
+//   AIMD window; the rate control has to avoid the timeouts and keep the
+//   round-trip time short.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SendRateControl.h"
+
+#define SIMULATED_MS	(10 * 60 * 1000)
+#define STEP_MS 	10
+#define OFFERED_PER_SEC	20
+#define SERVICE_PER_SEC	12
+#define BASE_RTT_MS	150
+#define HUB_QUEUE_LIMIT	16
+#define TIMEOUT_MS	4000
+#define WINDOW_MAX	32
+
+typedef struct InFlightMsg {
+    uint64_t	sentMs;     // time handed over
+    uint64_t	confirmMs;  // time to be confirmed
+    SendConfirm	result;
+} InFlightMsg;
+
+typedef struct SimResult {
+    uint32_t	delivered;
+    uint32_t	timeouts;
+    uint32_t	diverted;
+    uint32_t	backlog;    // messages left in the cache at the end
+    SendRateStats	stats;
+} SimResult;
+
+static void
+Simulate(bool useRateControl, SimResult* outResult)
+{
+    SendRateControl*	rateControl = SendRateControl_New();
+    InFlightMsg	inFlight[WINDOW_MAX];
+    uint32_t	numInFlight = 0;
+    uint32_t	cached = 0;
+    uint64_t	hubFreeMs = 0;  // time the hub finishes the queued messages
+    uint32_t	offerAcc = 0;
+
+    memset(outResult, 0, sizeof(*outResult));
+    SendRateControl_SetMaxWindow(rateControl, WINDOW_MAX);
+    for (uint64_t nowMs = 0; nowMs < SIMULATED_MS; nowMs += STEP_MS) {
+        uint32_t	window = (useRateControl
+            ? SendRateControl_GetWindow(rateControl) : WINDOW_MAX);
+        uint32_t	numOffered;
+
+        // confirmations
+        for (uint32_t i = 0; i < numInFlight; ) {
+            InFlightMsg*	msg = &inFlight[i];
+
+            if (msg->confirmMs > nowMs) {
+                ++i;
+                continue;
+            }
+            SendRateControl_OnConfirm(rateControl, msg->result,
+                (uint32_t)(nowMs - msg->sentMs), nowMs);
+            if (SendConfirm_OK == msg->result) {
+                ++outResult->delivered;
+            } else {
+                ++outResult->timeouts;
+                ++cached;  // put back to the cache
+            }
+            *msg = inFlight[--numInFlight];
+        }
+
+        // new messages, then the cached ones while the window is open
+        offerAcc  += OFFERED_PER_SEC * STEP_MS;
+        numOffered = offerAcc / 1000;
+        offerAcc  %= 1000;
+        cached    += numOffered;
+        while (0 < cached && numInFlight < window) {
+            InFlightMsg*	msg = &inFlight[numInFlight++];
+            uint64_t	queueMs = (hubFreeMs > nowMs ? hubFreeMs - nowMs : 0);
+
+            --cached;
+            msg->sentMs = nowMs;
+            if (queueMs * SERVICE_PER_SEC / 1000 >= HUB_QUEUE_LIMIT) {
+                msg->result    = SendConfirm_Timeout;
+                msg->confirmMs = nowMs + TIMEOUT_MS;
+            } else {
+                hubFreeMs = (hubFreeMs > nowMs ? hubFreeMs : nowMs)
+                    + 1000 / SERVICE_PER_SEC;
+                msg->result    = SendConfirm_OK;
+                msg->confirmMs = hubFreeMs + BASE_RTT_MS;
+            }
+        }
+        if (0 < cached && numOffered > 0) {
+            outResult->diverted += (cached < numOffered ? cached : numOffered);
+        }
+    }
+    outResult->backlog = cached;
+    SendRateControl_GetStats(rateControl, &outResult->stats);
+    if (! useRateControl) {
+        outResult->stats.window = WINDOW_MAX;
+    }
+    SendRateControl_Destroy(rateControl);
+}
+
+static void
+PrintResult(const char* label, const SimResult* result)
+{
+    printf("%s\tdelivered %u\ttimeouts %u\tdiverted %u\tbacklog %u\t"
+        "window %u\trtt p50 %u p90 %u p99 %u ms\n",
+        label, result->delivered, result->timeouts, result->diverted,
+        result->backlog, result->stats.window, result->stats.rttP50Ms,
+        result->stats.rttP90Ms, result->stats.rttP99Ms);
+}
+
+int
+main(void)
+{
+    SimResult	fixed;
+    SimResult	aimd;
+
+    Simulate(false, &fixed);
+    Simulate(true, &aimd);
+    PrintResult("fixed", &fixed);
+    PrintResult("aimd", &aimd);
+
+    return (aimd.timeouts < fixed.timeouts
+        && aimd.stats.rttP90Ms < fixed.stats.rttP90Ms ? 0 : 1);
+}
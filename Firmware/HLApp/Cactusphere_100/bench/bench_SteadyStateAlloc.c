@@ -0,0 +1,269 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Allocation counting test of the steady-state acquisition path
+//   ModbusDataFetchScheduler (with windowed aggregation and deadband on
+//   some items) -> TelemetryCollector -> JSON / binary frame,
+//   or the compressed cache while the network is down, and the resend
+// malloc() family is interposed to count the calls.  After the config is
+// applied and a warm-up period, no call is allowed in a tick; the test
+// fails otherwise.  LibCloud is replaced by the stub below and LibModbus by
+// stubs/ModbusStub.c, as the IoT SDK and the RS485 driver are not available
+// on the host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DataFetchScheduler.h"
+#include "LibCloud.h"
+#include "ModbusFetchItem.h"
+#include "ModbusStub.h"
+#include "TelemetryAggregator.h"
+#include "TelemetryCollector.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define NUM_DEVS	3
+#define ITEMS_PER_DEV	8
+#define NUM_ITEMS	(NUM_DEVS * ITEMS_PER_DEV)
+#define NETWORK_PERIOD	50	// ticks of each network up and down
+#define WARMUP_TICKS	(4 * NETWORK_PERIOD * 30)
+#define TEST_TICKS	(20 * NETWORK_PERIOD * 30)
+#define RESEND_MAX_NUM	10
+#define CACHE_BUF_SIZE	(50 * 1024)
+
+extern void*	__libc_malloc(size_t size);
+extern void*	__libc_calloc(size_t num, size_t size);
+extern void*	__libc_realloc(void* ptr, size_t size);
+extern void	__libc_free(void* ptr);
+
+static unsigned long	sNumAllocs = 0;
+
+void*
+malloc(size_t size)
+{
+    ++sNumAllocs;
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t num, size_t size)
+{
+    ++sNumAllocs;
+    return __libc_calloc(num, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    ++sNumAllocs;
+    return __libc_realloc(ptr, size);
+}
+
+void
+free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+// LibCloud stub; sends are serialized and framed as LibCloud does
+static TelemetryItemCache*	sCache;
+static TelemetryItems*	sResendItems;
+static unsigned char	sFrameBuf[(NUM_ITEMS * TelemetryAggregate_Num + 1) * 6];
+static uint32_t	sTick;
+static uint64_t	sStartMs;	// fetch timer origin, ticks advance it by 1[s]
+static unsigned long	sNumSent, sNumResent, sNumCached;
+
+bool
+IsAuthenticationDone(void)
+{
+    return true;
+}
+
+bool
+IoT_CentralLib_CheckConnection(void)
+{
+    return (0 == (sTick / NETWORK_PERIOD) % 2);
+}
+
+uint32_t
+IoT_CentralLib_GetTmeStamp(void)
+{
+    return sTick;
+}
+
+bool
+IoT_CentralLib_IsSendWindowFull(void)
+{
+    return false;
+}
+
+bool
+IoT_CentralLib_SendTelemetryItems(TelemetryItems* items,
+    uint32_t* outTimestamp)
+{
+    *outTimestamp = sTick;
+    if (NULL == TelemetryItems_ToJson(items)
+    || sizeof(sFrameBuf) < TelemetryItemCache_FrameSize(items)
+    || 0 == TelemetryItemCache_WriteFrame(items, sTick, sFrameBuf)) {
+        return false;
+    }
+    ++sNumSent;
+
+    return true;
+}
+
+bool
+IoT_CentralLib_EnqueueTelemtryItemsToCache(
+    const TelemetryItems* telemetryItems, uint32_t timeStamp)
+{
+    ++sNumCached;
+    return TelemetryItemCache_EnqueueItems(sCache, telemetryItems, timeStamp);
+}
+
+bool
+IoT_CentralLib_HasCachedTelemetryItems(void)
+{
+    return (! TelemetryItemCache_IsEmpty(sCache));
+}
+
+bool
+IoT_CentralLib_ResendCachedTelemetryItems(void)
+{
+    for (int i = 0; i < RESEND_MAX_NUM; ++i) {
+        uint32_t	timeStamp;
+
+        if (! TelemetryItemCache_DequeueItemsTo(sCache, sResendItems, &timeStamp)) {
+            break;
+        }
+        if (! IoT_CentralLib_SendTelemetryItems(sResendItems, &timeStamp)) {
+            return false;
+        }
+        ++sNumResent;
+    }
+
+    return true;
+}
+
+static void
+SetupFetchItems(ModbusFetchItem* items, vector fetchItemPtrs)
+{
+    static const uint32_t	sIntervals[] = { 1, 2, 3, 5 };
+
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        ModbusFetchItem*	item = &items[i];
+
+        memset(item, 0, sizeof(*item));
+        snprintf(item->telemetryName, sizeof(item->telemetryName),
+            "Modbus_dev%d_reg%02d", i / ITEMS_PER_DEV + 1, i % ITEMS_PER_DEV);
+        item->intervalSec = sIntervals[i % 4];
+        item->devID       = (uint32_t)(i / ITEMS_PER_DEV + 1);
+        item->regAddr     = (uint32_t)i;
+        item->regCount    = (uint32_t)(i % 2 + 1);
+        item->funcCode    = 3;
+        item->multiplier  = 1;
+        item->devider     = (0 == i % 3 ? 10 : 0);
+        item->asFloat     = (0 == i % 3);
+        if (0 == i % 5) {
+            item->filter.deadbandAbs = 1000.0f;
+            item->filter.maxSilenceSec = 10;
+        }
+        item->reportIntervalSec = (0 == i % 7 ? 10 : 0);
+        item->nameId      = TelemetryItems_AddDictionaryElem(
+            item->telemetryName, item->asFloat);
+        vector_add_last(fetchItemPtrs, &item);
+    }
+}
+
+static void
+Tick(DataFetchScheduler* scheduler, TelemetryCollector* collector)
+{
+    DataFetchScheduler_Schedule(scheduler,
+        sStartMs + (uint64_t)(sTick + 1) * 1000);
+    TelemetryCollector_AddItems(collector,
+        DataFetchScheduler_GetTelemetryItems(scheduler));
+    TelemetryCollector_Flush(collector);
+    ++sTick;
+}
+
+int
+main(void)
+{
+    static ModbusFetchItem	sFetchItems[NUM_ITEMS];
+    vector	fetchItemPtrs = vector_init(sizeof(ModbusFetchItem*));
+    DataFetchScheduler*	scheduler = Factory_CreateScheduler(MODBUS_RTU);
+    TelemetryCollector*	collector = TelemetryCollector_New();
+    unsigned long	numAllocs;
+
+    srand(1);
+    sCache       = TelemetryItemCache_New();
+    sResendItems = TelemetryItems_New();
+    if (NULL == scheduler || NULL == collector || NULL == sCache
+    || NULL == sResendItems
+    || ! TelemetryItemCache_Init(sCache, NULL, CACHE_BUF_SIZE)
+    || ! TelemetryItemCache_EnableCompression(sCache, true)) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    SetupFetchItems(sFetchItems, fetchItemPtrs);
+
+    numAllocs = sNumAllocs;
+    DataFetchScheduler_Init(scheduler, fetchItemPtrs);
+    sStartMs = FetchTimers_GetTimeMs();
+    printf("config load\t%lu allocs\n", sNumAllocs - numAllocs);
+
+    numAllocs = sNumAllocs;
+    for (int i = 0; i < WARMUP_TICKS; ++i) {
+        Tick(scheduler, collector);
+    }
+    printf("warm-up\t%lu allocs\t(%d ticks)\n",
+        sNumAllocs - numAllocs, WARMUP_TICKS);
+
+    numAllocs = sNumAllocs;
+    sNumSent = sNumResent = sNumCached = 0;
+    for (int i = 0; i < TEST_TICKS; ++i) {
+        Tick(scheduler, collector);
+    }
+    numAllocs = sNumAllocs - numAllocs;
+    printf("steady state\t%lu allocs\t(%d ticks; %lu sent, %lu cached, %lu resent)\n",
+        numAllocs, TEST_TICKS, sNumSent - sNumResent, sNumCached, sNumResent);
+    printf("allocs/tick\t%.3f\n", (double)numAllocs / TEST_TICKS);
+
+    TelemetryCollector_Destroy(collector);
+    DataFetchScheduler_Destroy(scheduler);
+    TelemetryItems_Destroy(sResendItems);
+    TelemetryItemCache_Destroy(sCache);
+    vector_destroy(fetchItemPtrs);
+    TelemetryItems_CleanupDictionary();
+
+    if (0 != numAllocs) {
+        fprintf(stderr, "FAIL: heap allocation in the steady state\n");
+        return 1;
+    }
+
+    return 0;
+}
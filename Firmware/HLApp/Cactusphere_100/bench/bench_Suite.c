@@ -0,0 +1,641 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Benchmark suite of the common/ data path
+//   telemetry items, the cache (raw and compressed), json_parse and key
+//   lookup, map, dictionary, StringBuf, vector and FetchTimers
+// with the workload of a large configuration; 500 telemetry items a tick
+// and a 50[KB] cache drained at once.  Each case prints a line of JSON;
+//   {"bench":"<name>","ops":<n>,"nsPerOp":<ns>,"allocsPerOp":<n>,"bytesPerOp":<n>}
+// allocsPerOp and bytesPerOp count the calls of the malloc() family and the
+// bytes requested by them, which are interposed below.  Only the timed
+// part of an op is counted.  A substring given as the argument selects the
+// cases to run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FetchTimers.h"
+#include "JsonArena.h"
+#include "StringBuf.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+#include "dictionary.h"
+#include "json.h"
+#include "map.h"
+#include "vector.h"
+
+#define NUM_ITEMS	500
+#define CACHE_BUF_SIZE	(50 * 1024)  // same as main.c
+#define CONFIG_ITEMS	100
+#define MIN_BENCH_NS	200000000ull  // run each case for at least 0.2[s]
+
+extern void*	__libc_malloc(size_t size);
+extern void*	__libc_calloc(size_t num, size_t size);
+extern void*	__libc_realloc(void* ptr, size_t size);
+
+static unsigned long	sNumAllocs = 0;
+static unsigned long	sNumBytes = 0;
+
+void*
+malloc(size_t size)
+{
+    ++sNumAllocs;
+    sNumBytes += size;
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t num, size_t size)
+{
+    ++sNumAllocs;
+    sNumBytes += num * size;
+    return __libc_calloc(num, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    ++sNumAllocs;
+    sNumBytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+// a benchmark case; prepare() is not timed, and may be NULL
+typedef struct BenchCase {
+    const char*	name;
+    void	(*setup)(void);
+    void	(*prepare)(uint32_t round);
+    void	(*run)(uint32_t round);
+    void	(*teardown)(void);
+} BenchCase;
+
+static char	sNames[NUM_ITEMS][24];
+static TelemetryNameId	sNameIds[NUM_ITEMS];
+static TelemetryItems*	sItems;
+static TelemetryItems*	sOutItems;
+static TelemetryItemCache*	sCache;
+static uint32_t	sTimeStamp;
+static char*	sConfigJson;
+static JsonArena*	sArena;
+static json_value*	sConfig;
+static char	sConfigKeys[CONFIG_ITEMS][32];
+static map	sMap;
+static dictionary	sDict;
+static StringBuf*	sStringBuf;
+static vector	sVector;
+static FetchTimers*	sFetchTimers;
+static FetchItemBase	sFetchItems[NUM_ITEMS];
+static uint64_t	sNowMs;
+static volatile uint64_t	sSink;
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+FillItems(TelemetryItems* items, uint32_t round)
+{
+    TelemetryItems_Clear(items);
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        uint32_t	raw = round * 2654435761u + (uint32_t)i * 40503u;
+
+        switch (i % 4) {
+        case TelemetryValueType_UInt32:
+            TelemetryItems_AddUInt32(items, sNameIds[i], raw & 0xffff);
+            break;
+        case TelemetryValueType_Int32:
+            TelemetryItems_AddInt32(items, sNameIds[i], (int32_t)(raw % 2000) - 1000);
+            break;
+        case TelemetryValueType_Float:
+            TelemetryItems_AddFloat(items, sNameIds[i], (float)(raw % 100000) / 10.0f);
+            break;
+        case TelemetryValueType_Bool:
+            TelemetryItems_AddBool(items, sNameIds[i], 0 != (raw & 0x100));
+            break;
+        }
+    }
+}
+
+// Telemetry items
+static void
+SetupItems(void)
+{
+    sItems    = TelemetryItems_New();
+    sOutItems = TelemetryItems_New();
+    FillItems(sItems, 0);
+}
+
+static void
+TeardownItems(void)
+{
+    TelemetryItems_Destroy(sOutItems);
+    TelemetryItems_Destroy(sItems);
+}
+
+static void
+RunFillItems(uint32_t round)
+{
+    FillItems(sItems, round);
+}
+
+static void
+RunToJson(uint32_t round)
+{
+    sSink += strlen(TelemetryItems_ToJson(sItems));
+}
+
+// Cache
+static void
+FillCache(void)
+{
+    // until the oldest snapshot is discarded to enqueue
+    uint32_t	numFrames;
+
+    do {
+        numFrames = TelemetryItemCache_CountFrames(sCache);
+        FillItems(sItems, sTimeStamp);
+        TelemetryItemCache_EnqueueItems(sCache, sItems, sTimeStamp++);
+    } while (numFrames < TelemetryItemCache_CountFrames(sCache));
+}
+
+static void
+SetupCache(bool compressed)
+{
+    SetupItems();
+    sCache = TelemetryItemCache_New();
+    TelemetryItemCache_Init(sCache, NULL, CACHE_BUF_SIZE);
+    TelemetryItemCache_EnableCompression(sCache, compressed);
+    sTimeStamp = 0;
+    FillCache();
+}
+
+static void
+SetupRawCache(void)
+{
+    SetupCache(false);
+}
+
+static void
+SetupCompressedCache(void)
+{
+    SetupCache(true);
+}
+
+static void
+TeardownCache(void)
+{
+    TelemetryItemCache_Destroy(sCache);
+    TeardownItems();
+}
+
+static void
+PrepareEnqueue(uint32_t round)
+{
+    FillItems(sItems, sTimeStamp);
+}
+
+static void
+RunEnqueue(uint32_t round)
+{
+    // into the full cache, which discards the oldest snapshot
+    TelemetryItemCache_EnqueueItems(sCache, sItems, sTimeStamp++);
+}
+
+static void
+PrepareDrain(uint32_t round)
+{
+    FillCache();
+}
+
+static void
+RunDrain(uint32_t round)
+{
+    uint32_t	ts;
+
+    while (TelemetryItemCache_DequeueItemsTo(sCache, sOutItems, &ts)) {
+        sSink += ts;
+    }
+}
+
+// json_parse
+static void
+SetupJson(void)
+{
+    StringBuf*	sb = StringBuf_New();
+
+    // desired properties of the Modbus configuration
+    StringBuf_Append(sb, "{\"ModbusTelemetryConfig\":{");
+    for (int i = 0; i < CONFIG_ITEMS; ++i) {
+        StringBuf_AppendByPrintf(sb,
+            "%s\"Modbus_dev%d_reg%03d\":{\"devID\":\"%d\",\"registerAddr\":\"0x%04x\","
+            "\"registerCount\":\"%d\",\"funcCode\":\"3\",\"interval\":\"%d\","
+            "\"multiply\":\"1\",\"devider\":\"10\",\"asFloat\":\"true\"}",
+            (0 < i ? "," : ""), i / 10 + 1, i, i / 10 + 1, i, i % 2 + 1, i % 5 + 1);
+    }
+    StringBuf_Append(sb, "},\"phasePolicy\":\"staggered\",\"$version\":12}");
+    sConfigJson = strdup(StringBuf_GetStr(sb));
+    StringBuf_Destroy(sb);
+}
+
+static void
+TeardownJson(void)
+{
+    free(sConfigJson);
+}
+
+static void
+SetupJsonArena(void)
+{
+    SetupJson();
+    sArena = JsonArena_New(8 * 1024);
+}
+
+static void
+TeardownJsonArena(void)
+{
+    JsonArena_Destroy(sArena);
+    TeardownJson();
+}
+
+static void
+RunJsonParse(uint32_t round)
+{
+    json_value*	json = json_parse(sConfigJson, strlen(sConfigJson));
+
+    sSink += json->u.object.length;
+    json_value_free(json);
+}
+
+static void
+RunJsonArenaParse(uint32_t round)
+{
+    json_value*	json = JsonArena_Parse(sArena, sConfigJson, strlen(sConfigJson));
+
+    sSink += json->u.object.length;
+    JsonArena_Reset(sArena);
+}
+
+// json_GetKeyJson of each item of the configuration
+static void
+SetupConfigKeys(void)
+{
+    for (int i = 0; i < CONFIG_ITEMS; ++i) {
+        snprintf(sConfigKeys[i], sizeof(sConfigKeys[i]),
+            "Modbus_dev%d_reg%03d", i / 10 + 1, i);
+    }
+}
+
+static void
+SetupJsonLookup(void)
+{
+    SetupJson();
+    SetupConfigKeys();
+    sConfig = json_parse(sConfigJson, strlen(sConfigJson));
+}
+
+static void
+TeardownJsonLookup(void)
+{
+    json_value_free(sConfig);
+    TeardownJson();
+}
+
+static void
+SetupJsonArenaLookup(void)
+{
+    SetupJsonArena();
+    SetupConfigKeys();
+    sConfig = JsonArena_Parse(sArena, sConfigJson, strlen(sConfigJson));
+}
+
+static void
+RunJsonLookup(uint32_t round)
+{
+    json_value*	config = json_GetKeyJson(
+        (unsigned char*)"ModbusTelemetryConfig", sConfig);
+
+    for (int i = 0; i < CONFIG_ITEMS; ++i) {
+        sSink += (uintptr_t)json_GetKeyJson(
+            (unsigned char*)sConfigKeys[i], config);
+    }
+}
+
+// map and dictionary
+static int
+CompareNames(const void* const one, const void* const two)
+{
+    return strcmp((const char*)one, (const char*)two);
+}
+
+static uint32_t
+HashName(const void* const key)
+{
+    return dictionary_hash_string((const char*)key);
+}
+
+static void
+SetupMap(void)
+{
+    sMap = map_init(sizeof(sNames[0]), sizeof(int), CompareNames);
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        map_put(sMap, sNames[i], &i);
+    }
+}
+
+static void
+TeardownMap(void)
+{
+    map_destroy(sMap);
+}
+
+static void
+RunMapGet(uint32_t round)
+{
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        int	value;
+
+        map_get(&value, sMap, sNames[i]);
+        sSink += (uint64_t)value;
+    }
+}
+
+static void
+RunMapPut(uint32_t round)
+{
+    map	m = map_init(sizeof(sNames[0]), sizeof(int), CompareNames);
+
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        map_put(m, sNames[i], &i);
+    }
+    map_destroy(m);
+}
+
+static void
+SetupDict(void)
+{
+    sDict = dictionary_init_hash(sizeof(sNames[0]), sizeof(int),
+        HashName, CompareNames);
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        dictionary_put(sDict, sNames[i], &i);
+    }
+}
+
+static void
+TeardownDict(void)
+{
+    dictionary_destroy(sDict);
+}
+
+static void
+RunDictGet(uint32_t round)
+{
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        int	value;
+
+        dictionary_get(&value, sDict, sNames[i]);
+        sSink += (uint64_t)value;
+    }
+}
+
+static void
+RunDictPut(uint32_t round)
+{
+    dictionary	d = dictionary_init_hash(sizeof(sNames[0]), sizeof(int),
+        HashName, CompareNames);
+
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        dictionary_put(d, sNames[i], &i);
+    }
+    dictionary_destroy(d);
+}
+
+// StringBuf and vector
+static void
+SetupStringBuf(void)
+{
+    sStringBuf = StringBuf_New();
+}
+
+static void
+TeardownStringBuf(void)
+{
+    StringBuf_Destroy(sStringBuf);
+}
+
+static void
+RunStringBuf(uint32_t round)
+{
+    // a JSON object of the items by printf, as the former serializer did
+    StringBuf_Clear(sStringBuf);
+    StringBuf_AppendChar(sStringBuf, '{');
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        StringBuf_AppendByPrintf(sStringBuf, "%s\"%s\":%lu",
+            (0 < i ? "," : ""), sNames[i], (unsigned long)(round + i));
+    }
+    StringBuf_AppendChar(sStringBuf, '}');
+    sSink += StringBuf_GetLength(sStringBuf);
+}
+
+static void
+SetupVector(void)
+{
+    sVector = vector_init(sizeof(TelemetryCacheElem));
+}
+
+static void
+TeardownVector(void)
+{
+    vector_destroy(sVector);
+}
+
+static void
+RunVector(uint32_t round)
+{
+    vector_remove_all(sVector);
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        TelemetryCacheElem	elem;
+
+        elem.nameId   = sNameIds[i];
+        elem.value.ul = round + (uint32_t)i;
+        vector_add_last(sVector, &elem);
+    }
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        TelemetryCacheElem	elem;
+
+        vector_get_at(&elem, sVector, i);
+        sSink += elem.value.ul;
+    }
+}
+
+// FetchTimers
+static void
+CountExpiration(void* arg, const FetchItemBase* fetchTarget)
+{
+    sSink += fetchTarget->intervalSec;
+}
+
+static void
+SetupFetchTimers(void)
+{
+    static const uint32_t	sIntervalsMs[] = { 100, 250, 500, 1000, 2000, 5000 };
+    vector	fetchItemPtrs = vector_init(sizeof(FetchItemBase*));
+
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        FetchItemBase*	item = &sFetchItems[i];
+
+        memset(item, 0, sizeof(*item));
+        snprintf(item->telemetryName, sizeof(item->telemetryName), "%.*s",
+            (int)sizeof(sNames[i]) - 1, sNames[i]);
+        item->intervalSec = 1;
+        item->intervalMs  = sIntervalsMs[i % 6];
+        vector_add_last(fetchItemPtrs, &item);
+    }
+    sFetchTimers = FetchTimers_New(CountExpiration, NULL);
+    FetchTimers_SetPhasePolicy(sFetchTimers, FETCH_PHASE_STAGGERED);
+    FetchTimers_Init(sFetchTimers, fetchItemPtrs);
+    vector_destroy(fetchItemPtrs);
+    sNowMs = FetchTimers_GetTimeMs();
+}
+
+static void
+TeardownFetchTimers(void)
+{
+    FetchTimers_Destroy(sFetchTimers);
+}
+
+static void
+RunFetchTimers(uint32_t round)
+{
+    // a tick of the fetch timer every 50[ms]
+    sNowMs += 50;
+    FetchTimers_UpdateTimers(sFetchTimers, sNowMs);
+}
+
+static const BenchCase	sCases[] = {
+    { "TelemetryItems_Add/500", SetupItems, NULL, RunFillItems, TeardownItems },
+    { "TelemetryItems_ToJson/500", SetupItems, NULL, RunToJson, TeardownItems },
+    { "TelemetryItemCache_EnqueueItems/500/full", SetupRawCache,
+        PrepareEnqueue, RunEnqueue, TeardownCache },
+    { "TelemetryItemCache_DequeueItemsTo/500/drain50KB", SetupRawCache,
+        PrepareDrain, RunDrain, TeardownCache },
+    { "TelemetryItemCache_EnqueueItems/500/full/compressed", SetupCompressedCache,
+        PrepareEnqueue, RunEnqueue, TeardownCache },
+    { "TelemetryItemCache_DequeueItemsTo/500/drain50KB/compressed",
+        SetupCompressedCache, PrepareDrain, RunDrain, TeardownCache },
+    { "json_parse/config100", SetupJson, NULL, RunJsonParse, TeardownJson },
+    { "JsonArena_Parse/config100", SetupJsonArena, NULL, RunJsonArenaParse,
+        TeardownJsonArena },
+    { "json_GetKeyJson/config100", SetupJsonLookup, NULL, RunJsonLookup,
+        TeardownJsonLookup },
+    { "json_GetKeyJson/config100/indexed", SetupJsonArenaLookup, NULL,
+        RunJsonLookup, TeardownJsonArena },
+    { "map_get/500", SetupMap, NULL, RunMapGet, TeardownMap },
+    { "map_put/500", NULL, NULL, RunMapPut, NULL },
+    { "dictionary_get/500", SetupDict, NULL, RunDictGet, TeardownDict },
+    { "dictionary_put/500", NULL, NULL, RunDictPut, NULL },
+    { "StringBuf_AppendByPrintf/500", SetupStringBuf, NULL, RunStringBuf,
+        TeardownStringBuf },
+    { "vector_add_last/500", SetupVector, NULL, RunVector, TeardownVector },
+    { "FetchTimers_UpdateTimers/500", SetupFetchTimers, NULL, RunFetchTimers,
+        TeardownFetchTimers },
+};
+
+static void
+RunCase(const BenchCase* bc)
+{
+    uint64_t	elapsed = 0;
+    unsigned long	numAllocs = 0, numBytes = 0;
+    uint32_t	ops = 0;
+
+    if (NULL != bc->setup) {
+        bc->setup();
+    }
+    if (NULL != bc->prepare) {
+        bc->prepare(0);
+    }
+    bc->run(0);  // warm-up
+
+    while (elapsed < MIN_BENCH_NS) {
+        // batches of ops between the clock reads, unless prepared each
+        uint32_t	batch = (NULL != bc->prepare ? 1 : 64);
+        unsigned long	allocs, bytes;
+        uint64_t	start;
+
+        if (NULL != bc->prepare) {
+            bc->prepare(ops + 1);
+        }
+        allocs = sNumAllocs;
+        bytes  = sNumBytes;
+        start  = NowNs();
+        for (uint32_t i = 0; i < batch; ++i) {
+            bc->run(ops + 1 + i);
+        }
+        elapsed   += NowNs() - start;
+        numAllocs += sNumAllocs - allocs;
+        numBytes  += sNumBytes - bytes;
+        ops       += batch;
+    }
+
+    if (NULL != bc->teardown) {
+        bc->teardown();
+    }
+
+    printf("{\"bench\":\"%s\",\"ops\":%u,\"nsPerOp\":%.1f,"
+        "\"allocsPerOp\":%.3f,\"bytesPerOp\":%.1f}\n",
+        bc->name, ops, (double)elapsed / ops,
+        (double)numAllocs / ops, (double)numBytes / ops);
+    fflush(stdout);
+}
+
+int
+main(int argc, char* argv[])
+{
+    const char*	filter = (1 < argc ? argv[1] : NULL);
+
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "Modbus_dev%d_reg%03d",
+            i / 25 + 1, i % 25);
+        sNameIds[i] = TelemetryItems_AddDictionaryElemOfType(
+            sNames[i], (TelemetryValueType)(i % 4));
+    }
+
+    for (size_t i = 0; i < sizeof(sCases) / sizeof(sCases[0]); ++i) {
+        if (NULL == filter || NULL != strstr(sCases[i].name, filter)) {
+            RunCase(&sCases[i]);
+        }
+    }
+
+    TelemetryItems_CleanupDictionary();
+
+    return 0;
+}
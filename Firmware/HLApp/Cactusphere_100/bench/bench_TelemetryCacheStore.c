@@ -0,0 +1,194 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Micro benchmark and recovery check of TelemetryCacheStore on a plain file
+//   - enqueue with the default sync policy
+//   - reopen and recover the frames
+//   - drain the recovered frames
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TelemetryCacheStore.h"
+#include "TelemetryItems.h"
+
+#define STORE_SIZE  	(64 * 1024)  // same as main.c
+#define ITEMS_PER_TICK	25
+#define NUM_FRAMES  	1000
+
+static char	sNames[ITEMS_PER_TICK][16];
+static TelemetryNameId	sNameIds[ITEMS_PER_TICK];
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+SetupItems(TelemetryItems* items)
+{
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "Reg%03d", i);
+        sNameIds[i] = TelemetryItems_AddDictionaryElem(sNames[i], (0 != (i & 1)));
+        if (i & 1) {
+            TelemetryItems_AddFloat(items, sNameIds[i], (float)(i * 10) + 0.5f);
+        } else {
+            TelemetryItems_AddUInt32(items, sNameIds[i], (uint32_t)(i * 10));
+        }
+    }
+}
+
+static TelemetryCacheStore*
+OpenStore(int fd)
+{
+    TelemetryCacheStore*	store = TelemetryCacheStore_New();
+
+    if (NULL == store || ! TelemetryCacheStore_Open(store, fd, STORE_SIZE)) {
+        fprintf(stderr, "cannot open the store\n");
+        exit(1);
+    }
+
+    return store;
+}
+
+int
+main(void)
+{
+    char	path[] = "/tmp/bench_TelemetryCacheStoreXXXXXX";
+    int 	fd = mkstemp(path);
+    TelemetryCacheStore*	store;
+    TelemetryItems*	items = TelemetryItems_New();
+    TelemetryItems*	outItems = TelemetryItems_New();
+    uint64_t	start, elapsed;
+    uint32_t	numSaved, numRecovered, numRead, ts;
+    int 	result = 0;
+
+    if (0 > fd) {
+        perror("mkstemp");
+        return 1;
+    }
+    SetupItems(items);
+
+    // enqueue (wraps around the store several times)
+    store = OpenStore(fd);
+    start = NowNs();
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i) {
+        TelemetryCacheStore_EnqueueItems(store, items, i);
+    }
+    elapsed = NowNs() - start;
+    printf("TelemetryCacheStore_EnqueueItems\t%.1f ns/op\n",
+        (double)elapsed / NUM_FRAMES);
+    numSaved = TelemetryCacheStore_CountFrames(store);
+    TelemetryCacheStore_Destroy(store);
+
+    // recover and read a half
+    start = NowNs();
+    store = OpenStore(fd);
+    elapsed = NowNs() - start;
+    numRecovered = TelemetryCacheStore_CountFrames(store);
+    printf("TelemetryCacheStore_Open(recover)\t%.1f ns/op\t(%u frames)\n",
+        (double)elapsed, numRecovered);
+    if (numSaved != numRecovered) {
+        printf("FAIL: %u frames saved, %u recovered\n", numSaved, numRecovered);
+        result = 1;
+    }
+    for (numRead = 0; numRead < numRecovered / 2; ++numRead) {
+        TelemetryCacheStore_DequeueItemsTo(store, outItems, &ts);
+        if (ts != NUM_FRAMES - numRecovered + numRead
+        || ITEMS_PER_TICK != TelemetryItems_Count(outItems)) {
+            printf("FAIL: unexpected frame %u (ts %u)\n", numRead, ts);
+            result = 1;
+            break;
+        }
+    }
+    TelemetryCacheStore_Destroy(store);
+
+    // recover the rest and drain
+    store = OpenStore(fd);
+    if (numRecovered - numRead != TelemetryCacheStore_CountFrames(store)) {
+        printf("FAIL: %u frames left, %u recovered\n",
+            numRecovered - numRead, TelemetryCacheStore_CountFrames(store));
+        result = 1;
+    }
+    numRead = 0;
+    start = NowNs();
+    while (TelemetryCacheStore_DequeueItemsTo(store, outItems, &ts)) {
+        ++numRead;
+    }
+    elapsed = NowNs() - start;
+    printf("TelemetryCacheStore_DequeueItemsTo(drain)\t%.1f ns/op\t(%u frames)\n",
+        (double)elapsed / (0 < numRead ? numRead : 1), numRead);
+    TelemetryCacheStore_Destroy(store);
+
+    // nothing is left after drained
+    store = OpenStore(fd);
+    if (! TelemetryCacheStore_IsEmpty(store)) {
+        printf("FAIL: %u frames left after drained\n",
+            TelemetryCacheStore_CountFrames(store));
+        result = 1;
+    }
+    TelemetryCacheStore_Destroy(store);
+
+    // capture times are restored after reopened
+    store = OpenStore(fd);
+    TelemetryItems_Clear(items);
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        TelemetryItems_SetCaptureTime(items, 1600000000000ull + (uint64_t)(i / 5) * 20);
+        TelemetryItems_AddUInt32(items, sNameIds[i & ~1], (uint32_t)i);
+    }
+    TelemetryCacheStore_EnqueueItems(store, items, 0);
+    TelemetryCacheStore_Sync(store);
+    TelemetryCacheStore_Destroy(store);
+    store = OpenStore(fd);
+    {
+        char	json[1024];
+
+        snprintf(json, sizeof(json), "%s", TelemetryItems_ToJson(items));
+        if (! TelemetryCacheStore_DequeueItemsTo(store, outItems, &ts)
+        || TelemetryItems_GetCaptureTime(items)
+            != TelemetryItems_GetCaptureTime(outItems)
+        || 0 != strcmp(json, TelemetryItems_ToJson(outItems))) {
+            printf("FAIL: capture times are not restored\n");
+            result = 1;
+        }
+    }
+    TelemetryCacheStore_Destroy(store);
+
+    close(fd);
+    unlink(path);
+    TelemetryItems_Destroy(outItems);
+    TelemetryItems_Destroy(items);
+    TelemetryItems_CleanupDictionary();
+
+    return result;
+}
@@ -0,0 +1,226 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Benchmark of the report-by-exception filter on telemetry traces
+// Without an argument, five synthetic 1[s] traces of a day are filtered
+// together, as the items of one scheduler:
+//   temperature  random walk in 0.1 steps      deadband 0.5, heartbeat 300[s]
+//   setpoint     hourly step changes           on change, heartbeat 600[s]
+//   pressure     1000 +/- noise                deadband 1[%], heartbeat 300[s]
+//   pulse count  counter with bursty rate      deadband 100, heartbeat 60[s]
+//   level        rare toggles (DI polling)     on change, heartbeat 300[s]
+// A recorded trace can be given as a file of one value per line (1[s]
+// period); it is filtered with several deadbands instead.
+// The samples saved and the CPU time per sample of TelemetryFilter_Apply()
+// are reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "TelemetryFilter.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define NUM_SAMPLES	86400
+#define NUM_TRACES	5
+#define MAX_TRACE_LEN	(1024 * 1024)
+
+typedef struct Trace {
+    const char*	name;
+    TelemetryFilterSpec	spec;
+    double*	values;
+    int	len;
+    TelemetryNameId	nameId;
+    unsigned long	numReported;
+} Trace;
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double
+Noise(double amplitude)
+{
+    return amplitude * ((double)rand() / RAND_MAX * 2.0 - 1.0);
+}
+
+static void
+MakeSyntheticTraces(Trace* traces)
+{
+    double	temperature = 20.0, setpoint = 50.0, count = 0.0;
+    bool	level = false;
+
+    for (int i = 0; i < NUM_TRACES; ++i) {
+        traces[i].values = (double*)malloc(sizeof(double) * NUM_SAMPLES);
+        traces[i].len    = NUM_SAMPLES;
+    }
+    for (int t = 0; t < NUM_SAMPLES; ++t) {
+        if (0 == rand() % 30) {
+            temperature += (rand() % 2) ? 0.1 : -0.1;
+        }
+        if (0 == t % 3600) {
+            setpoint = 40 + rand() % 20;
+        }
+        count += (0 == (t / 600) % 3) ? rand() % 10 : 0;
+        if (0 == rand() % 5000) {
+            level = ! level;
+        }
+        traces[0].values[t] = (double)(float)temperature;
+        traces[1].values[t] = setpoint;
+        traces[2].values[t] = (double)(float)(1000.0 + Noise(8.0));
+        traces[3].values[t] = count;
+        traces[4].values[t] = level ? 1.0 : 0.0;
+    }
+}
+
+static int
+LoadTrace(const char* path, double** outValues)
+{
+    FILE*	fp = fopen(path, "r");
+    double*	values;
+    int	len = 0;
+
+    if (NULL == fp) {
+        return 0;
+    }
+    values = (double*)malloc(sizeof(double) * MAX_TRACE_LEN);
+    while (len < MAX_TRACE_LEN && 1 == fscanf(fp, "%lf", &values[len])) {
+        ++len;
+    }
+    fclose(fp);
+    *outValues = values;
+
+    return len;
+}
+
+static void
+Run(Trace* traces, int numTraces)
+{
+    TelemetryFilter*	filter = TelemetryFilter_New();
+    TelemetryItems*	items = TelemetryItems_New();
+    int	len = traces[0].len;
+    uint64_t	elapsedNs = 0;
+    unsigned long	numSamples = 0, numReported = 0;
+
+    for (int i = 0; i < numTraces; ++i) {
+        char	name[32];
+
+        snprintf(name, sizeof(name), "trace%d", i);
+        traces[i].nameId = TelemetryItems_AddDictionaryElem(name, true);
+        traces[i].numReported = 0;
+        (void)TelemetryFilter_SetSpec(filter, traces[i].nameId, &traces[i].spec);
+    }
+    for (int t = 0; t < len; ++t) {
+        uint64_t	startNs;
+
+        TelemetryItems_Clear(items);
+        for (int i = 0; i < numTraces; ++i) {
+            TelemetryItems_AddFloat(items, traces[i].nameId,
+                (float)traces[i].values[t]);
+        }
+        startNs = NowNs();
+        TelemetryFilter_Apply(filter, items, (uint64_t)t * 1000);
+        elapsedNs += NowNs() - startNs;
+
+        for (int n = TelemetryItems_Count(items), k = 0; k < n; ++k) {
+            TelemetryCacheElem	elem;
+
+            TelemetryItems_ConvToCacheElemAt(items, k, &elem, NULL);
+            for (int i = 0; i < numTraces; ++i) {
+                if (traces[i].nameId == elem.nameId) {
+                    ++traces[i].numReported;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < numTraces; ++i) {
+        printf("%-12s\t%d samples\t%lu reported\t%.1f %% saved\n",
+            traces[i].name, len, traces[i].numReported,
+            100.0 * (len - traces[i].numReported) / len);
+        numSamples  += (unsigned long)len;
+        numReported += traces[i].numReported;
+    }
+    printf("total\t%lu samples\t%lu reported\t%.1f %% saved\t%.1f ns/sample\n",
+        numSamples, numReported,
+        100.0 * (numSamples - numReported) / numSamples,
+        (double)elapsedNs / numSamples);
+
+    TelemetryItems_Destroy(items);
+    TelemetryFilter_Destroy(filter);
+}
+
+int
+main(int argc, char* argv[])
+{
+    Trace	traces[NUM_TRACES] = {
+        { "temperature", { 0.5f, 0, 300 } },
+        { "setpoint",    { 0, 0, 600 } },
+        { "pressure",    { 0, 1.0f, 300 } },
+        { "pulse count", { 100.0f, 0, 60 } },
+        { "level",       { 0, 0, 300 } },
+    };
+
+    srand(1);
+    TelemetryItems_InitDictionary();
+    if (1 < argc) {
+        static const TelemetryFilterSpec	sSpecs[] = {
+            { 0, 0, 600 }, { 0, 0.5f, 600 }, { 0, 1.0f, 600 }, { 0, 5.0f, 600 },
+        };
+        static const char*	sNames[] = {
+            "on change", "0.5 %", "1 %", "5 %",
+        };
+        double*	values;
+        int	len = LoadTrace(argv[1], &values);
+
+        if (0 == len) {
+            fprintf(stderr, "can't load %s\n", argv[1]);
+            return 1;
+        }
+        for (int i = 0; i < 4; ++i) {
+            traces[i].name   = sNames[i];
+            traces[i].spec   = sSpecs[i];
+            traces[i].values = values;
+            traces[i].len    = len;
+        }
+        Run(traces, 4);
+        free(values);
+    } else {
+        MakeSyntheticTraces(traces);
+        Run(traces, NUM_TRACES);
+        for (int i = 0; i < NUM_TRACES; ++i) {
+            free(traces[i].values);
+        }
+    }
+    TelemetryItems_CleanupDictionary();
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Benchmark of TelemetryFrameCodec
+//   - compression ratio against the uncompressed cache slots
+//   - number of frames which the 50KB cache can hold
+//   - encode/decode throughput
+//
+// Usage: bench_TelemetryFrameCodec [recorded.csv]
+//   The CSV file has a header line "ts,<item name>,..." and lines of
+//   "<time stamp>,<value>,...".  Items whose values in the first line
+//   contain '.' are treated as float.  Without the file, a synthetic trace
+//   of DI counters/status and Modbus registers is used.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "TelemetryFrameCodec.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define CACHE_BUF_SIZE	(50 * 1024)  // same as main.c
+#define MAX_ITEMS   	64
+#define SYNTH_FRAMES	10000
+#define LINE_MAX_LEN	4096
+
+static char	sNames[MAX_ITEMS][33];
+static TelemetryNameId	sNameIds[MAX_ITEMS];
+static bool	sIsFloat[MAX_ITEMS];
+static int	sNumItems;
+static TelemetryItems**	sFrames;
+static uint32_t*	sTimeStamps;
+static int	sNumFrames;
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+AddFrame(uint32_t timeStamp, TelemetryItems* items)
+{
+    sFrames = realloc(sFrames, (sNumFrames + 1) * sizeof(*sFrames));
+    sTimeStamps = realloc(sTimeStamps, (sNumFrames + 1) * sizeof(*sTimeStamps));
+    sFrames[sNumFrames]     = items;
+    sTimeStamps[sNumFrames] = timeStamp;
+    ++sNumFrames;
+}
+
+static void
+MakeSyntheticTrace(void)
+{
+    // 8 DI pulse counters, 8 DI status, 6 Modbus analog registers (float)
+    // and 3 Modbus holding registers, sampled every second
+    uint32_t	counters[8] = { 0 };
+    int 	status[8] = { 0 };
+    double	analog[6] = { 20.0, 21.5, 50.0, 3.3, 100.0, 0.5 };
+
+    srand(1);
+    sNumItems = 25;
+    for (int i = 0; i < 8; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "DI%d_count", i + 1);
+        snprintf(sNames[8 + i], sizeof(sNames[8 + i]), "DI%d_status", i + 1);
+        sNameIds[i] = TelemetryItems_AddDictionaryElem(sNames[i], false);
+        sNameIds[8 + i] = TelemetryItems_AddDictionaryElem(sNames[8 + i], false);
+    }
+    for (int i = 0; i < 9; ++i) {
+        snprintf(sNames[16 + i], sizeof(sNames[16 + i]), "Modbus_reg%d", i + 1);
+        sNameIds[16 + i] = TelemetryItems_AddDictionaryElem(sNames[16 + i], (i < 6));
+    }
+
+    for (int f = 0; f < SYNTH_FRAMES; ++f) {
+        TelemetryItems*	items = TelemetryItems_New();
+
+        for (int i = 0; i < 8; ++i) {
+            counters[i] += (uint32_t)(rand() % (i + 2));
+            if (0 == rand() % 300) {
+                status[i] ^= 1;
+            }
+            TelemetryItems_AddUInt32(items, sNameIds[i], counters[i]);
+        }
+        for (int i = 0; i < 8; ++i) {
+            TelemetryItems_AddUInt32(items, sNameIds[8 + i], (uint32_t)status[i]);
+        }
+        for (int i = 0; i < 6; ++i) {
+            if (0 == rand() % 5) {
+                analog[i] += (rand() % 3 - 1) * 0.1;
+            }
+            TelemetryItems_AddFloat(items, sNameIds[16 + i], (float)analog[i]);
+        }
+        for (int i = 0; i < 3; ++i) {
+            TelemetryItems_AddUInt32(items,
+                sNameIds[22 + i], (uint32_t)(1000 * (i + 1)));
+        }
+        AddFrame((uint32_t)f, items);
+    }
+}
+
+static bool
+LoadRecordedTrace(const char* path)
+{
+    FILE*	fp = fopen(path, "r");
+    char	line[LINE_MAX_LEN];
+    char*	tok;
+
+    if (NULL == fp || NULL == fgets(line, sizeof(line), fp)) {
+        return false;
+    }
+    strtok(line, ",\r\n");  // "ts"
+    while (NULL != (tok = strtok(NULL, ",\r\n")) && sNumItems < MAX_ITEMS) {
+        snprintf(sNames[sNumItems++], sizeof(sNames[0]), "%s", tok);
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        TelemetryItems*	items;
+        uint32_t	timeStamp;
+
+        if (NULL == (tok = strtok(line, ",\r\n"))) {
+            continue;
+        }
+        timeStamp = (uint32_t)strtoul(tok, NULL, 10);
+        items = TelemetryItems_New();
+        for (int i = 0; i < sNumItems && NULL != (tok = strtok(NULL, ",\r\n")); ++i) {
+            if (0 == sNumFrames) {
+                sIsFloat[i] = (NULL != strchr(tok, '.'));
+                sNameIds[i] = TelemetryItems_AddDictionaryElem(sNames[i], sIsFloat[i]);
+            }
+            if (sIsFloat[i]) {
+                TelemetryItems_AddFloat(items, sNameIds[i], strtof(tok, NULL));
+            } else {
+                TelemetryItems_AddUInt32(items, sNameIds[i],
+                    (uint32_t)strtoul(tok, NULL, 10));
+            }
+        }
+        AddFrame(timeStamp, items);
+    }
+    fclose(fp);
+
+    return (0 < sNumFrames);
+}
+
+static uint32_t
+CountHoldableFrames(bool compressed)
+{
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    uint32_t	maxFrames = 0;
+
+    TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE);
+    TelemetryItemCache_EnableCompression(cache, compressed);
+    for (int f = 0; f < sNumFrames; ++f) {
+        TelemetryItemCache_EnqueueItems(cache, sFrames[f], sTimeStamps[f]);
+        if (maxFrames < TelemetryItemCache_CountFrames(cache)) {
+            maxFrames = TelemetryItemCache_CountFrames(cache);
+        }
+    }
+    TelemetryItemCache_Destroy(cache);
+
+    return maxFrames;
+}
+
+int
+main(int argc, char* argv[])
+{
+    TelemetryFrameCodec*	encoder = TelemetryFrameCodec_New();
+    TelemetryFrameCodec*	decoder = TelemetryFrameCodec_New();
+    TelemetryItems*	outItems = TelemetryItems_New();
+    uint32_t	bufSize = TelemetryFrameCodec_MaxEncodedSize(MAX_ITEMS);
+    unsigned char*	encoded;
+    uint32_t*	encLens;
+    uint64_t	start, encNs, decNs;
+    uint64_t	rawBytes = 0, encBytes = 0;
+    uint32_t	plainFrames, compFrames;
+
+    TelemetryItems_InitDictionary();
+    if (1 < argc) {
+        if (! LoadRecordedTrace(argv[1])) {
+            fprintf(stderr, "cannot load %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        MakeSyntheticTrace();
+    }
+    encoded = malloc((size_t)bufSize * sNumFrames);
+    encLens = malloc(sizeof(uint32_t) * sNumFrames);
+
+    start = NowNs();
+    for (int f = 0; f < sNumFrames; ++f) {
+        encLens[f] = TelemetryFrameCodec_Encode(encoder, sFrames[f],
+            sTimeStamps[f], encoded + (size_t)bufSize * f, bufSize);
+    }
+    encNs = NowNs() - start;
+
+    start = NowNs();
+    for (int f = 0; f < sNumFrames; ++f) {
+        uint32_t	timeStamp;
+
+        TelemetryFrameCodec_Decode(decoder, encoded + (size_t)bufSize * f,
+            encLens[f], outItems, &timeStamp);
+        if (timeStamp != sTimeStamps[f]
+        || TelemetryItems_Count(outItems) != TelemetryItems_Count(sFrames[f])) {
+            printf("FAIL: frame %d is not restored\n", f);
+            return 1;
+        }
+    }
+    decNs = NowNs() - start;
+
+    for (int f = 0; f < sNumFrames; ++f) {
+        rawBytes += (TelemetryItems_Count(sFrames[f]) + 2) * sizeof(TelemetryCacheElem);
+        encBytes += sizeof(uint16_t) + encLens[f];
+    }
+    plainFrames = CountHoldableFrames(false);
+    compFrames  = CountHoldableFrames(true);
+
+    printf("trace\t%d frames x %d items\n", sNumFrames, sNumItems);
+    printf("TelemetryFrameCodec ratio\t%.2f\t(%.1f -> %.1f bytes/frame)\n",
+        (double)rawBytes / encBytes,
+        (double)rawBytes / sNumFrames, (double)encBytes / sNumFrames);
+    printf("TelemetryFrameCodec_Encode\t%.1f ns/op\n", (double)encNs / sNumFrames);
+    printf("TelemetryFrameCodec_Decode\t%.1f ns/op\n", (double)decNs / sNumFrames);
+    printf("TelemetryItemCache frames in %d bytes\t%u -> %u\n",
+        CACHE_BUF_SIZE, plainFrames, compFrames);
+
+    for (int f = 0; f < sNumFrames; ++f) {
+        TelemetryItems_Destroy(sFrames[f]);
+    }
+    free(sFrames);
+    free(sTimeStamps);
+    free(encoded);
+    free(encLens);
+    TelemetryItems_Destroy(outItems);
+    TelemetryFrameCodec_Destroy(encoder);
+    TelemetryFrameCodec_Destroy(decoder);
+    TelemetryItems_CleanupDictionary();
+
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Micro benchmark of TelemetryItemCache at full occupancy
+//   - enqueue into a full cache (every enqueue evicts the oldest snapshot)
+//   - drain a full cache (dequeue every snapshot)
+//   - capture times of per-device reads: round trip and cache capacity
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define CACHE_BUF_SIZE	(50 * 1024)  // same as main.c
+#define ITEMS_PER_TICK	25
+#define EVICT_ROUNDS	20000
+#define CAPTURE_DEVICES	10
+#define CAPTURE_REGS	3
+#define CAPTURE_TICKS	20000
+
+static char	sNames[ITEMS_PER_TICK][16];
+static TelemetryNameId	sNameIds[ITEMS_PER_TICK];
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+SetupItems(TelemetryItems* items)
+{
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "Reg%03d", i);
+        sNameIds[i] = TelemetryItems_AddDictionaryElem(sNames[i], (0 != (i & 1)));
+        if (i & 1) {
+            TelemetryItems_AddFloat(items, sNameIds[i], (float)(i * 10) + 0.5f);
+        } else {
+            TelemetryItems_AddUInt32(items, sNameIds[i], (uint32_t)(i * 10));
+        }
+    }
+}
+
+static uint32_t
+FillCache(TelemetryItemCache* cache, const TelemetryItems* items)
+{
+    // enqueue as many snapshots as the buffer can hold
+    uint32_t	numFrames = (CACHE_BUF_SIZE / sizeof(TelemetryCacheElem))
+        / (uint32_t)(TelemetryItems_Count(items) + 2);
+    uint32_t	ts = 0;
+
+    while (ts < numFrames) {
+        TelemetryItemCache_EnqueueItems(cache, items, ts++);
+    }
+
+    return ts;
+}
+
+static TelemetryNameId	sRegIds[CAPTURE_DEVICES][CAPTURE_REGS];
+
+static void
+MakeDeviceReads(TelemetryItems* items, uint32_t tick, bool perDevice,
+    int skipDevice)
+{
+    // a tick of reads of the devices one after another, a few msec apart
+    uint64_t	tickMs = 1600000000000ull + (uint64_t)tick * 1000;
+
+    TelemetryItems_Clear(items);
+    for (int d = 0; d < CAPTURE_DEVICES; ++d) {
+        if (d == skipDevice) {
+            continue;
+        }
+        if (perDevice || 0 == d || skipDevice == d - 1) {
+            TelemetryItems_SetCaptureTime(items,
+                tickMs + (perDevice ? (uint64_t)(d * 12 + tick % 3) : 0));
+        }
+        for (int r = 0; r < CAPTURE_REGS; ++r) {
+            TelemetryItems_AddUInt32(items, sRegIds[d][r], tick + (uint32_t)r);
+        }
+    }
+}
+
+static bool
+IsSameFrame(TelemetryItems* expected, TelemetryItems* actual)
+{
+    char	json[2048];
+
+    snprintf(json, sizeof(json), "%s", TelemetryItems_ToJson(expected));
+    return TelemetryItems_GetCaptureTime(expected)
+        == TelemetryItems_GetCaptureTime(actual)
+        && 0 == strcmp(json, TelemetryItems_ToJson(actual));
+}
+
+static bool
+SkipDevice0(void* arg, TelemetryNameId nameId, double value)
+{
+    (void)arg;
+    (void)value;
+    for (int r = 0; r < CAPTURE_REGS; ++r) {
+        if (sRegIds[0][r] == nameId) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint32_t
+CountCaptureFrames(bool compressed, bool perDevice, TelemetryItems* items)
+{
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    uint32_t	numFrames;
+
+    TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE);
+    TelemetryItemCache_EnableCompression(cache, compressed);
+    for (uint32_t t = 0; t < CAPTURE_TICKS; ++t) {
+        MakeDeviceReads(items, t, perDevice, -1);
+        TelemetryItemCache_EnqueueItems(cache, items, t);
+    }
+    numFrames = TelemetryItemCache_CountFrames(cache);
+    TelemetryItemCache_Destroy(cache);
+
+    return numFrames;
+}
+
+static int
+CheckCaptureTime(void)
+{
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    TelemetryItems*	items = TelemetryItems_New();
+    TelemetryItems*	outItems = TelemetryItems_New();
+    unsigned char	frames[4096];
+    uint32_t	outTs, len = 0;
+
+    for (int d = 0; d < CAPTURE_DEVICES; ++d) {
+        for (int r = 0; r < CAPTURE_REGS; ++r) {
+            char	name[16];
+
+            snprintf(name, sizeof(name), "Dev%02d_r%d", d, r);
+            sRegIds[d][r] = TelemetryItems_AddDictionaryElem(name, false);
+        }
+    }
+
+    // round trip through the plain and the compressed ring and the frames
+    TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE);
+    for (int compressed = 0; compressed < 2; ++compressed) {
+        TelemetryItemCache_EnableCompression(cache, (0 != compressed));
+        for (uint32_t t = 0; t < 3; ++t) {
+            MakeDeviceReads(items, t, true, -1);
+            TelemetryItemCache_EnqueueItems(cache, items, t);
+        }
+        for (uint32_t t = 0; t < 3; ++t) {
+            MakeDeviceReads(items, t, true, -1);
+            if (! TelemetryItemCache_DequeueItemsTo(cache, outItems, &outTs)
+            || ! IsSameFrame(items, outItems)) {
+                fprintf(stderr, "capture time is not restored\n");
+                return 1;
+            }
+            len += TelemetryItemCache_WriteFrame(outItems, outTs, frames + len);
+        }
+    }
+    TelemetryItemCache_EnqueueFrames(cache, frames, len);
+    for (uint32_t t = 0; t < 6; ++t) {
+        MakeDeviceReads(items, t % 3, true, -1);
+        if (! TelemetryItemCache_DequeueItemsTo(cache, outItems, &outTs)
+        || ! IsSameFrame(items, outItems)) {
+            fprintf(stderr, "capture time is not restored from frames\n");
+            return 1;
+        }
+    }
+
+    // retain rebases the marks on the first value left
+    MakeDeviceReads(items, 1, true, -1);
+    TelemetryItems_Retain(items, SkipDevice0, NULL);
+    MakeDeviceReads(outItems, 1, true, 0);
+    if (! IsSameFrame(outItems, items)) {
+        fprintf(stderr, "capture time is broken by retain\n");
+        return 1;
+    }
+
+    printf("capture marks of %d devices x %d registers\t%d items\n",
+        CAPTURE_DEVICES, CAPTURE_REGS,
+        (MakeDeviceReads(items, 0, true, -1), TelemetryItems_Count(items)));
+    printf("TelemetryItemCache frames(plain)\t%u -> %u (per-device capture)\n",
+        CountCaptureFrames(false, false, items),
+        CountCaptureFrames(false, true, items));
+    printf("TelemetryItemCache frames(compressed)\t%u -> %u (per-device capture)\n",
+        CountCaptureFrames(true, false, items),
+        CountCaptureFrames(true, true, items));
+
+    TelemetryItems_Destroy(outItems);
+    TelemetryItems_Destroy(items);
+    TelemetryItemCache_Destroy(cache);
+
+    return 0;
+}
+
+int
+main(void)
+{
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    TelemetryItems*	items = TelemetryItems_New();
+    TelemetryItems*	outItems = TelemetryItems_New();
+    uint64_t	start, elapsed;
+    uint32_t	ts, frames;
+
+    SetupItems(items);
+    TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE);
+
+    // enqueue into a full cache
+    ts = FillCache(cache, items);
+    start = NowNs();
+    for (int i = 0; i < EVICT_ROUNDS; ++i) {
+        TelemetryItemCache_EnqueueItems(cache, items, ts++);
+    }
+    elapsed = NowNs() - start;
+    printf("TelemetryItemCache_EnqueueItems(full)\t%.1f ns/op\n",
+        (double)elapsed / EVICT_ROUNDS);
+
+    // drain a full cache
+    frames  = 0;
+    elapsed = 0;
+    for (int round = 0; round < 20; ++round) {
+        uint32_t	outTs;
+
+        FillCache(cache, items);
+        start = NowNs();
+        while (TelemetryItemCache_DequeueItemsTo(cache, outItems, &outTs)) {
+            ++frames;
+        }
+        elapsed += NowNs() - start;
+    }
+    printf("TelemetryItemCache_DequeueItemsTo(drain)\t%.1f ns/op\t(%u frames)\n",
+        (double)elapsed / frames, frames / 20);
+
+    // cached frames must survive reconfiguration of the telemetry items
+    FillCache(cache, items);
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        char	name[16];
+
+        TelemetryItems_RemoveDictionaryElem(sNames[i]);
+        snprintf(name, sizeof(name), "%s", sNames[i]);
+        memset(sNames[i], 0, sizeof(sNames[i]));
+        if (sNameIds[i] != TelemetryItems_AddDictionaryElem(name, (0 != (i & 1)))) {
+            fprintf(stderr, "name ID has changed\n");
+            return 1;
+        }
+        snprintf(sNames[i], sizeof(sNames[i]), "%s", name);
+    }
+    {
+        uint32_t	outTs;
+        char	json[1024];
+
+        snprintf(json, sizeof(json), "%s", TelemetryItems_ToJson(items));
+        while (TelemetryItemCache_DequeueItemsTo(cache, outItems, &outTs)) {
+            if (0 != strcmp(json, TelemetryItems_ToJson(outItems))) {
+                fprintf(stderr, "cached frame is broken\n");
+                return 1;
+            }
+        }
+    }
+    printf("TelemetryCacheElem size\t%zu bytes\n", sizeof(TelemetryCacheElem));
+    if (0 != CheckCaptureTime()) {
+        return 1;
+    }
+
+    TelemetryItems_Destroy(outItems);
+    TelemetryItems_Destroy(items);
+    TelemetryItemCache_Destroy(cache);
+    TelemetryItems_CleanupDictionary();
+
+    return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Micro benchmark of telemetry JSON serialization
+//   - before: StringBuf with a vsnprintf per item (the former
+//     TelemetryItems_ToJson)
+//   - after: TelemetryItems_ToJson with the precompiled key skeleton
+// Both outputs are compared on random values before measuring.  Double
+// values are compared with "%f" of the double, also after a round trip
+// through the cache, the compressed cache and the store.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "StringBuf.h"
+#include "TelemetryCacheStore.h"
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define ITEMS_PER_TICK	25
+#define VERIFY_ROUNDS	200000
+#define BENCH_ROUNDS	200000
+#define CACHE_BUF_SIZE	(50 * 1024)  // same as main.c
+#define STORE_SIZE  	(64 * 1024)  // same as main.c
+
+// 32-bit register values and multiplier/divider results
+static const double	sDoubles[] = {
+    16777217.0, 123456.789, 4294967295.0 * 0.001, 4294967295.0, 0.1,
+    -2147483648.0 / 3.0, -0.000001, 1e20 / 7.0, 3.5, 0.0, 23.4, 123.45
+};
+#define NUM_DOUBLES	(sizeof(sDoubles) / sizeof(sDoubles[0]))
+
+static char	sDoubleNames[NUM_DOUBLES][24];
+static TelemetryNameId	sDoubleNameIds[NUM_DOUBLES];
+
+static char	sNames[ITEMS_PER_TICK][24];
+static TelemetryNameId	sNameIds[ITEMS_PER_TICK];
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t
+Random32(void)
+{
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void
+SetupNames(void)
+{
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "Modbus_reg%02d", i);
+        sNameIds[i] = TelemetryItems_AddDictionaryElemOfType(
+            sNames[i], (TelemetryValueType)(i % 4));
+    }
+    for (size_t i = 0; i < NUM_DOUBLES; ++i) {
+        snprintf(sDoubleNames[i], sizeof(sDoubleNames[i]), "Modbus_dbl%02zu", i);
+        sDoubleNameIds[i] = TelemetryItems_AddDictionaryElemOfType(
+            sDoubleNames[i], TelemetryValueType_Float);
+    }
+}
+
+static void
+FillItems(TelemetryItems* items, bool randomBits)
+{
+    TelemetryItems_Clear(items);
+    for (int i = 0; i < ITEMS_PER_TICK; ++i) {
+        uint32_t	raw = Random32();
+        float	f;
+
+        switch (i % 4) {
+        case TelemetryValueType_UInt32:
+            TelemetryItems_AddUInt32(items, sNameIds[i], raw);
+            break;
+        case TelemetryValueType_Int32:
+            TelemetryItems_AddInt32(items, sNameIds[i], (int32_t)raw);
+            break;
+        case TelemetryValueType_Float:
+            if (randomBits) {
+                memcpy(&f, &raw, sizeof(f));  // any float including inf/nan
+            } else {
+                f = (float)(raw % 100000) / 10.0f;
+            }
+            TelemetryItems_AddFloat(items, sNameIds[i], f);
+            break;
+        case TelemetryValueType_Bool:
+            TelemetryItems_AddBool(items, sNameIds[i], 0 != (raw & 1));
+            break;
+        }
+    }
+}
+
+static const char*
+StringBufToJson(StringBuf* sb, const TelemetryItems* items)
+{
+    StringBuf_Clear(sb);
+    StringBuf_AppendChar(sb, '{');
+    for (int i = 0, n = TelemetryItems_Count(items); i < n; i++) {
+        TelemetryCacheElem	elem;
+        TelemetryValueType	type;
+        const char*	name;
+
+        TelemetryItems_ConvToCacheElemAt(items, i, &elem, &type);
+        name = TelemetryItems_GetName(elem.nameId);
+        switch (type) {
+        case TelemetryValueType_UInt32:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%lu",
+                name, (unsigned long)elem.value.ul);
+            break;
+        case TelemetryValueType_Int32:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%ld",
+                name, (long)(int32_t)elem.value.ul);
+            break;
+        case TelemetryValueType_Float:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%f",
+                name, (double)elem.value.f);
+            break;
+        case TelemetryValueType_Bool:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%s",
+                name, elem.value.ul ? "true" : "false");
+            break;
+        }
+        if (n - 1 > i) {
+            StringBuf_AppendChar(sb, ',');
+        }
+    }
+    StringBuf_AppendChar(sb, '}');
+
+    return StringBuf_GetStr(sb);
+}
+
+static bool
+PassAll(void* arg, TelemetryNameId nameId, double value)
+{
+    (void)arg; (void)nameId; (void)value;
+    return true;
+}
+
+static bool
+CheckDoubles(const char* what, TelemetryItems* items, const char* expected)
+{
+    const char*	json = TelemetryItems_ToJson(items);
+
+    if (0 != strcmp(json, expected)) {
+        fprintf(stderr, "%s differs:\n%s\n%s\n", what, json, expected);
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+RoundTripCache(TelemetryItemCache* cache, const TelemetryItems* items,
+    TelemetryItems* outItems)
+{
+    uint32_t	ts;
+
+    return TelemetryItemCache_EnqueueItems(cache, items, 1)
+        && TelemetryItemCache_DequeueItemsTo(cache, outItems, &ts);
+}
+
+static bool
+IsSameFloatText(double value)
+{
+    char	fText[64], dText[64];
+
+    snprintf(fText, sizeof(fText), "%f", (double)(float)value);
+    snprintf(dText, sizeof(dText), "%f", value);
+
+    return 0 == strcmp(fText, dText);
+}
+
+static bool
+VerifyRandomDoubles(void)
+{
+    // register values times scale factors, and random bits
+    TelemetryItems*	items = TelemetryItems_New();
+    int 	numSplit = 0;
+    bool	result = true;
+
+    for (int i = 0; i < VERIFY_ROUNDS && result; ++i) {
+        uint64_t	bits = ((uint64_t)Random32() << 32) | Random32();
+        double	value;
+        char	expected[128];
+
+        if (0 != (i & 1)) {
+            memcpy(&value, &bits, sizeof(value));
+            if (! (fabs(value) < 1e39)) {
+                continue;  // not in "%f"
+            }
+        } else {
+            value = (double)(int32_t)bits * pow(10.0, -(int)((bits >> 32) % 7));
+        }
+        TelemetryItems_Clear(items);
+        TelemetryItems_AddFloat(items, sDoubleNameIds[0], value);
+        snprintf(expected, sizeof(expected), "{\"%s\":%f}", sDoubleNames[0], value);
+        result = CheckDoubles("random", items, expected)
+            && TelemetryItems_Count(items) == (IsSameFloatText(value) ? 1 : 2);
+        numSplit += TelemetryItems_Count(items) - 1;
+    }
+    if (! result) {
+        fprintf(stderr, "items of a double differ\n");
+    }
+    printf("doubles split into FLOAT_LO\t%d / %d\n", numSplit, VERIFY_ROUNDS);
+    TelemetryItems_Destroy(items);
+
+    return result;
+}
+
+static bool
+VerifyDoubles(void)
+{
+    TelemetryItems*	items = TelemetryItems_New();
+    TelemetryItems*	outItems = TelemetryItems_New();
+    TelemetryItemCache*	cache = TelemetryItemCache_New();
+    TelemetryCacheStore*	store = TelemetryCacheStore_New();
+    char	path[] = "/tmp/bench_TelemetryItemsJsonXXXXXX";
+    int 	fd = mkstemp(path);
+    char	expected[1024];
+    size_t	len = 0;
+    int 	numItems = 0;
+    uint32_t	ts;
+    bool	result;
+
+    if (0 > fd) {
+        perror("mkstemp");
+        return false;
+    }
+    unlink(path);
+
+    // the baseline formatted the double by "%f"
+    expected[len++] = '{';
+    for (size_t i = 0; i < NUM_DOUBLES; ++i) {
+        TelemetryItems_AddFloat(items, sDoubleNameIds[i], sDoubles[i]);
+        len += (size_t)snprintf(expected + len, sizeof(expected) - len,
+            "%s\"%s\":%f", (0 < i ? "," : ""), sDoubleNames[i], sDoubles[i]);
+        numItems += (IsSameFloatText(sDoubles[i]) ? 1 : 2);
+    }
+    snprintf(expected + len, sizeof(expected) - len, "}");
+
+    // a double takes a FLOAT_LO only when its float prints otherwise
+    result = CheckDoubles("ToJson", items, expected);
+    if (numItems != TelemetryItems_Count(items)) {
+        fprintf(stderr, "%d items for %d expected\n",
+            TelemetryItems_Count(items), numItems);
+        result = false;
+    }
+    TelemetryItems_AddItems(outItems, items);
+    TelemetryItems_Retain(outItems, PassAll, NULL);
+    result = result && CheckDoubles("Retain", outItems, expected);
+
+    result = result && TelemetryItemCache_Init(cache, NULL, CACHE_BUF_SIZE)
+        && RoundTripCache(cache, items, outItems)
+        && CheckDoubles("cache", outItems, expected);
+    result = result && TelemetryItemCache_EnableCompression(cache, true)
+        && RoundTripCache(cache, items, outItems)
+        && CheckDoubles("compressed cache", outItems, expected);
+
+    result = result && TelemetryCacheStore_Open(store, fd, STORE_SIZE)
+        && TelemetryCacheStore_EnqueueItems(store, items, 1)
+        && TelemetryCacheStore_DequeueItemsTo(store, outItems, &ts)
+        && CheckDoubles("store", outItems, expected);
+
+    TelemetryCacheStore_Destroy(store);
+    close(fd);
+    TelemetryItemCache_Destroy(cache);
+    TelemetryItems_Destroy(outItems);
+    TelemetryItems_Destroy(items);
+
+    return result && VerifyRandomDoubles();
+}
+
+int
+main(void)
+{
+    TelemetryItems*	items = TelemetryItems_New();
+    StringBuf*	sb = StringBuf_New();
+    uint64_t	start, before, after;
+    size_t	totalLen = 0;
+
+    srand(1);
+    SetupNames();
+
+    if (! VerifyDoubles()) {
+        return 1;
+    }
+
+    for (int i = 0; i < VERIFY_ROUNDS; ++i) {
+        FillItems(items, true);
+        if (0 != strcmp(StringBufToJson(sb, items), TelemetryItems_ToJson(items))) {
+            fprintf(stderr, "output differs:\n%s\n%s\n",
+                StringBufToJson(sb, items), TelemetryItems_ToJson(items));
+            return 1;
+        }
+    }
+
+    FillItems(items, false);
+    start = NowNs();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        totalLen += strlen(StringBufToJson(sb, items));
+    }
+    before = NowNs() - start;
+    start = NowNs();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        totalLen += strlen(TelemetryItems_ToJson(items));
+    }
+    after = NowNs() - start;
+
+    printf("%d items, %zu bytes\n",
+        ITEMS_PER_TICK, totalLen / (2 * BENCH_ROUNDS));
+    printf("TelemetryItems_ToJson(StringBuf)\t%.1f ns/op\n",
+        (double)before / BENCH_ROUNDS);
+    printf("TelemetryItems_ToJson(template)\t%.1f ns/op\n",
+        (double)after / BENCH_ROUNDS);
+
+    StringBuf_Destroy(sb);
+    TelemetryItems_Destroy(items);
+    TelemetryItems_CleanupDictionary();
+
+    return 0;
+}
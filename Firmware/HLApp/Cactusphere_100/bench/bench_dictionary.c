@@ -0,0 +1,251 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Micro benchmark of the hash-indexed dictionary against the AVL map
+// which the dictionary was formerly built on, at 10, 100 and 1000 keys
+//   - devID: unsigned long keys (ModbusFetchTargets)
+//   - name: string pointer keys (telemetry item name index)
+// Results of random put/remove/get are compared with the map before
+// measuring, and the key order is checked to be the insertion order.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dictionary.h"
+#include "map.h"
+
+#define MAX_KEYS	1000
+#define VERIFY_OPS	200000
+#define LOOKUP_OPS	1000000
+#define INSERT_KEYS_PER_RUN	100000
+
+static char	sNames[MAX_KEYS][24];
+static const char*	sNamePtrs[MAX_KEYS];
+static unsigned long	sDevIDs[MAX_KEYS];
+
+static uint64_t
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+DevIDComparator(const void* const one, const void* const two)
+{
+    unsigned long	devID1 = *((unsigned long*)one);
+    unsigned long	devID2 = *((unsigned long*)two);
+
+    return (devID1 < devID2 ? -1 : (devID1 > devID2 ? 1 : 0));
+}
+
+static int
+NameComparator(const void* const one, const void* const two)
+{
+    return strcmp(*((char**)one), *((char**)two));
+}
+
+static uint32_t
+NameHash(const void* const key)
+{
+    return dictionary_hash_string(*((char**)key));
+}
+
+static void
+SetupKeys(void)
+{
+    for (int i = 0; i < MAX_KEYS; ++i) {
+        snprintf(sNames[i], sizeof(sNames[i]), "Modbus_dev%03d_reg%02d",
+            i / 32, i % 32);
+        sNamePtrs[i] = sNames[i];
+        sDevIDs[i]   = (unsigned long)(i * 7 + 1);
+    }
+}
+
+static int
+Verify(void)
+{
+    // random operations on both containers with small key space
+    dictionary	dict = dictionary_init_hash(sizeof(char*), sizeof(int),
+        NameHash, NameComparator);
+    map	ref = map_init(sizeof(char*), sizeof(int), NameComparator);
+    int	inserted[64];
+    int	numInserted = 0;
+
+    for (int i = 0; i < VERIFY_OPS; ++i) {
+        int	k = rand() % 64;
+        int	op = rand() % 4;
+        int	v = rand();
+        int	v1 = -1, v2 = -1;
+        void*	key = &sNamePtrs[k];
+
+        if (0 == op) {
+            if (! map_contains(ref, key)) {
+                inserted[numInserted++] = k;
+            }
+            dictionary_put(dict, key, &v);
+            map_put(ref, key, &v);
+        } else if (1 == op) {
+            if (dictionary_remove(dict, key) != map_remove(ref, key)) {
+                return 1;
+            }
+            for (int j = 0; j < numInserted; ++j) {
+                if (inserted[j] == k) {
+                    memmove(&inserted[j], &inserted[j + 1],
+                        (numInserted - j - 1) * sizeof(int));
+                    --numInserted;
+                    break;
+                }
+            }
+        } else {
+            if (dictionary_get(&v1, dict, key) != map_get(&v2, ref, key)
+            || v1 != v2) {
+                return 1;
+            }
+        }
+        if (dictionary_size(dict) != map_size(ref)) {
+            return 1;
+        }
+        if (0 == i % 97) {
+            vector	keys = dictionary_get_keys(dict);
+
+            if (vector_size(keys) != numInserted) {
+                return 1;
+            }
+            for (int j = 0; j < numInserted; ++j) {
+                const char*	name;
+
+                vector_get_at(&name, keys, j);
+                if (name != sNamePtrs[inserted[j]]) {
+                    return 1;
+                }
+            }
+        }
+    }
+    dictionary_destroy(dict);
+    map_destroy(ref);
+
+    return 0;
+}
+
+static double
+BenchDictLookup(dictionary dict, void* keys, size_t keySize, int numKeys)
+{
+    uint64_t	start = NowNs();
+    long	sum = 0;
+
+    for (int i = 0; i < LOOKUP_OPS; ++i) {
+        int	v;
+
+        if (dictionary_get(&v, dict, (char*)keys + (i % numKeys) * keySize)) {
+            sum += v;
+        }
+    }
+    if (0 == sum) {
+        printf("!");
+    }
+    return (double)(NowNs() - start) / LOOKUP_OPS;
+}
+
+static double
+BenchMapLookup(map theMap, void* keys, size_t keySize, int numKeys)
+{
+    uint64_t	start = NowNs();
+    long	sum = 0;
+
+    for (int i = 0; i < LOOKUP_OPS; ++i) {
+        int	v;
+
+        if (map_get(&v, theMap, (char*)keys + (i % numKeys) * keySize)) {
+            sum += v;
+        }
+    }
+    if (0 == sum) {
+        printf("!");
+    }
+    return (double)(NowNs() - start) / LOOKUP_OPS;
+}
+
+static void
+BenchKeys(const char* label, void* keys, size_t keySize,
+    uint32_t(*hash)(const void* const key),
+    int(*comparator)(const void* const one, const void* const two))
+{
+    static const int	sNumKeys[] = { 10, 100, 1000 };
+
+    for (size_t n = 0; n < sizeof(sNumKeys) / sizeof(sNumKeys[0]); ++n) {
+        int	numKeys = sNumKeys[n];
+        int	runs = INSERT_KEYS_PER_RUN / numKeys;
+        uint64_t	dictInsert = 0, mapInsert = 0, start;
+        dictionary	dict = NULL;
+        map	theMap = NULL;
+
+        for (int r = 0; r < runs; ++r) {
+            if (NULL != dict) {
+                dictionary_destroy(dict);
+                map_destroy(theMap);
+            }
+            start = NowNs();
+            dict = dictionary_init_hash(keySize, sizeof(int), hash, comparator);
+            for (int i = 0; i < numKeys; ++i) {
+                dictionary_put(dict, (char*)keys + i * keySize, &i);
+            }
+            dictInsert += NowNs() - start;
+            start = NowNs();
+            theMap = map_init(keySize, sizeof(int), comparator);
+            for (int i = 0; i < numKeys; ++i) {
+                map_put(theMap, (char*)keys + i * keySize, &i);
+            }
+            mapInsert += NowNs() - start;
+        }
+        printf("%s\t%d keys\tinsert\tmap %.1f ns/op\tdictionary %.1f ns/op\n",
+            label, numKeys, (double)mapInsert / (runs * numKeys),
+            (double)dictInsert / (runs * numKeys));
+        printf("%s\t%d keys\tlookup\tmap %.1f ns/op\tdictionary %.1f ns/op\n",
+            label, numKeys, BenchMapLookup(theMap, keys, keySize, numKeys),
+            BenchDictLookup(dict, keys, keySize, numKeys));
+        dictionary_destroy(dict);
+        map_destroy(theMap);
+    }
+}
+
+int
+main(void)
+{
+    srand(1);
+    SetupKeys();
+    if (0 != Verify()) {
+        fprintf(stderr, "dictionary differs from map\n");
+        return 1;
+    }
+
+    BenchKeys("devID", sDevIDs, sizeof(unsigned long), NULL, DevIDComparator);
+    BenchKeys("name", sNamePtrs, sizeof(char*), NameHash, NameComparator);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ModbusStub.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "LibModbus.h"
+#include "TelemetryItems.h"
+
+static int	sDummyDev;
+static uint32_t	sReadCostUs = 0;
+
+// Time
+uint64_t
+ModbusStub_NowUs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+// LibModbus stub
+void
+ModbusStub_SetReadCost(uint32_t costUs)
+{
+    sReadCostUs = costUs;
+}
+
+ModbusDev*
+Libmodbus_GetAndConnectLib(int devID)
+{
+    (void)devID;
+    return (ModbusDev*)&sDummyDev;
+}
+
+bool
+Libmodbus_ReadRegister(ModbusDev* me, int regAddr, int funcCode,
+    unsigned short* dst, int regCount)
+{
+    uint64_t	endUs = ModbusStub_NowUs() + sReadCostUs;
+
+    (void)me;
+    (void)regAddr;
+    (void)funcCode;
+    for (int i = 0; i < regCount; ++i) {
+        dst[i] = (unsigned short)rand();
+    }
+    while (0 < sReadCostUs && ModbusStub_NowUs() < endUs) {
+        // occupy the bus
+    }
+    return true;
+}
+
+bool
+Libmodbus_WriteRegister(ModbusDev* me, int regAddr, int funcCode,
+    unsigned short* data)
+{
+    (void)me;
+    (void)regAddr;
+    (void)funcCode;
+    (void)data;
+    return true;
+}
+
+// Fetch items
+void
+ModbusStub_SetupFetchItems(ModbusFetchItem* items,
+    int numDevs, int itemsPerDev, int fastItemsPerDev, vector fetchItemPtrs)
+{
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < numDevs * itemsPerDev; ++i) {
+        ModbusFetchItem*	item = &items[i];
+        int	reg = i % itemsPerDev;
+
+        memset(item, 0, sizeof(*item));
+        snprintf(item->telemetryName, sizeof(item->telemetryName),
+            "Modbus_dev%u_reg%02u",
+            (uint16_t)(i / itemsPerDev + 1), (uint16_t)reg);
+        item->intervalSec = (reg < fastItemsPerDev ? 10 : 60);
+        item->devID       = (uint32_t)(i / itemsPerDev + 1);
+        item->regAddr     = (uint32_t)reg;
+        item->regCount    = 1;
+        item->funcCode    = 3;
+        item->nameId      = TelemetryItems_AddDictionaryElem(
+            item->telemetryName, false);
+        item->isChanged   = true;
+        vector_add_last(fetchItemPtrs, &item);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build stub of LibModbus and a fixture of Modbus fetch items, shared
+// by the benchmarks of the RS485 scheduler
+
+#ifndef _BENCH_STUB_MODBUS_STUB_H_
+#define _BENCH_STUB_MODBUS_STUB_H_
+
+#include <stdint.h>
+
+#include "ModbusFetchItem.h"
+#include "vector.h"
+
+// Time
+extern uint64_t	ModbusStub_NowUs(void);
+
+// LibModbus stub
+extern void	ModbusStub_SetReadCost(uint32_t costUs);
+//
+// NOTE: Libmodbus_ReadRegister() reads random values, so that filters pass
+//       them, and busy-waits costUs [usec] per call as the bus (0: none).
+
+// Fetch items of numDevs slave devices x itemsPerDev registers
+extern void	ModbusStub_SetupFetchItems(ModbusFetchItem* items,
+    int numDevs, int itemsPerDev, int fastItemsPerDev, vector fetchItemPtrs);
+//
+// NOTE: The first fastItemsPerDev registers of each device are read at
+//       10[s] and the rest at 60[s].  The dictionary is initialized, and
+//       the items are all marked as changed, as in a new configuration.
+
+#endif  // _BENCH_STUB_MODBUS_STUB_H_
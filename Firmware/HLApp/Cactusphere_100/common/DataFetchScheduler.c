@@ -25,14 +25,22 @@
 #include "DataFetchScheduler.h"
 
 #include <string.h>
+#include <time.h>
 
-#include "LibCloud.h"
-#include "StringBuf.h"
+#include "TelemetryAggregator.h"
+#include "TelemetryFilter.h"
 #include "TelemetryItems.h"
 
-extern bool	IsAuthenticationDone(void);
+// Clock for the bus occupancy (in [us])
+static uint64_t
+DataFetchScheduler_GetTimeUs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-static DataFetchSchedulerBase*	sPrimaryScheduler = NULL;
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
 
 // Default implementation of virtual method
 static void
@@ -60,6 +68,13 @@ DataFetchSchedulerBase_DoSchedule(DataFetchSchedulerBase* me)
     // do nothing
 }
 
+static bool
+DataFetchSchedulerBase_GetNextDeadline(
+    const DataFetchSchedulerBase* me, uint64_t* outDeadlineMs)
+{
+    return FetchTimers_GetNextDeadline(me->mFetchTimers, outDeadlineMs);
+}
+
 // Initialization and cleanup
 void
 DataFetchScheduler_Init(DataFetchScheduler* me, vector fetchItemPtrs)
@@ -68,14 +83,41 @@ DataFetchScheduler_Init(DataFetchScheduler* me, vector fetchItemPtrs)
     // do for specialized/derived class
     FetchTimers_Init(me->mFetchTimers, fetchItemPtrs);
     TelemetryItems_Clear(me->mTelemetryItems);
-    StringBuf_Clear(me->mStringBuf);
+    TelemetryAggregator_Clear(me->mAggregator);
+    TelemetryFilter_Clear(me->mFilter);
 
     me->DoInit((DataFetchSchedulerBase*)me, fetchItemPtrs);
 
-    // set first instance as primary
-    if (NULL == sPrimaryScheduler) {
-        sPrimaryScheduler = me;
-    }
+    // every window may close in one run, in addition to the raw samples;
+    // a float value may take an extension item
+    (void)TelemetryItems_Reserve(me->mTelemetryItems,
+        2 * (vector_size(fetchItemPtrs) + TelemetryAggregate_Num
+            * TelemetryAggregator_GetNumWindows(me->mAggregator)));
+}
+
+static void
+DataFetchScheduler_RemoveItem(void* arg, TelemetryNameId nameId)
+{
+    DataFetchScheduler*	me = (DataFetchScheduler*)arg;
+
+    TelemetryAggregator_RemoveWindow(me->mAggregator, nameId);
+    TelemetryFilter_RemoveSpec(me->mFilter, nameId);
+}
+
+void
+DataFetchScheduler_Update(DataFetchScheduler* me, vector fetchItemPtrs)
+{
+    // apply the difference from the running configuration, keeping the
+    // timers, the windows and the filter history of the unchanged items
+    FetchTimers_Update(me->mFetchTimers, fetchItemPtrs,
+        DataFetchScheduler_RemoveItem);
+    TelemetryItems_Clear(me->mTelemetryItems);
+
+    me->DoInit((DataFetchSchedulerBase*)me, fetchItemPtrs);
+
+    (void)TelemetryItems_Reserve(me->mTelemetryItems,
+        2 * (vector_size(fetchItemPtrs) + TelemetryAggregate_Num
+            * TelemetryAggregator_GetNumWindows(me->mAggregator)));
 }
 
 void
@@ -84,66 +126,94 @@ DataFetchScheduler_Destroy(DataFetchScheduler* me)
     // cleanup member of specialized class and generalized class
     me->DoDestroy(me);
 
-    StringBuf_Destroy(me->mStringBuf);
+    TelemetryFilter_Destroy(me->mFilter);
+    TelemetryAggregator_Destroy(me->mAggregator);
     TelemetryItems_Destroy(me->mTelemetryItems);
     FetchTimers_Destroy(me->mFetchTimers);
 
     free(me);
 }
 
-// Periodic operation (per 1[sec])
+// Attribute
+const TelemetryItems*
+DataFetchScheduler_GetTelemetryItems(const DataFetchScheduler* me)
+{
+    return me->mTelemetryItems;
+}
+
+bool
+DataFetchScheduler_GetNextDeadline(
+    const DataFetchScheduler* me, uint64_t* outDeadlineMs)
+{
+    return me->GetNextDeadline(me, outDeadlineMs);
+}
+
 void
-DataFetchScheduler_Schedule(DataFetchScheduler* me)
+DataFetchScheduler_SetPhasePolicy(
+    DataFetchScheduler* me, FetchPhasePolicy policy)
 {
-    // Do data acquisition by specialized class and send it as telemetry.
-    // If nettwork is down, store the acquired data to cache and send it after recovery. 
-    const char* telemtryStr;
+    FetchTimers_SetPhasePolicy(me->mFetchTimers, policy);
+}
 
+const DataFetchBusStats*
+DataFetchScheduler_GetBusStats(const DataFetchScheduler* me)
+{
+    return &me->mBusStats;
+}
+
+void
+DataFetchScheduler_ResetBusStats(DataFetchScheduler* me)
+{
+    memset(&me->mBusStats, 0, sizeof(me->mBusStats));
+}
+
+const TelemetryAggregator*
+DataFetchScheduler_GetAggregator(const DataFetchScheduler* me)
+{
+    return me->mAggregator;
+}
+
+const TelemetryFilter*
+DataFetchScheduler_GetFilter(const DataFetchScheduler* me)
+{
+    return me->mFilter;
+}
+
+// Periodic operation (at the next deadline)
+void
+DataFetchScheduler_Schedule(DataFetchScheduler* me, uint64_t nowMs)
+{
+    // Do data acquisition by specialized class.  The acquired data is
+    // sent by TelemetryCollector together with other schedulers' one.
     me->ClearFetchTargets(me);
     TelemetryItems_Clear(me->mTelemetryItems);
-    StringBuf_Clear(me->mStringBuf);
-
-    FetchTimers_UpdateTimers(me->mFetchTimers);
 
-    me->DoSchedule(me);
+    me->mLastRunMs = nowMs;
+    FetchTimers_UpdateTimers(me->mFetchTimers, nowMs);
 
-    telemtryStr = TelemetryItems_ToJson(me->mTelemetryItems);
-    if (0 != strcmp(telemtryStr, "{}")) {
-        bool	isNetworkAlive = IoT_CentralLib_CheckConnection();
-        uint32_t	timeStamp = IoT_CentralLib_GetTmeStamp();
+    uint64_t	startUs = DataFetchScheduler_GetTimeUs();
+    uint32_t	busyUs;
+    DataFetchBusStats*	stats = &me->mBusStats;
 
-        if (! IsAuthenticationDone()) {
-            isNetworkAlive = false;
-        }
+    me->DoSchedule(me);
 
-        if (isNetworkAlive) {
-            if (IoT_CentralLib_HasCachedTelemetryItems()) {  // send cached data first
-                if (me == sPrimaryScheduler
-                && !IoT_CentralLib_ResendCachedTelemetryItems()) {
-                    // !!error
-                }
-                if (IoT_CentralLib_HasCachedTelemetryItems()) {
-                    goto do_cache;   // still outstanding cache, so append new data
-                }
-            }
-
-            if (! IoT_CentralLib_SendTelemetry(telemtryStr, &timeStamp)) {
-                isNetworkAlive = IoT_CentralLib_CheckConnection();
-                if (isNetworkAlive) {
-                    // !!error
-                }
-            }
+    busyUs = (uint32_t)(DataFetchScheduler_GetTimeUs() - startUs);
+    stats->lastItems  = (uint32_t)TelemetryItems_CountValues(me->mTelemetryItems);
+    stats->lastBusyUs = busyUs;
+    if (0 < stats->lastItems) {
+        if (stats->peakItems < stats->lastItems) {
+            stats->peakItems = stats->lastItems;
         }
-
-        if (! isNetworkAlive) {
-do_cache:
-            if (! IoT_CentralLib_EnqueueTelemtryItemsToCache(me->mTelemetryItems,
-                    timeStamp)) {
-                // failed to caching; Error!
-            }
+        if (stats->peakBusyUs < busyUs) {
+            stats->peakBusyUs = busyUs;
         }
-        TelemetryItems_Clear(me->mTelemetryItems);
+        stats->totalBusyUs += busyUs;
+        stats->totalItems  += stats->lastItems;
+        ++stats->numRuns;
     }
+
+    TelemetryAggregator_Apply(me->mAggregator, me->mTelemetryItems, nowMs);
+    TelemetryFilter_Apply(me->mFilter, me->mTelemetryItems, nowMs);
 }
 
 // For specialized class
@@ -157,19 +227,28 @@ DataFetchScheduler_InitOnNew(DataFetchSchedulerBase* me,
         goto err;
     }
     me->mTelemetryItems = TelemetryItems_New();
-    if (NULL == me->mFetchTimers) {
+    if (NULL == me->mTelemetryItems) {
         goto err_delete_fetchTimers;
     }
-    me->mStringBuf = StringBuf_New();
-    if (NULL == me->mStringBuf) {
+    me->mAggregator = TelemetryAggregator_New();
+    if (NULL == me->mAggregator) {
         goto err_delete_telemetryItems;
     }
+    me->mFilter = TelemetryFilter_New();
+    if (NULL == me->mFilter) {
+        goto err_delete_aggregator;
+    }
     me->DoDestroy         = DataFetchSchedulerBase_DoDestroy;
     me->DoInit            = DataFetchSchedulerBase_DoInit;
     me->ClearFetchTargets = DataFetchSchedulerBase_ClearFetchTargets;
     me->DoSchedule        = DataFetchSchedulerBase_DoSchedule;
+    me->GetNextDeadline   = DataFetchSchedulerBase_GetNextDeadline;
+    me->mLastRunMs        = 0;
+    DataFetchScheduler_ResetBusStats(me);
 
     return me;
+err_delete_aggregator:
+    TelemetryAggregator_Destroy(me->mAggregator);
 err_delete_telemetryItems:
     TelemetryItems_Destroy(me->mTelemetryItems);
 err_delete_fetchTimers:
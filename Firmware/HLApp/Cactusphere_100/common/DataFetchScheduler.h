@@ -36,9 +36,21 @@
 // forward declaration
 typedef struct DataFetchSchedulerBase	DataFetchSchedulerBase;
 typedef struct FetchTimers	FetchTimers;
-typedef struct StringBuf	StringBuf;
+typedef struct TelemetryAggregator	TelemetryAggregator;
+typedef struct TelemetryFilter	TelemetryFilter;
 typedef struct TelemetryItems	TelemetryItems;
 
+// bus occupancy of the data acquisition, per run of DoSchedule()
+typedef struct DataFetchBusStats {
+    uint32_t	lastBusyUs;     // acquisition time of the last run (in [us])
+    uint32_t	peakBusyUs;     // maximum of lastBusyUs
+    uint64_t	totalBusyUs;    // accumulated acquisition time (in [us])
+    uint32_t	lastItems;      // number of items acquired in the last run
+    uint32_t	peakItems;      // maximum of lastItems
+    uint64_t	totalItems;     // accumulated number of acquired items
+    uint32_t	numRuns;        // number of runs which acquired any item
+} DataFetchBusStats;
+
 // DataFetchSchedulerBase class's virtual methods and data mebers
 struct DataFetchSchedulerBase {
 // virtual method
@@ -46,11 +58,16 @@ struct DataFetchSchedulerBase {
     void	(*DoInit)(DataFetchSchedulerBase* me, vector fetchItemPtrs);
     void	(*ClearFetchTargets)(DataFetchSchedulerBase* me);
     void	(*DoSchedule)(DataFetchSchedulerBase* me);
+    bool	(*GetNextDeadline)(
+        const DataFetchSchedulerBase* me, uint64_t* outDeadlineMs);
 
 // data member
     FetchTimers*    mFetchTimers;       // timers for data acquistion
     TelemetryItems* mTelemetryItems;    // vector of telemetry item
-    StringBuf*      mStringBuf;         // for string processing
+    TelemetryAggregator*	mAggregator;    // windowed aggregation
+    TelemetryFilter*	mFilter;        // report-by-exception filter
+    DataFetchBusStats	mBusStats;      // measured bus occupancy
+    uint64_t	mLastRunMs;     // nowMs of the last DataFetchScheduler_Schedule()
 };
 
 // alias type
@@ -59,14 +76,49 @@ typedef DataFetchSchedulerBase	DataFetchScheduler;
 // Initialization and cleanup
 extern void	DataFetchScheduler_Init(
     DataFetchScheduler* me, vector fetchItemPtrs);
+extern void	DataFetchScheduler_Update(
+    DataFetchScheduler* me, vector fetchItemPtrs);
 extern void	DataFetchScheduler_Destroy(DataFetchScheduler* me);
 
-// Deriodic operation (per 1[sec])
-extern void	DataFetchScheduler_Schedule(DataFetchScheduler* me);
+// Attribute
+extern const TelemetryItems*	DataFetchScheduler_GetTelemetryItems(
+    const DataFetchScheduler* me);
+extern bool	DataFetchScheduler_GetNextDeadline(
+    const DataFetchScheduler* me, uint64_t* outDeadlineMs);
+extern void	DataFetchScheduler_SetPhasePolicy(
+    DataFetchScheduler* me, FetchPhasePolicy policy);
+extern const DataFetchBusStats*	DataFetchScheduler_GetBusStats(
+    const DataFetchScheduler* me);
+extern void	DataFetchScheduler_ResetBusStats(DataFetchScheduler* me);
+extern const TelemetryAggregator*	DataFetchScheduler_GetAggregator(
+    const DataFetchScheduler* me);
+extern const TelemetryFilter*	DataFetchScheduler_GetFilter(
+    const DataFetchScheduler* me);
+
+// Periodic operation (at the next deadline, see FetchTimers_GetTimeMs())
+extern void	DataFetchScheduler_Schedule(
+    DataFetchScheduler* me, uint64_t nowMs);
 
 // For specialized class
 extern DataFetchSchedulerBase*	DataFetchScheduler_InitOnNew(
     DataFetchSchedulerBase* me,
     FetchTimerCallback ftCallback, IO_Feature feature);
 
+//
+// NOTE:
+// The phase policy is applied by the next DataFetchScheduler_Init().
+// DataFetchScheduler_Init() clears the aggregation windows and the
+// report-by-exception filter, and the specialized class sets them for each
+// item in DoInit().  DataFetchScheduler_Update() keeps them instead, with
+// the running timers (see FetchTimers_Update()), and drops only those of
+// the removed items; DoInit() then sets them again, which keeps the state
+// of the unchanged ones.  The acquired items go through the aggregation
+// and then the filter after DoSchedule().
+// The bus statistics cover the runs in which any timer expired, so that
+// peakItems and peakBusyUs show the burst which the policy flattens.
+// DataFetchScheduler_GetNextDeadline() returns the earliest deadline of the
+// fetch timers by default; the specialized class overrides it to add the
+// deadlines of its own, such as the periodic check of the DI watcher.
+//
+
 #endif  // _DATA_FETCH_SCHEDULER_H_
@@ -34,6 +34,8 @@
 typedef struct FetchItemBase {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t    intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds,
+                                // 0: use intervalSec)
 } FetchItemBase;
 
 #endif  // _FETCH_ITEM_BASE_H_
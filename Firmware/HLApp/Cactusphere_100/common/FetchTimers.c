@@ -24,12 +24,216 @@
 
 #include "FetchTimers.h"
 
+#include <stdlib.h>
+#include <time.h>
+
+#include "dictionary.h"
+
+// deadline of a timer which is not started yet by FetchTimers_Update()
+#define FETCH_TIMER_NOT_STARTED	0
+
 // Initialization
 static void
-FetchTimer_Init(FetchTimer* me, FetchItemBase* fi)
+FetchTimer_Init(FetchTimer* me, FetchItemBase* fi, uint32_t order,
+    uint64_t nowMs)
+{
+    me->fetchItem  = fi;
+    me->intervalMs = FetchTimers_GetIntervalMs(fi);
+    me->phaseMs    = me->intervalMs;
+    me->deadlineMs = nowMs + me->phaseMs;
+    me->order      = order;
+    me->nameId     = TelemetryItems_FindNameId(fi->telemetryName);
+}
+
+static int
+NameId_Comparator(const void* const one, const void* const two)
+{
+    TelemetryNameId	nameId1 = *((TelemetryNameId*)one);
+    TelemetryNameId	nameId2 = *((TelemetryNameId*)two);
+
+    if (nameId1 < nameId2) {
+        return -1;
+    } else if (nameId1 > nameId2) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static int
+Position_Comparator(const void* one, const void* two)
+{
+    uint32_t	pos1 = *((const uint32_t*)one);
+    uint32_t	pos2 = *((const uint32_t*)two);
+
+    return (pos1 < pos2) ? -1 : (pos1 > pos2);
+}
+
+// Heap operation
+static bool
+FetchTimer_IsEarlier(const FetchTimer* lhs, const FetchTimer* rhs)
+{
+    if (lhs->deadlineMs != rhs->deadlineMs) {
+        return lhs->deadlineMs < rhs->deadlineMs;
+    }
+    return lhs->order < rhs->order;
+}
+
+static void
+FetchTimers_SiftDown(FetchTimer* heap, int n, int pos)
+{
+    FetchTimer	target = heap[pos];
+
+    for (;;) {
+        int	child = pos * 2 + 1;
+
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && FetchTimer_IsEarlier(&heap[child + 1], &heap[child])) {
+            ++child;
+        }
+        if (! FetchTimer_IsEarlier(&heap[child], &target)) {
+            break;
+        }
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = target;
+}
+
+// Phase policy (the timers are in configuration order, not a heap yet)
+static uint64_t
+FetchTimers_GetWallTimeMs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+static void
+FetchTimer_Align(FetchTimer* me, uint64_t nowMs, uint64_t wallMs)
+{
+    // expire on the next wall-clock multiple of the interval
+    me->phaseMs    = me->intervalMs - (uint32_t)(wallMs % me->intervalMs);
+    me->deadlineMs = nowMs + me->phaseMs;
+}
+
+static void
+FetchTimers_AlignPhases(FetchTimers* me, uint64_t nowMs)
+{
+    FetchTimer*	timers = vector_get_data(me->mBody);
+    uint64_t	wallMs = FetchTimers_GetWallTimeMs();
+
+    for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
+        FetchTimer_Align(&timers[i], nowMs, wallMs);
+    }
+}
+
+static void
+FetchTimers_StaggerPhases(FetchTimers* me, uint64_t nowMs)
+{
+    // Give each phase group a slot number among the groups of the same
+    // interval (kept in phaseMs for a while), then spread the slots
+    // evenly over the interval.  O(n^2), but only on reconfiguration.
+    FetchTimer*	timers = vector_get_data(me->mBody);
+    int	n = vector_size(me->mBody);
+
+    for (int i = 0; i < n; ++i) {
+        uint32_t	group = me->GetPhaseGroup(me, timers[i].fetchItem);
+        uint32_t	slot = 0;
+
+        for (int j = 0; j < i; ++j) {
+            if (timers[j].intervalMs != timers[i].intervalMs) {
+                continue;
+            }
+            if (me->GetPhaseGroup(me, timers[j].fetchItem) == group) {
+                slot = timers[j].phaseMs;
+                break;
+            }
+            if (slot <= timers[j].phaseMs) {
+                slot = timers[j].phaseMs + 1;
+            }
+        }
+        timers[i].phaseMs = slot;
+    }
+    for (int i = 0; i < n; ++i) {
+        uint64_t	numSlots = 0;
+
+        for (int j = 0; j < n; ++j) {
+            if (timers[j].intervalMs == timers[i].intervalMs
+            && numSlots <= timers[j].phaseMs) {
+                numSlots = timers[j].phaseMs + 1;
+            }
+        }
+        timers[i].deadlineMs = nowMs +
+            (timers[i].phaseMs + 1) * (uint64_t)timers[i].intervalMs / numSlots;
+    }
+    for (int i = 0; i < n; ++i) {
+        timers[i].phaseMs = (uint32_t)(timers[i].deadlineMs - nowMs);
+    }
+}
+
+static void
+FetchTimers_StaggerPhase(FetchTimers* me, int index, uint64_t nowMs,
+    uint32_t* work)
+{
+    // Join the phase group of the timer if it is running, otherwise take
+    // the middle of the largest gap between the positions in the interval
+    // of the running timers of the same interval (sorted in work).
+    FetchTimer*	timers = vector_get_data(me->mBody);
+    FetchTimer*	timer = &timers[index];
+    uint32_t	intervalMs = timer->intervalMs;
+    uint32_t	group = me->GetPhaseGroup(me, timer->fetchItem);
+    uint32_t	gapStart = 0, gapMs = 0, pos;
+    int	numPos = 0;
+
+    for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
+        if (FETCH_TIMER_NOT_STARTED == timers[i].deadlineMs
+        || timers[i].intervalMs != intervalMs) {
+            continue;
+        }
+        if (me->GetPhaseGroup(me, timers[i].fetchItem) == group) {
+            timer->deadlineMs = timers[i].deadlineMs;
+            timer->phaseMs    = timers[i].phaseMs;
+            return;
+        }
+        work[numPos++] = (uint32_t)(timers[i].deadlineMs % intervalMs);
+    }
+    if (0 == numPos) {
+        // the first one of the interval
+        timer->deadlineMs = nowMs + timer->phaseMs;
+        return;
+    }
+
+    qsort(work, numPos, sizeof(uint32_t), Position_Comparator);
+    for (int i = 0; i < numPos; ++i) {
+        uint32_t	next = (i + 1 < numPos) ? work[i + 1] : work[0] + intervalMs;
+
+        if (gapMs < next - work[i]) {
+            gapMs    = next - work[i];
+            gapStart = work[i];
+        }
+    }
+    pos = (uint32_t)((gapStart + gapMs / 2) % intervalMs);
+    timer->phaseMs    =
+        (pos + intervalMs - (uint32_t)(nowMs % intervalMs)) % intervalMs;
+    if (0 == timer->phaseMs) {
+        timer->phaseMs = intervalMs;
+    }
+    timer->deadlineMs = nowMs + timer->phaseMs;
+}
+
+static void
+FetchTimers_Heapify(FetchTimers* me)
 {
-    me->fetchItem   = fi;
-    me->downCounter = fi->intervalSec;
+    int	n = vector_size(me->mBody);
+
+    for (int i = n / 2 - 1; i >= 0; --i) {
+        FetchTimers_SiftDown(vector_get_data(me->mBody), n, i);
+    }
 }
 
 // Initialization and cleanup
@@ -40,14 +244,24 @@ FetchTimers_New(FetchTimerCallback cbProc, void* cbArg)
     FetchTimers*	newObj = (FetchTimers*)malloc(sizeof(FetchTimers));
 
     if (NULL != newObj) {
-        newObj->mBody = vector_init(sizeof(FetchTimer));
-        if (NULL == newObj->mBody) {
+        newObj->mBody     = vector_init(sizeof(FetchTimer));
+        newObj->mPrevBody = vector_init(sizeof(FetchTimer));
+        if (NULL == newObj->mBody || NULL == newObj->mPrevBody) {
+            if (NULL != newObj->mBody) {
+                vector_destroy(newObj->mBody);
+            }
+            if (NULL != newObj->mPrevBody) {
+                vector_destroy(newObj->mPrevBody);
+            }
             free(newObj);
             return NULL;
         }
         newObj->mCallbackProc = cbProc;
         newObj->mCbArg        = cbArg;
-        newObj->InitForTimer = FetchTimers_IntiForTimer;
+        newObj->mPhasePolicy  = FETCH_PHASE_NONE;
+        newObj->mRunningPolicy = FETCH_PHASE_NONE;
+        newObj->InitForTimer  = FetchTimers_IntiForTimer;
+        newObj->GetPhaseGroup = FetchTimers_GetPhaseGroup;
     }
 
     return newObj;
@@ -59,16 +273,121 @@ FetchTimers_Init(FetchTimers* me, vector fetchItemPtrs)
     // initialize the generalized/base class's member and do 
     // specialized/derived class specific timer related initialization
     FetchItemBase**	fetchItemCurs = vector_get_data(fetchItemPtrs);
+    uint64_t	nowMs = FetchTimers_GetTimeMs();
+    int	n = vector_size(fetchItemPtrs);
 
     vector_clear(me->mBody);
-    for (int i = 0, n = vector_size(fetchItemPtrs); i < n; ++i) {
+    for (int i = 0; i < n; ++i) {
         FetchItemBase*	fetchItem = *fetchItemCurs++;
         FetchTimer	pseudo;
 
-        FetchTimer_Init(&pseudo, fetchItem);
+        FetchTimer_Init(&pseudo, fetchItem, (uint32_t)i, nowMs);
         vector_add_last(me->mBody, &pseudo);
         me->InitForTimer(me, fetchItem);  // specialized class specific
     }
+
+    // shift the first deadlines by the policy, then build the heap
+    switch (me->mPhasePolicy) {
+    case FETCH_PHASE_ALIGNED:
+        FetchTimers_AlignPhases(me, nowMs);
+        break;
+    case FETCH_PHASE_STAGGERED:
+        FetchTimers_StaggerPhases(me, nowMs);
+        break;
+    default:
+        break;
+    }
+    FetchTimers_Heapify(me);
+    me->mRunningPolicy = me->mPhasePolicy;
+}
+
+void
+FetchTimers_Update(FetchTimers* me, vector fetchItemPtrs,
+    FetchTimerRemovedCallback removedProc)
+{
+    // take over the running timers of the items kept, start the others
+    // and tell the removed items.  The index of the running timers is
+    // allocated only here, on reconfiguration; without it every timer
+    // restarts.
+    FetchItemBase**	fetchItemCurs = vector_get_data(fetchItemPtrs);
+    uint64_t	nowMs = FetchTimers_GetTimeMs();
+    int	n = vector_size(fetchItemPtrs);
+    bool	keepPhases = (me->mPhasePolicy == me->mRunningPolicy);
+    vector	prevBody = me->mBody;
+    FetchTimer*	prevTimers = vector_get_data(prevBody);
+    FetchTimer*	timers;
+    bool	hasNewTimer = false;
+    dictionary	runningIndex = dictionary_init(
+        sizeof(TelemetryNameId), sizeof(int), NameId_Comparator);
+
+    for (int i = 0, m = vector_size(prevBody); NULL != runningIndex && i < m; ++i) {
+        if (TELEMETRY_NAME_ID_INVALID != prevTimers[i].nameId) {
+            dictionary_put(runningIndex, &prevTimers[i].nameId, &i);
+        }
+    }
+    me->mBody     = me->mPrevBody;
+    me->mPrevBody = prevBody;
+    vector_remove_all(me->mBody);
+    for (int i = 0; i < n; ++i) {
+        FetchItemBase*	fetchItem = *fetchItemCurs++;
+        FetchTimer	pseudo;
+        int	pos;
+
+        FetchTimer_Init(&pseudo, fetchItem, (uint32_t)i, nowMs);
+        pseudo.deadlineMs = FETCH_TIMER_NOT_STARTED;
+        if (NULL != runningIndex
+        && TELEMETRY_NAME_ID_INVALID != pseudo.nameId
+        && dictionary_get(&pos, runningIndex, &pseudo.nameId)) {
+            dictionary_remove(runningIndex, &pseudo.nameId);
+            if (keepPhases && prevTimers[pos].intervalMs == pseudo.intervalMs) {
+                pseudo.deadlineMs = prevTimers[pos].deadlineMs;
+                pseudo.phaseMs    = prevTimers[pos].phaseMs;
+            }
+        }
+        hasNewTimer |= (FETCH_TIMER_NOT_STARTED == pseudo.deadlineMs);
+        vector_add_last(me->mBody, &pseudo);
+        me->InitForTimer(me, fetchItem);  // specialized class specific
+    }
+
+    // the items left in the index are no longer configured
+    if (NULL != removedProc) {
+        for (int i = 0, m = vector_size(prevBody); i < m; ++i) {
+            if (TELEMETRY_NAME_ID_INVALID != prevTimers[i].nameId
+            && (NULL == runningIndex
+            || dictionary_contains(runningIndex, &prevTimers[i].nameId))) {
+                removedProc(me->mCbArg, prevTimers[i].nameId);
+            }
+        }
+    }
+    if (NULL != runningIndex) {
+        dictionary_destroy(runningIndex);
+    }
+
+    // start the new timers by the policy, then build the heap
+    timers = vector_get_data(me->mBody);
+    if (! keepPhases && FETCH_PHASE_STAGGERED == me->mPhasePolicy) {
+        FetchTimers_StaggerPhases(me, nowMs);
+    } else if (hasNewTimer) {
+        uint64_t	wallMs = FetchTimers_GetWallTimeMs();
+        uint32_t*	work = (FETCH_PHASE_STAGGERED == me->mPhasePolicy)
+            ? (uint32_t*)malloc(n * sizeof(uint32_t)) : NULL;
+
+        for (int i = 0; i < n; ++i) {
+            if (FETCH_TIMER_NOT_STARTED != timers[i].deadlineMs) {
+                continue;
+            }
+            if (FETCH_PHASE_ALIGNED == me->mPhasePolicy) {
+                FetchTimer_Align(&timers[i], nowMs, wallMs);
+            } else if (NULL != work) {
+                FetchTimers_StaggerPhase(me, i, nowMs, work);
+            } else {
+                timers[i].deadlineMs = nowMs + timers[i].phaseMs;
+            }
+        }
+        free(work);
+    }
+    FetchTimers_Heapify(me);
+    me->mRunningPolicy = me->mPhasePolicy;
 }
 
 void
@@ -77,25 +396,82 @@ FetchTimers_IntiForTimer(FetchTimers* me, FetchItemBase* fetchItem)
     // do nothing
 }
 
+uint32_t
+FetchTimers_GetPhaseGroup(FetchTimers* me, const FetchItemBase* fetchItem)
+{
+    // every item is a group of its own
+    return (uint32_t)(uintptr_t)fetchItem;
+}
+
 void
 FetchTimers_Destroy(FetchTimers* me)
 {
     vector_destroy(me->mBody);
+    vector_destroy(me->mPrevBody);
     free(me);
 }
 
-// Updating timer counters for periodic expiration
+// Attribute
+bool
+FetchTimers_GetNextDeadline(const FetchTimers* me, uint64_t* outDeadlineMs)
+{
+    if (vector_is_empty(me->mBody)) {
+        return false;
+    }
+    *outDeadlineMs = ((const FetchTimer*)vector_get_data(me->mBody))->deadlineMs;
+
+    return true;
+}
+
+FetchPhasePolicy
+FetchTimers_GetPhasePolicy(const FetchTimers* me)
+{
+    return me->mPhasePolicy;
+}
+
 void
-FetchTimers_UpdateTimers(FetchTimers* me)
+FetchTimers_SetPhasePolicy(FetchTimers* me, FetchPhasePolicy policy)
 {
-    // decrement the timer's down counter and fire when it reaches 0
-    FetchTimer*	timerCurs = vector_get_data(me->mBody);
+    me->mPhasePolicy = policy;
+}
 
-    for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
-        if (0 == --timerCurs->downCounter) {
-            me->mCallbackProc(me->mCbArg, timerCurs->fetchItem);
-            timerCurs->downCounter = timerCurs->fetchItem->intervalSec;  // reset
+// Firing the timers whose deadline has passed
+void
+FetchTimers_UpdateTimers(FetchTimers* me, uint64_t nowMs)
+{
+    // pop the expired timers in deadline order, notify and rearm them
+    FetchTimer*	heap = vector_get_data(me->mBody);
+    int	n = vector_size(me->mBody);
+
+    while (0 < n && heap[0].deadlineMs <= nowMs) {
+        me->mCallbackProc(me->mCbArg, heap[0].fetchItem);
+
+        heap[0].deadlineMs += heap[0].intervalMs;
+        if (heap[0].deadlineMs <= nowMs) {
+            // overrun, skip the missed periods
+            heap[0].deadlineMs = nowMs + heap[0].intervalMs;
         }
-        ++timerCurs;
+        FetchTimers_SiftDown(heap, n, 0);
     }
 }
+
+// Effective acquisition interval of an item (in [ms])
+uint32_t
+FetchTimers_GetIntervalMs(const FetchItemBase* fetchItem)
+{
+    uint32_t	intervalMs = (0 != fetchItem->intervalMs)
+        ? fetchItem->intervalMs : fetchItem->intervalSec * 1000;
+
+    return (0 != intervalMs) ? intervalMs : 1000;
+}
+
+// Monotonic clock (in [ms]) which the deadlines are based on
+uint64_t
+FetchTimers_GetTimeMs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)(ts.tv_nsec / 1000000);
+}
@@ -25,6 +25,10 @@
 #ifndef _FETCH_TIMERS_H_
 #define _FETCH_TIMERS_H_
 
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+
 #ifndef CONTAINERS_VECTOR_H
 #include <vector.h>
 #endif
@@ -33,36 +37,107 @@
 #include <FetchItemBase.h>
 #endif
 
+#ifndef _TELEMETRYITEMS_H_
+#include <TelemetryItems.h>
+#endif
+
 // timer for periodic data acquisition
 typedef struct FetchTimer {
     const FetchItemBase* fetchItem;  // telemetry data acquisition spec
-    uint32_t	downCounter;         // down counter for timer expiration
+    uint64_t	deadlineMs;          // next expiration (monotonic, in [ms])
+    uint32_t	intervalMs;          // expiration period (in [ms])
+    uint32_t	phaseMs;             // first expiration after Init (in [ms])
+    uint32_t	order;               // position in the configuration
+    TelemetryNameId	nameId;          // interned name of the item
 } FetchTimer;
 
+// phase of the periodic expiration
+typedef enum {
+    FETCH_PHASE_NONE = 0,   // all timers start together at initialization
+    FETCH_PHASE_ALIGNED,    // expire on wall-clock multiples of the interval
+    FETCH_PHASE_STAGGERED,  // spread timers of the same interval over it
+} FetchPhasePolicy;
+
 // callback procedure for timer expiration notification
 typedef void (*FetchTimerCallback)(
     void* arg, const FetchItemBase* fetchTarget);
 
+// callback procedure for the items removed by FetchTimers_Update()
+typedef void (*FetchTimerRemovedCallback)(void* arg, TelemetryNameId nameId);
+
 typedef struct FetchTimers	FetchTimers;
 
 // FetchTimers class's virtual methods and data members
 struct FetchTimers {
 // virtual method
     void (*InitForTimer)(FetchTimers* me, FetchItemBase* fetchItem);
+    uint32_t (*GetPhaseGroup)(FetchTimers* me, const FetchItemBase* fetchItem);
 
 // data member
-    vector	mBody;                      // vector of timer
+    vector	mBody;                      // min-heap of timer ordered by deadline
+    vector	mPrevBody;                  // running timers during Update
     FetchTimerCallback	mCallbackProc;  // timer expiration notifier
     void* mCbArg;                       // callback argument
+    FetchPhasePolicy	mPhasePolicy;   // phase of the timers started by Init
+    FetchPhasePolicy	mRunningPolicy; // phase of the running timers
 };
 
 // Initialization and cleanup
 extern FetchTimers*	FetchTimers_New(FetchTimerCallback cbProc, void* cbArg);
 extern void	FetchTimers_Init(FetchTimers* me, vector fetchItemPtrs);
+extern void	FetchTimers_Update(FetchTimers* me, vector fetchItemPtrs,
+    FetchTimerRemovedCallback removedProc);
 extern void	FetchTimers_IntiForTimer(FetchTimers* me, FetchItemBase* fetchItem);
+extern uint32_t	FetchTimers_GetPhaseGroup(
+    FetchTimers* me, const FetchItemBase* fetchItem);
 extern void	FetchTimers_Destroy(FetchTimers* me);
 
-// Updating timer counters for periodic expiration
-extern void	FetchTimers_UpdateTimers(FetchTimers* me);
+// Attribute
+extern bool	FetchTimers_GetNextDeadline(
+    const FetchTimers* me, uint64_t* outDeadlineMs);
+extern FetchPhasePolicy	FetchTimers_GetPhasePolicy(const FetchTimers* me);
+extern void	FetchTimers_SetPhasePolicy(
+    FetchTimers* me, FetchPhasePolicy policy);
+
+// Firing the timers whose deadline has passed
+extern void	FetchTimers_UpdateTimers(FetchTimers* me, uint64_t nowMs);
+
+// Effective acquisition interval of an item (in [ms])
+extern uint32_t	FetchTimers_GetIntervalMs(const FetchItemBase* fetchItem);
+
+// Monotonic clock (in [ms]) which the deadlines are based on
+extern uint64_t	FetchTimers_GetTimeMs(void);
+
+//
+// NOTE:
+// The timers are kept in a binary min-heap keyed by (deadlineMs, order),
+// so finding the next deadline is O(1) and firing a timer is O(log n)
+// regardless of how many items are configured.  Timers which expire at
+// the same time fire in configuration order, and an interval which is
+// overrun (e.g. by a slow Modbus transaction) skips the missed periods
+// instead of firing repeatedly to catch up.
+//
+// NOTE:
+// The phase policy takes effect on the next FetchTimers_Init().  With
+// FETCH_PHASE_STAGGERED, the timers of the same interval are divided into
+// phase groups by GetPhaseGroup() (each item by default) and the groups
+// are spread evenly over the interval; the timers of one group keep
+// expiring together so that they can share a bus transaction.  With
+// FETCH_PHASE_ALIGNED, the first deadline is put on the next wall-clock
+// multiple of the interval, which makes the samples of different devices
+// comparable; the phase is taken once at Init() and follows the monotonic
+// clock afterward.
+//
+// NOTE:
+// FetchTimers_Update() applies a new configuration as the difference from
+// the running timers, which are matched with the items by the interned
+// telemetry name.  The timer of an item of the same interval keeps its
+// deadline; the others start as Init() does with the policy, except that
+// a staggered one joins its phase group if it is running, or takes the
+// middle of the largest gap between the timers of the same interval.
+// removedProc is called back with mCbArg for each item no longer
+// configured.  A change of the phase policy restarts all the timers.
+// InitForTimer() is called for every item in both cases.
+//
 
 #endif  // _FETCH_TIMERS_H_
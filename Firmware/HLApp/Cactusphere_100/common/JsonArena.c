@@ -0,0 +1,173 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "JsonArena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+#define JSON_ARENA_ALIGN	8
+
+typedef struct JsonArenaBlock	JsonArenaBlock;
+
+struct JsonArenaBlock {
+    JsonArenaBlock*	next;	// older block
+    size_t	size;	// bytes for the values
+    size_t	used;	// bytes allocated
+};
+
+#define JSON_ARENA_HEADER_SIZE	\
+    ((sizeof(JsonArenaBlock) + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1))
+
+struct JsonArena {
+    JsonArenaBlock*	mBlocks;	// the newest block first
+    size_t	mBlockSize;	// size of a new block
+    size_t	mUsedSize;	// bytes allocated since the last reset
+    json_settings	mSettings;	// hooks of json_parse_ex()
+};
+
+static void*
+JsonArena_Alloc(size_t size, int zero, void* userData)
+{
+    JsonArena*	me = (JsonArena*)userData;
+    JsonArenaBlock*	block = me->mBlocks;
+    unsigned char*	ptr;
+
+    size = (size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+    if (NULL == block || block->size - block->used < size) {
+        size_t	blockSize = (size > me->mBlockSize ? size : me->mBlockSize);
+
+        block = (JsonArenaBlock*)malloc(JSON_ARENA_HEADER_SIZE + blockSize);
+        if (NULL == block) {
+            return NULL;
+        }
+        block->next  = me->mBlocks;
+        block->size  = blockSize;
+        block->used  = 0;
+        me->mBlocks = block;
+    }
+    ptr = (unsigned char*)block + JSON_ARENA_HEADER_SIZE + block->used;
+    block->used   += size;
+    me->mUsedSize += size;
+    if (zero) {
+        memset(ptr, 0, size);
+    }
+
+    return ptr;
+}
+
+static void
+JsonArena_Free(void* ptr, void* userData)
+{
+    // the arena blocks are released in bulk by JsonArena_FreeBlocks()
+    (void)ptr;
+    (void)userData;
+}
+
+static void
+JsonArena_FreeBlocks(JsonArena* me)
+{
+    JsonArenaBlock*	block = me->mBlocks;
+
+    while (NULL != block) {
+        JsonArenaBlock*	next = block->next;
+
+        free(block);
+        block = next;
+    }
+    me->mBlocks = NULL;
+}
+
+// Initialization and cleanup
+JsonArena*
+JsonArena_New(size_t blockSize)
+{
+    JsonArena*	newObj = (JsonArena*)malloc(sizeof(JsonArena));
+
+    if (NULL != newObj) {
+        newObj->mBlocks    = NULL;
+        newObj->mBlockSize = blockSize;
+        newObj->mUsedSize  = 0;
+        memset(&newObj->mSettings, 0, sizeof(newObj->mSettings));
+        newObj->mSettings.settings  = json_enable_index;
+        newObj->mSettings.mem_alloc = JsonArena_Alloc;
+        newObj->mSettings.mem_free  = JsonArena_Free;
+        newObj->mSettings.user_data = newObj;
+    }
+
+    return newObj;
+}
+
+void
+JsonArena_Destroy(JsonArena* me)
+{
+    if (NULL != me) {
+        JsonArena_FreeBlocks(me);
+        free(me);
+    }
+}
+
+void
+JsonArena_Reset(JsonArena* me)
+{
+    if (NULL != me->mBlocks && NULL != me->mBlocks->next) {
+        // merge into a block on the next parse
+        if (me->mBlockSize < me->mUsedSize) {
+            me->mBlockSize = me->mUsedSize;
+        }
+        JsonArena_FreeBlocks(me);
+    } else if (NULL != me->mBlocks) {
+        me->mBlocks->used = 0;
+    }
+    me->mUsedSize = 0;
+}
+
+// Parse
+json_value*
+JsonArena_Parse(JsonArena* me, const char* json, size_t length)
+{
+    char	error[json_error_max];
+
+    return json_parse_ex(&me->mSettings, json, length, error);
+}
+
+json_value*
+JsonArena_ParseString(JsonArena* me, const json_value* strValue)
+{
+    if (NULL == strValue || json_string != strValue->type) {
+        return NULL;
+    }
+
+    return JsonArena_Parse(me, strValue->u.string.ptr, strValue->u.string.length);
+}
+
+// Attribute
+size_t
+JsonArena_GetUsedSize(const JsonArena* me)
+{
+    return me->mUsedSize;
+}
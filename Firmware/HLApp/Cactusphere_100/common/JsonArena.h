@@ -0,0 +1,62 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _JSON_ARENA_H_
+#define _JSON_ARENA_H_
+
+#ifndef _STDDEF_H
+#include <stddef.h>
+#endif
+
+typedef struct JsonArena	JsonArena;
+typedef struct _json_value	json_value;
+
+// Initialization and cleanup
+extern JsonArena*	JsonArena_New(size_t blockSize);
+extern void	JsonArena_Destroy(JsonArena* me);
+extern void	JsonArena_Reset(JsonArena* me);
+//
+// NOTE: JsonArena_Reset() releases all the values parsed so far in one
+//       shot.  The blocks are merged into one of the size used, which is
+//       kept for the next parse, so that a document of the same size is
+//       parsed without allocation.
+
+// Parse
+extern json_value*	JsonArena_Parse(JsonArena* me,
+    const char* json, size_t length);
+extern json_value*	JsonArena_ParseString(JsonArena* me,
+    const json_value* strValue);
+//
+// NOTE: The values are allocated from the arena through the json_settings
+//       hooks of json_parse_ex(), and must not be freed by json_value_free().
+//       JsonArena_ParseString() parses a JSON text held in a string value
+//       (e.g. a twin property of a JSON configuration); it returns NULL if
+//       strValue is not a string or fails to parse.
+//       Objects are parsed with json_enable_index, to look up their keys by
+//       json_GetKeyJson() without scanning.
+
+// Attribute
+extern size_t	JsonArena_GetUsedSize(const JsonArena* me);
+
+#endif  // _JSON_ARENA_H_
@@ -26,10 +26,14 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <applibs/log.h>
 #include <applibs/networking.h>
+#include <applibs/storage.h>
 
 #include <iothub_client_core_common.h>
 #include <iothub_device_client_ll.h>
@@ -38,27 +42,181 @@
 #include <iothub.h>
 #include <azure_sphere_provisioning.h>
 
-#include "vector.h"
-
+#include "Metrics.h"
+#include "SendRateControl.h"
+#include "TelemetryCacheStore.h"
 #include "TelemetryItemCache.h"
 #include "TelemetryItems.h"
 
 #define RESEND_MAX_NUM	10
+#define SEND_WINDOW_MAX	32	// number of message slots
+
+// context of SendMessageCallback(); slot index in the lower bits and
+// use count of the slot in the upper bits to reject stale confirmation
+#define MSG_SLOT_INDEX_BITS	8
+#define MSG_SLOT_INDEX_MASK	((1u << MSG_SLOT_INDEX_BITS) - 1)
+#define MSG_SLOT_GEN_MASK	(UINT32_MAX >> MSG_SLOT_INDEX_BITS)
+
+// batch message of cached telemetry data;
+//   {"snapshots":[{"time":"<creation time>","data":{<telemetry>}}, ...]}
+#define BATCH_HEAD	"{\"snapshots\":["
+#define BATCH_TAIL	"]}"
+#define BATCH_ELEM_HEAD	"{\"time\":\""
+#define BATCH_ELEM_DATA	"\",\"data\":"
+#define BATCH_ELEM_TAIL	"}"
+#define DATE_TIME_STR_LEN	28	// "YYYY-MM-DDTHH:MM:SS.0000000Z"
 
 extern IOTHUB_DEVICE_CLIENT_LL_HANDLE Get_IOTHUB_DEVICE_CLIENT_LL_HANDLE(void); // main.c
 
-static int  IoT_CentralLib_FindWaitingMsg(IOTHUB_MESSAGE_HANDLE msgHandle);
-
 typedef struct TelemetryMsgInfo {
-    IOTHUB_MESSAGE_HANDLE   msgHandle;
-    uint32_t    timeStamp;
+    IOTHUB_MESSAGE_HANDLE   msgHandle;  // NULL: free slot
+    unsigned char*  frames;         // binary frames of the sent snapshots
+    uint32_t    framesLen;          // length of the frames in byte
+    uint32_t    framesCapacity;     // allocated size of frames
+    uint32_t    generation;         // use count of the slot
+    uint64_t    sentMs;             // time handed over to IoTHubClient
 } TelemetryMsgInfo;
 
 static IOTHUB_DEVICE_CLIENT_LL_HANDLE sIothubClientHandle = NULL;
 static TelemetryItemCache*	sTelemetryCache = NULL;
+static TelemetryCacheStore*	sCacheStore = NULL;
+static int	sCacheStoreFd = -1;
 static TelemetryItems*	sTelemetryItems = NULL;
-static vector   sWaitingMsgs = NULL;
+static TelemetryMsgInfo	sMsgSlots[SEND_WINDOW_MAX];	// in-flight messages
+static uint8_t	sFreeSlots[SEND_WINDOW_MAX];	// stack of free slot indices
+static uint32_t	sNumFreeSlots = 0;
+static uint32_t	sSendWindow = SEND_WINDOW_MAX;
+static SendRateControl*	sRateControl = NULL;
+static TelemetryCacheEviction	sCacheEviction = TelemetryCacheEviction_DropOldest;
+static uint32_t	sPeakInFlight = 0;
 static time_t	sBaseTime;
+static uint32_t	sResendBatchSize = 0;
+static char*	sBatchBuf = NULL;
+static uint32_t	sBatchBufSize = 0;
+static unsigned char*	sBatchFrames = NULL;	// binary frames of the batch
+static uint32_t	sBatchFramesSize = 0;
+
+static uint32_t
+IoT_CentralLib_CountInFlight(void)
+{
+    return SEND_WINDOW_MAX - sNumFreeSlots;
+}
+
+static uint32_t
+IoT_CentralLib_CurrentWindow(void)
+{
+    // the configured window narrowed by the rate control
+    uint32_t	window = (NULL != sRateControl
+        ? SendRateControl_GetWindow(sRateControl) : sSendWindow);
+
+    return (window < sSendWindow ? window : sSendWindow);
+}
+
+static uint64_t
+GetTickMs(void)
+{
+    struct timespec	now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+static TelemetryMsgInfo*
+IoT_CentralLib_AcquireMsgSlot(void)
+{
+    // take a free slot unless the send window is full
+    TelemetryMsgInfo*	theSlot;
+
+    if (IoT_CentralLib_IsSendWindowFull()) {
+        return NULL;
+    }
+    theSlot = &sMsgSlots[sFreeSlots[--sNumFreeSlots]];
+    theSlot->generation = (theSlot->generation + 1) & MSG_SLOT_GEN_MASK;
+    if (sPeakInFlight < IoT_CentralLib_CountInFlight()) {
+        sPeakInFlight = IoT_CentralLib_CountInFlight();
+    }
+
+    return theSlot;
+}
+
+static void*
+IoT_CentralLib_MsgSlotToContext(const TelemetryMsgInfo* msgSlot)
+{
+    uint32_t	index = (uint32_t)(msgSlot - sMsgSlots);
+
+    return (void*)(uintptr_t)((msgSlot->generation << MSG_SLOT_INDEX_BITS)
+        | index);
+}
+
+static TelemetryMsgInfo*
+IoT_CentralLib_ContextToMsgSlot(void* context)
+{
+    uint32_t	index = (uint32_t)(uintptr_t)context & MSG_SLOT_INDEX_MASK;
+    uint32_t	generation = (uint32_t)(uintptr_t)context >> MSG_SLOT_INDEX_BITS;
+    TelemetryMsgInfo*	theSlot;
+
+    if (SEND_WINDOW_MAX <= index) {
+        return NULL;
+    }
+    theSlot = &sMsgSlots[index];
+    if (NULL == theSlot->msgHandle || generation != theSlot->generation) {
+        return NULL;  // already released
+    }
+
+    return theSlot;
+}
+
+static bool
+IoT_CentralLib_GrowBuf(unsigned char** buf, uint32_t* bufSize,
+    uint32_t reqSize)
+{
+    unsigned char*	newBuf;
+
+    if (reqSize <= *bufSize) {
+        return true;
+    }
+    newBuf = realloc(*buf, reqSize);
+    if (NULL == newBuf) {
+        return false;
+    }
+    *buf     = newBuf;
+    *bufSize = reqSize;
+
+    return true;
+}
+
+static void
+IoT_CentralLib_ReleaseMsgSlot(TelemetryMsgInfo* msgSlot)
+{
+    // the frame buffer is kept for the next use of the slot
+    IoTHubMessage_Destroy(msgSlot->msgHandle);
+    msgSlot->msgHandle = NULL;
+    msgSlot->framesLen = 0;
+    sFreeSlots[sNumFreeSlots++] = (uint8_t)(msgSlot - sMsgSlots);
+}
+
+static void
+IoT_CentralLib_ResetMsgSlots(bool freeFrames)
+{
+    // release all the in-flight messages and rebuild the free slot stack
+    sNumFreeSlots = 0;
+    for (int i = SEND_WINDOW_MAX - 1; 0 <= i; --i) {
+        TelemetryMsgInfo*	curs = &sMsgSlots[i];
+
+        if (NULL != curs->msgHandle) {
+            IoTHubMessage_Destroy(curs->msgHandle);
+            curs->msgHandle = NULL;
+            curs->framesLen = 0;
+        }
+        if (freeFrames) {
+            free(curs->frames);
+            curs->frames         = NULL;
+            curs->framesCapacity = 0;
+        }
+        sFreeSlots[sNumFreeSlots++] = (uint8_t)i;
+    }
+}
 
 /// <summary>
 ///     Callback confirming message delivered to IoT Hub.
@@ -68,26 +226,46 @@ static time_t	sBaseTime;
 static void
 SendMessageCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *context)
 {
-    int theIndex =
-        IoT_CentralLib_FindWaitingMsg((IOTHUB_MESSAGE_HANDLE)context);
+    TelemetryMsgInfo*	theMsg = IoT_CentralLib_ContextToMsgSlot(context);
 
     Log_Debug("INFO: Message received by IoT Hub. Result is: %d\n", result);
-    if (0 <= theIndex) {
-        if (IOTHUB_CLIENT_CONFIRMATION_OK != result) {
-            const TelemetryMsgInfo*   theMsg =
-                (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs) + theIndex;
-            const char* jsonStr = IoTHubMessage_GetString(theMsg->msgHandle);
-
-            if (TelemetryItems_LoadFromJson(sTelemetryItems, jsonStr)) {
-                (void)TelemetryItemCache_EnqueueItems(
-                    sTelemetryCache, sTelemetryItems, theMsg->timeStamp);
-            }
+    if (NULL != theMsg && NULL != sRateControl) {
+        uint64_t	nowMs = GetTickMs();
+        SendConfirm	confirm;
+
+        switch (result) {
+        case IOTHUB_CLIENT_CONFIRMATION_OK:
+            confirm = SendConfirm_OK;
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT:
+            confirm = SendConfirm_Timeout;
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY:
+            confirm = SendConfirm_Canceled;
+            break;
+        default:
+            confirm = SendConfirm_Error;
+            break;
+        }
+        SendRateControl_OnConfirm(sRateControl,
+            confirm, (uint32_t)(nowMs - theMsg->sentMs), nowMs);
+        if (SendConfirm_Canceled != confirm) {
+            uint64_t	rttMs = nowMs - theMsg->sentMs;
+
+            Metrics_RecordLatency(MetricsLatency_SendConfirm,
+                (UINT32_MAX / 1000 < rttMs ? UINT32_MAX : (uint32_t)rttMs * 1000));
         }
-        vector_remove_at(sWaitingMsgs, theIndex);
+    }
+    if (NULL != theMsg) {
+        if (IOTHUB_CLIENT_CONFIRMATION_OK != result && 0 < theMsg->framesLen) {
+            // put the undelivered snapshots back to the cache
+            (void)TelemetryItemCache_EnqueueFrames(
+                sTelemetryCache, theMsg->frames, theMsg->framesLen);
+        }
+        IoT_CentralLib_ReleaseMsgSlot(theMsg);
     } else {
         Log_Debug("WARN: Unknown essage on  SendMessageCallback().\n");
     }
-    IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)context);
 }
 
 static uint32_t
@@ -98,109 +276,385 @@ GetTimestamp(void)
     return (uint32_t)(currTime - sBaseTime);
 }
 
+static uint64_t
+TimeStampToMs(uint32_t timeStamp)
+{
+    return ((uint64_t)sBaseTime + timeStamp) * 1000;
+}
+
+static uint64_t
+GetMessageTimeMs(const TelemetryItems* items, uint32_t timeStamp)
+{
+    // the capture time of the items if they have, or the time stamp
+    uint64_t	captureMs = TelemetryItems_GetCaptureTime(items);
+
+    return (0 != captureMs ? captureMs : TimeStampToMs(timeStamp));
+}
+
 static void
-MakeDateTimeStr(char* strBuf, size_t bufSize, uint32_t timeStamp)
+MakeDateTimeStr(char* strBuf, size_t bufSize, uint64_t timeMs)
 {
-    time_t	theTime = sBaseTime + (time_t)timeStamp;
+    time_t	theTime = (time_t)(timeMs / 1000);
     struct tm*	tmVal;
 
     tmVal = gmtime(&theTime);
     strftime(strBuf, bufSize, "%Y-%m-%dT%H:%M:%S", tmVal);
-    sprintf(strBuf + strlen(strBuf), ".%07ldZ", 0);
+    sprintf(strBuf + strlen(strBuf), ".%03u0000Z", (unsigned)(timeMs % 1000));
 //
-// NOTE: Since the timestamp is a 32-bit integer, time values less than 
-//       seconds (timespec::tv_nsec) that can be obtained by timespec_get() 
-//       are ignored, and time values less than seconds are set to 0 
-//       in the character string returned as an output argument.
+// NOTE: The time is in millisecond resolution, so the last 4 digits of
+//       the fraction are always 0.
 }
 
-static int
-IoT_CentralLib_FindWaitingMsg(IOTHUB_MESSAGE_HANDLE msgHandle)
+static const char*
+IoT_CentralLib_ToJson(TelemetryItems* items)
 {
-    TelemetryMsgInfo*   curs =
-        (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
+    uint64_t	startUs = Metrics_GetTimeUs();
+    const char*	jsonStr = TelemetryItems_ToJson(items);
 
-    for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-        if ((curs++)->msgHandle == msgHandle) {
-            return i;
-        }
-    }
+    Metrics_RecordSince(MetricsLatency_Serialize, startUs);
 
-    return -1;
+    return jsonStr;
 }
 
 static bool
-IoT_CentralLib_DoSendTelemetry(const char* jsonStr, uint32_t timeStamp)
+IoT_CentralLib_DoSendMessage(const char* jsonStr, uint64_t timeMs,
+    const void* frames, uint32_t framesLen, uint32_t batchCount)
 {
     // send telemetry data message to IoT Central with timestamp property
     bool	isOK = true;
     char	strBuf[64];
-    IOTHUB_MESSAGE_HANDLE messageHandle = IoTHubMessage_CreateFromString(jsonStr);
-    TelemetryMsgInfo    msgInfo;
+    IOTHUB_MESSAGE_HANDLE messageHandle;
+    TelemetryMsgInfo*	msgInfo;
 
+    if (NULL == jsonStr) {
+        return false;
+    }
+    msgInfo = IoT_CentralLib_AcquireMsgSlot();
+    if (NULL == msgInfo) {
+        Log_Debug("WARNING: send window is full (%lu messages in flight)\n",
+            (unsigned long)IoT_CentralLib_CountInFlight());
+        return false;
+    }
+    messageHandle = IoTHubMessage_CreateFromString(jsonStr);
     if (messageHandle == 0) {
         Log_Debug("WARNING: unable to create a new IoTHubMessage\n");
+        sFreeSlots[sNumFreeSlots++] = (uint8_t)(msgInfo - sMsgSlots);
         return false;
     }
-    MakeDateTimeStr(strBuf, sizeof(strBuf), timeStamp);
+    MakeDateTimeStr(strBuf, sizeof(strBuf), timeMs);
     IoTHubMessage_SetProperty(messageHandle, "iothub-creation-time-utc", strBuf);
-    msgInfo.msgHandle = messageHandle;
-    msgInfo.timeStamp = timeStamp;
-    vector_add_last(sWaitingMsgs, &msgInfo);
+    if (0 < batchCount) {
+        snprintf(strBuf, sizeof(strBuf), "%lu", (unsigned long)batchCount);
+        IoTHubMessage_SetProperty(messageHandle, "telemetry-batch", strBuf);
+    }
+    msgInfo->msgHandle = messageHandle;
+    msgInfo->framesLen = 0;
+    msgInfo->sentMs    = GetTickMs();
+    if (0 < framesLen && IoT_CentralLib_GrowBuf(
+            &msgInfo->frames, &msgInfo->framesCapacity, framesLen)) {
+        memcpy(msgInfo->frames, frames, framesLen);
+        msgInfo->framesLen = framesLen;
+    }
     if (IoTHubDeviceClient_LL_SendEventAsync(
-            sIothubClientHandle, messageHandle, SendMessageCallback, messageHandle)
+            sIothubClientHandle, messageHandle, SendMessageCallback,
+            IoT_CentralLib_MsgSlotToContext(msgInfo))
         != IOTHUB_CLIENT_OK) {
-        int theIndex = IoT_CentralLib_FindWaitingMsg(messageHandle);
-
         isOK = false;
-        if (0 <= theIndex) {
-            (void)vector_remove_at(sWaitingMsgs, theIndex);
-            IoTHubMessage_Destroy(messageHandle);
-        }
+        IoT_CentralLib_ReleaseMsgSlot(msgInfo);
+        Metrics_AddCount(MetricsCounter_SendFailures, 1);
         Log_Debug("WARNING: failed to hand over the message to IoTHubClient\n");
     } else {
+        Metrics_AddCount(MetricsCounter_MsgsSent, 1);
         Log_Debug("INFO: IoTHubClient accepted the message for delivery\n");
     }
 
     return isOK;
 }
 
-// Initialization and cleanup
-bool
-IoT_CentralLib_Initialize(
-    uint32_t cachBufSize, bool clearCache)
+static bool
+IoT_CentralLib_DoSendTelemetryItems(TelemetryItems* items,
+    uint32_t timeStamp)
 {
-    if (clearCache && NULL != sTelemetryCache) {
-        TelemetryItemCache_Destroy(sTelemetryCache);
-        sTelemetryCache = NULL;
+    // send the items with their binary frame to requeue on failure
+    uint32_t	frameSize = TelemetryItemCache_FrameSize(items);
+    uint32_t	frameLen = 0;
+
+    if (IoT_CentralLib_GrowBuf(&sBatchFrames, &sBatchFramesSize, frameSize)) {
+        frameLen = TelemetryItemCache_WriteFrame(items, timeStamp, sBatchFrames);
     }
-    if (NULL == sTelemetryCache) {
-        sTelemetryCache = TelemetryItemCache_New();
-        if (NULL != sTelemetryCache) {
+
+    return IoT_CentralLib_DoSendMessage(IoT_CentralLib_ToJson(items),
+        GetMessageTimeMs(items, timeStamp), sBatchFrames, frameLen, 0);
+}
+
+static bool
+IoT_CentralLib_ReserveBatch(uint32_t bufSize)
+{
+    if (bufSize > sBatchBufSize) {
+        char*	newBuf = realloc(sBatchBuf, bufSize);
+
+        if (NULL == newBuf) {
+            return false;
+        }
+        sBatchBuf     = newBuf;
+        sBatchBufSize = bufSize;
+    }
+
+    return true;
+}
+
+static uint32_t
+IoT_CentralLib_BatchElemLen(const char* jsonStr)
+{
+    return (uint32_t)(sizeof(BATCH_ELEM_HEAD) - 1 + DATE_TIME_STR_LEN
+        + sizeof(BATCH_ELEM_DATA) - 1 + strlen(jsonStr)
+        + sizeof(BATCH_ELEM_TAIL) - 1);
+}
+
+static bool
+IoT_CentralLib_AppendToBatch(uint32_t* len, uint32_t* framesLen,
+    uint32_t* count, const char* jsonStr, uint32_t timeStamp)
+{
+    // append a snapshot in sTelemetryItems to the batch message in sBatchBuf
+    // and its binary frame to sBatchFrames
+    uint32_t	elemLen = IoT_CentralLib_BatchElemLen(jsonStr);
+    uint32_t	frameLen;
+    char*	dst;
+
+    if (! IoT_CentralLib_ReserveBatch(*len + 1 + elemLen + sizeof(BATCH_TAIL))
+    || ! IoT_CentralLib_GrowBuf(&sBatchFrames, &sBatchFramesSize,
+            *framesLen + TelemetryItemCache_FrameSize(sTelemetryItems))) {
+        return false;
+    }
+    frameLen = TelemetryItemCache_WriteFrame(sTelemetryItems, timeStamp,
+        sBatchFrames + *framesLen);
+    if (0 == frameLen) {
+        return false;
+    }
+    *framesLen += frameLen;
+    dst = sBatchBuf + *len;
+    if (0 < *count) {
+        *dst++ = ',';
+    }
+    memcpy(dst, BATCH_ELEM_HEAD, sizeof(BATCH_ELEM_HEAD) - 1);
+    dst += sizeof(BATCH_ELEM_HEAD) - 1;
+    MakeDateTimeStr(dst, DATE_TIME_STR_LEN + 1,
+        GetMessageTimeMs(sTelemetryItems, timeStamp));
+    dst += strlen(dst);
+    memcpy(dst, BATCH_ELEM_DATA, sizeof(BATCH_ELEM_DATA) - 1);
+    dst += sizeof(BATCH_ELEM_DATA) - 1;
+    memcpy(dst, jsonStr, strlen(jsonStr));
+    dst += strlen(jsonStr);
+    memcpy(dst, BATCH_ELEM_TAIL, sizeof(BATCH_ELEM_TAIL) - 1);
+    dst += sizeof(BATCH_ELEM_TAIL) - 1;
+
+    *len = (uint32_t)(dst - sBatchBuf);
+    ++(*count);
+
+    return true;
+}
+
+static void
+IoT_CentralLib_RequeueBatch(
+    uint32_t framesLen, bool hasItems, uint32_t timeStamp)
+{
+    // put the snapshots dequeued for a batch back into the cache; the frames
+    // in sBatchFrames, then the one in sTelemetryItems if hasItems
+    if (0 < framesLen) {
+        (void)TelemetryItemCache_EnqueueFrames(
+            sTelemetryCache, sBatchFrames, framesLen);
+    }
+    if (hasItems) {
+        (void)TelemetryItemCache_EnqueueItems(
+            sTelemetryCache, sTelemetryItems, timeStamp);
+    }
+}
+
+static bool
+IoT_CentralLib_ResendCachedTelemetryBatches(void)
+{
+    // Send cached telemetry data as batch messages, each of which packs
+    // snapshots up to sResendBatchSize bytes.  A snapshot which doesn't
+    // fit into a batch is carried over to the next one, and is sent alone
+    // after the last batch.
+    bool	hasCarryOver = false;
+    uint32_t	carryOverTs = 0;
+
+    for (int i = 0; i < RESEND_MAX_NUM || hasCarryOver; ++i) {
+        uint32_t	len = sizeof(BATCH_HEAD) - 1;
+        uint32_t	framesLen = 0;
+        uint32_t	count = 0;
+        uint32_t	firstTs = 0;
+        uint32_t	timeStamp;
+
+        if (IoT_CentralLib_IsSendWindowFull()) {
+            // keep the rest in the cache until the window opens
+            IoT_CentralLib_RequeueBatch(0, hasCarryOver, carryOverTs);
+            break;
+        }
+        if (! IoT_CentralLib_ReserveBatch(sResendBatchSize + 1)) {
+            IoT_CentralLib_RequeueBatch(0, hasCarryOver, carryOverTs);
+            return false;
+        }
+        memcpy(sBatchBuf, BATCH_HEAD, len);
+        if (hasCarryOver) {
+            if (! IoT_CentralLib_AppendToBatch(&len, &framesLen, &count,
+                    IoT_CentralLib_ToJson(sTelemetryItems), carryOverTs)) {
+                IoT_CentralLib_RequeueBatch(0, true, carryOverTs);
+                return false;
+            }
+            hasCarryOver = false;
+            firstTs      = carryOverTs;
+        }
+        while (i < RESEND_MAX_NUM
+            && TelemetryItemCache_DequeueItemsTo(
+                sTelemetryCache, sTelemetryItems, &timeStamp)) {
+            const char*	jsonStr = IoT_CentralLib_ToJson(sTelemetryItems);
+
+            if (NULL == jsonStr) {
+                continue;  // no memory; drop the snapshot
+            }
+            if (0 < count
+            && sResendBatchSize < len + 1 + IoT_CentralLib_BatchElemLen(jsonStr)
+                + sizeof(BATCH_TAIL) - 1) {
+                hasCarryOver = true;
+                carryOverTs  = timeStamp;
+                break;
+            }
+            if (0 == count) {
+                firstTs = timeStamp;
+            }
+            if (! IoT_CentralLib_AppendToBatch(&len, &framesLen, &count,
+                    jsonStr, timeStamp)) {
+                IoT_CentralLib_RequeueBatch(framesLen, true, timeStamp);
+                return false;
+            }
+        }
+        if (0 == count) {
+            break;
+        }
+        memcpy(sBatchBuf + len, BATCH_TAIL, sizeof(BATCH_TAIL));
+        if (! IoT_CentralLib_DoSendMessage(sBatchBuf,
+                TimeStampToMs(firstTs), sBatchFrames, framesLen, count)) {
+            // keep the snapshots in the cache
+            IoT_CentralLib_RequeueBatch(framesLen, hasCarryOver, carryOverTs);
+            return false;
+        }
+        if (! hasCarryOver && TelemetryItemCache_IsEmpty(sTelemetryCache)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+static bool
+IoT_CentralLib_OpenCacheStore(uint32_t storeSize)
+{
+    // open the persistent telemetry cache on the mutable storage and
+    // recover the frames saved before restart
+    sCacheStoreFd = Storage_OpenMutableFile();
+    if (0 > sCacheStoreFd) {
+        Log_Debug("ERROR: Storage_OpenMutableFile failed: %d\n", errno);
+        return false;
+    }
+    sCacheStore = TelemetryCacheStore_New();
+    if (NULL == sCacheStore
+    || ! TelemetryCacheStore_Open(sCacheStore, sCacheStoreFd, storeSize)) {
+        if (NULL != sCacheStore) {
+            TelemetryCacheStore_Destroy(sCacheStore);
+            sCacheStore = NULL;
+        }
+        close(sCacheStoreFd);
+        sCacheStoreFd = -1;
+        return false;
+    }
+    Log_Debug("INFO: %u cached telemetry recovered.\n",
+        TelemetryCacheStore_CountFrames(sCacheStore));
+
+    return true;
+}
+
+static void
+IoT_CentralLib_CloseCacheStore(void)
+{
+    if (NULL != sCacheStore) {
+        TelemetryCacheStore_Destroy(sCacheStore);
+        sCacheStore = NULL;
+    }
+    if (0 <= sCacheStoreFd) {
+        close(sCacheStoreFd);
+        sCacheStoreFd = -1;
+    }
+}
+
+static void
+IoT_CentralLib_CreateCache(uint32_t cachBufSize, uint32_t cacheStoreSize)
+{
+    sBaseTime = time(NULL);
+    if (0 < cacheStoreSize && NULL == sCacheStore) {
+        (void)IoT_CentralLib_OpenCacheStore(cacheStoreSize);
+    }
+    sTelemetryCache = TelemetryItemCache_New();
+    if (NULL != sTelemetryCache) {
+        if (NULL != sCacheStore) {
+            if (TelemetryCacheStore_IsEmpty(sCacheStore)) {
+                TelemetryCacheStore_SetTimeBase(sCacheStore, sBaseTime);
+            } else {
+                // continue the time stamps of the recovered frames
+                sBaseTime = (time_t)TelemetryCacheStore_GetTimeBase(
+                    sCacheStore);
+            }
+            TelemetryItemCache_AttachStore(sTelemetryCache, sCacheStore);
+        } else {
             TelemetryItemCache_Init(sTelemetryCache,
                 NULL, cachBufSize);
+            // compressed frames to hold longer outage in the memory
+            (void)TelemetryItemCache_EnableCompression(
+                sTelemetryCache, true);
         }
-        sBaseTime = time(NULL);
+        (void)TelemetryItemCache_SetEviction(sTelemetryCache, sCacheEviction);
     }
+}
 
+// Initialization and cleanup
+bool
+IoT_CentralLib_InitializeCache(uint32_t cachBufSize, uint32_t cacheStoreSize)
+{
+    if (NULL == sTelemetryCache) {
+        IoT_CentralLib_CreateCache(cachBufSize, cacheStoreSize);
+    }
     if (NULL == sTelemetryItems) {
         sTelemetryItems = TelemetryItems_New();
-        if (NULL == sTelemetryItems) {
-            return false;
-        }
     }
 
-    if (NULL == sWaitingMsgs) {
-        sWaitingMsgs = vector_init(sizeof(TelemetryMsgInfo));
-    } else if (0 != vector_size(sWaitingMsgs)) {
-        TelemetryMsgInfo* curs =
-            (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
+    return (NULL != sTelemetryCache && NULL != sTelemetryItems);
+}
 
-        for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-            IoTHubMessage_Destroy(curs->msgHandle);
-            ++curs;
+bool
+IoT_CentralLib_Initialize(
+    uint32_t cachBufSize, uint32_t cacheStoreSize, bool clearCache)
+{
+    if (clearCache && NULL != sTelemetryCache) {
+        TelemetryItemCache_Destroy(sTelemetryCache);
+        sTelemetryCache = NULL;
+        if (NULL != sCacheStore) {
+            TelemetryCacheStore_Clear(sCacheStore);
         }
     }
+    if (! IoT_CentralLib_InitializeCache(cachBufSize, cacheStoreSize)) {
+        return false;
+    }
+
+    if (NULL == sRateControl) {
+        sRateControl = SendRateControl_New();
+    }
+    if (NULL != sRateControl) {
+        // restart the rate control on (re)connection
+        SendRateControl_SetMaxWindow(sRateControl, sSendWindow);
+        SendRateControl_Reset(sRateControl);
+    }
+    IoT_CentralLib_ResetMsgSlots(false);
     sIothubClientHandle = Get_IOTHUB_DEVICE_CLIENT_LL_HANDLE();
 
     return (sIothubClientHandle != NULL);
@@ -209,25 +663,26 @@ IoT_CentralLib_Initialize(
 void
 IoT_CentralLib_Cleanup(void)
 {
-    if (NULL != sWaitingMsgs) {
-        TelemetryMsgInfo*   curs =
-            (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
-
-        for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-            IoTHubMessage_Destroy(curs->msgHandle);
-            ++curs;
-        }
-        vector_destroy(sWaitingMsgs);
-        sWaitingMsgs = NULL;
-    }
+    IoT_CentralLib_ResetMsgSlots(true);
+    free(sBatchBuf);
+    free(sBatchFrames);
+    sBatchBuf        = NULL;
+    sBatchBufSize    = 0;
+    sBatchFrames     = NULL;
+    sBatchFramesSize = 0;
     if (NULL != sTelemetryCache) {
         TelemetryItemCache_Destroy(sTelemetryCache);
         sTelemetryCache = NULL;
     }
+    IoT_CentralLib_CloseCacheStore();
     if (NULL != sTelemetryItems) {
         TelemetryItems_Destroy(sTelemetryItems);
         sTelemetryItems = NULL;
     }
+    if (NULL != sRateControl) {
+        SendRateControl_Destroy(sRateControl);
+        sRateControl = NULL;
+    }
 }
 
 // Send telemetry data
@@ -238,7 +693,19 @@ IoT_CentralLib_SendTelemetry(const char* jsonStr, uint32_t* outTimestamp)
 
     *outTimestamp = timeStamp;
 
-    return IoT_CentralLib_DoSendTelemetry(jsonStr, timeStamp);
+    return IoT_CentralLib_DoSendMessage(jsonStr,
+        TimeStampToMs(timeStamp), NULL, 0, 0);
+}
+
+bool
+IoT_CentralLib_SendTelemetryItems(TelemetryItems* items,
+    uint32_t* outTimestamp)
+{
+    uint32_t	timeStamp = GetTimestamp();
+
+    *outTimestamp = timeStamp;
+
+    return IoT_CentralLib_DoSendTelemetryItems(items, timeStamp);
 }
 
 // Telemetry data caching during network down
@@ -256,6 +723,8 @@ bool
 IoT_CentralLib_EnqueueTelemtryItemsToCache(
     const TelemetryItems* telemetryItems, uint32_t timeStamp)
 {
+    Metrics_AddCount(MetricsCounter_FramesCached, 1);
+
     return TelemetryItemCache_EnqueueItems(sTelemetryCache,
         telemetryItems, timeStamp);
 }
@@ -266,22 +735,40 @@ IoT_CentralLib_HasCachedTelemetryItems(void)
     return (! TelemetryItemCache_IsEmpty(sTelemetryCache));
 }
 
+uint32_t
+IoT_CentralLib_CountCachedFrames(void)
+{
+    return (NULL != sTelemetryCache
+        ? TelemetryItemCache_CountFrames(sTelemetryCache) : 0);
+}
+
+void
+IoT_CentralLib_SetResendBatchSize(uint32_t batchSize)
+{
+    sResendBatchSize = batchSize;
+}
+
 bool
 IoT_CentralLib_ResendCachedTelemetryItems(void)
 {
-    // send cached telemetry data up to RESEND_MAX_NUM at a time
+    // send cached telemetry data up to RESEND_MAX_NUM messages at a time
     if (TelemetryItemCache_IsEmpty(sTelemetryCache)) {
         return true;
+    } else if (0 < sResendBatchSize) {
+        return IoT_CentralLib_ResendCachedTelemetryBatches();
     }
 
     for (int i = 0; i < RESEND_MAX_NUM; ++i) {
         uint32_t	timeStamp;
-        const char* jsonStr;
 
-        (void)TelemetryItemCache_DequeueItemsTo(
-            sTelemetryCache, sTelemetryItems, &timeStamp);
-        jsonStr = TelemetryItems_ToJson(sTelemetryItems);
-        if (! IoT_CentralLib_DoSendTelemetry(jsonStr, timeStamp)) {
+        if (IoT_CentralLib_IsSendWindowFull()) {
+            break;  // keep the rest in the cache until the window opens
+        }
+        if (! TelemetryItemCache_DequeueItemsTo(
+                sTelemetryCache, sTelemetryItems, &timeStamp)) {
+            break;  // nothing valid is left, e.g. the store was cleared
+        }
+        if (! IoT_CentralLib_DoSendTelemetryItems(sTelemetryItems, timeStamp)) {
             return false;  // error
         }
         TelemetryItems_Clear(sTelemetryItems);
@@ -294,21 +781,103 @@ IoT_CentralLib_ResendCachedTelemetryItems(void)
     return true;
 }
 
+// Send window of in-flight messages
+void
+IoT_CentralLib_SetSendWindow(uint32_t windowSize)
+{
+    if (0 == windowSize || SEND_WINDOW_MAX < windowSize) {
+        windowSize = SEND_WINDOW_MAX;
+    }
+    sSendWindow = windowSize;
+    if (NULL != sRateControl) {
+        SendRateControl_SetMaxWindow(sRateControl, windowSize);
+    }
+}
+
+uint32_t
+IoT_CentralLib_GetSendWindow(void)
+{
+    return sSendWindow;
+}
+
+bool
+IoT_CentralLib_IsSendWindowFull(void)
+{
+    return (0 == sNumFreeSlots
+        || IoT_CentralLib_CurrentWindow() <= IoT_CentralLib_CountInFlight());
+}
+
+uint32_t
+IoT_CentralLib_CountInFlightMsgs(void)
+{
+    return IoT_CentralLib_CountInFlight();
+}
+
+uint32_t
+IoT_CentralLib_GetPeakInFlightMsgs(void)
+{
+    return sPeakInFlight;
+}
+
+bool
+IoT_CentralLib_GetSendRateStats(SendRateStats* outStats)
+{
+    if (NULL == sRateControl) {
+        return false;
+    }
+    SendRateControl_GetStats(sRateControl, outStats);
+
+    return true;
+}
+
 uint32_t
 IoT_CentralLib_GetTmeStamp(void)
 {
     return GetTimestamp();
 }
 
-void IoT_CentralLib_SendProperty(const char* jsonStr)
+bool
+IoT_CentralLib_SetCacheEviction(TelemetryCacheEviction eviction)
+{
+    sCacheEviction = eviction;
+    if (NULL == sTelemetryCache) {
+        return true;  // applied when the cache is created
+    }
+
+    return TelemetryItemCache_SetEviction(sTelemetryCache, eviction);
+}
+
+bool
+IoT_CentralLib_SetCacheItemPolicy(
+    TelemetryNameId nameId, uint8_t priority, uint32_t ttlSec)
+{
+    if (NULL == sTelemetryCache) {
+        return false;
+    }
+
+    return TelemetryItemCache_SetItemPolicy(
+        sTelemetryCache, nameId, priority, ttlSec);
+}
+
+void
+IoT_CentralLib_ClearCacheItemPolicies(void)
 {
+    if (NULL != sTelemetryCache) {
+        TelemetryItemCache_ClearItemPolicies(sTelemetryCache);
+    }
+}
+
+bool IoT_CentralLib_SendProperty(const char* jsonStr)
+{
+    bool ret = false;
+
     Log_Debug("Sending IoT Hub Message: %s\n", jsonStr);
 
     IOTHUB_MESSAGE_HANDLE messageHandle = IoTHubMessage_CreateFromString(jsonStr);
 
     if (messageHandle == 0) {
         Log_Debug("WARNING: unable to create a new IoTHubMessage\n");
-        return;
+        return false;
     }
 
     if (IoTHubDeviceClient_LL_SendReportedState(sIothubClientHandle, jsonStr, strlen(jsonStr), NULL, 0) != IOTHUB_CLIENT_OK) {
@@ -316,7 +885,10 @@ void IoT_CentralLib_SendProperty(const char* jsonStr)
     }
     else {
         //Log_Debug("INFO: IoTHubClient accepted the message for delivery\n");
+        ret = true;
     }
 
     IoTHubMessage_Destroy(messageHandle);
+
+    return ret;
 }
@@ -32,26 +32,82 @@
 #include <stdint.h>
 #endif
 
+#ifndef _TELEMETRY_ITEM_CACHE_H_
+#include "TelemetryItemCache.h"
+#endif
+
 typedef struct TelemetryItems	TelemetryItems;
+typedef struct SendRateStats	SendRateStats;
 
 // Initialization and cleanup
+extern bool IoT_CentralLib_InitializeCache(
+    uint32_t cachBufSize, uint32_t cacheStoreSize);
 extern bool IoT_CentralLib_Initialize(
-    uint32_t cachBufSize, bool clearCache);
+    uint32_t cachBufSize, uint32_t cacheStoreSize, bool clearCache);
+//
+// NOTE: If cacheStoreSize is not 0, telemetry data is cached on the
+//       mutable storage instead of the memory, and is kept over restart.
+//       IoT_CentralLib_InitializeCache() opens the cache and recovers the
+//       stored frames without the hub connection, so that it is called at
+//       startup; IoT_CentralLib_Initialize() calls it if not yet called.
 extern void IoT_CentralLib_Cleanup(void);
 
 // Send telemetry data
 extern bool	IoT_CentralLib_SendTelemetry(
     const char* jsonStr, uint32_t* outTimestamp);
+extern bool	IoT_CentralLib_SendTelemetryItems(
+    TelemetryItems* items, uint32_t* outTimestamp);
+//
+// NOTE: Telemetry data items sent by IoT_CentralLib_SendTelemetryItems() are
+//       put back to the cache when the delivery fails.
+//       The creation time of the message is the capture time of the items
+//       in millisecond resolution if they have, or the time stamp.
 
 // Telemetry data caching during network down
 extern bool	IoT_CentralLib_CheckConnection(void);
 extern bool	IoT_CentralLib_EnqueueTelemtryItemsToCache(
     const TelemetryItems* telemetryItems, uint32_t timeStamp);
 extern bool	IoT_CentralLib_HasCachedTelemetryItems(void);
+extern uint32_t	IoT_CentralLib_CountCachedFrames(void);
+extern void	IoT_CentralLib_SetResendBatchSize(uint32_t batchSize);
 extern bool	IoT_CentralLib_ResendCachedTelemetryItems(void);
+//
+// NOTE: When the batch size is not 0, cached telemetry data is resent as
+//       batch messages of up to batchSize bytes each, which pack snapshots
+//       with their own creation time as follows;
+//         {"snapshots":[{"time":"<UTC>","data":{<telemetry>}}, ...]}
+//       A snapshot larger than batchSize is sent alone in a batch.
 extern uint32_t	IoT_CentralLib_GetTmeStamp(void);
+extern bool	IoT_CentralLib_SetCacheEviction(TelemetryCacheEviction eviction);
+extern bool	IoT_CentralLib_SetCacheItemPolicy(
+    TelemetryNameId nameId, uint8_t priority, uint32_t ttlSec);
+extern void	IoT_CentralLib_ClearCacheItemPolicies(void);
+//
+// NOTE: The eviction policy is kept over IoT_CentralLib_Initialize(), while
+//       the item policies are of the current cache; they are set after the
+//       cache is created.  See TelemetryItemCache.h for the policies.
+//       With the persistent store, only dropping the oldest and the TTL are
+//       applicable, and the setters return false for the others; the store
+//       keeps dropping the oldest frames then.
+
+// Send window of in-flight messages
+extern void	IoT_CentralLib_SetSendWindow(uint32_t windowSize);
+extern uint32_t	IoT_CentralLib_GetSendWindow(void);
+extern bool	IoT_CentralLib_IsSendWindowFull(void);
+extern uint32_t	IoT_CentralLib_CountInFlightMsgs(void);
+extern uint32_t	IoT_CentralLib_GetPeakInFlightMsgs(void);
+extern bool	IoT_CentralLib_GetSendRateStats(SendRateStats* outStats);
+//
+// NOTE: Messages handed over to IoTHubClient are tracked until they are
+//       confirmed, and at most windowSize (up to 32, 0: 32) messages are
+//       kept in flight.  While the window is full, IoT_CentralLib_SendTelemetry()
+//       fails and new telemetry data should be cached instead.
+//       Within windowSize, the window is narrowed by SendRateControl from
+//       the confirmation results and round-trip times, so that telemetry
+//       data is diverted to the cache before IoT Hub starts rejecting.
 
 // Send property data
-extern void IoT_CentralLib_SendProperty(const char* jsonStr);
+//   Returns false if the reported state is not handed over to IoTHubClient.
+extern bool IoT_CentralLib_SendProperty(const char* jsonStr);
 
 #endif  // _LIB_CLOUD_H_
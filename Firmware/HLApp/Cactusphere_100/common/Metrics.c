@@ -0,0 +1,229 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "StringBuf.h"
+
+#define METRICS_NUM_BUCKETS	22	// [0, 8), [8, 16), ..., [2^23, inf) usec
+#define METRICS_FIRST_BITS	3	// bits of the upper bound of bucket 0
+
+typedef struct MetricsGaugeValue {
+    uint32_t	value;
+    uint32_t	peak;
+} MetricsGaugeValue;
+
+typedef struct MetricsHistogram {
+    uint32_t	buckets[METRICS_NUM_BUCKETS];
+    uint32_t	count;
+    uint32_t	maxUs;
+    uint64_t	totalUs;
+} MetricsHistogram;
+
+static uint32_t	sCounters[MetricsCounter_Num];
+static MetricsGaugeValue	sGauges[MetricsGauge_Num];
+static MetricsHistogram	sHistograms[MetricsLatency_Num];
+static uint64_t	sStartUs = 0;
+static StringBuf*	sJsonBuf = NULL;
+
+static const char*	sCounterNames[MetricsCounter_Num] = {
+    "ticks", "itemsAcquired", "msgsSent", "sendFailures", "framesCached",
+    "rtAppErrors",
+};
+static const char*	sGaugeNames[MetricsGauge_Num] = {
+    "cacheFrames", "inFlightMsgs", "sendWindow",
+};
+static const char*	sLatencyNames[MetricsLatency_Num] = {
+    "tick", "schedule", "rtAppRoundTrip", "serialize", "sendConfirm",
+};
+
+static inline int
+Metrics_BucketOf(uint32_t latencyUs)
+{
+    // number of significant bits less those of the first bucket
+    int	bits = (0 == latencyUs ? 0 : 32 - __builtin_clz(latencyUs));
+
+    if (bits <= METRICS_FIRST_BITS) {
+        return 0;
+    }
+    bits -= METRICS_FIRST_BITS;
+
+    return (bits < METRICS_NUM_BUCKETS ? bits : METRICS_NUM_BUCKETS - 1);
+}
+
+static uint32_t
+Metrics_Percentile(const MetricsHistogram* hist, uint32_t percent)
+{
+    // upper bound of the bucket where the percentile falls in, up to max
+    uint32_t	rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t	sum = 0;
+
+    for (int i = 0; i < METRICS_NUM_BUCKETS - 1; ++i) {
+        sum += hist->buckets[i];
+        if (rank <= sum) {
+            uint32_t	upperUs = 1u << (METRICS_FIRST_BITS + i);
+
+            return (upperUs < hist->maxUs ? upperUs : hist->maxUs);
+        }
+    }
+
+    return hist->maxUs;
+}
+
+// Initialization and cleanup
+void
+Metrics_Reset(void)
+{
+    memset(sCounters, 0, sizeof(sCounters));
+    memset(sGauges, 0, sizeof(sGauges));
+    memset(sHistograms, 0, sizeof(sHistograms));
+    sStartUs = Metrics_GetTimeUs();
+}
+
+void
+Metrics_Cleanup(void)
+{
+    if (NULL != sJsonBuf) {
+        StringBuf_Destroy(sJsonBuf);
+        sJsonBuf = NULL;
+    }
+}
+
+// Record
+uint64_t
+Metrics_GetTimeUs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+void
+Metrics_AddCount(MetricsCounter id, uint32_t count)
+{
+    sCounters[id] += count;
+}
+
+void
+Metrics_SetGauge(MetricsGauge id, uint32_t value)
+{
+    sGauges[id].value = value;
+    if (sGauges[id].peak < value) {
+        sGauges[id].peak = value;
+    }
+}
+
+void
+Metrics_RecordLatency(MetricsLatency id, uint32_t latencyUs)
+{
+    MetricsHistogram*	hist = &sHistograms[id];
+
+    ++hist->buckets[Metrics_BucketOf(latencyUs)];
+    ++hist->count;
+    hist->totalUs += latencyUs;
+    if (hist->maxUs < latencyUs) {
+        hist->maxUs = latencyUs;
+    }
+}
+
+void
+Metrics_RecordSince(MetricsLatency id, uint64_t startUs)
+{
+    uint64_t	elapsedUs = Metrics_GetTimeUs() - startUs;
+
+    Metrics_RecordLatency(id,
+        (UINT32_MAX < elapsedUs ? UINT32_MAX : (uint32_t)elapsedUs));
+}
+
+// Read
+uint32_t
+Metrics_GetCount(MetricsCounter id)
+{
+    return sCounters[id];
+}
+
+void
+Metrics_GetLatencyStats(MetricsLatency id, MetricsLatencyStats* outStats)
+{
+    const MetricsHistogram*	hist = &sHistograms[id];
+
+    uint64_t	meanTenthUs = (0 < hist->count
+        ? (hist->totalUs * 10 + hist->count / 2) / hist->count : 0);
+
+    outStats->count  = hist->count;
+    outStats->meanTenthUs = (UINT32_MAX < meanTenthUs
+        ? UINT32_MAX : (uint32_t)meanTenthUs);
+    outStats->p50Us  = Metrics_Percentile(hist, 50);
+    outStats->p99Us  = Metrics_Percentile(hist, 99);
+    outStats->maxUs  = hist->maxUs;
+}
+
+const char*
+Metrics_ToJson(const char* wrapKey)
+{
+    if (NULL == sJsonBuf) {
+        sJsonBuf = StringBuf_New();
+        if (NULL == sJsonBuf) {
+            return NULL;
+        }
+    }
+    StringBuf_Clear(sJsonBuf);
+
+    if (NULL != wrapKey) {
+        StringBuf_AppendByPrintf(sJsonBuf, "{\"%s\":", wrapKey);
+    }
+    StringBuf_AppendByPrintf(sJsonBuf, "{\"uptimeSec\":%lu,\"counters\":{",
+        (unsigned long)((Metrics_GetTimeUs() - sStartUs) / 1000000));
+    for (int i = 0; i < MetricsCounter_Num; ++i) {
+        StringBuf_AppendByPrintf(sJsonBuf, "%s\"%s\":%lu",
+            (0 < i ? "," : ""), sCounterNames[i], (unsigned long)sCounters[i]);
+    }
+    StringBuf_Append(sJsonBuf, "},\"gauges\":{");
+    for (int i = 0; i < MetricsGauge_Num; ++i) {
+        StringBuf_AppendByPrintf(sJsonBuf, "%s\"%s\":{\"value\":%lu,\"peak\":%lu}",
+            (0 < i ? "," : ""), sGaugeNames[i],
+            (unsigned long)sGauges[i].value, (unsigned long)sGauges[i].peak);
+    }
+    StringBuf_Append(sJsonBuf, "},\"latencyUs\":{");
+    for (int i = 0; i < MetricsLatency_Num; ++i) {
+        MetricsLatencyStats	stats;
+
+        Metrics_GetLatencyStats((MetricsLatency)i, &stats);
+        StringBuf_AppendByPrintf(sJsonBuf,
+            "%s\"%s\":{\"count\":%lu,\"mean\":%lu.%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+            (0 < i ? "," : ""), sLatencyNames[i], (unsigned long)stats.count,
+            (unsigned long)(stats.meanTenthUs / 10),
+            (unsigned long)(stats.meanTenthUs % 10), (unsigned long)stats.p50Us,
+            (unsigned long)stats.p99Us, (unsigned long)stats.maxUs);
+    }
+    StringBuf_Append(sJsonBuf, (NULL != wrapKey ? "}}}" : "}}"));
+
+    return StringBuf_GetStr(sJsonBuf);
+}
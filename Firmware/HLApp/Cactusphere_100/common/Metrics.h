@@ -0,0 +1,99 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+// event counters
+typedef enum {
+    MetricsCounter_Ticks = 0,	// fetch timer ticks
+    MetricsCounter_ItemsAcquired,	// telemetry values acquired
+    MetricsCounter_MsgsSent,	// messages handed over to IoTHubClient
+    MetricsCounter_SendFailures,	// messages failed to hand over
+    MetricsCounter_FramesCached,	// snapshots put into the cache
+    MetricsCounter_RTAppErrors,	// failed requests to the real-time app
+    MetricsCounter_Num
+} MetricsCounter;
+
+// sampled levels, kept with their peak
+typedef enum {
+    MetricsGauge_CacheFrames = 0,	// snapshots in the cache
+    MetricsGauge_InFlightMsgs,	// messages waiting for confirmation
+    MetricsGauge_SendWindow,	// current send window
+    MetricsGauge_Num
+} MetricsGauge;
+
+// latency histograms
+typedef enum {
+    MetricsLatency_Tick = 0,	// whole fetch timer tick
+    MetricsLatency_Schedule,	// DataFetchScheduler_Schedule()
+    MetricsLatency_RTAppRoundTrip,	// request and response of the real-time app
+    MetricsLatency_Serialize,	// telemetry items to JSON
+    MetricsLatency_SendConfirm,	// message sent to its confirmation
+    MetricsLatency_Num
+} MetricsLatency;
+
+// summary of a latency histogram [usec]
+typedef struct MetricsLatencyStats {
+    uint32_t	count;
+    uint32_t	meanTenthUs;    // mean in 0.1[usec] (fixed point)
+    uint32_t	p50Us;      // percentiles by the upper bound of the bucket
+    uint32_t	p99Us;
+    uint32_t	maxUs;
+} MetricsLatencyStats;
+
+// Initialization and cleanup
+extern void	Metrics_Reset(void);
+extern void	Metrics_Cleanup(void);
+
+// Record
+extern uint64_t	Metrics_GetTimeUs(void);
+extern void	Metrics_AddCount(MetricsCounter id, uint32_t count);
+extern void	Metrics_SetGauge(MetricsGauge id, uint32_t value);
+extern void	Metrics_RecordLatency(MetricsLatency id, uint32_t latencyUs);
+extern void	Metrics_RecordSince(MetricsLatency id, uint64_t startUs);
+
+// Read
+extern uint32_t	Metrics_GetCount(MetricsCounter id);
+extern void	Metrics_GetLatencyStats(MetricsLatency id,
+    MetricsLatencyStats* outStats);
+extern const char*	Metrics_ToJson(const char* wrapKey);
+
+//
+// NOTE: The metrics are a fixed set in static storage, so recording them is
+//       a few additions without allocation or lookup.  A latency histogram
+//       has power of 2 buckets from 8[usec] to 8[sec] and above, and the
+//       mean is kept to 0.1[usec] as the short latencies fall in bucket 0.
+//       Metrics_ToJson() returns all the metrics as a JSON object, wrapped
+//       as {"<wrapKey>": ...} unless wrapKey is NULL; the string is valid
+//       until the next call.  Metrics_Cleanup() frees the string buffer.
+
+#endif  // _METRICS_H_
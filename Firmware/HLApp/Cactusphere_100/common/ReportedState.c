@@ -0,0 +1,287 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ReportedState.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LibCloud.h"
+#include "PropertyItems.h"
+#include "StringBuf.h"
+
+// reported property; name and value are held as JSON texts
+typedef struct ReportedProperty {
+    char*	name;   // quoted and escaped property name
+    char*	value;  // JSON value
+} ReportedProperty;
+
+struct ReportedState {
+    vector	mProperties;    // properties to be reported, in order of arrival
+    StringBuf*	mJson;      // buffer of the rendered patch
+};
+
+// quote a string as a JSON string, escaping it unless isEscaped; the
+// result is to be freed by the caller
+static char*
+ReportedState_Quote(const char* str, bool isEscaped)
+{
+    size_t	len = 2;
+    char*	quoted;
+    char*	dst;
+
+    for (const unsigned char* p = (const unsigned char*)str; '\0' != *p; ++p) {
+        if (isEscaped) {
+            len += 1;
+        } else if ('"' == *p || '\\' == *p) {
+            len += 2;
+        } else if (*p < 0x20) {
+            len += 6;
+        } else {
+            len += 1;
+        }
+    }
+    quoted = (char*)malloc(len + 1);
+    if (NULL == quoted) {
+        return NULL;
+    }
+
+    dst    = quoted;
+    *dst++ = '"';
+    for (const unsigned char* p = (const unsigned char*)str; '\0' != *p; ++p) {
+        if (isEscaped) {
+            *dst++ = (char)*p;
+        } else if ('"' == *p || '\\' == *p) {
+            *dst++ = '\\';
+            *dst++ = (char)*p;
+        } else if (*p < 0x20) {
+            dst += sprintf(dst, "\\u%04x", *p);
+        } else {
+            *dst++ = (char)*p;
+        }
+    }
+    *dst++ = '"';
+    *dst   = '\0';
+
+    return quoted;
+}
+
+// set a property of the quoted name to the value; takes both strings
+static bool
+ReportedState_SetOwned(ReportedState* me, char* quotedName, char* value)
+{
+    ReportedProperty*	curs =
+        (ReportedProperty*)vector_get_data(me->mProperties);
+    ReportedProperty	newProp;
+
+    if (NULL == quotedName || NULL == value) {
+        free(quotedName);
+        free(value);
+        return false;
+    }
+
+    // a handful of properties per patch; merge by a linear search
+    for (int i = 0, n = vector_size(me->mProperties); i < n; ++i, ++curs) {
+        if (0 == strcmp(curs->name, quotedName)) {
+            free(quotedName);
+            free(curs->value);
+            curs->value = value;
+            return true;
+        }
+    }
+
+    newProp.name  = quotedName;
+    newProp.value = value;
+    if (0 != vector_add_last(me->mProperties, &newProp)) {
+        free(quotedName);
+        free(value);
+        return false;
+    }
+
+    return true;
+}
+
+// Initialization and cleanup
+ReportedState*
+ReportedState_New(void)
+{
+    ReportedState*	newObj = (ReportedState*)malloc(sizeof(ReportedState));
+
+    if (NULL != newObj) {
+        newObj->mProperties = vector_init(sizeof(ReportedProperty));
+        newObj->mJson       = StringBuf_New();
+        if (NULL == newObj->mProperties || NULL == newObj->mJson) {
+            if (NULL != newObj->mProperties) {
+                vector_destroy(newObj->mProperties);
+            }
+            StringBuf_Destroy(newObj->mJson);
+            free(newObj);
+            newObj = NULL;
+        }
+    }
+
+    return newObj;
+}
+
+void
+ReportedState_Destroy(ReportedState* me)
+{
+    if (NULL != me) {
+        ReportedState_Clear(me);
+        vector_destroy(me->mProperties);
+        StringBuf_Destroy(me->mJson);
+        free(me);
+    }
+}
+
+void
+ReportedState_Clear(ReportedState* me)
+{
+    ReportedProperty*	curs =
+        (ReportedProperty*)vector_get_data(me->mProperties);
+
+    for (int i = 0, n = vector_size(me->mProperties); i < n; ++i, ++curs) {
+        free(curs->name);
+        free(curs->value);
+    }
+    vector_clear(me->mProperties);
+}
+
+// Attribute
+bool
+ReportedState_IsEmpty(const ReportedState* me)
+{
+    return vector_is_empty(me->mProperties);
+}
+
+int
+ReportedState_Count(const ReportedState* me)
+{
+    return vector_size(me->mProperties);
+}
+
+// Set reported property values
+bool
+ReportedState_SetJson(
+    ReportedState* me, const char* name, const char* jsonValue)
+{
+    return ReportedState_SetOwned(
+        me, ReportedState_Quote(name, false), strdup(jsonValue));
+}
+
+bool
+ReportedState_SetBool(ReportedState* me, const char* name, bool value)
+{
+    return ReportedState_SetJson(me, name, value ? "true" : "false");
+}
+
+bool
+ReportedState_SetNumber(ReportedState* me, const char* name, uint32_t value)
+{
+    char	numStr[16];
+
+    snprintf(numStr, sizeof(numStr), "%u", value);
+    return ReportedState_SetJson(me, name, numStr);
+}
+
+bool
+ReportedState_SetString(
+    ReportedState* me, const char* name, const char* value)
+{
+    return ReportedState_SetOwned(me, ReportedState_Quote(name, false),
+        ReportedState_Quote(value, false));
+}
+
+bool
+ReportedState_SetNull(ReportedState* me, const char* name)
+{
+    return ReportedState_SetJson(me, name, "null");
+}
+
+void
+ReportedState_AddPropertyItems(ReportedState* me, vector propertyItems)
+{
+    const ResponsePropertyItem*	curs =
+        (const ResponsePropertyItem*)vector_get_data(propertyItems);
+
+    for (int i = 0, n = vector_size(propertyItems); i < n; ++i, ++curs) {
+        switch (curs->type) {
+        case TYPE_BOOL:
+            ReportedState_SetBool(me, curs->propertyName, curs->value.b);
+            break;
+        case TYPE_NUM:
+            ReportedState_SetNumber(me, curs->propertyName, curs->value.ul);
+            break;
+        case TYPE_STR:
+            // already escaped by PropertyItems_AddItem()
+            ReportedState_SetOwned(me,
+                ReportedState_Quote(curs->propertyName, false),
+                ReportedState_Quote(curs->value.str, true));
+            break;
+        case TYPE_NULL:
+            ReportedState_SetNull(me, curs->propertyName);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Render all properties as one JSON object
+const char*
+ReportedState_ToJson(ReportedState* me)
+{
+    const ReportedProperty*	curs =
+        (const ReportedProperty*)vector_get_data(me->mProperties);
+
+    StringBuf_Clear(me->mJson);
+    StringBuf_AppendChar(me->mJson, '{');
+    for (int i = 0, n = vector_size(me->mProperties); i < n; ++i, ++curs) {
+        if (0 < i) {
+            StringBuf_AppendChar(me->mJson, ',');
+        }
+        StringBuf_Append(me->mJson, curs->name);
+        StringBuf_AppendChar(me->mJson, ':');
+        StringBuf_Append(me->mJson, curs->value);
+    }
+    StringBuf_AppendChar(me->mJson, '}');
+
+    return StringBuf_GetStr(me->mJson);
+}
+
+// Send all properties as one reported state patch
+bool
+ReportedState_Flush(ReportedState* me)
+{
+    if (ReportedState_IsEmpty(me)) {
+        return false;
+    }
+    if (! IoT_CentralLib_SendProperty(ReportedState_ToJson(me))) {
+        return false;   // kept to be sent by the next flush
+    }
+    ReportedState_Clear(me);
+
+    return true;
+}
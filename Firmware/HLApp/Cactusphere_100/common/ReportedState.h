@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _REPORTED_STATE_H_
+#define _REPORTED_STATE_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef CONTAINERS_VECTOR_H
+#include <vector.h>
+#endif
+
+typedef struct ReportedState	ReportedState;
+
+// Initialization and cleanup
+extern ReportedState*	ReportedState_New(void);
+extern void	ReportedState_Destroy(ReportedState* me);
+extern void	ReportedState_Clear(ReportedState* me);
+
+// Attribute
+extern bool	ReportedState_IsEmpty(const ReportedState* me);
+extern int	ReportedState_Count(const ReportedState* me);
+
+// Set reported property values
+extern bool	ReportedState_SetBool(
+    ReportedState* me, const char* name, bool value);
+extern bool	ReportedState_SetNumber(
+    ReportedState* me, const char* name, uint32_t value);
+extern bool	ReportedState_SetString(
+    ReportedState* me, const char* name, const char* value);
+extern bool	ReportedState_SetNull(ReportedState* me, const char* name);
+extern bool	ReportedState_SetJson(
+    ReportedState* me, const char* name, const char* jsonValue);
+extern void	ReportedState_AddPropertyItems(
+    ReportedState* me, vector propertyItems);
+
+// Render all properties as one JSON object
+extern const char*	ReportedState_ToJson(ReportedState* me);
+
+// Send all properties as one reported state patch
+//   The properties are kept if they are not handed over to IoTHubClient.
+extern bool	ReportedState_Flush(ReportedState* me);
+
+//
+// NOTE: The properties set are merged by name; the last value set wins and
+//       the patch keeps the order in which the names first appeared, so a
+//       twin update with several keys is acknowledged by one reported state
+//       publish instead of one per key.  The caller decides when to flush,
+//       e.g. a short while after the first property is set.
+//
+// NOTE: SetString() escapes the value.  SetJson() takes a value which is
+//       already a JSON text, and AddPropertyItems() takes the string values
+//       of ResponsePropertyItem as they are, since PropertyItems_AddItem()
+//       has already escaped them.
+//
+
+#endif  // _REPORTED_STATE_H_
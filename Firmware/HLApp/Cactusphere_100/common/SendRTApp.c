@@ -36,6 +36,7 @@
 #include <applibs/application.h>
 #include <applibs/log.h>
 
+#include "Metrics.h"
 #include "cactusphere_product.h"
 
 #if (APP_PRODUCT_ID == PRODUCT_ATMARK_TECHNO_DIN)
@@ -102,16 +103,20 @@ SendRTApp_SendMessageToRTCoreAndReadMessage(
     unsigned char* rxMessage, long rxMessageSize)
 {
     int bytesReceived;
+    uint64_t startUs = Metrics_GetTimeUs();
 
     if (! SendRTApp_SendMessageToRTCore(txMessage, txMessageSize)) {
+        Metrics_AddCount(MetricsCounter_RTAppErrors, 1);
         return false;
     }
     bytesReceived = recv(sSockFd, rxMessage, (size_t)rxMessageSize, 0);
     if (bytesReceived == -1) {
         Log_Debug("ERROR: Unable to receive message: %d (%s)\n", errno, strerror(errno));
+        Metrics_AddCount(MetricsCounter_RTAppErrors, 1);
         SendRTApp_CloseHandlers();
         return false;
     }
+    Metrics_RecordSince(MetricsLatency_RTAppRoundTrip, startUs);
 
     return true;
 }
@@ -0,0 +1,231 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SendRateControl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SEND_RATE_INIT_WINDOW	2	// window on start and reconnection
+#define SEND_RATE_RTT_SAMPLES	64	// number of kept round-trip times
+#define SEND_RATE_RTT_LIMIT_MS	1000	// round-trip time regarded as slow
+#define SEND_RATE_RTT_RATIO	4	// ... if also this times the shortest
+#define WINDOW_ONE	256	// 1 message in the fixed point window
+
+// SendRateControl class's data members
+struct SendRateControl {
+    uint32_t	mWindow;        // window in 1/WINDOW_ONE message unit
+    uint32_t	mSsThresh;      // slow start threshold in the same unit
+    uint32_t	mMaxWindow;     // upper limit of the window in message unit
+    uint32_t	mSmoothedRtt;   // smoothed round-trip time [msec]
+    uint64_t	mHoldUntilMs;   // no decrease until this time
+
+    uint32_t	mRtts[SEND_RATE_RTT_SAMPLES];  // ring of recent samples
+    uint32_t	mNumRtts;       // number of valid samples
+    uint32_t	mRttPos;        // next position to put a sample
+
+    uint32_t	mNumConfirmed;
+    uint32_t	mNumTimeouts;
+    uint32_t	mNumErrors;
+    uint32_t	mNumDecreases;
+};
+
+static void
+SendRateControl_AddRtt(SendRateControl* me, uint32_t rttMs)
+{
+    me->mRtts[me->mRttPos] = rttMs;
+    me->mRttPos = (me->mRttPos + 1) % SEND_RATE_RTT_SAMPLES;
+    if (me->mNumRtts < SEND_RATE_RTT_SAMPLES) {
+        ++me->mNumRtts;
+    }
+    me->mSmoothedRtt = (0 == me->mSmoothedRtt
+        ? rttMs : (me->mSmoothedRtt * 7 + rttMs) / 8);
+}
+
+static bool
+SendRateControl_IsSlow(const SendRateControl* me, uint32_t rttMs)
+{
+    uint32_t	minRtt = rttMs;
+
+    if (SEND_RATE_RTT_LIMIT_MS >= rttMs) {
+        return false;
+    }
+    for (uint32_t i = 0; i < me->mNumRtts; ++i) {
+        if (minRtt > me->mRtts[i]) {
+            minRtt = me->mRtts[i];
+        }
+    }
+
+    return (rttMs > minRtt * SEND_RATE_RTT_RATIO);
+}
+
+static void
+SendRateControl_Increase(SendRateControl* me)
+{
+    uint32_t	maxWindow = me->mMaxWindow * WINDOW_ONE;
+
+    if (me->mWindow < me->mSsThresh) {
+        me->mWindow += WINDOW_ONE;  // slow start
+    } else {
+        me->mWindow += WINDOW_ONE * WINDOW_ONE / me->mWindow;
+    }
+    if (me->mWindow > maxWindow) {
+        me->mWindow = maxWindow;
+    }
+}
+
+static void
+SendRateControl_Decrease(SendRateControl* me, uint64_t nowMs)
+{
+    // once per round-trip time, as the messages in flight at the time
+    // are likely to be failed by the same congestion
+    if (nowMs < me->mHoldUntilMs) {
+        return;
+    }
+    me->mSsThresh = me->mWindow / 2;
+    if (me->mSsThresh < WINDOW_ONE) {
+        me->mSsThresh = WINDOW_ONE;
+    }
+    me->mWindow      = me->mSsThresh;
+    me->mHoldUntilMs = nowMs + me->mSmoothedRtt;
+    ++me->mNumDecreases;
+}
+
+static uint32_t
+SendRateControl_Percentile(const uint32_t* sorted, uint32_t n, uint32_t pct)
+{
+    return (0 == n ? 0 : sorted[(n - 1) * pct / 100]);
+}
+
+// Initialization and cleanup
+SendRateControl*
+SendRateControl_New(void)
+{
+    SendRateControl*	newObj =
+        (SendRateControl*)malloc(sizeof(SendRateControl));
+
+    if (NULL != newObj) {
+        memset(newObj, 0, sizeof(SendRateControl));
+        newObj->mMaxWindow = SEND_RATE_INIT_WINDOW;
+        SendRateControl_Reset(newObj);
+    }
+
+    return newObj;
+}
+
+void
+SendRateControl_Destroy(SendRateControl* me)
+{
+    free(me);
+}
+
+void
+SendRateControl_Reset(SendRateControl* me)
+{
+    uint32_t	initWindow = (SEND_RATE_INIT_WINDOW < me->mMaxWindow
+        ? SEND_RATE_INIT_WINDOW : me->mMaxWindow);
+
+    me->mWindow      = initWindow * WINDOW_ONE;
+    me->mSsThresh    = me->mMaxWindow * WINDOW_ONE;
+    me->mHoldUntilMs = 0;
+}
+
+// Attribute
+void
+SendRateControl_SetMaxWindow(SendRateControl* me, uint32_t maxWindow)
+{
+    me->mMaxWindow = (0 < maxWindow ? maxWindow : 1);
+    if (me->mWindow > me->mMaxWindow * WINDOW_ONE) {
+        me->mWindow = me->mMaxWindow * WINDOW_ONE;
+    }
+    if (me->mSsThresh > me->mMaxWindow * WINDOW_ONE) {
+        me->mSsThresh = me->mMaxWindow * WINDOW_ONE;
+    }
+}
+
+uint32_t
+SendRateControl_GetWindow(const SendRateControl* me)
+{
+    uint32_t	window = me->mWindow / WINDOW_ONE;
+
+    return (0 < window ? window : 1);
+}
+
+void
+SendRateControl_GetStats(const SendRateControl* me, SendRateStats* outStats)
+{
+    // percentiles of the sorted copy of the recent samples
+    uint32_t	sorted[SEND_RATE_RTT_SAMPLES];
+    uint32_t	n = me->mNumRtts;
+
+    memcpy(sorted, me->mRtts, n * sizeof(uint32_t));
+    for (uint32_t i = 1; i < n; ++i) {
+        uint32_t	val = sorted[i];
+        uint32_t	j = i;
+
+        for (; 0 < j && sorted[j - 1] > val; --j) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = val;
+    }
+
+    outStats->window       = SendRateControl_GetWindow(me);
+    outStats->maxWindow    = me->mMaxWindow;
+    outStats->rttP50Ms     = SendRateControl_Percentile(sorted, n, 50);
+    outStats->rttP90Ms     = SendRateControl_Percentile(sorted, n, 90);
+    outStats->rttP99Ms     = SendRateControl_Percentile(sorted, n, 99);
+    outStats->numConfirmed = me->mNumConfirmed;
+    outStats->numTimeouts  = me->mNumTimeouts;
+    outStats->numErrors    = me->mNumErrors;
+    outStats->numDecreases = me->mNumDecreases;
+}
+
+// Feedback of confirmation
+void
+SendRateControl_OnConfirm(SendRateControl* me,
+    SendConfirm result, uint32_t rttMs, uint64_t nowMs)
+{
+    switch (result) {
+    case SendConfirm_OK:
+        ++me->mNumConfirmed;
+        if (SendRateControl_IsSlow(me, rttMs)) {
+            SendRateControl_AddRtt(me, rttMs);
+            SendRateControl_Decrease(me, nowMs);
+        } else {
+            SendRateControl_AddRtt(me, rttMs);
+            SendRateControl_Increase(me);
+        }
+        break;
+    case SendConfirm_Timeout:
+        ++me->mNumTimeouts;
+        SendRateControl_Decrease(me, nowMs);
+        break;
+    case SendConfirm_Error:
+        ++me->mNumErrors;
+        SendRateControl_Decrease(me, nowMs);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _SEND_RATE_CONTROL_H_
+#define _SEND_RATE_CONTROL_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+// class of message confirmation
+typedef enum {
+    SendConfirm_OK = 0,	// delivered
+    SendConfirm_Timeout,	// not confirmed in time; throttled or congested
+    SendConfirm_Error,	// rejected
+    SendConfirm_Canceled,	// discarded on disconnection
+} SendConfirm;
+
+// statistics of the rate control
+typedef struct SendRateStats {
+    uint32_t	window;         // current number of messages allowed in flight
+    uint32_t	maxWindow;      // upper limit of the window
+    uint32_t	rttP50Ms;       // confirmation round-trip time percentiles
+    uint32_t	rttP90Ms;       // of the recent samples [msec]
+    uint32_t	rttP99Ms;
+    uint32_t	numConfirmed;   // number of delivered messages
+    uint32_t	numTimeouts;    // number of timed out messages
+    uint32_t	numErrors;      // number of rejected messages
+    uint32_t	numDecreases;   // number of times the window was decreased
+} SendRateStats;
+
+typedef struct SendRateControl	SendRateControl;
+
+// Initialization and cleanup
+extern SendRateControl*	SendRateControl_New(void);
+extern void	SendRateControl_Destroy(SendRateControl* me);
+extern void	SendRateControl_Reset(SendRateControl* me);
+
+// Attribute
+extern void	SendRateControl_SetMaxWindow(SendRateControl* me,
+    uint32_t maxWindow);
+extern uint32_t	SendRateControl_GetWindow(const SendRateControl* me);
+extern void	SendRateControl_GetStats(const SendRateControl* me,
+    SendRateStats* outStats);
+
+// Feedback of confirmation
+extern void	SendRateControl_OnConfirm(SendRateControl* me,
+    SendConfirm result, uint32_t rttMs, uint64_t nowMs);
+
+//
+// NOTE:
+// The window of in-flight messages is controlled by AIMD.  It starts at 2
+// and grows by one per confirmation up to the slow start threshold, then
+// by one per window of confirmations.  A timeout, an error, or a round-trip
+// time longer than both 1 second and 4 times the shortest recent one
+// halves the window, at most once per round-trip time.  Canceled messages
+// don't change the window, as they are caused by disconnection rather than
+// load.  SendRateControl_Reset() restarts the window on reconnection, and
+// keeps the statistics.
+//
+
+#endif  // _SEND_RATE_CONTROL_H_
@@ -0,0 +1,312 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TelemetryAggregator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector.h"
+
+// running statistics of a telemetry item
+typedef struct TelemetryAggregatorEntry {
+    uint32_t	windowMs;       // report period (0: not aggregated)
+    uint32_t	sampleMs;       // sampling period
+    uint64_t	windowEndMs;    // end of the current window (0: not started)
+    double  	min;
+    double  	max;
+    double  	sum;
+    double  	last;
+    uint32_t	count;          // number of samples in the current window
+    bool    	isReady;        // window closed, waiting to be reported
+    TelemetryValueType	type;   // value type of the item
+    TelemetryNameId	outIds[TelemetryAggregate_Num];  // output item names
+} TelemetryAggregatorEntry;
+
+// TelemetryAggregator class's data members
+struct TelemetryAggregator {
+    vector  	mEntries;       // vector of entry, indexed by TelemetryNameId
+    vector  	mReadyIds;      // TelemetryNameId of closed windows
+    int     	mNumWindows;    // number of items with window
+    uint32_t	mNumSamples;    // number of aggregated samples
+    uint32_t	mNumReports;    // number of reported windows
+};
+
+#define AGGREGATE_NAME_MAX_LEN	48	// item name and the suffix
+
+static const char*	sAggregateSuffix[TelemetryAggregate_Num] = {
+    "_min", "_max", "_mean", "_last", "_count"
+};
+
+typedef struct TelemetryAggregatorArg {
+    TelemetryAggregator*	aggregator;
+    uint64_t	nowMs;
+} TelemetryAggregatorArg;
+
+static void
+TelemetryAggregator_AddValue(TelemetryItems* items,
+    TelemetryNameId nameId, TelemetryValueType type, double value)
+{
+    switch (type) {
+    case TelemetryValueType_Int32:
+        TelemetryItems_AddInt32(items, nameId, (int32_t)value);
+        break;
+    case TelemetryValueType_Float:
+        TelemetryItems_AddFloat(items, nameId, value);
+        break;
+    case TelemetryValueType_Bool:
+        TelemetryItems_AddBool(items, nameId, (0 != value));
+        break;
+    default:
+        TelemetryItems_AddUInt32(items, nameId, (uint32_t)value);
+        break;
+    }
+}
+
+static bool
+TelemetryAggregator_Accumulate(void* arg, TelemetryNameId nameId, double value)
+{
+    // fold the sample into the window; false to take it out of the items
+    TelemetryAggregatorArg*	aggArg = (TelemetryAggregatorArg*)arg;
+    TelemetryAggregator*	me = aggArg->aggregator;
+    TelemetryAggregatorEntry*	entry;
+
+    if ((int)nameId >= vector_size(me->mEntries)) {
+        return true;
+    }
+    entry = (TelemetryAggregatorEntry*)vector_get_data(me->mEntries) + nameId;
+    if (0 == entry->windowMs) {
+        return true;
+    }
+
+    if (0 == entry->count) {
+        entry->min = entry->max = value;
+        entry->sum = 0;
+    } else if (value < entry->min) {
+        entry->min = value;
+    } else if (entry->max < value) {
+        entry->max = value;
+    }
+    entry->sum  += value;
+    entry->last  = value;
+    ++entry->count;
+    ++me->mNumSamples;
+
+    if (0 == entry->windowEndMs) {
+        entry->windowEndMs = aggArg->nowMs + entry->windowMs - entry->sampleMs;
+    }
+    if (entry->windowEndMs <= aggArg->nowMs && ! entry->isReady) {
+        entry->isReady = true;
+        (void)vector_add_last(me->mReadyIds, &nameId);
+    }
+
+    return false;
+}
+
+// Initialization and cleanup
+TelemetryAggregator*
+TelemetryAggregator_New(void)
+{
+    TelemetryAggregator*	newObj =
+        (TelemetryAggregator*)malloc(sizeof(TelemetryAggregator));
+
+    if (NULL != newObj) {
+        newObj->mEntries = vector_init(sizeof(TelemetryAggregatorEntry));
+        if (NULL == newObj->mEntries) {
+            free(newObj);
+            return NULL;
+        }
+        newObj->mReadyIds = vector_init(sizeof(TelemetryNameId));
+        if (NULL == newObj->mReadyIds) {
+            vector_destroy(newObj->mEntries);
+            free(newObj);
+            return NULL;
+        }
+        newObj->mNumWindows = 0;
+        newObj->mNumSamples = 0;
+        newObj->mNumReports = 0;
+    }
+
+    return newObj;
+}
+
+void
+TelemetryAggregator_Destroy(TelemetryAggregator* me)
+{
+    vector_destroy(me->mReadyIds);
+    vector_destroy(me->mEntries);
+    free(me);
+}
+
+void
+TelemetryAggregator_Clear(TelemetryAggregator* me)
+{
+    vector_remove_all(me->mEntries);
+    vector_remove_all(me->mReadyIds);
+    me->mNumWindows = 0;
+}
+
+// Attribute
+int
+TelemetryAggregator_GetNumWindows(const TelemetryAggregator* me)
+{
+    return me->mNumWindows;
+}
+
+uint32_t
+TelemetryAggregator_GetNumSamples(const TelemetryAggregator* me)
+{
+    return me->mNumSamples;
+}
+
+uint32_t
+TelemetryAggregator_GetNumReports(const TelemetryAggregator* me)
+{
+    return me->mNumReports;
+}
+
+// Add aggregation window
+bool
+TelemetryAggregator_SetWindow(TelemetryAggregator* me,
+    TelemetryNameId nameId, uint32_t windowMs, uint32_t sampleMs)
+{
+    TelemetryAggregatorEntry	pseudo;
+    TelemetryAggregatorEntry*	entry;
+    const char*	itemName = TelemetryItems_GetName(nameId);
+    TelemetryValueType	type;
+
+    if (NULL == itemName || 0 == windowMs) {
+        TelemetryAggregator_RemoveWindow(me, nameId);
+        return true;  // not aggregated
+    }
+    if (windowMs < sampleMs) {
+        windowMs = sampleMs;
+    }
+
+    // keep the partial statistics of the same window
+    type = TelemetryItems_GetValueType(nameId);
+    if ((int)nameId < vector_size(me->mEntries)) {
+        entry = (TelemetryAggregatorEntry*)vector_get_data(me->mEntries) + nameId;
+        if (windowMs == entry->windowMs && sampleMs == entry->sampleMs
+        && type == entry->type) {
+            return true;
+        }
+    }
+
+    memset(&pseudo, 0, sizeof(pseudo));
+    while (vector_size(me->mEntries) <= (int)nameId) {
+        if (0 != vector_add_last(me->mEntries, &pseudo)) {
+            return false;
+        }
+    }
+
+    // intern the output names
+    for (int i = 0; i < TelemetryAggregate_Num; ++i) {
+        char	outName[AGGREGATE_NAME_MAX_LEN + 1];
+        TelemetryValueType	outType = type;
+
+        if (TelemetryAggregate_Mean == i) {
+            outType = TelemetryValueType_Float;
+        } else if (TelemetryAggregate_Count == i) {
+            outType = TelemetryValueType_UInt32;
+        }
+        snprintf(outName, sizeof(outName), "%s%s", itemName, sAggregateSuffix[i]);
+        pseudo.outIds[i] = TelemetryItems_AddDictionaryElemOfType(outName, outType);
+        if (TELEMETRY_NAME_ID_INVALID == pseudo.outIds[i]) {
+            return false;
+        }
+    }
+    pseudo.windowMs = windowMs;
+    pseudo.sampleMs = sampleMs;
+    pseudo.type     = type;
+
+    entry = (TelemetryAggregatorEntry*)vector_get_data(me->mEntries) + nameId;
+    if (0 == entry->windowMs) {
+        ++me->mNumWindows;
+    }
+    *entry = pseudo;
+
+    // at most every window closes at once
+    return (0 == vector_reserve(me->mReadyIds, me->mNumWindows));
+}
+
+void
+TelemetryAggregator_RemoveWindow(TelemetryAggregator* me, TelemetryNameId nameId)
+{
+    TelemetryAggregatorEntry*	entry;
+
+    if ((int)nameId >= vector_size(me->mEntries)) {
+        return;
+    }
+    entry = (TelemetryAggregatorEntry*)vector_get_data(me->mEntries) + nameId;
+    if (0 != entry->windowMs) {
+        memset(entry, 0, sizeof(*entry));
+        --me->mNumWindows;
+    }
+}
+
+// Aggregation
+void
+TelemetryAggregator_Apply(TelemetryAggregator* me,
+    TelemetryItems* items, uint64_t nowMs)
+{
+    TelemetryAggregatorArg	arg = { me, nowMs };
+    TelemetryNameId*	readyIds;
+
+    if (0 == me->mNumWindows) {
+        return;
+    }
+    TelemetryItems_Retain(items, TelemetryAggregator_Accumulate, &arg);
+
+    // report the closed windows and start the next ones
+    readyIds = (TelemetryNameId*)vector_get_data(me->mReadyIds);
+    if (0 < vector_size(me->mReadyIds)) {
+        TelemetryItems_SetCaptureTime(items, TelemetryItems_GetTimeMs());
+    }
+    for (int i = 0, n = vector_size(me->mReadyIds); i < n; ++i) {
+        TelemetryAggregatorEntry*	entry =
+            (TelemetryAggregatorEntry*)vector_get_data(me->mEntries) + readyIds[i];
+        const TelemetryNameId*	outIds = entry->outIds;
+
+        TelemetryAggregator_AddValue(items,
+            outIds[TelemetryAggregate_Min], entry->type, entry->min);
+        TelemetryAggregator_AddValue(items,
+            outIds[TelemetryAggregate_Max], entry->type, entry->max);
+        TelemetryItems_AddFloat(items,
+            outIds[TelemetryAggregate_Mean], entry->sum / entry->count);
+        TelemetryAggregator_AddValue(items,
+            outIds[TelemetryAggregate_Last], entry->type, entry->last);
+        TelemetryItems_AddUInt32(items,
+            outIds[TelemetryAggregate_Count], entry->count);
+        ++me->mNumReports;
+
+        entry->count   = 0;
+        entry->isReady = false;
+        do {
+            entry->windowEndMs += entry->windowMs;
+        } while (entry->windowEndMs <= nowMs);
+    }
+    vector_remove_all(me->mReadyIds);
+}
@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _TELEMETRY_AGGREGATOR_H_
+#define _TELEMETRY_AGGREGATOR_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef _TELEMETRYITEMS_H_
+#include <TelemetryItems.h>
+#endif
+
+// statistics reported for each window, appended to the item name
+typedef enum {
+    TelemetryAggregate_Min = 0,     // "_min"
+    TelemetryAggregate_Max,         // "_max"
+    TelemetryAggregate_Mean,        // "_mean"  (always float)
+    TelemetryAggregate_Last,        // "_last"
+    TelemetryAggregate_Count,       // "_count" (number of samples)
+    TelemetryAggregate_Num
+} TelemetryAggregate;
+
+typedef struct TelemetryAggregator	TelemetryAggregator;
+
+// Initialization and cleanup
+extern TelemetryAggregator*	TelemetryAggregator_New(void);
+extern void	TelemetryAggregator_Destroy(TelemetryAggregator* me);
+extern void	TelemetryAggregator_Clear(TelemetryAggregator* me);
+
+// Attribute
+extern int	TelemetryAggregator_GetNumWindows(const TelemetryAggregator* me);
+extern uint32_t	TelemetryAggregator_GetNumSamples(const TelemetryAggregator* me);
+extern uint32_t	TelemetryAggregator_GetNumReports(const TelemetryAggregator* me);
+
+// Add aggregation window
+extern bool	TelemetryAggregator_SetWindow(TelemetryAggregator* me,
+    TelemetryNameId nameId, uint32_t windowMs, uint32_t sampleMs);
+extern void	TelemetryAggregator_RemoveWindow(
+    TelemetryAggregator* me, TelemetryNameId nameId);
+
+// Aggregation
+extern void	TelemetryAggregator_Apply(TelemetryAggregator* me,
+    TelemetryItems* items, uint64_t nowMs);
+
+//
+// NOTE:
+// The samples of an item with a window are taken out of the acquired
+// items and folded into running statistics (constant memory per item).
+// The window is closed by the sample which is taken at or after its end,
+// and the statistics are then appended as "<name>_min", "_max", "_mean",
+// "_last" and "_count", stamped with the time of the closing; the next
+// window follows without a gap.  The first
+// window ends windowMs after the sampling period preceding the first
+// sample, so that a window of N sampling periods holds N samples.
+// SetWindow() interns the output names, so it is to be done on
+// (re)configuration; TelemetryAggregator_Clear() drops the windows and
+// the partial statistics.  Setting the same window again keeps the
+// partial statistics, and a window of 0 [ms] is the same as
+// TelemetryAggregator_RemoveWindow().
+//
+
+#endif  // _TELEMETRY_AGGREGATOR_H_
@@ -0,0 +1,785 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TelemetryCacheStore.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <applibs/log.h>
+
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define STORE_SEG_SIZE	4096	// segment size in bytes
+#define STORE_MIN_SEGS	3	// minimum number of segments
+#define STORE_SEG_MAGIC	0x47455343	// "CSEG"
+
+#define STORE_REC_CURSOR	2	// record type: read cursor
+#define STORE_REC_FRAME 	3	// record type: telemetry snapshot
+// type 1 is the snapshot without capture time of older builds; skipped
+
+#define STORE_ALIGN4(n)	(((n) + 3) & ~3u)
+
+// default sync policy
+#define STORE_SYNC_FRAMES	30
+#define STORE_SYNC_SEC  	60
+
+// segment header which is placed at the top of each segment
+typedef struct StoreSegHeader {
+    uint32_t	magic;	// STORE_SEG_MAGIC
+    uint32_t	seq;	// sequence number of the segment
+    int64_t 	baseTime;	// base time of the time stamps in the segment
+    uint32_t	crc;	// CRC-32 of the above members
+    uint32_t	reserved;
+} StoreSegHeader;
+
+// record header which is placed in front of each record's payload
+typedef struct StoreRecHeader {
+    uint16_t	type;	// STORE_REC_XXX
+    uint16_t	length;	// payload length in bytes
+    uint32_t	crc;	// CRC-32 of segment seq, type, length and payload
+} StoreRecHeader;
+
+// payload of STORE_REC_CURSOR
+typedef struct StoreCursor {
+    uint32_t	seq;	// sequence number of the segment to be read next
+    uint32_t	offset;	// offset of the record to be read next
+} StoreCursor;
+
+// payload of STORE_REC_FRAME is as follows (unaligned, native byte order)
+//   uint32_t timeStamp, uint64_t captureMs, uint16_t itemCount,
+//   { uint8_t nameLen, char name[nameLen], uint32_t value } * itemCount
+// item names are stored as text since TelemetryNameId is valid only in
+// the running process; a capture time mark is stored without name
+#define STORE_FRAME_HEAD_SIZE	\
+    (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint16_t))
+#define STORE_ITEM_NAME_MAX 	255
+#define STORE_ITEM_EST_SIZE 	(1 + 32 + sizeof(uint32_t))
+
+#define STORE_SEG_HDR_SIZE	((uint32_t)sizeof(StoreSegHeader))
+#define STORE_REC_HDR_SIZE	((uint32_t)sizeof(StoreRecHeader))
+#define STORE_CURSOR_REC_SIZE	\
+    (STORE_REC_HDR_SIZE + STORE_ALIGN4((uint32_t)sizeof(StoreCursor)))
+#define STORE_MAX_PAYLOAD	(STORE_SEG_SIZE - STORE_SEG_HDR_SIZE	\
+    - STORE_CURSOR_REC_SIZE - STORE_REC_HDR_SIZE)
+
+// segment index element
+typedef struct StoreSegment {
+    uint32_t	seq;	// sequence number
+    uint32_t	endOff;	// end offset of the valid records
+    uint32_t	numFrames;	// number of unread frames
+    int64_t 	baseTime;	// base time of the time stamps
+    bool    	inUse;	// whether holding valid header
+} StoreSegment;
+
+struct TelemetryCacheStore {
+    int 	mFd;	// file descriptor of the storage
+    uint32_t	mNumSegs;	// number of segments
+    StoreSegment*	mSegs;	// segment index
+    uint32_t	mReadSeg;	// segment to be read next
+    uint32_t	mReadOff;	// offset in mReadSeg to be read next
+    uint32_t	mWriteSeg;	// segment being written (or last written)
+    bool    	mWriteOpen;	// whether mWriteSeg accepts appending
+    uint32_t	mNextSeq;	// sequence number of the next segment
+    uint32_t	mFrameCount;	// number of unread frames
+    int64_t 	mBaseTime;	// base time of the time stamps
+    unsigned char*	mPendBuf;	// buffer of records not written yet
+    uint32_t	mPendBase;	// offset in mWriteSeg of mPendBuf
+    uint32_t	mPendLen;	// length of the data in mPendBuf
+    unsigned char*	mRecBuf;	// work area for a record
+    bool    	mCursorDirty;	// whether read cursor is moved after sync
+    uint32_t	mPendingOps;	// number of enqueue/dequeue after sync
+    bool    	mHasPendingTs;	// whether mFirstPendingTs is valid
+    uint32_t	mFirstPendingTs;	// time stamp of the first frame after sync
+    uint32_t	mSyncFrames;	// sync policy: max pending operations
+    uint32_t	mSyncSec;	// sync policy: max pending time in seconds
+};
+
+static uint32_t
+TelemetryCacheStore_Crc32(uint32_t crc, const void* data, uint32_t len)
+{
+    // CRC-32 (IEEE 802.3) with 4 bit table
+    static const uint32_t	sCrcTbl[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const unsigned char*	p = data;
+
+    crc = ~crc;
+    while (0 < len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ sCrcTbl[crc & 0x0F];
+        crc = (crc >> 4) ^ sCrcTbl[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+static uint32_t
+TelemetryCacheStore_RecCrc(uint32_t seq,
+    const StoreRecHeader* hdr, const void* payload)
+{
+    // including the segment sequence number so that the records
+    // left by the previous round of the segment are rejected
+    uint32_t	crc;
+
+    crc = TelemetryCacheStore_Crc32(0, &seq, sizeof(seq));
+    crc = TelemetryCacheStore_Crc32(crc, &hdr->type,
+        sizeof(hdr->type) + sizeof(hdr->length));
+    return TelemetryCacheStore_Crc32(crc, payload, hdr->length);
+}
+
+static bool
+TelemetryCacheStore_ReadFile(TelemetryCacheStore* me,
+    uint32_t fileOff, void* buf, uint32_t len)
+{
+    unsigned char*	p = buf;
+
+    if (0 > lseek(me->mFd, (off_t)fileOff, SEEK_SET)) {
+        return false;
+    }
+    while (0 < len) {
+        ssize_t	n = read(me->mFd, p, len);
+
+        if (0 > n && EINTR == errno) {
+            continue;
+        } else if (0 >= n) {
+            return false;  // error or beyond the end of file
+        }
+        p   += n;
+        len -= (uint32_t)n;
+    }
+
+    return true;
+}
+
+static bool
+TelemetryCacheStore_WriteFile(TelemetryCacheStore* me,
+    uint32_t fileOff, const void* buf, uint32_t len)
+{
+    const unsigned char*	p = buf;
+
+    if (0 > lseek(me->mFd, (off_t)fileOff, SEEK_SET)) {
+        return false;
+    }
+    while (0 < len) {
+        ssize_t	n = write(me->mFd, p, len);
+
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            Log_Debug("ERROR: TelemetryCacheStore write failed: %d\n", errno);
+            return false;
+        }
+        p   += n;
+        len -= (uint32_t)n;
+    }
+
+    return true;
+}
+
+static inline uint32_t
+TelemetryCacheStore_SegEnd(const TelemetryCacheStore* me, uint32_t seg)
+{
+    return (me->mWriteOpen && seg == me->mWriteSeg
+        ? me->mPendBase + me->mPendLen : me->mSegs[seg].endOff);
+}
+
+static bool
+TelemetryCacheStore_ReadAt(TelemetryCacheStore* me,
+    uint32_t seg, uint32_t off, void* buf, uint32_t len)
+{
+    // read from the pending buffer if the area is not written yet
+    if (me->mWriteOpen && seg == me->mWriteSeg && off >= me->mPendBase) {
+        memcpy(buf, me->mPendBuf + (off - me->mPendBase), len);
+        return true;
+    }
+
+    return TelemetryCacheStore_ReadFile(me, seg * STORE_SEG_SIZE + off, buf, len);
+}
+
+static bool
+TelemetryCacheStore_Flush(TelemetryCacheStore* me)
+{
+    // write out the pending records (without fsync)
+    bool	isOK = true;
+
+    if (0 < me->mPendLen) {
+        isOK = TelemetryCacheStore_WriteFile(me,
+            me->mWriteSeg * STORE_SEG_SIZE + me->mPendBase,
+            me->mPendBuf, me->mPendLen);
+        me->mPendBase += me->mPendLen;
+        me->mPendLen   = 0;
+        me->mSegs[me->mWriteSeg].endOff = me->mPendBase;
+    }
+
+    return isOK;
+}
+
+static void
+TelemetryCacheStore_PutRecord(TelemetryCacheStore* me,
+    uint16_t type, const void* payload, uint32_t len)
+{
+    // append a record to the pending buffer; the space must be checked
+    // by the caller
+    unsigned char*	dst = me->mPendBuf + me->mPendLen;
+    StoreRecHeader	hdr;
+    uint32_t	padLen = STORE_ALIGN4(len) - len;
+
+    hdr.type   = type;
+    hdr.length = (uint16_t)len;
+    hdr.crc    = TelemetryCacheStore_RecCrc(
+        me->mSegs[me->mWriteSeg].seq, &hdr, payload);
+    memcpy(dst, &hdr, sizeof(hdr));
+    memcpy(dst + sizeof(hdr), payload, len);
+    memset(dst + sizeof(hdr) + len, 0, padLen);
+    me->mPendLen += STORE_REC_HDR_SIZE + len + padLen;
+}
+
+static void
+TelemetryCacheStore_PutCursor(TelemetryCacheStore* me)
+{
+    StoreCursor	cursor;
+
+    cursor.seq    = me->mSegs[me->mReadSeg].seq;
+    cursor.offset = me->mReadOff;
+    TelemetryCacheStore_PutRecord(me, STORE_REC_CURSOR, &cursor, sizeof(cursor));
+    me->mCursorDirty = false;
+}
+
+static bool
+TelemetryCacheStore_OpenNewSegment(TelemetryCacheStore* me)
+{
+    // Move to the next segment.  If it holds the oldest unread frames
+    // (the store is full), discard them.
+    // A cursor record is put at the top of each segment so that the latest
+    // cursor always lives in the newest segment.
+    uint32_t	next = (me->mWriteSeg + 1) % me->mNumSegs;
+    StoreSegment*	seg = &me->mSegs[next];
+    StoreSegHeader	hdr;
+    bool	isOK = TelemetryCacheStore_Flush(me);
+
+    if (seg->inUse && next == me->mReadSeg) {
+        me->mFrameCount -= seg->numFrames;
+        me->mReadSeg = (next + 1) % me->mNumSegs;
+        me->mReadOff = STORE_SEG_HDR_SIZE;
+    }
+
+    seg->seq       = me->mNextSeq++;
+    seg->numFrames = 0;
+    seg->baseTime  = me->mBaseTime;
+    seg->endOff    = 0;
+    seg->inUse     = true;
+    me->mWriteSeg  = next;
+    me->mWriteOpen = true;
+    me->mPendBase  = 0;
+    me->mPendLen   = 0;
+
+    hdr.magic    = STORE_SEG_MAGIC;
+    hdr.seq      = seg->seq;
+    hdr.baseTime = seg->baseTime;
+    hdr.crc      = TelemetryCacheStore_Crc32(0, &hdr, offsetof(StoreSegHeader, crc));
+    hdr.reserved = 0;
+    memcpy(me->mPendBuf, &hdr, sizeof(hdr));
+    me->mPendLen = STORE_SEG_HDR_SIZE;
+    TelemetryCacheStore_PutCursor(me);
+
+    return isOK;
+}
+
+static bool
+TelemetryCacheStore_AppendRecord(TelemetryCacheStore* me,
+    uint16_t type, const void* payload, uint32_t len)
+{
+    bool	isOK = true;
+    uint32_t	recSize = STORE_REC_HDR_SIZE + STORE_ALIGN4(len);
+
+    if (! me->mWriteOpen
+    || STORE_SEG_SIZE < me->mPendBase + me->mPendLen + recSize) {
+        isOK = TelemetryCacheStore_OpenNewSegment(me);
+    }
+    TelemetryCacheStore_PutRecord(me, type, payload, len);
+
+    return isOK;
+}
+
+static bool
+TelemetryCacheStore_ReadRecord(TelemetryCacheStore* me,
+    uint32_t seg, uint32_t off, uint32_t endOff, StoreRecHeader* outHdr)
+{
+    // read a record into mRecBuf and check its length
+    if (endOff < off + STORE_REC_HDR_SIZE
+    || ! TelemetryCacheStore_ReadAt(me, seg, off, outHdr, sizeof(*outHdr))
+    || endOff < off + STORE_REC_HDR_SIZE + STORE_ALIGN4(outHdr->length)) {
+        return false;
+    }
+
+    return TelemetryCacheStore_ReadAt(me, seg, off + STORE_REC_HDR_SIZE,
+        me->mRecBuf, outHdr->length);
+}
+
+static uint32_t
+TelemetryCacheStore_ScanSegment(TelemetryCacheStore* me,
+    uint32_t segIdx, uint32_t off, StoreCursor* outCursor)
+{
+    // Scan valid records from the offset and count frames. The end of the
+    // valid records is stored to the segment index.
+    StoreSegment*	seg = &me->mSegs[segIdx];
+    StoreRecHeader	hdr;
+    uint32_t	numFrames = 0;
+
+    while (TelemetryCacheStore_ReadRecord(me, segIdx, off, STORE_SEG_SIZE, &hdr)
+        && hdr.crc == TelemetryCacheStore_RecCrc(seg->seq, &hdr, me->mRecBuf)) {
+        if (STORE_REC_FRAME == hdr.type) {
+            ++numFrames;
+        } else if (STORE_REC_CURSOR == hdr.type && NULL != outCursor) {
+            memcpy(outCursor, me->mRecBuf, sizeof(*outCursor));
+        }
+        off += STORE_REC_HDR_SIZE + STORE_ALIGN4(hdr.length);
+    }
+    seg->endOff = off;
+
+    return numFrames;
+}
+
+static void
+TelemetryCacheStore_Recover(TelemetryCacheStore* me)
+{
+    // Rebuild the segment index from the storage.
+    // The valid segments whose sequence numbers are consecutive and end at
+    // the newest one are the live log; the latest cursor record in it tells
+    // where to resume reading.
+    StoreCursor	cursor = { 0, 0 };
+    uint32_t	newest = 0;
+    uint32_t	oldest;
+    uint32_t	numLive = 1;
+    bool	found = false;
+    bool	hasCursor = false;
+
+    for (uint32_t i = 0; i < me->mNumSegs; ++i) {
+        StoreSegHeader	hdr;
+        StoreSegment*	seg = &me->mSegs[i];
+
+        seg->inUse = (TelemetryCacheStore_ReadFile(
+                me, i * STORE_SEG_SIZE, &hdr, sizeof(hdr))
+            && STORE_SEG_MAGIC == hdr.magic
+            && hdr.crc == TelemetryCacheStore_Crc32(
+                0, &hdr, offsetof(StoreSegHeader, crc)));
+        if (seg->inUse) {
+            seg->seq      = hdr.seq;
+            seg->baseTime = hdr.baseTime;
+            if (! found || (int32_t)(hdr.seq - me->mSegs[newest].seq) > 0) {
+                newest = i;
+                found  = true;
+            }
+        }
+    }
+    if (! found) {
+        return;  // empty storage
+    }
+
+    oldest = newest;
+    while (numLive < me->mNumSegs) {
+        uint32_t	prev = (oldest + me->mNumSegs - 1) % me->mNumSegs;
+
+        if (! me->mSegs[prev].inUse
+        || me->mSegs[prev].seq + 1 != me->mSegs[oldest].seq) {
+            break;
+        }
+        oldest = prev;
+        ++numLive;
+    }
+    for (uint32_t i = 0; i < me->mNumSegs - numLive; ++i) {
+        me->mSegs[(newest + 1 + i) % me->mNumSegs].inUse = false;
+    }
+
+    me->mReadSeg = oldest;
+    me->mReadOff = STORE_SEG_HDR_SIZE;
+    for (uint32_t i = 0, segIdx = oldest; i < numLive; ++i) {
+        me->mSegs[segIdx].numFrames =
+            TelemetryCacheStore_ScanSegment(me, segIdx, STORE_SEG_HDR_SIZE, &cursor);
+        segIdx = (segIdx + 1) % me->mNumSegs;
+    }
+
+    // resume from the latest cursor if it points into the live log
+    for (uint32_t i = 0, segIdx = oldest; i < numLive; ++i) {
+        StoreSegment*	seg = &me->mSegs[segIdx];
+
+        if (seg->seq == cursor.seq && cursor.offset <= seg->endOff) {
+            me->mReadSeg = segIdx;
+            me->mReadOff = cursor.offset;
+            seg->numFrames = TelemetryCacheStore_ScanSegment(
+                me, segIdx, cursor.offset, NULL);
+            hasCursor = true;
+            break;
+        }
+        seg->numFrames = 0;  // already read
+        segIdx = (segIdx + 1) % me->mNumSegs;
+    }
+    if (! hasCursor) {
+        // the cursor is lost; resend all the frames in the live log
+        me->mReadSeg = oldest;
+        me->mReadOff = STORE_SEG_HDR_SIZE;
+        for (uint32_t i = 0, segIdx = oldest; i < numLive; ++i) {
+            me->mSegs[segIdx].numFrames = TelemetryCacheStore_ScanSegment(
+                me, segIdx, STORE_SEG_HDR_SIZE, NULL);
+            segIdx = (segIdx + 1) % me->mNumSegs;
+        }
+    }
+
+    me->mFrameCount = 0;
+    for (uint32_t segIdx = me->mReadSeg; ; segIdx = (segIdx + 1) % me->mNumSegs) {
+        me->mFrameCount += me->mSegs[segIdx].numFrames;
+        if (segIdx == newest) {
+            break;
+        }
+    }
+    me->mBaseTime = me->mSegs[me->mReadSeg].baseTime;
+    me->mWriteSeg = newest;
+    me->mNextSeq  = me->mSegs[newest].seq + 1;
+//
+// NOTE: Appending is restarted from the next segment rather than the tail
+//       of the newest one, since the tail may be torn by the power failure
+//       and the segment may hold the time stamps with another base time.
+}
+
+// Initialization and cleanup
+TelemetryCacheStore*
+TelemetryCacheStore_New(void)
+{
+    TelemetryCacheStore*	newObj =
+        (TelemetryCacheStore*)malloc(sizeof(TelemetryCacheStore));
+
+    if (NULL != newObj) {
+        memset(newObj, 0, sizeof(*newObj));
+        newObj->mFd         = -1;
+        newObj->mSyncFrames = STORE_SYNC_FRAMES;
+        newObj->mSyncSec    = STORE_SYNC_SEC;
+    }
+
+    return newObj;
+}
+
+bool
+TelemetryCacheStore_Open(TelemetryCacheStore* me, int fd, uint32_t storeSize)
+{
+    uint32_t	numSegs = storeSize / STORE_SEG_SIZE;
+
+    if (0 > fd || STORE_MIN_SEGS > numSegs || NULL != me->mSegs) {
+        return false;  // invalid argument or already opened
+    }
+    me->mSegs    = (StoreSegment*)calloc(numSegs, sizeof(StoreSegment));
+    me->mPendBuf = (unsigned char*)malloc(STORE_SEG_SIZE);
+    me->mRecBuf  = (unsigned char*)malloc(STORE_SEG_SIZE);
+    if (NULL == me->mSegs || NULL == me->mPendBuf || NULL == me->mRecBuf) {
+        free(me->mSegs);
+        free(me->mPendBuf);
+        free(me->mRecBuf);
+        me->mSegs    = NULL;
+        me->mPendBuf = me->mRecBuf = NULL;
+        return false;
+    }
+
+    me->mFd          = fd;
+    me->mNumSegs     = numSegs;
+    me->mReadSeg     = 0;
+    me->mReadOff     = STORE_SEG_HDR_SIZE;
+    me->mWriteSeg    = numSegs - 1;  // start writing from the first segment
+    me->mWriteOpen   = false;
+    me->mNextSeq     = 1;
+    me->mFrameCount  = 0;
+    me->mPendBase    = me->mPendLen = 0;
+    me->mCursorDirty = false;
+    me->mPendingOps  = 0;
+    me->mHasPendingTs = false;
+    TelemetryCacheStore_Recover(me);
+
+    return true;
+}
+
+void
+TelemetryCacheStore_Destroy(TelemetryCacheStore* me)
+{
+    if (NULL != me->mSegs) {
+        (void)TelemetryCacheStore_Sync(me);
+        free(me->mSegs);
+        free(me->mPendBuf);
+        free(me->mRecBuf);
+    }
+    free(me);
+}
+
+// Attribute
+uint32_t
+TelemetryCacheStore_CountAvailItems(const TelemetryCacheStore* me)
+{
+    // estimate by the space until reaching the oldest unread frame
+    uint32_t	usedSegs =
+        (me->mWriteSeg + me->mNumSegs - me->mReadSeg) % me->mNumSegs + 1;
+    uint32_t	freeBytes = (me->mNumSegs - usedSegs) * STORE_MAX_PAYLOAD;
+
+    if (me->mWriteOpen) {
+        uint32_t	segEnd = TelemetryCacheStore_SegEnd(me, me->mWriteSeg);
+
+        if (segEnd + STORE_REC_HDR_SIZE + STORE_FRAME_HEAD_SIZE < STORE_SEG_SIZE) {
+            freeBytes += STORE_SEG_SIZE - segEnd
+                - STORE_REC_HDR_SIZE - STORE_FRAME_HEAD_SIZE;
+        }
+    }
+
+    return freeBytes / STORE_ITEM_EST_SIZE;
+}
+
+uint32_t
+TelemetryCacheStore_CountFrames(const TelemetryCacheStore* me)
+{
+    return me->mFrameCount;
+}
+
+bool
+TelemetryCacheStore_IsEmpty(const TelemetryCacheStore* me)
+{
+    return (0 == me->mFrameCount);
+}
+
+int64_t
+TelemetryCacheStore_GetTimeBase(const TelemetryCacheStore* me)
+{
+    return me->mBaseTime;
+}
+
+void
+TelemetryCacheStore_SetTimeBase(TelemetryCacheStore* me, int64_t baseTime)
+{
+    // The base time can be changed only when there is no unread frame,
+    // and it is applied from the next segment.
+    if (TelemetryCacheStore_IsEmpty(me) && baseTime != me->mBaseTime) {
+        me->mBaseTime = baseTime;
+        if (me->mWriteOpen) {
+            (void)TelemetryCacheStore_Flush(me);
+            me->mWriteOpen = false;
+        }
+    }
+}
+
+void
+TelemetryCacheStore_SetSyncPolicy(TelemetryCacheStore* me,
+    uint32_t maxPendingFrames, uint32_t maxPendingSec)
+{
+    me->mSyncFrames = maxPendingFrames;
+    me->mSyncSec    = maxPendingSec;
+}
+
+// Add and remove frame
+bool
+TelemetryCacheStore_EnqueueItems(TelemetryCacheStore* me,
+    const TelemetryItems* items, uint32_t timeStamp)
+{
+    // Encode the telemetry data items as a frame record and append it.
+    unsigned char*	dst = me->mRecBuf + STORE_FRAME_HEAD_SIZE;
+    unsigned char*	end = me->mRecBuf + STORE_MAX_PAYLOAD;
+    uint64_t	captureMs = TelemetryItems_GetCaptureTime(items);
+    uint16_t	numStored = 0;
+    bool	isOK;
+
+    if (NULL == me->mSegs) {
+        return false;  // not opened
+    }
+
+    for (int i = 0, n = TelemetryItems_Count(items); i < n; ++i) {
+        TelemetryCacheElem	elem;
+        const char*	name;
+        uint32_t	value;
+        size_t	nameLen;
+
+        if (NULL == TelemetryItems_ConvToCacheElemAt(items, i, &elem, NULL)
+        || NULL == (name = TelemetryItems_GetName(elem.nameId))) {
+            continue;
+        }
+        nameLen = (TELEMETRY_NAME_ID_CAPTURE == elem.nameId ? 0 : strlen(name));
+        value   = elem.value.ul;
+        if (STORE_ITEM_NAME_MAX < nameLen
+        || end < dst + 1 + nameLen + sizeof(value)) {
+            return false;  // too large items
+        }
+        *dst++ = (unsigned char)nameLen;
+        memcpy(dst, name, nameLen);
+        dst += nameLen;
+        memcpy(dst, &value, sizeof(value));
+        dst += sizeof(value);
+        ++numStored;
+    }
+    memcpy(me->mRecBuf, &timeStamp, sizeof(timeStamp));
+    memcpy(me->mRecBuf + sizeof(timeStamp), &captureMs, sizeof(captureMs));
+    memcpy(me->mRecBuf + sizeof(timeStamp) + sizeof(captureMs),
+        &numStored, sizeof(numStored));
+
+    isOK = TelemetryCacheStore_AppendRecord(me, STORE_REC_FRAME,
+        me->mRecBuf, (uint32_t)(dst - me->mRecBuf));
+    ++me->mSegs[me->mWriteSeg].numFrames;
+    ++me->mFrameCount;
+
+    if (! me->mHasPendingTs) {
+        me->mHasPendingTs   = true;
+        me->mFirstPendingTs = timeStamp;
+    }
+    if (me->mSyncFrames <= ++me->mPendingOps
+    || me->mSyncSec <= timeStamp - me->mFirstPendingTs) {
+        isOK = TelemetryCacheStore_Sync(me) && isOK;
+    }
+
+    return isOK;
+}
+
+bool
+TelemetryCacheStore_DequeueItemsTo(TelemetryCacheStore* me,
+    TelemetryItems* outItems, uint32_t* outTimeStamp)
+{
+    // Retrieve the oldest frame, skipping cursor records.
+    StoreRecHeader	hdr;
+    const unsigned char*	src;
+    uint64_t	captureMs;
+    uint16_t	numItems;
+
+    if (TelemetryCacheStore_IsEmpty(me)) {
+        return false;
+    }
+
+    for (;;) {
+        uint32_t	segEnd = TelemetryCacheStore_SegEnd(me, me->mReadSeg);
+
+        if (! TelemetryCacheStore_ReadRecord(
+                me, me->mReadSeg, me->mReadOff, segEnd, &hdr)) {
+            if (me->mReadSeg == me->mWriteSeg) {
+                // inconsistent with the frame count; give up the rest
+                TelemetryCacheStore_Clear(me);
+                return false;
+            }
+            me->mReadSeg = (me->mReadSeg + 1) % me->mNumSegs;
+            me->mReadOff = STORE_SEG_HDR_SIZE;
+            continue;
+        }
+        me->mReadOff += STORE_REC_HDR_SIZE + STORE_ALIGN4(hdr.length);
+        if (STORE_REC_FRAME == hdr.type) {
+            break;
+        }
+    }
+    --me->mSegs[me->mReadSeg].numFrames;
+    --me->mFrameCount;
+    me->mCursorDirty = true;
+
+    TelemetryItems_Clear(outItems);
+    memcpy(outTimeStamp, me->mRecBuf, sizeof(*outTimeStamp));
+    *outTimeStamp += (uint32_t)(me->mSegs[me->mReadSeg].baseTime - me->mBaseTime);
+    memcpy(&captureMs, me->mRecBuf + sizeof(uint32_t), sizeof(captureMs));
+    memcpy(&numItems, me->mRecBuf + sizeof(uint32_t) + sizeof(captureMs),
+        sizeof(numItems));
+    TelemetryItems_SetCaptureBase(outItems, captureMs);
+    src = me->mRecBuf + STORE_FRAME_HEAD_SIZE;
+    for (uint16_t i = 0; i < numItems; ++i) {
+        char	name[STORE_ITEM_NAME_MAX + 1];
+        TelemetryCacheElem	elem;
+        uint32_t	value;
+        size_t	nameLen = *src++;
+
+        memcpy(name, src, nameLen);
+        name[nameLen] = '\0';
+        src += nameLen;
+        memcpy(&value, src, sizeof(value));
+        src += sizeof(value);
+        elem.nameId   = (0 == nameLen
+            ? TELEMETRY_NAME_ID_CAPTURE : TelemetryItems_FindNameId(name));
+        elem.value.ul = value;
+        TelemetryItems_AddFromCacheElem(outItems, &elem);
+    }
+
+    // persist the cursor when drained so that the frames are not resent
+    // after restart
+    if (me->mSyncFrames <= ++me->mPendingOps
+    || TelemetryCacheStore_IsEmpty(me)) {
+        (void)TelemetryCacheStore_Sync(me);
+    }
+
+    return true;
+}
+
+void
+TelemetryCacheStore_Clear(TelemetryCacheStore* me)
+{
+    if (NULL == me->mSegs) {
+        return;
+    }
+    for (uint32_t i = 0; i < me->mNumSegs; ++i) {
+        me->mSegs[i].numFrames = 0;
+    }
+    me->mReadSeg     = me->mWriteSeg;
+    me->mReadOff     = TelemetryCacheStore_SegEnd(me, me->mWriteSeg);
+    me->mFrameCount  = 0;
+    me->mCursorDirty = true;
+    (void)TelemetryCacheStore_Sync(me);
+}
+
+// Write out buffered records to the storage
+bool
+TelemetryCacheStore_Sync(TelemetryCacheStore* me)
+{
+    bool	isOK;
+
+    if (NULL == me->mSegs
+    || (0 == me->mPendLen && ! me->mCursorDirty)) {
+        return true;  // nothing to do
+    }
+
+    isOK = true;
+    if (me->mCursorDirty) {
+        if (me->mWriteOpen && me->mPendBase + me->mPendLen
+                + STORE_CURSOR_REC_SIZE <= STORE_SEG_SIZE) {
+            TelemetryCacheStore_PutCursor(me);
+        } else if (! me->mSegs[(me->mWriteSeg + 1) % me->mNumSegs].inUse
+            || (me->mWriteSeg + 1) % me->mNumSegs != me->mReadSeg) {
+            // a new segment has a cursor record at its top
+            isOK = TelemetryCacheStore_OpenNewSegment(me);
+        }
+//
+// NOTE: When the store is full, the cursor is not saved until the reader
+//       leaves the oldest segment, so as not to discard unread frames
+//       only for saving the cursor.
+    }
+    isOK = TelemetryCacheStore_Flush(me) && isOK;
+    if (0 != fsync(me->mFd)) {
+        Log_Debug("ERROR: TelemetryCacheStore fsync failed: %d\n", errno);
+        isOK = false;
+    }
+    me->mPendingOps = 0;
+    me->mHasPendingTs = false;
+
+    return isOK;
+}
@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _TELEMETRY_CACHE_STORE_H_
+#define _TELEMETRY_CACHE_STORE_H_
+
+#ifndef _STDBOOL
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+typedef struct TelemetryCacheStore	TelemetryCacheStore;
+typedef struct TelemetryItems	TelemetryItems;
+
+// Log-structured telemetry cache on a file (mutable storage).
+//
+// The file is divided into fixed size segments which are written
+// cyclically.  Each segment starts with a header holding its sequence
+// number, and telemetry snapshots (frames) and read cursors are appended
+// to it as CRC protected records.  On opening, the segments are scanned to
+// recover the unsent frames.  Appended records are buffered in memory and
+// written with fsync() in a batch, so some of the latest frames may be lost
+// on a power failure.
+
+// Initialization and cleanup
+extern TelemetryCacheStore*	TelemetryCacheStore_New(void);
+extern bool	TelemetryCacheStore_Open(TelemetryCacheStore* me,
+    int fd, uint32_t storeSize);
+extern void	TelemetryCacheStore_Destroy(TelemetryCacheStore* me);
+//
+// NOTE: TelemetryCacheStore_Destroy() syncs outstanding records but does
+//       not close the file descriptor passed to TelemetryCacheStore_Open().
+
+// Attribute
+extern uint32_t	TelemetryCacheStore_CountAvailItems(
+    const TelemetryCacheStore* me);
+extern uint32_t	TelemetryCacheStore_CountFrames(const TelemetryCacheStore* me);
+extern bool	TelemetryCacheStore_IsEmpty(const TelemetryCacheStore* me);
+extern int64_t	TelemetryCacheStore_GetTimeBase(const TelemetryCacheStore* me);
+extern void	TelemetryCacheStore_SetTimeBase(TelemetryCacheStore* me,
+    int64_t baseTime);
+extern void	TelemetryCacheStore_SetSyncPolicy(TelemetryCacheStore* me,
+    uint32_t maxPendingFrames, uint32_t maxPendingSec);
+
+// Add and remove frame
+extern bool	TelemetryCacheStore_EnqueueItems(TelemetryCacheStore* me,
+    const TelemetryItems* items, uint32_t timeStamp);
+extern bool	TelemetryCacheStore_DequeueItemsTo(TelemetryCacheStore* me,
+    TelemetryItems* outItems, uint32_t* outTimeStamp);
+extern void	TelemetryCacheStore_Clear(TelemetryCacheStore* me);
+
+// Write out buffered records to the storage
+extern bool	TelemetryCacheStore_Sync(TelemetryCacheStore* me);
+
+#endif  // _TELEMETRY_CACHE_STORE_H_
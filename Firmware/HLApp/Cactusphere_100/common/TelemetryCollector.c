@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TelemetryCollector.h"
+
+#include <stdlib.h>
+
+#include "LibCloud.h"
+#include "TelemetryItems.h"
+
+extern bool	IsAuthenticationDone(void);
+
+struct TelemetryCollector {
+    TelemetryItems*	mItems;	// items collected in the current tick
+    int	mTickCapacity;	// capacity of the items added in the tick
+};
+
+// Initialization and cleanup
+TelemetryCollector*
+TelemetryCollector_New(void)
+{
+    TelemetryCollector*	newObj =
+        (TelemetryCollector*)malloc(sizeof(TelemetryCollector));
+
+    if (NULL != newObj) {
+        newObj->mItems = TelemetryItems_New();
+        newObj->mTickCapacity = 0;
+        if (NULL == newObj->mItems) {
+            free(newObj);
+            newObj = NULL;
+        }
+    }
+
+    return newObj;
+}
+
+void
+TelemetryCollector_Destroy(TelemetryCollector* me)
+{
+    if (NULL != me) {
+        TelemetryItems_Destroy(me->mItems);
+        free(me);
+    }
+}
+
+// Collect telemetry data items of a tick
+void
+TelemetryCollector_AddItems(TelemetryCollector* me,
+    const TelemetryItems* items)
+{
+    // reserve for all the schedulers at their largest, so that a rare tick
+    // in which every interval expires doesn't allocate; one more for the
+    // capture time mark put in front of the items
+    me->mTickCapacity += TelemetryItems_GetCapacity(items) + 1;
+    (void)TelemetryItems_Reserve(me->mItems, me->mTickCapacity);
+    TelemetryItems_AddItems(me->mItems, items);
+}
+
+// Send collected items (per 1[sec])
+void
+TelemetryCollector_Flush(TelemetryCollector* me)
+{
+    // Send the data acquired by all schedulers in this tick as telemetry.
+    // If nettwork is down, store the data to cache and send it after recovery.
+    bool	isNetworkAlive;
+    uint32_t	timeStamp;
+
+    me->mTickCapacity = 0;
+    if (0 == TelemetryItems_Count(me->mItems)) {
+        return;
+    }
+
+    isNetworkAlive = IoT_CentralLib_CheckConnection();
+    timeStamp      = IoT_CentralLib_GetTmeStamp();
+    if (! IsAuthenticationDone()) {
+        isNetworkAlive = false;
+    }
+
+    if (isNetworkAlive) {
+        if (IoT_CentralLib_HasCachedTelemetryItems()) {  // send cached data first
+            if (! IoT_CentralLib_ResendCachedTelemetryItems()) {
+                // !!error
+            }
+            if (IoT_CentralLib_HasCachedTelemetryItems()) {
+                goto do_cache;   // still outstanding cache, so append new data
+            }
+        }
+
+        if (IoT_CentralLib_IsSendWindowFull()) {
+            goto do_cache;   // too many messages in flight, so hold new data
+        }
+        if (! IoT_CentralLib_SendTelemetryItems(me->mItems, &timeStamp)) {
+            isNetworkAlive = IoT_CentralLib_CheckConnection();
+            if (isNetworkAlive) {
+                // !!error
+            }
+        }
+    }
+
+    if (! isNetworkAlive) {
+do_cache:
+        if (! IoT_CentralLib_EnqueueTelemtryItemsToCache(me->mItems,
+                timeStamp)) {
+            // failed to caching; Error!
+        }
+    }
+    TelemetryItems_Clear(me->mItems);
+}
@@ -0,0 +1,46 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _TELEMETRY_COLLECTOR_H_
+#define _TELEMETRY_COLLECTOR_H_
+
+typedef struct TelemetryCollector	TelemetryCollector;
+typedef struct TelemetryItems	TelemetryItems;
+
+// Initialization and cleanup
+extern TelemetryCollector*	TelemetryCollector_New(void);
+extern void	TelemetryCollector_Destroy(TelemetryCollector* me);
+
+// Collect telemetry data items of a tick
+extern void	TelemetryCollector_AddItems(TelemetryCollector* me,
+    const TelemetryItems* items);
+
+// Send collected items (per 1[sec])
+extern void	TelemetryCollector_Flush(TelemetryCollector* me);
+//
+// NOTE: All items collected in a tick are sent as one message, or stored
+//       to cache as one frame when network is down.  Each item keeps the
+//       capture time which the scheduler recorded on its acquisition.
+
+#endif  // _TELEMETRY_COLLECTOR_H_
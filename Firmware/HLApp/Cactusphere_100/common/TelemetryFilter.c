@@ -0,0 +1,231 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TelemetryFilter.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "vector.h"
+
+// filter condition and history of a telemetry item
+typedef struct TelemetryFilterEntry {
+    TelemetryFilterSpec	spec;
+    bool    	isEnabled;      // spec is enabled
+    bool    	hasReported;    // lastValue and lastReportMs are valid
+    double  	lastValue;      // last reported value
+    uint64_t	lastReportMs;   // time of the last report
+} TelemetryFilterEntry;
+
+// TelemetryFilter class's data members
+struct TelemetryFilter {
+    vector  	mEntries;       // vector of entry, indexed by TelemetryNameId
+    int     	mNumEnabled;    // number of enabled entries
+    uint32_t	mNumSamples;    // number of filtered samples
+    uint32_t	mNumSuppressed; // number of suppressed samples
+};
+
+// Initialization and cleanup
+TelemetryFilter*
+TelemetryFilter_New(void)
+{
+    TelemetryFilter*	newObj =
+        (TelemetryFilter*)malloc(sizeof(TelemetryFilter));
+
+    if (NULL != newObj) {
+        newObj->mEntries = vector_init(sizeof(TelemetryFilterEntry));
+        if (NULL == newObj->mEntries) {
+            free(newObj);
+            return NULL;
+        }
+        newObj->mNumEnabled    = 0;
+        newObj->mNumSamples    = 0;
+        newObj->mNumSuppressed = 0;
+    }
+
+    return newObj;
+}
+
+void
+TelemetryFilter_Destroy(TelemetryFilter* me)
+{
+    vector_destroy(me->mEntries);
+    free(me);
+}
+
+void
+TelemetryFilter_Clear(TelemetryFilter* me)
+{
+    vector_remove_all(me->mEntries);
+    me->mNumEnabled = 0;
+}
+
+// Attribute
+bool
+TelemetryFilter_IsEmpty(const TelemetryFilter* me)
+{
+    return (0 == me->mNumEnabled);
+}
+
+uint32_t
+TelemetryFilter_GetNumSamples(const TelemetryFilter* me)
+{
+    return me->mNumSamples;
+}
+
+uint32_t
+TelemetryFilter_GetNumSuppressed(const TelemetryFilter* me)
+{
+    return me->mNumSuppressed;
+}
+
+// Add filter condition
+bool
+TelemetryFilterSpec_IsEnabled(const TelemetryFilterSpec* spec)
+{
+    return (0 < spec->deadbandAbs || 0 < spec->deadbandPct
+        || 0 < spec->maxSilenceSec);
+}
+
+static bool
+TelemetryFilterSpec_IsEqual(
+    const TelemetryFilterSpec* lhs, const TelemetryFilterSpec* rhs)
+{
+    return (lhs->deadbandAbs == rhs->deadbandAbs
+        && lhs->deadbandPct == rhs->deadbandPct
+        && lhs->maxSilenceSec == rhs->maxSilenceSec);
+}
+
+bool
+TelemetryFilter_SetSpec(TelemetryFilter* me,
+    TelemetryNameId nameId, const TelemetryFilterSpec* spec)
+{
+    TelemetryFilterEntry	pseudo = { { 0 }, false, false, 0.0, 0 };
+    TelemetryFilterEntry*	entry;
+
+    if (TELEMETRY_NAME_ID_INVALID == nameId) {
+        return true;  // always pass
+    }
+    if (! TelemetryFilterSpec_IsEnabled(spec)) {
+        TelemetryFilter_RemoveSpec(me, nameId);
+        return true;  // always pass
+    }
+    while (vector_size(me->mEntries) <= (int)nameId) {
+        if (0 != vector_add_last(me->mEntries, &pseudo)) {
+            return false;
+        }
+    }
+
+    entry = (TelemetryFilterEntry*)vector_get_data(me->mEntries) + nameId;
+    if (! entry->isEnabled) {
+        ++me->mNumEnabled;
+    } else if (TelemetryFilterSpec_IsEqual(&entry->spec, spec)) {
+        return true;  // keep the history
+    }
+    entry->spec        = *spec;
+    entry->isEnabled   = true;
+    entry->hasReported = false;
+
+    return true;
+}
+
+void
+TelemetryFilter_RemoveSpec(TelemetryFilter* me, TelemetryNameId nameId)
+{
+    TelemetryFilterEntry*	entry;
+
+    if ((int)nameId >= vector_size(me->mEntries)) {
+        return;
+    }
+    entry = (TelemetryFilterEntry*)vector_get_data(me->mEntries) + nameId;
+    if (entry->isEnabled) {
+        entry->isEnabled   = false;
+        entry->hasReported = false;
+        --me->mNumEnabled;
+    }
+}
+
+// Filtering
+bool
+TelemetryFilter_Pass(TelemetryFilter* me,
+    TelemetryNameId nameId, double value, uint64_t nowMs)
+{
+    TelemetryFilterEntry*	entry;
+    double	deadband;
+
+    if ((int)nameId >= vector_size(me->mEntries)) {
+        return true;
+    }
+    entry = (TelemetryFilterEntry*)vector_get_data(me->mEntries) + nameId;
+    if (! entry->isEnabled) {
+        return true;
+    }
+
+    ++me->mNumSamples;
+    if (entry->hasReported) {
+        deadband = fabs(entry->lastValue) * entry->spec.deadbandPct / 100.0;
+        if (deadband < entry->spec.deadbandAbs) {
+            deadband = entry->spec.deadbandAbs;
+        }
+        if (((0 < deadband) ? fabs(value - entry->lastValue) <= deadband
+                            : value == entry->lastValue)
+        && (0 == entry->spec.maxSilenceSec
+            || nowMs - entry->lastReportMs
+                < (uint64_t)entry->spec.maxSilenceSec * 1000)) {
+            ++me->mNumSuppressed;
+            return false;
+        }
+    }
+    entry->hasReported  = true;
+    entry->lastValue    = value;
+    entry->lastReportMs = nowMs;
+
+    return true;
+}
+
+typedef struct TelemetryFilterArg {
+    TelemetryFilter*	filter;
+    uint64_t	nowMs;
+} TelemetryFilterArg;
+
+static bool
+TelemetryFilter_PassItem(void* arg, TelemetryNameId nameId, double value)
+{
+    TelemetryFilterArg*	filterArg = (TelemetryFilterArg*)arg;
+
+    return TelemetryFilter_Pass(
+        filterArg->filter, nameId, value, filterArg->nowMs);
+}
+
+void
+TelemetryFilter_Apply(TelemetryFilter* me,
+    TelemetryItems* items, uint64_t nowMs)
+{
+    TelemetryFilterArg	arg = { me, nowMs };
+
+    if (TelemetryFilter_IsEmpty(me)) {
+        return;
+    }
+    TelemetryItems_Retain(items, TelemetryFilter_PassItem, &arg);
+}
@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _TELEMETRY_FILTER_H_
+#define _TELEMETRY_FILTER_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef _TELEMETRYITEMS_H_
+#include <TelemetryItems.h>
+#endif
+
+// report-by-exception condition of a telemetry item
+typedef struct TelemetryFilterSpec {
+    float   	deadbandAbs;    // absolute deadband (0: none)
+    float   	deadbandPct;    // deadband in [%] of the last reported value
+    uint32_t	maxSilenceSec;  // heartbeat period (in seconds, 0: none)
+} TelemetryFilterSpec;
+
+typedef struct TelemetryFilter	TelemetryFilter;
+
+// Initialization and cleanup
+extern TelemetryFilter*	TelemetryFilter_New(void);
+extern void	TelemetryFilter_Destroy(TelemetryFilter* me);
+extern void	TelemetryFilter_Clear(TelemetryFilter* me);
+
+// Attribute
+extern bool	TelemetryFilter_IsEmpty(const TelemetryFilter* me);
+extern uint32_t	TelemetryFilter_GetNumSamples(const TelemetryFilter* me);
+extern uint32_t	TelemetryFilter_GetNumSuppressed(const TelemetryFilter* me);
+
+// Add filter condition
+extern bool	TelemetryFilterSpec_IsEnabled(const TelemetryFilterSpec* spec);
+extern bool	TelemetryFilter_SetSpec(TelemetryFilter* me,
+    TelemetryNameId nameId, const TelemetryFilterSpec* spec);
+extern void	TelemetryFilter_RemoveSpec(
+    TelemetryFilter* me, TelemetryNameId nameId);
+
+// Filtering
+extern bool	TelemetryFilter_Pass(TelemetryFilter* me,
+    TelemetryNameId nameId, double value, uint64_t nowMs);
+extern void	TelemetryFilter_Apply(TelemetryFilter* me,
+    TelemetryItems* items, uint64_t nowMs);
+
+//
+// NOTE:
+// A sample is reported when it is the first one after the condition was
+// set, when it differs from the last reported value by more than the
+// deadband (the larger of the absolute one and the percentage of the last
+// reported value; any change if both are 0), or when nothing has been
+// reported for maxSilenceSec.  Items without an enabled condition always
+// pass.  TelemetryFilter_Clear() drops the conditions and the history,
+// and is done on reconfiguration; setting the same condition again keeps
+// the history, and setting a disabled one is the same as
+// TelemetryFilter_RemoveSpec().
+//
+
+#endif  // _TELEMETRY_FILTER_H_
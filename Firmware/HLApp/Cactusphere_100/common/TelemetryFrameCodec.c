@@ -0,0 +1,380 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TelemetryFrameCodec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "TelemetryItemCache.h"
+#include "TelemetryItems.h"
+
+#define FRAME_NAMES_CHANGED	0x01	// frame flag: item names are included
+#define FRAME_CAPTURE_DELTA	0x02	// frame flag: capture time in delta-of-delta
+#define FRAME_CAPTURE_FULL	0x04	// frame flag: capture time in full
+
+#define VARINT_MAX_LEN	5	// max length of 32 bit variable length integer
+
+// per position state of the frame
+typedef struct FrameItemState {
+    TelemetryNameId	nameId;	// item name
+    uint32_t	value;	// item value in raw bits
+    TelemetryValueType	type;	// value type
+} FrameItemState;
+
+struct TelemetryFrameCodec {
+    uint32_t	mPrevTs;	// time stamp of the previous frame
+    uint32_t	mPrevDelta;	// time stamp delta of the previous frame
+    uint64_t	mPrevCaptureMs;	// capture time of the previous stamped frame
+    int64_t	mPrevCaptureDelta;	// its capture time delta
+    FrameItemState*	mPrev;	// items of the previous frame
+    uint32_t	mPrevCount;	// number of items of the previous frame
+    FrameItemState*	mCurr;	// work area for the current frame
+    uint32_t	mCapacity;	// capacity of mPrev and mCurr
+};
+
+static inline uint32_t
+ZigZag(int32_t val)
+{
+    return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+}
+
+static inline int32_t
+UnZigZag(uint32_t val)
+{
+    return (int32_t)(val >> 1) ^ -(int32_t)(val & 1);
+}
+
+static inline unsigned char*
+PutVarint(unsigned char* dst, uint32_t val)
+{
+    while (0x80 <= val) {
+        *dst++ = (unsigned char)(val | 0x80);
+        val >>= 7;
+    }
+    *dst++ = (unsigned char)val;
+
+    return dst;
+}
+
+static inline const unsigned char*
+GetVarint(const unsigned char* src, const unsigned char* end, uint32_t* outVal)
+{
+    uint32_t	val = 0;
+
+    for (int shift = 0; shift < 7 * VARINT_MAX_LEN && src < end; shift += 7) {
+        unsigned char	byte = *src++;
+
+        val |= (uint32_t)(byte & 0x7F) << shift;
+        if (0 == (byte & 0x80)) {
+            *outVal = val;
+            return src;
+        }
+    }
+
+    return NULL;  // broken
+}
+
+static inline uint32_t
+TelemetryFrameCodec_PrevValue(const TelemetryFrameCodec* me,
+    uint32_t index, const FrameItemState* curr)
+{
+    // the value of the same item at the same position in the previous frame
+    if (index < me->mPrevCount
+    && me->mPrev[index].nameId == curr->nameId
+    && me->mPrev[index].type == curr->type) {
+        return me->mPrev[index].value;
+    }
+
+    return 0;
+}
+
+static inline int64_t
+TelemetryFrameCodec_CaptureDelta(const TelemetryFrameCodec* me,
+    uint64_t captureMs)
+{
+    // delta-of-delta of the capture time
+    return (int64_t)(captureMs - me->mPrevCaptureMs) - me->mPrevCaptureDelta;
+}
+
+static void
+TelemetryFrameCodec_Commit(TelemetryFrameCodec* me,
+    uint32_t timeStamp, uint64_t captureMs, uint32_t numItems)
+{
+    FrameItemState*	tmp = me->mPrev;
+
+    me->mPrevDelta = timeStamp - me->mPrevTs;
+    me->mPrevTs    = timeStamp;
+    if (0 != captureMs) {
+        me->mPrevCaptureDelta = (int64_t)(captureMs - me->mPrevCaptureMs);
+        me->mPrevCaptureMs    = captureMs;
+    }
+    me->mPrev      = me->mCurr;
+    me->mCurr      = tmp;
+    me->mPrevCount = numItems;
+}
+
+// Initialization and cleanup
+TelemetryFrameCodec*
+TelemetryFrameCodec_New(void)
+{
+    TelemetryFrameCodec*	newObj =
+        (TelemetryFrameCodec*)malloc(sizeof(TelemetryFrameCodec));
+
+    if (NULL != newObj) {
+        newObj->mPrev     = NULL;
+        newObj->mCurr     = NULL;
+        newObj->mCapacity = 0;
+        TelemetryFrameCodec_Reset(newObj);
+    }
+
+    return newObj;
+}
+
+void
+TelemetryFrameCodec_Destroy(TelemetryFrameCodec* me)
+{
+    free(me->mPrev);
+    free(me->mCurr);
+    free(me);
+}
+
+void
+TelemetryFrameCodec_Reset(TelemetryFrameCodec* me)
+{
+    me->mPrevTs    = 0;
+    me->mPrevDelta = 0;
+    me->mPrevCaptureMs    = 0;
+    me->mPrevCaptureDelta = 0;
+    me->mPrevCount = 0;
+}
+
+bool
+TelemetryFrameCodec_CopyState(TelemetryFrameCodec* me,
+    const TelemetryFrameCodec* src)
+{
+    if (! TelemetryFrameCodec_Reserve(me, src->mPrevCount)) {
+        return false;
+    }
+    if (0 < src->mPrevCount) {
+        memcpy(me->mPrev, src->mPrev,
+            src->mPrevCount * sizeof(FrameItemState));
+    }
+    me->mPrevTs    = src->mPrevTs;
+    me->mPrevDelta = src->mPrevDelta;
+    me->mPrevCaptureMs    = src->mPrevCaptureMs;
+    me->mPrevCaptureDelta = src->mPrevCaptureDelta;
+    me->mPrevCount = src->mPrevCount;
+
+    return true;
+}
+
+bool
+TelemetryFrameCodec_Reserve(TelemetryFrameCodec* me, uint32_t numItems)
+{
+    FrameItemState*	newPrev;
+    FrameItemState*	newCurr;
+
+    if (numItems <= me->mCapacity) {
+        return true;
+    }
+    newPrev = realloc(me->mPrev, numItems * sizeof(FrameItemState));
+    if (NULL == newPrev) {
+        return false;
+    }
+    me->mPrev = newPrev;
+    newCurr = realloc(me->mCurr, numItems * sizeof(FrameItemState));
+    if (NULL == newCurr) {
+        return false;
+    }
+    me->mCurr     = newCurr;
+    me->mCapacity = numItems;
+
+    return true;
+}
+
+// Attribute
+uint32_t
+TelemetryFrameCodec_MaxEncodedSize(uint32_t numItems)
+{
+    // flags, time stamp, capture time (2 words at most), number of items
+    // and (name ID, type and value) * numItems
+    return 1 + VARINT_MAX_LEN * 4
+        + numItems * (VARINT_MAX_LEN + 1 + VARINT_MAX_LEN);
+}
+
+// Encode and decode frame
+uint32_t
+TelemetryFrameCodec_Encode(TelemetryFrameCodec* me,
+    const TelemetryItems* items, uint32_t timeStamp,
+    unsigned char* outBuf, uint32_t bufSize)
+{
+    unsigned char*	dst = outBuf;
+    uint32_t	numItems = 0;
+    bool	namesChanged;
+    int 	n = TelemetryItems_Count(items);
+    uint64_t	captureMs = TelemetryItems_GetCaptureTime(items);
+    int64_t	captureDelta = TelemetryFrameCodec_CaptureDelta(me, captureMs);
+    unsigned char	flags = 0;
+
+    if (! TelemetryFrameCodec_Reserve(me, (uint32_t)n)
+    || bufSize < TelemetryFrameCodec_MaxEncodedSize((uint32_t)n)) {
+        return 0;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        TelemetryCacheElem	elem;
+        FrameItemState* curr = &me->mCurr[numItems];
+
+        if (NULL != TelemetryItems_ConvToCacheElemAt(
+                items, i, &elem, &curr->type)) {
+            curr->nameId = elem.nameId;
+            curr->value  = elem.value.ul;
+            ++numItems;
+        }
+    }
+    namesChanged = (numItems != me->mPrevCount);
+    for (uint32_t i = 0; i < numItems && ! namesChanged; ++i) {
+        namesChanged = (me->mCurr[i].nameId != me->mPrev[i].nameId
+            || me->mCurr[i].type != me->mPrev[i].type);
+    }
+
+    if (namesChanged) {
+        flags |= FRAME_NAMES_CHANGED;
+    }
+    if (0 != captureMs) {
+        flags |= (INT32_MIN <= captureDelta && captureDelta <= INT32_MAX
+            ? FRAME_CAPTURE_DELTA : FRAME_CAPTURE_FULL);
+    }
+    *dst++ = flags;
+    dst = PutVarint(dst,
+        ZigZag((int32_t)(timeStamp - me->mPrevTs - me->mPrevDelta)));
+    if (0 != (flags & FRAME_CAPTURE_DELTA)) {
+        dst = PutVarint(dst, ZigZag((int32_t)captureDelta));
+    } else if (0 != (flags & FRAME_CAPTURE_FULL)) {
+        dst = PutVarint(dst, (uint32_t)(captureMs >> 32));
+        dst = PutVarint(dst, (uint32_t)captureMs);
+    }
+    if (namesChanged) {
+        dst = PutVarint(dst, numItems);
+        for (uint32_t i = 0; i < numItems; ++i) {
+            dst = PutVarint(dst, me->mCurr[i].nameId);
+            *dst++ = (unsigned char)me->mCurr[i].type;
+        }
+    }
+    for (uint32_t i = 0; i < numItems; ++i) {
+        const FrameItemState*	curr = &me->mCurr[i];
+        uint32_t	prev = TelemetryFrameCodec_PrevValue(me, i, curr);
+
+        dst = PutVarint(dst, (TelemetryValueType_Float == curr->type
+            ? curr->value ^ prev : ZigZag((int32_t)(curr->value - prev))));
+    }
+    TelemetryFrameCodec_Commit(me, timeStamp, captureMs, numItems);
+
+    return (uint32_t)(dst - outBuf);
+}
+
+uint32_t
+TelemetryFrameCodec_Decode(TelemetryFrameCodec* me,
+    const unsigned char* buf, uint32_t len,
+    TelemetryItems* outItems, uint32_t* outTimeStamp)
+{
+    const unsigned char*	src = buf;
+    const unsigned char*	end = buf + len;
+    uint32_t	numItems = me->mPrevCount;
+    uint32_t	timeStamp;
+    uint64_t	captureMs = 0;
+    uint32_t	val;
+    unsigned char	flags;
+
+    if (src >= end) {
+        return 0;
+    }
+    flags = *src++;
+    if (NULL == (src = GetVarint(src, end, &val))) {
+        return 0;
+    }
+    timeStamp = me->mPrevTs + me->mPrevDelta + (uint32_t)UnZigZag(val);
+    if (0 != (flags & FRAME_CAPTURE_DELTA)) {
+        if (NULL == (src = GetVarint(src, end, &val))) {
+            return 0;
+        }
+        captureMs = me->mPrevCaptureMs
+            + (uint64_t)(me->mPrevCaptureDelta + UnZigZag(val));
+    } else if (0 != (flags & FRAME_CAPTURE_FULL)) {
+        uint32_t	hi;
+
+        if (NULL == (src = GetVarint(src, end, &hi))
+        || NULL == (src = GetVarint(src, end, &val))) {
+            return 0;
+        }
+        captureMs = ((uint64_t)hi << 32) | val;
+    }
+
+    if (0 != (flags & FRAME_NAMES_CHANGED)) {
+        if (NULL == (src = GetVarint(src, end, &numItems))
+        || (uint32_t)(end - src) < numItems * 2
+        || ! TelemetryFrameCodec_Reserve(me, numItems)) {
+            return 0;
+        }
+        for (uint32_t i = 0; i < numItems; ++i) {
+            if (NULL == (src = GetVarint(src, end, &val)) || src >= end) {
+                return 0;
+            }
+            me->mCurr[i].nameId = (TelemetryNameId)val;
+            me->mCurr[i].type   = (TelemetryValueType)*src++;
+        }
+    } else {
+        memcpy(me->mCurr, me->mPrev, numItems * sizeof(FrameItemState));
+    }
+
+    for (uint32_t i = 0; i < numItems; ++i) {
+        FrameItemState*	curr = &me->mCurr[i];
+        uint32_t	prev = TelemetryFrameCodec_PrevValue(me, i, curr);
+
+        if (NULL == (src = GetVarint(src, end, &val))) {
+            return 0;
+        }
+        curr->value = (TelemetryValueType_Float == curr->type
+            ? val ^ prev : prev + (uint32_t)UnZigZag(val));
+    }
+
+    if (NULL != outItems) {
+        TelemetryItems_Clear(outItems);
+        TelemetryItems_SetCaptureBase(outItems, captureMs);
+        for (uint32_t i = 0; i < numItems; ++i) {
+            TelemetryCacheElem	elem;
+
+            elem.nameId   = me->mCurr[i].nameId;
+            elem.value.ul = me->mCurr[i].value;
+            TelemetryItems_AddFromCacheElem(outItems, &elem);
+        }
+    }
+    if (NULL != outTimeStamp) {
+        *outTimeStamp = timeStamp;
+    }
+    TelemetryFrameCodec_Commit(me, timeStamp, captureMs, numItems);
+
+    return (uint32_t)(src - buf);
+}
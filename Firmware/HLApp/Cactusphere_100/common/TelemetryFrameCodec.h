@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _TELEMETRY_FRAME_CODEC_H_
+#define _TELEMETRY_FRAME_CODEC_H_
+
+#ifndef _STDBOOL
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+typedef struct TelemetryFrameCodec	TelemetryFrameCodec;
+typedef struct TelemetryItems	TelemetryItems;
+
+// Compressed encoding of telemetry snapshots (frames).
+//
+// Each frame is encoded against the previous one: the time stamp and the
+// capture time base as delta-of-delta, float values as XOR and integer values as delta, all of
+// them written in variable length integer.  Items are matched by position,
+// and the item name IDs are written only when they differ from the previous
+// frame.  An encoder and a decoder must see the same sequence of frames,
+// so the decoder has to decode every frame even if it is to be discarded.
+
+// Initialization and cleanup
+extern TelemetryFrameCodec*	TelemetryFrameCodec_New(void);
+extern void	TelemetryFrameCodec_Destroy(TelemetryFrameCodec* me);
+extern void	TelemetryFrameCodec_Reset(TelemetryFrameCodec* me);
+extern bool	TelemetryFrameCodec_CopyState(TelemetryFrameCodec* me,
+    const TelemetryFrameCodec* src);
+extern bool	TelemetryFrameCodec_Reserve(TelemetryFrameCodec* me,
+    uint32_t numItems);
+//
+// NOTE: TelemetryFrameCodec_CopyState() makes me continue the sequence of
+//       frames of src, so that frames can be rewritten from a point.
+//       The state grows to the number of items of a frame as needed, or
+//       up to numItems in advance by TelemetryFrameCodec_Reserve().
+
+// Attribute
+extern uint32_t	TelemetryFrameCodec_MaxEncodedSize(uint32_t numItems);
+
+// Encode and decode frame
+extern uint32_t	TelemetryFrameCodec_Encode(TelemetryFrameCodec* me,
+    const TelemetryItems* items, uint32_t timeStamp,
+    unsigned char* outBuf, uint32_t bufSize);
+extern uint32_t	TelemetryFrameCodec_Decode(TelemetryFrameCodec* me,
+    const unsigned char* buf, uint32_t len,
+    TelemetryItems* outItems, uint32_t* outTimeStamp);
+//
+// NOTE: Both return the encoded length in bytes, or 0 on error.  The state
+//       is not changed on error.  outItems of _Decode() can be NULL to
+//       skip the frame.
+
+#endif  // _TELEMETRY_FRAME_CODEC_H_
@@ -24,52 +24,697 @@
 
 #include "TelemetryItemCache.h"
 
-#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "TelemetryCacheStore.h"
+#include "TelemetryFrameCodec.h"
 #include "TelemetryItems.h"
+#include "vector.h"
 
-const char	MARKER_NAME[] = "___-___";
+// frame header which is placed in front of each snapshot's items; it takes
+// CACHE_HEADER_SLOTS slots of the same size as TelemetryCacheElem
+typedef struct __attribute__((__packed__, __aligned__(2))) TelemetryCacheFrameHeader {
+    uint32_t	timeStamp;	// time stamp of the snapshot
+    uint16_t	itemCount;	// number of items which follow the header
+} TelemetryCacheFrameHeader;
+
+// second slot of the frame header
+typedef struct __attribute__((__packed__, __aligned__(2))) TelemetryCacheFrameTime {
+    uint16_t	captureHi;	// capture time base [msec], upper 16 of 48 bits
+    uint32_t	captureLo;	// and the lower 32 bits (0: not stamped)
+} TelemetryCacheFrameTime;
+
+// ring buffer slot; holds a frame header or a telemetry item
+typedef union TelemetryCacheSlot {
+    TelemetryCacheFrameHeader	header;
+    TelemetryCacheFrameTime	time;
+    TelemetryCacheElem	elem;
+} TelemetryCacheSlot;
+
+// eviction policy of a telemetry item
+typedef struct TelemetryCachePolicy {
+    uint8_t 	priority;	// priority class (0: lowest)
+    uint32_t	ttlSec;	// time to live (in seconds, 0: forever)
+} TelemetryCachePolicy;
 
 typedef struct TelemetryItemCache {
-    TelemetryCacheElem* mRingBuf;	// ring buffer area
+    TelemetryCacheSlot* mRingBuf;	// ring buffer area
     unsigned char*      mOwnBuf;    // self allocated buffer area
-    uint32_t	mBufSize;	// ring buffer size in cache element size unit
+    uint32_t	mBufSize;	// ring buffer size in slot unit
     uint32_t	mWritePos;	// write position index
-    uint32_t	mReadPos;	// read position index
-    uint32_t	mIndexMax;	// max value of index
+    uint32_t	mReadPos;	// read position index (head of the oldest frame)
+    uint32_t	mUsedSlots;	// number of slots in use
+    uint32_t	mFrameCount;	// number of cached frames
+    TelemetryCacheStore*	mStore;	// persistent store (optional)
+
+    // for compressed frames; the positions above are in byte unit
+    TelemetryFrameCodec*	mEncoder;	// codec state of the newest frame
+    TelemetryFrameCodec*	mDecoder;	// codec state of the oldest frame
+    unsigned char*	mEncBuf;	// work area for encoding
+    unsigned char*	mDecBuf;	// work area for decoding
+    uint32_t	mEncBufSize;	// size of mEncBuf
+    uint32_t	mDecBufSize;	// size of mDecBuf
+    uint32_t	mBytesPerItem;	// average encoded size of the last frame
+
+    TelemetryItems*	mWorkItems;	// work area for requeued frames
+
+    // eviction policy
+    TelemetryCacheEviction	mEviction;
+    vector	mPolicies;	// vector of policy, indexed by TelemetryNameId
+    uint8_t 	mMaxPriority;	// highest priority class of the items
+    uint32_t	mNumTtls;	// number of items with TTL
+    uint32_t	mNewestTs;	// time stamp of the newest enqueued frame
+    uint32_t	mNumSinceCompact;	// frames enqueued since the last rewrite
+    bool	mEvictStalled;	// the last rewrite didn't make enough room
+    TelemetryFrameCodec*	mRewriter;	// encoder to rewrite compressed frames
+    TelemetryFrameCodec*	mRewindState;	// decoder state of the oldest frame
 } TelemetryItemCache;
 
+// steps of making room by the eviction policy
+typedef enum {
+    CacheStage_Expire = 0,	// remove expired items
+    CacheStage_Decimate,	// thin the densest frames of the older half
+    CacheStage_Strip,	// remove the items of a priority of the older half
+} CacheStage;
+
+// state of rewriting the cached frames
+typedef struct CacheCompaction {
+    const TelemetryItemCache*	cache;
+    CacheStage	stage;
+    uint8_t 	stripPriority;	// priority to remove on CacheStage_Strip
+    uint32_t	numOlder;	// number of frames of the older half
+    uint32_t	keepGap;	// interval of the frames to keep in the older half
+    uint32_t	index;	// index of the current frame from the oldest
+    uint32_t	timeStamp;	// time stamp of the current frame
+    uint32_t	keptTimeStamp;	// time stamp of the last frame kept
+} CacheCompaction;
+
+#define CACHE_MIN_SLOTS	10
+#define CACHE_HEADER_SLOTS	2	// slots of a frame header
+#define CACHE_MAX_DECIMATIONS	8	// decimation passes to make room at a time
+
+typedef uint16_t	CompressedFrameLen;	// length prefix of compressed frame
+
+static inline uint32_t
+TelemetryItemCache_Advance(const TelemetryItemCache* me,
+    uint32_t pos, uint32_t count)
+{
+    pos += count;
+    return (pos >= me->mBufSize ? pos - me->mBufSize : pos);
+}
+
+static inline void
+TelemetryItemCache_PutFrameTime(TelemetryCacheSlot* slot, uint64_t timeMs)
+{
+    slot->time.captureHi = (uint16_t)(timeMs >> 32);
+    slot->time.captureLo = (uint32_t)timeMs;
+}
+
+static inline uint64_t
+TelemetryItemCache_GetFrameTime(const TelemetryCacheSlot* slot)
+{
+    return ((uint64_t)slot->time.captureHi << 32) | slot->time.captureLo;
+}
+
 static void
 TelemetryItemCache_DiscardOldestCache(TelemetryItemCache* me)
 {
-    // skip until the second marker appears or reaches end
-    const TelemetryCacheElem* cacheElem =
-        me->mRingBuf + (me->mReadPos % me->mBufSize);
+    // skip the whole oldest frame by the item count in its header
+    uint32_t	frameSlots =
+        me->mRingBuf[me->mReadPos].header.itemCount + CACHE_HEADER_SLOTS;
 
-    if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
-        if (++(me->mReadPos) > me->mIndexMax) {
-            me->mReadPos = 0;
+    me->mReadPos    = TelemetryItemCache_Advance(me, me->mReadPos, frameSlots);
+    me->mUsedSlots -= frameSlots;
+    --me->mFrameCount;
+}
+
+static void
+TelemetryItemCache_DestroyRingBuf(TelemetryItemCache* me)
+{
+    free(me->mOwnBuf);
+    me->mOwnBuf = NULL;
+}
+
+static inline bool
+TelemetryItemCache_IsCompressed(const TelemetryItemCache* me)
+{
+    return (NULL != me->mEncoder);
+}
+
+static inline uint32_t
+TelemetryItemCache_ByteSize(const TelemetryItemCache* me)
+{
+    return me->mBufSize * (uint32_t)sizeof(TelemetryCacheSlot);
+}
+
+static uint32_t
+TelemetryItemCache_PutBytes(TelemetryItemCache* me,
+    uint32_t pos, const void* src, uint32_t len)
+{
+    // copy into the ring buffer (in byte unit) with wrapping around
+    unsigned char*	ringBuf = (unsigned char*)me->mRingBuf;
+    uint32_t	byteSize = TelemetryItemCache_ByteSize(me);
+    uint32_t	firstLen = byteSize - pos;
+
+    if (len < firstLen) {
+        memcpy(ringBuf + pos, src, len);
+        return pos + len;
+    }
+    memcpy(ringBuf + pos, src, firstLen);
+    memcpy(ringBuf, (const unsigned char*)src + firstLen, len - firstLen);
+
+    return len - firstLen;
+}
+
+static uint32_t
+TelemetryItemCache_GetBytes(const TelemetryItemCache* me,
+    uint32_t pos, void* dst, uint32_t len)
+{
+    // copy from the ring buffer (in byte unit) with wrapping around
+    const unsigned char*	ringBuf = (const unsigned char*)me->mRingBuf;
+    uint32_t	byteSize = TelemetryItemCache_ByteSize(me);
+    uint32_t	firstLen = byteSize - pos;
+
+    if (len < firstLen) {
+        memcpy(dst, ringBuf + pos, len);
+        return pos + len;
+    }
+    memcpy(dst, ringBuf + pos, firstLen);
+    memcpy((unsigned char*)dst + firstLen, ringBuf, len - firstLen);
+
+    return len - firstLen;
+}
+
+static bool
+TelemetryItemCache_DecodeOldest(TelemetryItemCache* me,
+    TelemetryItems* outItems, uint32_t* outTimeStamp)
+{
+    // Decode the oldest compressed frame and remove it.
+    // Discarded frames must be decoded too, to keep the decoder state.
+    CompressedFrameLen	frameLen;
+    uint32_t	pos;
+    bool	isOK;
+
+    pos = TelemetryItemCache_GetBytes(me, me->mReadPos,
+        &frameLen, sizeof(frameLen));
+    pos = TelemetryItemCache_GetBytes(me, pos, me->mDecBuf, frameLen);
+    isOK = (0 != TelemetryFrameCodec_Decode(me->mDecoder,
+        me->mDecBuf, frameLen, outItems, outTimeStamp));
+
+    me->mReadPos    = pos;
+    me->mUsedSlots -= (uint32_t)sizeof(frameLen) + frameLen;
+    --me->mFrameCount;
+
+    return isOK;
+}
+
+static bool
+TelemetryItemCache_GrowBuf(unsigned char** buf, uint32_t* bufSize,
+    uint32_t reqSize)
+{
+    unsigned char*	newBuf;
+
+    if (reqSize <= *bufSize) {
+        return true;
+    }
+    newBuf = realloc(*buf, reqSize);
+    if (NULL == newBuf) {
+        return false;
+    }
+    *buf     = newBuf;
+    *bufSize = reqSize;
+
+    return true;
+}
+
+static bool
+TelemetryItemCache_ReserveCodec(TelemetryItemCache* me,
+    const TelemetryItems* items)
+{
+    // size the scratch buffers and the codec states for the capacity of the
+    // items rather than the count, so that they don't grow on a rare tick
+    // with more items than usual
+    uint32_t	numItems = (uint32_t)TelemetryItems_GetCapacity(items);
+    uint32_t	maxLen;
+
+    if (numItems < (uint32_t)TelemetryItems_Count(items)) {
+        numItems = (uint32_t)TelemetryItems_Count(items);
+    }
+    maxLen = TelemetryFrameCodec_MaxEncodedSize(numItems);
+
+    return (TelemetryItemCache_GrowBuf(&me->mEncBuf, &me->mEncBufSize, maxLen)
+        && TelemetryItemCache_GrowBuf(&me->mDecBuf, &me->mDecBufSize, maxLen)
+        && TelemetryFrameCodec_Reserve(me->mEncoder, numItems)
+        && TelemetryFrameCodec_Reserve(me->mDecoder, numItems)
+        && (NULL == me->mRewriter
+            || TelemetryFrameCodec_Reserve(me->mRewriter, numItems))
+        && (NULL == me->mRewindState
+            || TelemetryFrameCodec_Reserve(me->mRewindState, numItems)));
+}
+
+static const TelemetryCachePolicy*
+TelemetryItemCache_PolicyOf(const TelemetryItemCache* me,
+    TelemetryNameId nameId)
+{
+    if ((int)nameId >= vector_size(me->mPolicies)) {
+        return NULL;
+    }
+
+    return (const TelemetryCachePolicy*)vector_get_data(me->mPolicies)
+        + nameId;
+}
+
+static inline bool
+TelemetryItemCache_HasEvictionPolicy(const TelemetryItemCache* me)
+{
+    return (NULL == me->mStore
+        && (TelemetryCacheEviction_DropOldest != me->mEviction
+            || 0 < me->mMaxPriority || 0 < me->mNumTtls));
+}
+
+static inline uint32_t
+TelemetryItemCache_CapacityUnits(const TelemetryItemCache* me)
+{
+    // buffer size in slot unit, or in byte unit if compressed
+    return (TelemetryItemCache_IsCompressed(me)
+        ? TelemetryItemCache_ByteSize(me) : me->mBufSize);
+}
+
+static inline uint32_t
+TelemetryItemCache_FreeUnits(const TelemetryItemCache* me)
+{
+    return TelemetryItemCache_CapacityUnits(me) - me->mUsedSlots;
+}
+
+static bool
+TelemetryItemCache_KeepItem(void* arg, TelemetryNameId nameId, double value)
+{
+    const CacheCompaction*	compaction = (const CacheCompaction*)arg;
+    const TelemetryItemCache*	me = compaction->cache;
+    const TelemetryCachePolicy*	policy =
+        TelemetryItemCache_PolicyOf(me, nameId);
+
+    (void)value;
+    if (NULL == policy) {
+        return (CacheStage_Strip != compaction->stage
+            || compaction->index >= compaction->numOlder);
+    }
+    if (0 < policy->ttlSec && me->mNewestTs > compaction->timeStamp
+    && policy->ttlSec < me->mNewestTs - compaction->timeStamp) {
+        return false;  // expired
+    }
+
+    return (CacheStage_Strip != compaction->stage
+        || compaction->index >= compaction->numOlder
+        || policy->priority > compaction->stripPriority);
+}
+
+static bool
+TelemetryItemCache_KeepFrame(const CacheCompaction* compaction,
+    const TelemetryItems* items)
+{
+    // Decimation keeps the frames of the older half at least keepGap
+    // apart, so only the part denser than that is thinned out.
+    const TelemetryItemCache*	me = compaction->cache;
+
+    if (CacheStage_Decimate != compaction->stage
+    || 0 == compaction->index || compaction->index >= compaction->numOlder
+    || compaction->timeStamp - compaction->keptTimeStamp
+        >= compaction->keepGap) {
+        return true;
+    }
+    for (int i = 0, n = TelemetryItems_Count(items);
+        0 < me->mMaxPriority && i < n; ++i) {
+        TelemetryCacheElem	elem;
+        const TelemetryCachePolicy*	policy;
+
+        (void)TelemetryItems_ConvToCacheElemAt(items, i, &elem, NULL);
+        policy = TelemetryItemCache_PolicyOf(me, elem.nameId);
+        if (NULL != policy && me->mMaxPriority == policy->priority) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t
+TelemetryItemCache_ReadFrameAt(TelemetryItemCache* me, uint32_t* pos,
+    TelemetryItems* outItems, uint32_t* outTimeStamp)
+{
+    // read the frame at *pos without removing it; returns its size in
+    // slot unit, or in byte unit if compressed
+    if (TelemetryItemCache_IsCompressed(me)) {
+        CompressedFrameLen	frameLen;
+
+        *pos = TelemetryItemCache_GetBytes(me, *pos,
+            &frameLen, sizeof(frameLen));
+        *pos = TelemetryItemCache_GetBytes(me, *pos, me->mDecBuf, frameLen);
+        if (0 == TelemetryFrameCodec_Decode(me->mDecoder,
+                me->mDecBuf, frameLen, outItems, outTimeStamp)) {
+            TelemetryItems_Clear(outItems);  // broken; drop it
+        }
+
+        return (uint32_t)sizeof(frameLen) + frameLen;
+    } else {
+        const TelemetryCacheFrameHeader*	header = &me->mRingBuf[*pos].header;
+        uint32_t	numItems = header->itemCount;
+        uint32_t	curs = TelemetryItemCache_Advance(me, *pos, 1);
+
+        *outTimeStamp = header->timeStamp;
+        TelemetryItems_Clear(outItems);
+        TelemetryItems_SetCaptureBase(outItems,
+            TelemetryItemCache_GetFrameTime(&me->mRingBuf[curs]));
+        curs = TelemetryItemCache_Advance(me, curs, 1);
+        for (uint32_t i = 0; i < numItems; ++i) {
+            TelemetryItems_AddFromCacheElem(outItems, &me->mRingBuf[curs].elem);
+            curs = TelemetryItemCache_Advance(me, curs, 1);
+        }
+        *pos = curs;
+
+        return numItems + CACHE_HEADER_SLOTS;
+    }
+}
+
+static uint32_t
+TelemetryItemCache_WriteFrameAt(TelemetryItemCache* me, uint32_t* pos,
+    const TelemetryItems* items, uint32_t timeStamp, uint32_t limit)
+{
+    // write the frame at *pos if it fits in limit; returns its size in the
+    // same unit as _ReadFrameAt(), or 0 if it doesn't fit
+    uint32_t	numItems = (uint32_t)TelemetryItems_Count(items);
+
+    if (TelemetryItemCache_IsCompressed(me)) {
+        CompressedFrameLen	frameLen;
+        uint32_t	encLen;
+
+        // mEncoder is free to keep the rewriter state to roll back
+        if (! TelemetryItemCache_GrowBuf(&me->mEncBuf, &me->mEncBufSize,
+                TelemetryFrameCodec_MaxEncodedSize(numItems))
+        || ! TelemetryFrameCodec_CopyState(me->mEncoder, me->mRewriter)) {
+            return 0;
+        }
+        encLen = TelemetryFrameCodec_Encode(me->mRewriter,
+            items, timeStamp, me->mEncBuf, me->mEncBufSize);
+        if (0 == encLen || limit < sizeof(frameLen) + encLen
+        || ! TelemetryItemCache_GrowBuf(&me->mDecBuf, &me->mDecBufSize, encLen)) {
+            (void)TelemetryFrameCodec_CopyState(me->mRewriter, me->mEncoder);
+            return 0;
+        }
+        frameLen = (CompressedFrameLen)encLen;
+        *pos = TelemetryItemCache_PutBytes(me, *pos, &frameLen, sizeof(frameLen));
+        *pos = TelemetryItemCache_PutBytes(me, *pos, me->mEncBuf, encLen);
+
+        return (uint32_t)sizeof(frameLen) + encLen;
+    } else {
+        TelemetryCacheFrameHeader*	header = &me->mRingBuf[*pos].header;
+        uint32_t	curs = TelemetryItemCache_Advance(me, *pos, 1);
+
+        if (limit < numItems + CACHE_HEADER_SLOTS) {
+            return 0;
         }
-        cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
+        header->timeStamp = timeStamp;
+        header->itemCount = (uint16_t)numItems;
+        TelemetryItemCache_PutFrameTime(&me->mRingBuf[curs],
+            TelemetryItems_GetCaptureTime(items));
+        curs = TelemetryItemCache_Advance(me, curs, 1);
+        for (uint32_t i = 0; i < numItems; ++i) {
+            (void)TelemetryItems_ConvToCacheElemAt(
+                items, (int)i, &me->mRingBuf[curs].elem, NULL);
+            curs = TelemetryItemCache_Advance(me, curs, 1);
+        }
+        *pos = curs;
+
+        return numItems + CACHE_HEADER_SLOTS;
+    }
+}
+
+static bool
+TelemetryItemCache_PrepareRewrite(TelemetryItemCache* me)
+{
+    // the rewriter and the decoder after rewriting start from the state
+    // of the oldest frame
+    if (NULL == me->mRewriter) {
+        me->mRewriter = TelemetryFrameCodec_New();
+    }
+    if (NULL == me->mRewindState) {
+        me->mRewindState = TelemetryFrameCodec_New();
+    }
+
+    return (NULL != me->mRewriter && NULL != me->mRewindState
+        && TelemetryFrameCodec_CopyState(me->mRewriter, me->mDecoder)
+        && TelemetryFrameCodec_CopyState(me->mRewindState, me->mDecoder));
+}
+
+static void
+TelemetryItemCache_FinishRewrite(TelemetryItemCache* me)
+{
+    TelemetryFrameCodec*	tmp = me->mDecoder;
+
+    me->mDecoder     = me->mRewindState;
+    me->mRewindState = tmp;
+    tmp              = me->mEncoder;
+    me->mEncoder     = me->mRewriter;
+    me->mRewriter    = tmp;
+}
+
+static uint32_t
+TelemetryItemCache_ScanMinGap(TelemetryItemCache* me, uint32_t numFrames)
+{
+    // the shortest interval of the oldest numFrames frames; the decoder
+    // is rewound after the scan
+    uint32_t	pos = me->mReadPos;
+    uint32_t	minGap = UINT32_MAX;
+    uint32_t	timeStamp, prevTimeStamp = 0;
+
+    if (TelemetryItemCache_IsCompressed(me)
+    && ! TelemetryItemCache_PrepareRewrite(me)) {
+        return UINT32_MAX;
     }
-    while (! TelemetryItemCache_IsEmpty(me)) {
-        if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
-            break;
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        (void)TelemetryItemCache_ReadFrameAt(me, &pos,
+            me->mWorkItems, &timeStamp);
+        if (0 < i && timeStamp - prevTimeStamp < minGap) {
+            minGap = timeStamp - prevTimeStamp;
         }
-        if (++(me->mReadPos) > me->mIndexMax) {
-            me->mReadPos = 0;
+        if (0 == minGap) {
+            minGap = 1;  // frames of the same second
         }
-        cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
+        prevTimeStamp = timeStamp;
+    }
+    if (TelemetryItemCache_IsCompressed(me)) {
+        (void)TelemetryFrameCodec_CopyState(me->mDecoder, me->mRewindState);
     }
+
+    return minGap;
 }
 
 static void
-TelemetryItemCache_DestroyRingBuf(TelemetryItemCache* me)
+TelemetryItemCache_Compact(TelemetryItemCache* me,
+    CacheCompaction* compaction)
 {
-    free(me->mOwnBuf);
-    me->mOwnBuf = NULL;
+    // Read the frames from the oldest one and write the kept part of them
+    // back from the same position.  Removing items only shrinks a plain
+    // frame, so the writer never overtakes the reader.  A compressed frame
+    // is encoded against another previous frame after removal, and is
+    // dropped in the rare case that it grows larger than the room.
+    uint32_t	numFrames = me->mFrameCount;
+    uint32_t	readPos   = me->mReadPos;
+    uint32_t	writePos  = me->mReadPos;
+    uint32_t	numRead = 0, numWritten = 0, numKept = 0;
+
+    if (TelemetryItemCache_IsCompressed(me)
+    && ! TelemetryItemCache_PrepareRewrite(me)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        uint32_t	frameLen;
+
+        compaction->index = i;
+        numRead += TelemetryItemCache_ReadFrameAt(me, &readPos,
+            me->mWorkItems, &compaction->timeStamp);
+        if (! TelemetryItemCache_KeepFrame(compaction, me->mWorkItems)) {
+            continue;
+        }
+        TelemetryItems_Retain(me->mWorkItems,
+            TelemetryItemCache_KeepItem, compaction);
+        if (0 == TelemetryItems_CountValues(me->mWorkItems)) {
+            continue;
+        }
+        frameLen = TelemetryItemCache_WriteFrameAt(me, &writePos,
+            me->mWorkItems, compaction->timeStamp, numRead - numWritten);
+        if (0 < frameLen) {
+            numWritten += frameLen;
+            ++numKept;
+            compaction->keptTimeStamp = compaction->timeStamp;
+        }
+    }
+
+    me->mWritePos   = writePos;
+    me->mUsedSlots  = numWritten;
+    me->mFrameCount = numKept;
+    me->mNumSinceCompact = 0;
+    if (TelemetryItemCache_IsCompressed(me)) {
+        TelemetryItemCache_FinishRewrite(me);
+    }
+}
+
+static void
+TelemetryItemCache_Evict(TelemetryItemCache* me, uint32_t needUnits)
+{
+    // Make room of needUnits by the eviction policy.  When the last
+    // rewrite didn't make enough room, the next one is put off until 1/8 of
+    // the frames are new, as it reads all the frames to remove nothing.
+    CacheCompaction	compaction = { me, CacheStage_Expire, 0, 0, 0, 0, 0, 0 };
+
+    if (me->mEvictStalled && me->mNumSinceCompact < me->mFrameCount / 8) {
+        return;
+    }
+    if (NULL == me->mWorkItems) {
+        me->mWorkItems = TelemetryItems_New();
+        if (NULL == me->mWorkItems) {
+            return;
+        }
+    }
+    if (0 < me->mNumTtls) {
+        TelemetryItemCache_Compact(me, &compaction);
+    }
+    if (TelemetryCacheEviction_Decimate == me->mEviction
+    && TelemetryItemCache_FreeUnits(me) < needUnits) {
+        // 1/8 of the buffer is made free not to rewrite on every frame;
+        // each pass doubles the interval to keep from the shortest one
+        uint32_t	minGap = TelemetryItemCache_ScanMinGap(
+            me, me->mFrameCount / 2);
+
+        compaction.stage = CacheStage_Decimate;
+        for (int pass = 1; pass <= CACHE_MAX_DECIMATIONS
+            && minGap <= (UINT32_MAX >> pass)
+            && TelemetryItemCache_FreeUnits(me) < needUnits
+                + TelemetryItemCache_CapacityUnits(me) / 8; ++pass) {
+            compaction.numOlder = me->mFrameCount / 2;
+            compaction.keepGap  = minGap << pass;
+            TelemetryItemCache_Compact(me, &compaction);
+        }
+    }
+    for (uint8_t priority = 0; priority < me->mMaxPriority
+        && TelemetryItemCache_FreeUnits(me) < needUnits; ++priority) {
+        compaction.stage         = CacheStage_Strip;
+        compaction.stripPriority = priority;
+        compaction.numOlder      = me->mFrameCount / 2;
+        TelemetryItemCache_Compact(me, &compaction);
+    }
+    me->mEvictStalled = (TelemetryItemCache_FreeUnits(me) < needUnits);
+}
+
+static bool
+TelemetryItemCache_EnqueueCompressed(TelemetryItemCache* me,
+    const TelemetryItems* items, uint32_t timeStamp)
+{
+    // Encode the telemetry data items as a frame with length prefix and
+    // put it into the ring buffer.  Old frames are discarded as needed.
+    uint32_t	numItems = (uint32_t)TelemetryItems_Count(items);
+    uint32_t	maxLen = TelemetryFrameCodec_MaxEncodedSize(numItems);
+    uint32_t	byteSize = TelemetryItemCache_ByteSize(me);
+    CompressedFrameLen	frameLen;
+    uint32_t	encLen;
+
+    if (UINT16_MAX < maxLen || byteSize < sizeof(frameLen) + maxLen) {
+        return false;  // too large items
+    }
+    if (! TelemetryItemCache_ReserveCodec(me, items)) {
+        return false;
+    }
+    if (TelemetryItemCache_HasEvictionPolicy(me)) {
+        // before encoding, as rewriting replaces the encoder state
+        uint32_t	needLen = (uint32_t)sizeof(frameLen) + maxLen;
+
+        if (byteSize - me->mUsedSlots < needLen) {
+            TelemetryItemCache_Evict(me, needLen);
+        }
+    }
+    encLen = TelemetryFrameCodec_Encode(me->mEncoder,
+        items, timeStamp, me->mEncBuf, me->mEncBufSize);
+    if (0 == encLen) {
+        return false;
+    }
+    if (! TelemetryItemCache_GrowBuf(&me->mDecBuf, &me->mDecBufSize, encLen)) {
+        // cannot decode the frame later; start over from the next frame
+        TelemetryItemCache_EnableCompression(me, true);
+        return false;
+    }
+
+    while (byteSize - me->mUsedSlots < sizeof(frameLen) + encLen) {
+        (void)TelemetryItemCache_DecodeOldest(me, NULL, NULL);
+    }
+    frameLen = (CompressedFrameLen)encLen;
+    me->mWritePos = TelemetryItemCache_PutBytes(me, me->mWritePos,
+        &frameLen, sizeof(frameLen));
+    me->mWritePos = TelemetryItemCache_PutBytes(me, me->mWritePos,
+        me->mEncBuf, encLen);
+    me->mUsedSlots += (uint32_t)sizeof(frameLen) + encLen;
+    ++me->mFrameCount;
+    me->mBytesPerItem = (sizeof(frameLen) + encLen) / (0 < numItems ? numItems : 1);
+
+    return true;
+}
+
+static bool
+TelemetryItemCache_EnqueueRawFrame(TelemetryItemCache* me,
+    const TelemetryCacheSlot* frame)
+{
+    // copy a frame into the ring buffer as is
+    uint32_t	frameSlots = frame->header.itemCount + CACHE_HEADER_SLOTS;
+    uint32_t	firstSlots = me->mBufSize - me->mWritePos;
+
+    if (frameSlots > me->mBufSize) {
+        return false;  // too large items
+    }
+    if (TelemetryItemCache_HasEvictionPolicy(me)
+    && me->mBufSize - me->mUsedSlots < frameSlots) {
+        TelemetryItemCache_Evict(me, frameSlots);
+        firstSlots = me->mBufSize - me->mWritePos;
+    }
+    while (me->mBufSize - me->mUsedSlots < frameSlots) {
+        TelemetryItemCache_DiscardOldestCache(me);
+    }
+    if (frameSlots < firstSlots) {
+        firstSlots = frameSlots;
+    }
+    memcpy(&me->mRingBuf[me->mWritePos], frame,
+        firstSlots * sizeof(TelemetryCacheSlot));
+    memcpy(me->mRingBuf, frame + firstSlots,
+        (frameSlots - firstSlots) * sizeof(TelemetryCacheSlot));
+
+    me->mWritePos   = TelemetryItemCache_Advance(me, me->mWritePos, frameSlots);
+    me->mUsedSlots += frameSlots;
+    ++me->mFrameCount;
+
+    return true;
+}
+
+static bool
+TelemetryItemCache_EnqueueFrameItems(TelemetryItemCache* me,
+    const TelemetryCacheSlot* frame)
+{
+    // convert a frame to items for the store or the compressed ring buffer
+    if (NULL == me->mWorkItems) {
+        me->mWorkItems = TelemetryItems_New();
+        if (NULL == me->mWorkItems) {
+            return false;
+        }
+    }
+    TelemetryItems_Clear(me->mWorkItems);
+    TelemetryItems_SetCaptureBase(me->mWorkItems,
+        TelemetryItemCache_GetFrameTime(&frame[1]));
+    for (uint32_t i = 0, n = frame->header.itemCount; i < n; ++i) {
+        TelemetryItems_AddFromCacheElem(me->mWorkItems,
+            &frame[CACHE_HEADER_SLOTS + i].elem);
+    }
+
+    return TelemetryItemCache_EnqueueItems(me,
+        me->mWorkItems, frame->header.timeStamp);
 }
 
 // Initialization and cleanup
@@ -84,7 +729,26 @@ TelemetryItemCache_New(void)
         newObj->mOwnBuf     = NULL;
         newObj->mBufSize    = 0;
         newObj->mWritePos   = newObj->mReadPos = 0;
-        newObj->mIndexMax   = ULONG_MAX;
+        newObj->mUsedSlots  = 0;
+        newObj->mFrameCount = 0;
+        newObj->mStore      = NULL;
+        newObj->mEncoder    = newObj->mDecoder = NULL;
+        newObj->mEncBuf     = newObj->mDecBuf  = NULL;
+        newObj->mEncBufSize = newObj->mDecBufSize = 0;
+        newObj->mBytesPerItem = 1;
+        newObj->mWorkItems  = NULL;
+        newObj->mEviction   = TelemetryCacheEviction_DropOldest;
+        newObj->mPolicies   = vector_init(sizeof(TelemetryCachePolicy));
+        newObj->mMaxPriority = 0;
+        newObj->mNumTtls    = 0;
+        newObj->mNewestTs   = 0;
+        newObj->mNumSinceCompact = 0;
+        newObj->mEvictStalled = false;
+        newObj->mRewriter   = newObj->mRewindState = NULL;
+        if (NULL == newObj->mPolicies) {
+            free(newObj);
+            newObj = NULL;
+        }
     }
 
     return newObj;
@@ -96,10 +760,12 @@ TelemetryItemCache_Init(TelemetryItemCache* me,
 {
     // Setting up ring buffer with passed buffer area.
     // If buffer isn't passed (passed pointer is NULL), then allocate it.
+    uintptr_t	mod;
+
     if (NULL != me->mOwnBuf) {
         TelemetryItemCache_DestroyRingBuf(me);
     }
-    if (bufSize < sizeof(TelemetryCacheElem) * 10) {
+    if (bufSize < sizeof(TelemetryCacheSlot) * CACHE_MIN_SLOTS) {
         return false;  // invalid argument
     }
     if (NULL == cacheBuf) {
@@ -110,28 +776,69 @@ TelemetryItemCache_Init(TelemetryItemCache* me,
         me->mOwnBuf = cacheBuf;
     }
 
-    if (0 != ((uint32_t)cacheBuf & 0x3)) {
-        // align if the passed area is not aligned on a 4 byte boundary
-        uint32_t	mod = (uint32_t)cacheBuf & 0x3;
-
-        cacheBuf += (4 - mod);
-        bufSize  -= (4 - mod);
-        if (bufSize < sizeof(TelemetryCacheElem) * 10) {
+    mod = (uintptr_t)cacheBuf % sizeof(void*);
+    if (0 != mod) {
+        // align if the passed area is not aligned on a pointer size boundary
+        cacheBuf += (sizeof(void*) - mod);
+        bufSize  -= (uint32_t)(sizeof(void*) - mod);
+        if (bufSize < sizeof(TelemetryCacheSlot) * CACHE_MIN_SLOTS) {
             if (NULL != me->mOwnBuf) {
                 TelemetryItemCache_DestroyRingBuf(me);
             }
             return false;  // invalid argument (too small buf)
         }
     }
-    me->mRingBuf  = (TelemetryCacheElem*)cacheBuf;
-    me->mBufSize  = bufSize / sizeof(TelemetryCacheElem);
-    me->mWritePos = me->mReadPos = 0;
-    me->mIndexMax = ULONG_MAX - (ULONG_MAX % me->mBufSize);
+    me->mRingBuf    = (TelemetryCacheSlot*)cacheBuf;
+    me->mBufSize    = bufSize / sizeof(TelemetryCacheSlot);
+    me->mWritePos   = me->mReadPos = 0;
+    me->mUsedSlots  = 0;
+    me->mFrameCount = 0;
+    if (TelemetryItemCache_IsCompressed(me)) {
+        TelemetryFrameCodec_Reset(me->mEncoder);
+        TelemetryFrameCodec_Reset(me->mDecoder);
+    }
 
     return true;
-//
-// NOTE: Here, it is assumed that the CPU is a 32-bit CPU, that is, 
-//       the pointer size is 32 bits.
+}
+
+void
+TelemetryItemCache_AttachStore(TelemetryItemCache* me,
+    TelemetryCacheStore* store)
+{
+    me->mStore = store;
+    if (NULL != store) {
+        me->mEviction = TelemetryCacheEviction_DropOldest;
+    }
+}
+
+bool
+TelemetryItemCache_EnableCompression(TelemetryItemCache* me, bool enable)
+{
+    if (enable && ! TelemetryItemCache_IsCompressed(me)) {
+        me->mEncoder = TelemetryFrameCodec_New();
+        me->mDecoder = TelemetryFrameCodec_New();
+        if (NULL == me->mEncoder || NULL == me->mDecoder) {
+            enable = false;
+        }
+    }
+    if (! enable && NULL != me->mEncoder) {
+        TelemetryFrameCodec_Destroy(me->mEncoder);
+        me->mEncoder = NULL;
+    }
+    if (! enable && NULL != me->mDecoder) {
+        TelemetryFrameCodec_Destroy(me->mDecoder);
+        me->mDecoder = NULL;
+    }
+    if (enable) {
+        TelemetryFrameCodec_Reset(me->mEncoder);
+        TelemetryFrameCodec_Reset(me->mDecoder);
+    }
+
+    me->mWritePos   = me->mReadPos = 0;
+    me->mUsedSlots  = 0;
+    me->mFrameCount = 0;
+
+    return (enable == TelemetryItemCache_IsCompressed(me));
 }
 
 void
@@ -140,36 +847,110 @@ TelemetryItemCache_Destroy(TelemetryItemCache* me)
     if (NULL != me->mOwnBuf) {
         free(me->mOwnBuf);
     }
+    if (TelemetryItemCache_IsCompressed(me)) {
+        TelemetryFrameCodec_Destroy(me->mEncoder);
+        TelemetryFrameCodec_Destroy(me->mDecoder);
+    }
+    free(me->mEncBuf);
+    free(me->mDecBuf);
+    if (NULL != me->mWorkItems) {
+        TelemetryItems_Destroy(me->mWorkItems);
+    }
+    if (NULL != me->mRewriter) {
+        TelemetryFrameCodec_Destroy(me->mRewriter);
+    }
+    if (NULL != me->mRewindState) {
+        TelemetryFrameCodec_Destroy(me->mRewindState);
+    }
+    vector_destroy(me->mPolicies);
     free(me);
 }
 
+// Eviction policy
+bool
+TelemetryItemCache_SetEviction(TelemetryItemCache* me,
+    TelemetryCacheEviction eviction)
+{
+    if (NULL != me->mStore && TelemetryCacheEviction_DropOldest != eviction) {
+        return false;  // the store discards the oldest segment only
+    }
+    me->mEviction = eviction;
+
+    return true;
+}
+
+bool
+TelemetryItemCache_SetItemPolicy(TelemetryItemCache* me,
+    TelemetryNameId nameId, uint8_t priority, uint32_t ttlSec)
+{
+    TelemetryCachePolicy*	policy;
+
+    if (TELEMETRY_NAME_ID_INVALID == nameId
+    || TelemetryItems_IsMark(nameId)
+    || (NULL != me->mStore && 0 < priority)) {
+        return false;
+    }
+    while (vector_size(me->mPolicies) <= (int)nameId) {
+        TelemetryCachePolicy	none = { 0, 0 };
+
+        if (0 != vector_add_last(me->mPolicies, &none)) {
+            return false;
+        }
+    }
+    policy = (TelemetryCachePolicy*)vector_get_data(me->mPolicies) + nameId;
+    if (0 < policy->ttlSec) {
+        --me->mNumTtls;
+    }
+    policy->priority = priority;
+    policy->ttlSec   = ttlSec;
+    if (0 < ttlSec) {
+        ++me->mNumTtls;
+    }
+    if (me->mMaxPriority < priority) {
+        me->mMaxPriority = priority;
+    }
+
+    return true;
+}
+
+void
+TelemetryItemCache_ClearItemPolicies(TelemetryItemCache* me)
+{
+    vector_remove_all(me->mPolicies);
+    me->mMaxPriority = 0;
+    me->mNumTtls     = 0;
+}
+
 // Attribute
 uint32_t
 TelemetryItemCache_CountAvailItems(const TelemetryItemCache* me)
 {
-    uint32_t	numSpace = 0;
+    uint32_t	numSpace = me->mBufSize - me->mUsedSlots;
 
-    if (ULONG_MAX == me->mIndexMax) {
-        numSpace = (me->mWritePos - me->mReadPos);
-    } else {
-        if (me->mWritePos == me->mReadPos) {  // empty
-            numSpace = me->mBufSize;
-        } else if (me->mWritePos > me->mReadPos) {
-            numSpace = (me->mWritePos - me->mReadPos);
-        } else {
-            numSpace = ((me->mIndexMax - me->mReadPos) + me->mWritePos);
-        }
+    if (NULL != me->mStore) {
+        return TelemetryCacheStore_CountAvailItems(me->mStore);
+    } else if (TelemetryItemCache_IsCompressed(me)) {
+        // estimate by the last frame
+        return (TelemetryItemCache_ByteSize(me) - me->mUsedSlots)
+            / (0 < me->mBytesPerItem ? me->mBytesPerItem : 1);
     }
 
-    return (0 < numSpace ? (numSpace - 1) : 0);
+    return (CACHE_HEADER_SLOTS < numSpace ? (numSpace - CACHE_HEADER_SLOTS) : 0);
 //
-// NOET: Subtract 1 for time stamp / separator markers
+// NOTE: Subtract the frame header
+}
+
+uint32_t
+TelemetryItemCache_CountFrames(const TelemetryItemCache* me)
+{
+    return (NULL != me->mStore
+        ? TelemetryCacheStore_CountFrames(me->mStore) : me->mFrameCount);
 }
 
 bool
 TelemetryItemCache_IsEmpty(const TelemetryItemCache* me)
 {
-    return (me->mWritePos == me->mReadPos);
+    return (0 == TelemetryItemCache_CountFrames(me));
 }
 
 // Add and remove chace elem
@@ -177,80 +958,168 @@ bool
 TelemetryItemCache_EnqueueItems(TelemetryItemCache* me,
     const TelemetryItems* items, uint32_t timeStamp)
 {
-    // Puts all passed telemetry data items into the ring buffer 
-    // with a timestamp/separation marker at the beginning.
-    // When there is no enough space left, discard old caches.
-    TelemetryCacheElem* curs;
+    // Puts all passed telemetry data items into the ring buffer as a frame
+    // with a header holding the item count and time stamp at the beginning.
+    // When there is no enough space left, discard old frames.
+    TelemetryCacheFrameHeader*	header;
+    uint32_t	numItems = (uint32_t)TelemetryItems_Count(items);
+    uint32_t	numStored = 0;
+    uint32_t	pos;
 
-    while (TelemetryItemCache_CountAvailItems(me) < TelemetryItems_Count(items)) {
-        if (TelemetryItemCache_IsEmpty(me)) {
-            return false;  // too large items
-        }
-        TelemetryItemCache_DiscardOldestCache(me);
+    if (me->mNewestTs < timeStamp || TelemetryItemCache_IsEmpty(me)) {
+        me->mNewestTs = timeStamp;
     }
-
-    curs = me->mRingBuf + (me->mWritePos % me->mBufSize);
-    curs->itemName = MARKER_NAME;
-    curs->value.ul = timeStamp;
-    if (++(me->mWritePos) > me->mIndexMax) {
-        me->mWritePos = 0;
+    ++me->mNumSinceCompact;
+    if (NULL != me->mStore) {
+        return TelemetryCacheStore_EnqueueItems(me->mStore, items, timeStamp);
+    } else if (TelemetryItemCache_IsCompressed(me)) {
+        return TelemetryItemCache_EnqueueCompressed(me, items, timeStamp);
+    }
+    if (numItems + CACHE_HEADER_SLOTS > me->mBufSize || UINT16_MAX < numItems) {
+        return false;  // too large items
+    }
+    if (TelemetryItemCache_HasEvictionPolicy(me)
+    && TelemetryItemCache_CountAvailItems(me) < numItems) {
+        TelemetryItemCache_Evict(me, numItems + CACHE_HEADER_SLOTS);
+    }
+    while (TelemetryItemCache_CountAvailItems(me) < numItems) {
+        TelemetryItemCache_DiscardOldestCache(me);
     }
 
-    for (int i = 0, n = TelemetryItems_Count(items); i < n; ++i) {
-        curs = me->mRingBuf + (me->mWritePos % me->mBufSize);
-        TelemetryItems_ConvToCacheElemAt(items, i, curs);
+    header = &me->mRingBuf[me->mWritePos].header;
+    header->timeStamp = timeStamp;
+    pos = TelemetryItemCache_Advance(me, me->mWritePos, 1);
+    TelemetryItemCache_PutFrameTime(&me->mRingBuf[pos],
+        TelemetryItems_GetCaptureTime(items));
+    pos = TelemetryItemCache_Advance(me, pos, 1);
 
-        if (++(me->mWritePos) > me->mIndexMax) {
-            me->mWritePos = 0;
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if (NULL != TelemetryItems_ConvToCacheElemAt(
+                items, (int)i, &me->mRingBuf[pos].elem, NULL)) {
+            pos = TelemetryItemCache_Advance(me, pos, 1);
+            ++numStored;
         }
     }
+    header->itemCount = (uint16_t)numStored;
+
+    me->mWritePos   = pos;
+    me->mUsedSlots += numStored + CACHE_HEADER_SLOTS;
+    ++me->mFrameCount;
 
     return true;
 }
 
-bool
-TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
+static bool
+TelemetryItemCache_DequeueFrame(TelemetryItemCache* me,
     TelemetryItems* outItems, uint32_t* outTimeStamp)
 {
-    // Retrieve a set of telemetry data items from the cache. Extract 
-    // from the first time stamp / separation marker to the next one.
-    const TelemetryCacheElem*	cacheElem;
+    // Retrieve the oldest frame of telemetry data items from the cache.
+    const TelemetryCacheFrameHeader*	header;
+    uint32_t	pos;
 
+    if (NULL != me->mStore) {
+        return TelemetryCacheStore_DequeueItemsTo(
+            me->mStore, outItems, outTimeStamp);
+    }
     if (TelemetryItemCache_IsEmpty(me)) {
         return false;
+    } else if (TelemetryItemCache_IsCompressed(me)) {
+        return TelemetryItemCache_DecodeOldest(me, outItems, outTimeStamp);
     }
 
     TelemetryItems_Clear(outItems);
-    *outTimeStamp = 0;
-
-    cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-    if (0 != strcmp(cacheElem->itemName, MARKER_NAME)) {
-        // skip until time stamp / separation marker appears
-        do {
-            if (++(me->mReadPos) > me->mIndexMax) {
-                me->mReadPos = 0;
-            }
-            if (TelemetryItemCache_IsEmpty(me)) {
-                return false;  // reached to end
-            }
-            cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-        } while (0 != strcmp(cacheElem->itemName, MARKER_NAME));
+
+    header = &me->mRingBuf[me->mReadPos].header;
+    *outTimeStamp = header->timeStamp;
+    pos = TelemetryItemCache_Advance(me, me->mReadPos, 1);
+    TelemetryItems_SetCaptureBase(outItems,
+        TelemetryItemCache_GetFrameTime(&me->mRingBuf[pos]));
+    pos = TelemetryItemCache_Advance(me, pos, 1);
+    for (uint32_t i = 0, n = header->itemCount; i < n; ++i) {
+        TelemetryItems_AddFromCacheElem(outItems, &me->mRingBuf[pos].elem);
+        pos = TelemetryItemCache_Advance(me, pos, 1);
+    }
+    TelemetryItemCache_DiscardOldestCache(me);
+
+    return true;
+}
+
+bool
+TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
+    TelemetryItems* outItems, uint32_t* outTimeStamp)
+{
+    // skip the frames whose items are all expired
+    CacheCompaction	expiry = { me, CacheStage_Expire, 0, 0, 0, 0, 0, 0 };
+
+    while (TelemetryItemCache_DequeueFrame(me, outItems, outTimeStamp)) {
+        if (0 == me->mNumTtls) {
+            return true;
+        }
+        expiry.timeStamp = *outTimeStamp;
+        TelemetryItems_Retain(outItems, TelemetryItemCache_KeepItem, &expiry);
+        if (0 < TelemetryItems_CountValues(outItems)) {
+            return true;
+        }
     }
-    *outTimeStamp = cacheElem->value.ul;
-    if (++(me->mReadPos) > me->mIndexMax) {
-        me->mReadPos = 0;
+
+    return false;
+}
+
+// Binary frame of telemetry data items
+uint32_t
+TelemetryItemCache_FrameSize(const TelemetryItems* items)
+{
+    return (uint32_t)(TelemetryItems_Count(items) + CACHE_HEADER_SLOTS)
+        * (uint32_t)sizeof(TelemetryCacheSlot);
+}
+
+uint32_t
+TelemetryItemCache_WriteFrame(const TelemetryItems* items,
+    uint32_t timeStamp, void* outBuf)
+{
+    // write the items with the frame header in the same layout as the
+    // ring buffer; outBuf must have TelemetryItemCache_FrameSize() bytes
+    TelemetryCacheSlot*	slots = (TelemetryCacheSlot*)outBuf;
+    uint32_t	numItems = (uint32_t)TelemetryItems_Count(items);
+
+    if (UINT16_MAX < numItems) {
+        return 0;  // too large items
     }
+    slots[0].header.timeStamp = timeStamp;
+    slots[0].header.itemCount = (uint16_t)numItems;
+    TelemetryItemCache_PutFrameTime(&slots[1],
+        TelemetryItems_GetCaptureTime(items));
+    for (uint32_t i = 0; i < numItems; ++i) {
+        (void)TelemetryItems_ConvToCacheElemAt(
+            items, (int)i, &slots[CACHE_HEADER_SLOTS + i].elem, NULL);
+    }
+
+    return (numItems + CACHE_HEADER_SLOTS) * (uint32_t)sizeof(TelemetryCacheSlot);
+}
 
-    while (! TelemetryItemCache_IsEmpty(me)) {
-        cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-        if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
-            break;
+bool
+TelemetryItemCache_EnqueueFrames(TelemetryItemCache* me,
+    const void* frames, uint32_t len)
+{
+    // Put frames written by TelemetryItemCache_WriteFrame() into the cache.
+    // The plain ring buffer takes them with memcpy and no conversion.
+    const TelemetryCacheSlot*	curs = (const TelemetryCacheSlot*)frames;
+    const TelemetryCacheSlot*	end = curs + len / sizeof(TelemetryCacheSlot);
+    bool	isOK = true;
+
+    while (curs < end) {
+        uint32_t	frameSlots = curs->header.itemCount + CACHE_HEADER_SLOTS;
+
+        if ((uint32_t)(end - curs) < frameSlots) {
+            return false;  // broken frame
         }
-        TelemetryItems_AddFromCacheElem(outItems, cacheElem);
-        if (++(me->mReadPos) > me->mIndexMax) {
-            me->mReadPos = 0;
+        if (NULL == me->mStore && ! TelemetryItemCache_IsCompressed(me)) {
+            isOK = TelemetryItemCache_EnqueueRawFrame(me, curs) && isOK;
+        } else {
+            isOK = TelemetryItemCache_EnqueueFrameItems(me, curs) && isOK;
         }
+        curs += frameSlots;
     }
 
-    return true;
+    return isOK;
 }
@@ -32,27 +32,73 @@
 #include <stdint.h>
 #endif
 
+#ifndef _TELEMETRYITEMS_H_
+#include "TelemetryItems.h"
+#endif
+
+typedef struct TelemetryCacheStore	TelemetryCacheStore;
 typedef struct TelemetryItemCache	TelemetryItemCache;
-typedef struct TelemetryItems	TelemetryItems;
 
-// telemetry item data for caching
-typedef struct TelemetryCacheElem {
-    const char* itemName;
+// telemetry item data for caching (6 bytes)
+typedef struct __attribute__((__packed__, __aligned__(2))) TelemetryCacheElem {
+    TelemetryNameId	nameId;
     union {
         uint32_t    ul;
         float       f;
     }	value;
 } TelemetryCacheElem;
 
+// what to evict first when the cache is full
+typedef enum {
+    TelemetryCacheEviction_DropOldest = 0,  // the oldest frames
+    TelemetryCacheEviction_Decimate,        // every 2nd of the older frames
+} TelemetryCacheEviction;
+
 // Initialization and cleanup
 extern TelemetryItemCache* TelemetryItemCache_New(void);
 extern bool TelemetryItemCache_Init(TelemetryItemCache* me,
     unsigned char* cacheBuf, uint32_t bufSize);
+extern void	TelemetryItemCache_AttachStore(TelemetryItemCache* me,
+    TelemetryCacheStore* store);
+extern bool	TelemetryItemCache_EnableCompression(TelemetryItemCache* me,
+    bool enable);
 extern void	TelemetryItemCache_Destroy(TelemetryItemCache* me);
+//
+// NOTE: When a store is attached, frames are kept in the store instead of
+//       the ring buffer.  The store is not destroyed with the cache.
+//       When compression is enabled, frames in the ring buffer are encoded
+//       by TelemetryFrameCodec.  Changing it discards the cached frames.
+
+// Eviction policy
+extern bool	TelemetryItemCache_SetEviction(TelemetryItemCache* me,
+    TelemetryCacheEviction eviction);
+extern bool	TelemetryItemCache_SetItemPolicy(TelemetryItemCache* me,
+    TelemetryNameId nameId, uint8_t priority, uint32_t ttlSec);
+extern void	TelemetryItemCache_ClearItemPolicies(TelemetryItemCache* me);
+//
+// NOTE: When a frame doesn't fit, the cached frames are rewritten in place
+//       to make room, by the following steps in order until it fits;
+//         1. remove the items older than their TTL (ttlSec, 0: no TTL)
+//         2. with _Decimate, thin the frames of the older half to twice,
+//            4 times, ... the shortest interval until 1/8 of the buffer is
+//            free, except the frames holding an item of the highest
+//            priority; repeated on each fill, the frames kept spread over
+//            the whole time cached
+//         3. remove the items of priority 0, 1, ... from the older half,
+//            up to the class below the highest configured one
+//       and then the oldest frames are discarded as before.  Expired items
+//       are also removed on dequeue; "now" is the newest enqueued frame.
+//       With a store attached, only the TTL is applied, as the store is
+//       a log which discards its oldest segment when full;
+//       TelemetryItemCache_SetEviction() refuses _Decimate and
+//       TelemetryItemCache_SetItemPolicy() refuses a priority (returns
+//       false) then.
+//       Items have priority 0 and no TTL unless set.
 
 // Attribute
 extern uint32_t	TelemetryItemCache_CountAvailItems(
     const TelemetryItemCache* me);
+extern uint32_t	TelemetryItemCache_CountFrames(const TelemetryItemCache* me);
 extern bool	TelemetryItemCache_IsEmpty(const TelemetryItemCache* me);
 
 // Add and remove chace elem
@@ -61,4 +107,15 @@ extern bool	TelemetryItemCache_EnqueueItems(TelemetryItemCache* me,
 extern bool	TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
     TelemetryItems* outItems, uint32_t* outTimeStamp);
 
+// Binary frame of telemetry data items
+extern uint32_t	TelemetryItemCache_FrameSize(const TelemetryItems* items);
+extern uint32_t	TelemetryItemCache_WriteFrame(const TelemetryItems* items,
+    uint32_t timeStamp, void* outBuf);
+extern bool	TelemetryItemCache_EnqueueFrames(TelemetryItemCache* me,
+    const void* frames, uint32_t len);
+//
+// NOTE: A frame holds a snapshot in the same layout as the ring buffer,
+//       so it is put back into the cache without parsing.  Frames are
+//       valid only in the running process, as they hold name IDs.
+
 #endif  // _TELEMETRY_ITEM_CACHE_H_
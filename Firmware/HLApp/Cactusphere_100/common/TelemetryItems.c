@@ -23,8 +23,12 @@
  */
 
 #include <errno.h>
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <applibs/log.h>
 
@@ -34,44 +38,172 @@
 
 #include "TelemetryItems.h"
 #include "TelemetryItemCache.h"
-#include "StringBuf.h"
 
-// string representation of telemetry data item
+// telemetry data item with typed value
 typedef struct TelemetryItem {
-    const char* name;
-    char* value;
+    TelemetryNameId	nameId;
+    TelemetryValueType	type;
+    union {
+        uint32_t	ul;
+        int32_t 	l;
+        float   	f;
+        bool    	b;
+    }	value;
 } TelemetryItem;
 
 // TelemetryItems class's data members
 struct TelemetryItems {
     vector     mBody; // vector of telemetry data item
-    StringBuf* mSb;   // for string processing
+    int 	mNumMarks;	// number of marks in mBody
+    uint64_t	mBaseTimeMs;	// capture time of the first value (0: none)
+    uint64_t	mMarkTimeMs;	// capture time of the last value
+    uint64_t	mPendingTimeMs;	// time to mark on the next value (0: none)
+
+    // JSON skeleton which is compiled for the current set of item names
+    TelemetryNameId*	mTmplNameIds;	// item names of the skeleton
+    uint32_t*	mTmplKeyEnds;	// end offset of each key in mTmplKeys
+    char*   	mTmplKeys;	// rendered keys; {"name1": ,"name2": ...
+    uint32_t	mTmplKeysSize;	// size of mTmplKeys
+    uint32_t	mTmplCount;	// number of items of the skeleton
+    uint32_t	mTmplCapacity;	// capacity of mTmplNameIds and mTmplKeyEnds
+    char*   	mJsonBuf;	// output buffer
+    uint32_t	mJsonBufSize;	// size of mJsonBuf
 };
 
+#define JSON_VALUE_MAX_LEN	48	// longest value text; "%f" of -FLT_MAX
+#define JSON_FLOAT_MAX_F	1e39	// "%f" of a larger double is longer
+#define CAPTURE_OFFSET_HEAD	",\"captureOffsetMs\":"
+#define CAPTURE_NAME	"$capture"
+#define FLOAT_LO_NAME	"$floatLo"
+
 // telemetry item data type dictionary element
 typedef struct TelemetryItemDictElem {
-    const char* itemName;	// telemetry item name
-    bool        isFloat;	// whether value type is float
+    const char* itemName;	// telemetry item name (owned)
+    TelemetryValueType	type;	// value type
 } TelemetryItemDictElem;
 
-// telemetry item data type dictionary
-static dictionary	sTelemetryItemDict = NULL;
+// telemetry item data type dictionary; indexed by TelemetryNameId
+static vector	sTelemetryItemDict = NULL;
+// name to TelemetryNameId index of the dictionary
+static dictionary	sTelemetryNameIndex = NULL;
 
-// comparator function for the dictionary
+// comparator function for the name index
 static int
 TelemetryItemDictComparator(const void* const one, const void* const two)
 {
     return strcmp(*((char**)one), *((char**)two));
 }
 
+// hash function for the name index
+static uint32_t
+TelemetryItemDictHash(const void* const key)
+{
+    return dictionary_hash_string(*((char**)key));
+}
+
+static char*	TelemetryItems_PutFloat(char* dst, double val, bool isDouble);
+
+static inline const TelemetryItemDictElem*
+TelemetryItems_DictElemAt(TelemetryNameId nameId)
+{
+    if (NULL == sTelemetryItemDict
+    || (int)nameId >= vector_size(sTelemetryItemDict)) {
+        return NULL;
+    }
+
+    return (const TelemetryItemDictElem*)vector_get_data(sTelemetryItemDict)
+        + nameId;
+}
+
+static void
+TelemetryItems_PutItem(TelemetryItems* me, TelemetryNameId nameId,
+    TelemetryValueType type, uint32_t rawValue)
+{
+    TelemetryItem	telemetryItem;
+
+    telemetryItem.nameId   = nameId;
+    telemetryItem.type     = type;
+    telemetryItem.value.ul = rawValue;
+    if (0 == vector_add_last(me->mBody, &telemetryItem)
+    && TelemetryItems_IsMark(nameId)) {
+        ++me->mNumMarks;
+    }
+}
+
+static int32_t
+TelemetryItems_CaptureOffset(uint64_t timeMs, uint64_t baseMs)
+{
+    // offset from the base, saturated to a mark value
+    int64_t	offsetMs = (int64_t)(timeMs - baseMs);
+
+    if (INT32_MAX < offsetMs) {
+        return INT32_MAX;
+    } else if (INT32_MIN > offsetMs) {
+        return INT32_MIN;
+    }
+
+    return (int32_t)offsetMs;
+}
+
+static void
+TelemetryItems_PutCaptureMark(TelemetryItems* me)
+{
+    // mark the pending capture time in front of the next value; the time
+    // of the first value is the base, which takes no mark
+    uint64_t	timeMs = me->mPendingTimeMs;
+    int32_t	offsetMs;
+
+    me->mPendingTimeMs = 0;
+    if (0 == me->mBaseTimeMs) {
+        me->mBaseTimeMs = me->mMarkTimeMs = timeMs;
+        return;
+    }
+    if (timeMs == me->mMarkTimeMs) {
+        return;  // same as the previous value
+    }
+    offsetMs = TelemetryItems_CaptureOffset(timeMs, me->mBaseTimeMs);
+    TelemetryItems_PutItem(me, TELEMETRY_NAME_ID_CAPTURE,
+        TelemetryValueType_Int32, (uint32_t)offsetMs);
+    me->mMarkTimeMs = me->mBaseTimeMs + (uint64_t)(int64_t)offsetMs;
+}
+
+static void
+TelemetryItems_AddItem(TelemetryItems* me, TelemetryNameId nameId,
+    TelemetryValueType type, uint32_t rawValue)
+{
+    if (NULL == TelemetryItems_DictElemAt(nameId)) {
+        return;  // unknown name
+    }
+    if (TelemetryItems_IsCaptureMark(nameId)) {
+        // restored mark
+        me->mMarkTimeMs = me->mBaseTimeMs + (uint64_t)(int64_t)(int32_t)rawValue;
+    } else if (0 != me->mPendingTimeMs
+    && TELEMETRY_NAME_ID_FLOAT_LO != nameId) {
+        TelemetryItems_PutCaptureMark(me);
+    }
+    TelemetryItems_PutItem(me, nameId, type, rawValue);
+}
+
+static inline uint64_t
+TelemetryItems_MarkTime(const TelemetryItems* me, const TelemetryItem* item)
+{
+    // capture time of the values which follow a mark
+    return me->mBaseTimeMs + (uint64_t)(int64_t)item->value.l;
+}
+
 // Initialization and cleanup of the telemetry item data type dicitionary
 void
 TelemetryItems_InitDictionary(void)
 {
     if (NULL == sTelemetryItemDict) {
-        sTelemetryItemDict = dictionary_init(
-            sizeof(char*), sizeof(TelemetryItemDictElem),
-            TelemetryItemDictComparator);
+        sTelemetryItemDict = vector_init(sizeof(TelemetryItemDictElem));
+        sTelemetryNameIndex = dictionary_init_hash(
+            sizeof(char*), sizeof(TelemetryNameId),
+            TelemetryItemDictHash, TelemetryItemDictComparator);
+        (void)TelemetryItems_AddDictionaryElemOfType(
+            CAPTURE_NAME, TelemetryValueType_Int32);
+        (void)TelemetryItems_AddDictionaryElemOfType(
+            FLOAT_LO_NAME, TelemetryValueType_UInt32);
     }
 }
 
@@ -79,26 +211,111 @@ void
 TelemetryItems_CleanupDictionary(void)
 {
     if (NULL != sTelemetryItemDict) {
-        dictionary_destroy(sTelemetryItemDict);
-        sTelemetryItemDict = NULL;
+        TelemetryItemDictElem*	curs =
+            (TelemetryItemDictElem*)vector_get_data(sTelemetryItemDict);
+
+        for (int i = 0, n = vector_size(sTelemetryItemDict); i < n; ++i) {
+            free((char*)curs[i].itemName);
+        }
+        vector_destroy(sTelemetryItemDict);
+        dictionary_destroy(sTelemetryNameIndex);
+        sTelemetryItemDict  = NULL;
+        sTelemetryNameIndex = NULL;
     }
 }
 
 // Add and remove telemetry item data type
-void
+TelemetryNameId
 TelemetryItems_AddDictionaryElem(const char* itemName, bool isFloat)
 {
-    TelemetryItemDictElem	pseudo;
+    return TelemetryItems_AddDictionaryElemOfType(itemName,
+        (isFloat ? TelemetryValueType_Float : TelemetryValueType_UInt32));
+}
+
+TelemetryNameId
+TelemetryItems_AddDictionaryElemOfType(
+    const char* itemName, TelemetryValueType type)
+{
+    TelemetryNameId	nameId = TelemetryItems_FindNameId(itemName);
+    TelemetryItemDictElem	newElem;
+
+    if (TELEMETRY_NAME_ID_INVALID != nameId) {
+        // already interned; just update the data type
+        ((TelemetryItemDictElem*)vector_get_data(sTelemetryItemDict))[nameId]
+            .type = type;
+        return nameId;
+    }
+    if (TELEMETRY_NAME_ID_INVALID <= vector_size(sTelemetryItemDict)) {
+        Log_Debug("ERROR: too many telemetry item names\n");
+        return TELEMETRY_NAME_ID_INVALID;
+    }
+
+    newElem.itemName = strdup(itemName);
+    newElem.type     = type;
+    if (NULL == newElem.itemName) {
+        return TELEMETRY_NAME_ID_INVALID;
+    }
+    nameId = (TelemetryNameId)vector_size(sTelemetryItemDict);
+    if (0 != vector_add_last(sTelemetryItemDict, &newElem)) {
+        free((char*)newElem.itemName);
+        return TELEMETRY_NAME_ID_INVALID;
+    }
+    if (0 != dictionary_put(sTelemetryNameIndex, &newElem.itemName, &nameId)) {
+        // the element is left unreachable by name, and released on cleanup
+        return TELEMETRY_NAME_ID_INVALID;
+    }
 
-    pseudo.itemName = itemName;
-    pseudo.isFloat  = isFloat;
-    dictionary_put(sTelemetryItemDict, &itemName, &pseudo);
+    return nameId;
 }
 
 void
 TelemetryItems_RemoveDictionaryElem(const char* itemName)
 {
-    dictionary_remove(sTelemetryItemDict, &itemName);
+    // Keep the interned name so that the cached items which refer to
+    // it remain valid
+    (void)itemName;
+}
+
+// Search the dictionary
+TelemetryNameId
+TelemetryItems_FindNameId(const char* itemName)
+{
+    TelemetryNameId	nameId;
+
+    if (NULL == sTelemetryNameIndex
+    || ! dictionary_get(&nameId, sTelemetryNameIndex, &itemName)) {
+        return TELEMETRY_NAME_ID_INVALID;
+    }
+
+    return nameId;
+}
+
+const char*
+TelemetryItems_GetName(TelemetryNameId nameId)
+{
+    const TelemetryItemDictElem*	dictElem = TelemetryItems_DictElemAt(nameId);
+
+    return (NULL != dictElem ? dictElem->itemName : NULL);
+}
+
+TelemetryValueType
+TelemetryItems_GetValueType(TelemetryNameId nameId)
+{
+    const TelemetryItemDictElem*	dictElem = TelemetryItems_DictElemAt(nameId);
+
+    return (NULL != dictElem ? dictElem->type : TelemetryValueType_UInt32);
+}
+
+bool
+TelemetryItems_IsCaptureMark(TelemetryNameId nameId)
+{
+    return (TELEMETRY_NAME_ID_CAPTURE == nameId);
+}
+
+bool
+TelemetryItems_IsMark(TelemetryNameId nameId)
+{
+    return (TELEMETRY_NAME_ID_FLOAT_LO >= nameId);
 }
 
 // Initialization and cleanup
@@ -109,17 +326,22 @@ TelemetryItems_New(void)
 
     if (newObj != NULL) {
         newObj->mBody = vector_init(sizeof(TelemetryItem));
-        newObj->mSb   = StringBuf_New();
-        if (newObj->mBody == NULL || newObj->mSb == NULL) {
-            if (newObj->mBody != NULL) {
-                vector_destroy(newObj->mBody);
-            }
-            if (newObj->mSb != NULL) {
-                StringBuf_Destroy(newObj->mSb);
-            }
+        if (newObj->mBody == NULL) {
             free(newObj);
-            newObj = NULL;
+            return NULL;
         }
+        newObj->mNumMarks      = 0;
+        newObj->mBaseTimeMs    = 0;
+        newObj->mMarkTimeMs    = 0;
+        newObj->mPendingTimeMs = 0;
+        newObj->mTmplNameIds  = NULL;
+        newObj->mTmplKeyEnds  = NULL;
+        newObj->mTmplKeys     = NULL;
+        newObj->mTmplKeysSize = 0;
+        newObj->mTmplCount    = 0;
+        newObj->mTmplCapacity = 0;
+        newObj->mJsonBuf      = NULL;
+        newObj->mJsonBufSize  = 0;
     }
 
     return newObj;
@@ -129,13 +351,21 @@ void
 TelemetryItems_Destroy(TelemetryItems* me)
 {
     if (me != NULL) {
-        TelemetryItems_Clear(me);
         vector_destroy(me->mBody);
-        StringBuf_Destroy(me->mSb);
+        free(me->mTmplNameIds);
+        free(me->mTmplKeyEnds);
+        free(me->mTmplKeys);
+        free(me->mJsonBuf);
         free(me);
     }
 }
 
+bool
+TelemetryItems_Reserve(TelemetryItems* me, int numItems)
+{
+    return (0 == vector_reserve(me->mBody, numItems));
+}
+
 // Attribute
 int
 TelemetryItems_Count(const TelemetryItems* me)
@@ -143,47 +373,272 @@ TelemetryItems_Count(const TelemetryItems* me)
     return vector_size(me->mBody);
 }
 
+int
+TelemetryItems_CountValues(const TelemetryItems* me)
+{
+    return vector_size(me->mBody) - me->mNumMarks;
+}
+
+int
+TelemetryItems_GetCapacity(const TelemetryItems* me)
+{
+    return vector_capacity(me->mBody);
+}
+
+// Capture time
+uint64_t
+TelemetryItems_GetTimeMs(void)
+{
+    struct timespec	now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+void
+TelemetryItems_SetCaptureTime(TelemetryItems* me, uint64_t timeMs)
+{
+    me->mPendingTimeMs = timeMs;
+}
+
+uint64_t
+TelemetryItems_GetCaptureTime(const TelemetryItems* me)
+{
+    return me->mBaseTimeMs;
+}
+
+void
+TelemetryItems_SetCaptureBase(TelemetryItems* me, uint64_t timeMs)
+{
+    me->mBaseTimeMs = me->mMarkTimeMs = timeMs;
+}
+
 // Add and remove telemetry data item
 void
-TelemetryItems_Add(TelemetryItems* me, const char* name, const char* value)
+TelemetryItems_AddUInt32(TelemetryItems* me, TelemetryNameId nameId, uint32_t value)
+{
+    TelemetryItems_AddItem(me, nameId, TelemetryValueType_UInt32, value);
+}
+
+void
+TelemetryItems_AddInt32(TelemetryItems* me, TelemetryNameId nameId, int32_t value)
+{
+    TelemetryItems_AddItem(me, nameId, TelemetryValueType_Int32, (uint32_t)value);
+}
+
+static bool
+TelemetryItems_IsSameFloatText(float fValue, double value)
+{
+    // Whether the float is put in the same text as the double.  The float
+    // times 10^6 is exact, and so is its rounding as in _PutFloat(); the
+    // double times 10^6 is off by half an ulp at most, which decides the
+    // digits unless it is at a tie.  Otherwise compare the texts.
+    double	scaled  = fabs(value) * 1000000.0;
+    double	fScaled = fabs((double)fValue) * 1000000.0;
+    char	fText[JSON_VALUE_MAX_LEN + 1];
+    char	dText[JSON_VALUE_MAX_LEN + 1];
+    char*	fEnd;
+    char*	dEnd;
+
+    if (scaled < 1e15 && fScaled < 1e15) {
+        double	digits = floor(fScaled);
+        double	frac   = fScaled - digits;
+        double	margin = scaled * DBL_EPSILON;
+
+        if (0.5 < frac || (0.5 == frac && 0 != fmod(digits, 2.0))) {
+            digits += 1.0;
+        }
+        if (fabs(scaled - digits) < 0.5 - margin) {
+            return true;
+        } else if (fabs(scaled - digits) > 0.5 + margin) {
+            return false;
+        }
+    }
+    fEnd = TelemetryItems_PutFloat(fText, (double)fValue, false);
+    dEnd = TelemetryItems_PutFloat(dText, value, true);
+
+    return (fEnd - fText == dEnd - dText
+        && 0 == memcmp(fText, dText, (size_t)(fEnd - fText)));
+}
+
+void
+TelemetryItems_AddFloat(TelemetryItems* me, TelemetryNameId nameId, double value)
 {
-    TelemetryItem telemetryItem;
-    char* newValue = strdup(value);
+    float	fValue = (float)value;
+    uint32_t	rawValue;
+    uint64_t	rawDouble;
+
+    if ((double)fValue == value || isnan(value)
+    || TelemetryItems_IsSameFloatText(fValue, value)) {
+        memcpy(&rawValue, &fValue, sizeof(rawValue));
+        TelemetryItems_AddItem(me, nameId, TelemetryValueType_Float, rawValue);
+        return;
+    }
 
-    telemetryItem.name  = name;
-    telemetryItem.value = newValue;
-    vector_add_last(me->mBody, &telemetryItem);
+    // the float would print otherwise; the upper half followed by FLOAT_LO
+    memcpy(&rawDouble, &value, sizeof(rawDouble));
+    if (NULL == TelemetryItems_DictElemAt(nameId)) {
+        return;  // unknown name
+    }
+    TelemetryItems_AddItem(me, nameId, TelemetryValueType_Float,
+        (uint32_t)(rawDouble >> 32));
+    TelemetryItems_PutItem(me, TELEMETRY_NAME_ID_FLOAT_LO,
+        TelemetryValueType_UInt32, (uint32_t)rawDouble);
+}
+
+void
+TelemetryItems_AddBool(TelemetryItems* me, TelemetryNameId nameId, bool value)
+{
+    TelemetryItems_AddItem(me, nameId, TelemetryValueType_Bool, value ? 1 : 0);
+}
+
+void
+TelemetryItems_AddItems(TelemetryItems* me, const TelemetryItems* items)
+{
+    // the marks of items are against its own base, so they are put again
+    // against the base of self
+    const TelemetryItem*	item = (const TelemetryItem*)vector_get_data(items->mBody);
+    uint64_t	pendingMs = me->mPendingTimeMs;
+
+    if (0 != items->mBaseTimeMs) {
+        me->mPendingTimeMs = items->mBaseTimeMs;
+    }
+    for (int i = 0, n = vector_size(items->mBody); i < n; ++i, ++item) {
+        if (TelemetryItems_IsCaptureMark(item->nameId)) {
+            me->mPendingTimeMs = TelemetryItems_MarkTime(items, item);
+        } else if (TELEMETRY_NAME_ID_FLOAT_LO == item->nameId) {
+            TelemetryItems_PutItem(me, item->nameId, item->type, item->value.ul);
+        } else {
+            TelemetryItems_AddItem(me, item->nameId, item->type, item->value.ul);
+        }
+    }
+    me->mPendingTimeMs = pendingMs;
 }
 
 void
 TelemetryItems_Clear(TelemetryItems* me) {
-    TelemetryItem* tempP = (TelemetryItem*)vector_get_data(me->mBody);
+    vector_remove_all(me->mBody);
+    me->mNumMarks      = 0;
+    me->mBaseTimeMs    = 0;
+    me->mMarkTimeMs    = 0;
+    me->mPendingTimeMs = 0;
+}
+
+static bool
+TelemetryItem_HasFloatLo(const TelemetryItem* item, const TelemetryItem* end)
+{
+    return (item + 1 < end && TELEMETRY_NAME_ID_FLOAT_LO == item[1].nameId);
+}
+
+static double
+TelemetryItem_FloatValue(const TelemetryItem* item, const TelemetryItem* end)
+{
+    // a float, or a double of the item and its FLOAT_LO
+    uint64_t	rawDouble;
+    double	value;
 
-    for (int i = 0, n = vector_size(me->mBody); i < n; i++) {
-        free(tempP[i].value);
+    if (! TelemetryItem_HasFloatLo(item, end)) {
+        return item->value.f;
     }
-    vector_clear(me->mBody);
+    rawDouble = ((uint64_t)item->value.ul << 32) | item[1].value.ul;
+    memcpy(&value, &rawDouble, sizeof(value));
+
+    return value;
 }
 
-// Mutual conversion between cache elem
-TelemetryCacheElem*
-TelemetryItems_ConvToCacheElemAt(
-    const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem)
+static double
+TelemetryItem_ToDouble(const TelemetryItem* item, const TelemetryItem* end)
 {
-    // Search telemetry item data type dictionary and convert from 
-    // string to number according to data type
-    TelemetryItem*	item = (TelemetryItem*)vector_get_data(me->mBody) + index;
-    TelemetryItemDictElem	dictElem;
+    switch (item->type) {
+    case TelemetryValueType_Int32:
+        return item->value.l;
+    case TelemetryValueType_Float:
+        return TelemetryItem_FloatValue(item, end);
+    case TelemetryValueType_Bool:
+        return item->value.b ? 1.0 : 0.0;
+    default:
+        return item->value.ul;
+    }
+}
 
-    if (! dictionary_get(&dictElem, sTelemetryItemDict, &item->name)) {
-        return NULL;
+void
+TelemetryItems_Retain(TelemetryItems* me, TelemetryItemPredicate pred,
+    void* arg)
+{
+    // Compact the selected items to the front, then drop the tail.
+    // The capture marks are put again in front of the kept values whose
+    // time differs from the previous kept value's, against the time of the
+    // first kept value as the new base; as such a value had a mark before,
+    // the items are never written ahead of the reading.  A FLOAT_LO follows
+    // the value which it belongs to.
+    TelemetryItem*	items = (TelemetryItem*)vector_get_data(me->mBody);
+    int	n = vector_size(me->mBody);
+    int	numKept = 0;
+    uint64_t	timeMs = me->mBaseTimeMs;	// capture time of items[i]
+    uint64_t	baseMs = 0;	// capture time of the first kept value
+    uint64_t	lastMs = 0;	// capture time of the last kept value
+    bool	isLastKept = false;
+
+    for (int i = 0; i < n; ++i) {
+        TelemetryNameId	nameId = items[i].nameId;
+
+        if (TELEMETRY_NAME_ID_FLOAT_LO == nameId) {
+            if (! isLastKept) {
+                continue;
+            }
+        } else if (TelemetryItems_IsCaptureMark(nameId)) {
+            timeMs = TelemetryItems_MarkTime(me, &items[i]);
+            continue;
+        } else if (pred(arg, nameId,
+                TelemetryItem_ToDouble(&items[i], items + n))) {
+            isLastKept = true;
+            if (0 == numKept) {
+                baseMs = lastMs = timeMs;
+            } else if (timeMs != lastMs) {
+                items[numKept].nameId   = TELEMETRY_NAME_ID_CAPTURE;
+                items[numKept].type     = TelemetryValueType_Int32;
+                items[numKept].value.l  =
+                    TelemetryItems_CaptureOffset(timeMs, baseMs);
+                ++numKept;
+                lastMs = timeMs;
+            }
+        } else {
+            isLastKept = false;
+            continue;
+        }
+        if (numKept != i) {
+            items[numKept] = items[i];
+        }
+        ++numKept;
     }
+    me->mNumMarks = 0;
+    for (int i = 0; i < numKept; ++i) {
+        if (TelemetryItems_IsMark(items[i].nameId)) {
+            ++me->mNumMarks;
+        }
+    }
+    me->mBaseTimeMs = baseMs;
+    me->mMarkTimeMs = lastMs;
+    while (numKept < n--) {
+        vector_remove_last(me->mBody);
+    }
+}
 
-    outCacheElem->itemName = item->name;
-    if (dictElem.isFloat) {
-        outCacheElem->value.f = (float)atof(item->value);
-    } else {
-        outCacheElem->value.ul = strtoul(item->value, NULL, 10);
+// Mutual conversion between cache elem
+TelemetryCacheElem*
+TelemetryItems_ConvToCacheElemAt(
+    const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem,
+    TelemetryValueType* outType)
+{
+    // values are kept in binary, so just copy them
+    const TelemetryItem*	item =
+        (const TelemetryItem*)vector_get_data(me->mBody) + index;
+
+    outCacheElem->nameId   = item->nameId;
+    outCacheElem->value.ul = item->value.ul;
+    if (NULL != outType) {
+        *outType = item->type;
     }
 
     return outCacheElem;
@@ -193,41 +648,304 @@ void
 TelemetryItems_AddFromCacheElem(TelemetryItems* me,
     const TelemetryCacheElem* cacheElem)
 {
-    // Search telemetry item data type dictionary and convert from 
-    // number to string according to data type, then add to self
-    TelemetryItemDictElem	dictElem;
+    // Add the value with the data type of the interned name to self
+    const TelemetryItemDictElem*	dictElem =
+        TelemetryItems_DictElemAt(cacheElem->nameId);
 
-    if (! dictionary_get(&dictElem, sTelemetryItemDict,
-            &((TelemetryCacheElem*)cacheElem)->itemName)) {
+    if (NULL == dictElem) {
         return;  // not found; error
     }
 
-    StringBuf_Clear(me->mSb);
-    if (dictElem.isFloat) {
-        StringBuf_AppendByPrintf(me->mSb, "%f", cacheElem->value.f);
-    } else {
-        StringBuf_AppendByPrintf(me->mSb, "%lu", cacheElem->value.ul);
-    }
-    TelemetryItems_Add(me, cacheElem->itemName, StringBuf_GetStr(me->mSb));
+    TelemetryItems_AddItem(me,
+        cacheElem->nameId, dictElem->type, cacheElem->value.ul);
 }
 
 // Convert to JSON text
+static uint32_t
+TelemetryItems_JsonKeyLen(const char* name)
+{
+    // '{' or ',', and the quoted name followed by ':'
+    uint32_t	len = 4;
+
+    for (; '\0' != *name; ++name) {
+        len += ('"' == *name || '\\' == *name ? 2 : 1);
+    }
+
+    return len;
+}
+
+static bool
+TelemetryItems_IsJsonCompiled(const TelemetryItems* me)
+{
+    const TelemetryItem*	item = (const TelemetryItem*)vector_get_data(me->mBody);
+    uint32_t	n = (uint32_t)vector_size(me->mBody);
+    uint32_t	numValues = 0;
+
+    if ((uint32_t)TelemetryItems_CountValues(me) != me->mTmplCount
+    || NULL == me->mJsonBuf) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (TelemetryItems_IsMark(item[i].nameId)) {
+            continue;
+        }
+        if (item[i].nameId != me->mTmplNameIds[numValues++]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+TelemetryItems_CompileJson(TelemetryItems* me)
+{
+    // Render the keys of the current item names once, and allocate the
+    // output buffer which is large enough for any values and their
+    // capture time offsets.
+    const TelemetryItem*	item = (const TelemetryItem*)vector_get_data(me->mBody);
+    uint32_t	numItems = (uint32_t)vector_size(me->mBody);
+    uint32_t	n = (uint32_t)TelemetryItems_CountValues(me);
+    uint32_t	keysLen = 0;
+    uint32_t	bufSize;
+    char*	dst;
+
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if (! TelemetryItems_IsMark(item[i].nameId)) {
+            keysLen += TelemetryItems_JsonKeyLen(
+                TelemetryItems_GetName(item[i].nameId));
+        }
+    }
+    bufSize = (keysLen + n * JSON_VALUE_MAX_LEN) * 2
+        + sizeof(CAPTURE_OFFSET_HEAD) + sizeof("{}}");
+
+    if (n > me->mTmplCapacity) {
+        TelemetryNameId*	newIds =
+            realloc(me->mTmplNameIds, n * sizeof(TelemetryNameId));
+        uint32_t*	newEnds;
+
+        if (NULL == newIds) {
+            return false;
+        }
+        me->mTmplNameIds = newIds;
+        newEnds = realloc(me->mTmplKeyEnds, n * sizeof(uint32_t));
+        if (NULL == newEnds) {
+            return false;
+        }
+        me->mTmplKeyEnds  = newEnds;
+        me->mTmplCapacity = n;
+    }
+    if (keysLen + 1 > me->mTmplKeysSize) {
+        char*	newKeys = realloc(me->mTmplKeys, keysLen + 1);
+
+        if (NULL == newKeys) {
+            return false;
+        }
+        me->mTmplKeys     = newKeys;
+        me->mTmplKeysSize = keysLen + 1;
+    }
+    dst = me->mTmplKeys;
+    if (bufSize > me->mJsonBufSize) {
+        char*	newBuf = realloc(me->mJsonBuf, bufSize);
+
+        if (NULL == newBuf) {
+            return false;
+        }
+        me->mJsonBuf     = newBuf;
+        me->mJsonBufSize = bufSize;
+    }
+
+    for (uint32_t i = 0; i < n; ++i, ++item) {
+        const char*	name;
+
+        while (TelemetryItems_IsMark(item->nameId)) {
+            ++item;
+        }
+        name = TelemetryItems_GetName(item->nameId);
+        *dst++ = (0 == i ? '{' : ',');
+        *dst++ = '"';
+        for (; '\0' != *name; ++name) {
+            if ('"' == *name || '\\' == *name) {
+                *dst++ = '\\';
+            }
+            *dst++ = *name;
+        }
+        *dst++ = '"';
+        *dst++ = ':';
+        me->mTmplNameIds[i] = item->nameId;
+        me->mTmplKeyEnds[i] = (uint32_t)(dst - me->mTmplKeys);
+    }
+    me->mTmplCount = n;
+
+    return true;
+}
+
+static char*
+TelemetryItems_PutUInt(char* dst, uint64_t val)
+{
+    char	digits[20];
+    int 	len = 0;
+
+    do {
+        digits[len++] = (char)('0' + val % 10);
+        val /= 10;
+    } while (0 != val);
+    while (0 < len) {
+        *dst++ = digits[--len];
+    }
+
+    return dst;
+}
+
+static char*
+TelemetryItems_PutFloat(char* dst, double val, bool isDouble)
+{
+    // Same as "%f".  A float times 10^6 is exact in double, so rounding
+    // it half to even gives the same digits as printf.  A double which is
+    // not exact in float is left to printf.
+    double	scaled = fabs(val) * 1000000.0;
+    uint64_t	intPart;
+    uint32_t	fracPart;
+    double	frac;
+
+    if (isDouble || ! (scaled < 1e15)) {
+        if (! (fabs(val) < JSON_FLOAT_MAX_F) && isfinite(val)) {
+            return dst + sprintf(dst, "%.17g", val);  // too long for "%f"
+        }
+        return dst + sprintf(dst, "%f", val);  // large, inf or nan
+    }
+    intPart = (uint64_t)scaled;
+    frac    = scaled - (double)intPart;
+    if (0.5 < frac || (0.5 == frac && 0 != (intPart & 1))) {
+        ++intPart;
+    }
+
+    if (signbit(val)) {
+        *dst++ = '-';
+    }
+    dst = TelemetryItems_PutUInt(dst, intPart / 1000000);
+    *dst++ = '.';
+    fracPart = (uint32_t)(intPart % 1000000);
+    for (int i = 5; 0 <= i; --i) {
+        dst[i] = (char)('0' + fracPart % 10);
+        fracPart /= 10;
+    }
+
+    return dst + 6;
+}
+
+static char*
+TelemetryItems_PutCaptureOffsets(const TelemetryItems* me, char* dst,
+    uint64_t baseMs)
+{
+    // append the offsets of the values which are not captured at baseMs;
+    // the keys are taken from the skeleton without its leading '{' or ','
+    const TelemetryItem*	item = (const TelemetryItem*)vector_get_data(me->mBody);
+    uint32_t	n = (uint32_t)vector_size(me->mBody);
+    uint32_t	keyStart = 0;
+    uint32_t	numValues = 0;
+    uint64_t	timeMs = baseMs;
+    char	sep = '{';
+
+    memcpy(dst, CAPTURE_OFFSET_HEAD, sizeof(CAPTURE_OFFSET_HEAD) - 1);
+    dst += sizeof(CAPTURE_OFFSET_HEAD) - 1;
+    for (uint32_t i = 0; i < n; ++i, ++item) {
+        uint32_t	keyEnd;
+
+        if (TELEMETRY_NAME_ID_FLOAT_LO == item->nameId) {
+            continue;
+        }
+        if (TelemetryItems_IsCaptureMark(item->nameId)) {
+            timeMs = TelemetryItems_MarkTime(me, item);
+            continue;
+        }
+        keyEnd = me->mTmplKeyEnds[numValues++];
+        if (timeMs != baseMs) {
+            *dst++ = sep;
+            sep    = ',';
+            memcpy(dst, me->mTmplKeys + keyStart + 1, keyEnd - keyStart - 1);
+            dst += keyEnd - keyStart - 1;
+            if (timeMs < baseMs) {
+                *dst++ = '-';
+                dst = TelemetryItems_PutUInt(dst, baseMs - timeMs);
+            } else {
+                dst = TelemetryItems_PutUInt(dst, timeMs - baseMs);
+            }
+        }
+        keyStart = keyEnd;
+    }
+    *dst++ = '}';
+
+    return dst;
+}
+
 const char*
 TelemetryItems_ToJson(TelemetryItems* me)
 {
-    StringBuf_Clear(me->mSb);
-    StringBuf_AppendChar(me->mSb, '{');
-    for (int i = 0, n = vector_size(me->mBody); i < n; i++) {
-        TelemetryItem tmp;
-        vector_get_at(&tmp, me->mBody, i);
-        StringBuf_AppendByPrintf(me->mSb, "\"%s\":%s", tmp.name, tmp.value);
-        if (n - 1 > i) {
-            StringBuf_AppendChar(me->mSb, ',');
+    const TelemetryItem*	item = (const TelemetryItem*)vector_get_data(me->mBody);
+    uint32_t	n = (uint32_t)vector_size(me->mBody);
+    const TelemetryItem*	end = item + n;
+    uint32_t	keyStart = 0;
+    uint32_t	numValues = 0;
+    bool	hasOffsets = false;
+    char*	dst;
+
+    if (! TelemetryItems_IsJsonCompiled(me)
+    && ! TelemetryItems_CompileJson(me)) {
+        return NULL;
+    }
+
+    dst = me->mJsonBuf;
+    if (0 == me->mTmplCount) {
+        *dst++ = '{';
+    }
+    for (uint32_t i = 0; i < n; ++i, ++item) {
+        uint32_t	keyEnd;
+
+        if (TELEMETRY_NAME_ID_FLOAT_LO == item->nameId) {
+            continue;
+        }
+        if (TelemetryItems_IsCaptureMark(item->nameId)) {
+            // a value captured at another time than the base follows
+            hasOffsets = hasOffsets
+                || TelemetryItems_MarkTime(me, item) != me->mBaseTimeMs;
+            continue;
+        }
+        keyEnd = me->mTmplKeyEnds[numValues++];
+        memcpy(dst, me->mTmplKeys + keyStart, keyEnd - keyStart);
+        dst += keyEnd - keyStart;
+        keyStart = keyEnd;
+
+        switch (item->type) {
+        case TelemetryValueType_UInt32:
+            dst = TelemetryItems_PutUInt(dst, item->value.ul);
+            break;
+        case TelemetryValueType_Int32:
+            if (0 > item->value.l) {
+                *dst++ = '-';
+            }
+            dst = TelemetryItems_PutUInt(dst,
+                (uint64_t)llabs((long long)item->value.l));
+            break;
+        case TelemetryValueType_Float:
+            dst = TelemetryItems_PutFloat(dst,
+                TelemetryItem_FloatValue(item, end),
+                TelemetryItem_HasFloatLo(item, end));
+            break;
+        case TelemetryValueType_Bool:
+            memcpy(dst, (item->value.b ? "true" : "false"),
+                (item->value.b ? 4 : 5));
+            dst += (item->value.b ? 4 : 5);
+            break;
         }
     }
-    StringBuf_AppendChar(me->mSb, '}');
+    if (hasOffsets) {
+        dst = TelemetryItems_PutCaptureOffsets(me, dst, me->mBaseTimeMs);
+    }
+    *dst++ = '}';
+    *dst   = '\0';
 
-    return StringBuf_GetStr(me->mSb);
+    return me->mJsonBuf;
 }
 
 // Convert from JSON text
@@ -235,42 +953,68 @@ bool
 TelemetryItems_LoadFromJson(TelemetryItems* me, const char* jsonStr)
 {
     json_value* jsonObj = json_parse(jsonStr, strlen(jsonStr));
+    bool	isOK;
 
     if (NULL == jsonObj) {
         return false;
-    } else if (json_object != jsonObj->type) {
-        json_value_free(jsonObj);
+    }
+    isOK = TelemetryItems_LoadFromJsonObject(me, jsonObj);
+    json_value_free(jsonObj);
+
+    return isOK;
+}
+
+bool
+TelemetryItems_LoadFromJsonObject(
+    TelemetryItems* me, const struct _json_value* jsonObj)
+{
+    const json_object_entry*	curs;
+    const json_object_entry*	end;
+
+    if (json_object != jsonObj->type) {
         return false;
-    } else {
-        json_object_entry*  curs = jsonObj->u.object.values;
-        json_object_entry*  end  = curs + jsonObj->u.object.length;
-        TelemetryItemDictElem   dictElem;
-
-        TelemetryItems_Clear(me);
-        for (; curs < end; ++curs) {
-            if (! dictionary_get(&dictElem, sTelemetryItemDict, &curs->name)) {
-                goto err;  // unkown item
-            }
+    }
 
-            StringBuf_Clear(me->mSb);
-            switch (curs->value->type) {
-            case json_integer:
-                StringBuf_AppendByPrintf(
-                    me->mSb, "%lu", (uint32_t)curs->value->u.integer);
-                break;
-            case json_double:
-                StringBuf_AppendByPrintf(
-                    me->mSb, "%f", (float)curs->value->u.dbl);
-                break;
-            default:
-                goto err;  // unexpected type
-            }
-            TelemetryItems_Add(me, dictElem.itemName, StringBuf_GetStr(me->mSb));
+    curs = jsonObj->u.object.values;
+    end  = curs + jsonObj->u.object.length;
+    TelemetryItems_Clear(me);
+    for (; curs < end; ++curs) {
+        const json_value*	value = curs->value;
+        TelemetryNameId	nameId = TelemetryItems_FindNameId(curs->name);
+        TelemetryValueType	type;
+
+        if (TELEMETRY_NAME_ID_INVALID == nameId) {
+            return false;  // unkown item
         }
 
-        return true;
-err:
-        json_value_free(jsonObj);
-        return false;
+        type = TelemetryItems_GetValueType(nameId);
+        switch (type) {
+        case TelemetryValueType_UInt32:
+        case TelemetryValueType_Int32:
+            if (json_integer != value->type) {
+                return false;  // unexpected type
+            }
+            TelemetryItems_AddItem(me, nameId,
+                type, (uint32_t)value->u.integer);
+            break;
+        case TelemetryValueType_Float:
+            if (json_double == value->type) {
+                TelemetryItems_AddFloat(me, nameId, value->u.dbl);
+            } else if (json_integer == value->type) {
+                TelemetryItems_AddFloat(me,
+                    nameId, (double)value->u.integer);
+            } else {
+                return false;  // unexpected type
+            }
+            break;
+        case TelemetryValueType_Bool:
+            if (json_boolean != value->type) {
+                return false;  // unexpected type
+            }
+            TelemetryItems_AddBool(me, nameId, value->u.boolean);
+            break;
+        }
     }
+
+    return true;
 }
@@ -28,42 +28,143 @@
 #ifndef _STDBOOL
 #include <stdbool.h>
 #endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
 
 typedef struct TelemetryItems	TelemetryItems;
 typedef struct TelemetryCacheElem	TelemetryCacheElem;
+struct _json_value;
+
+// telemetry item data value type
+typedef enum {
+    TelemetryValueType_UInt32 = 0,
+    TelemetryValueType_Int32,
+    TelemetryValueType_Float,
+    TelemetryValueType_Bool,
+} TelemetryValueType;
+
+// interned telemetry item name
+typedef uint16_t	TelemetryNameId;
+#define TELEMETRY_NAME_ID_INVALID	((TelemetryNameId)0xFFFF)
+
+// reserved item name of capture time marks; interned first by
+// TelemetryItems_InitDictionary()
+#define TELEMETRY_NAME_ID_CAPTURE	((TelemetryNameId)0)
+// reserved item name of the lower 32 bits of a double precision value
+#define TELEMETRY_NAME_ID_FLOAT_LO	((TelemetryNameId)1)
 
 // Initialization and cleanup of the telemetry item data type dicitionary
 extern void	TelemetryItems_InitDictionary(void);
 extern void	TelemetryItems_CleanupDictionary(void);
 
 // Add and remove telemetry item data type
-extern void	TelemetryItems_AddDictionaryElem(
+extern TelemetryNameId	TelemetryItems_AddDictionaryElem(
     const char* itemName, bool isFloat);
+extern TelemetryNameId	TelemetryItems_AddDictionaryElemOfType(
+    const char* itemName, TelemetryValueType type);
 extern void	TelemetryItems_RemoveDictionaryElem(const char* itemName);
+//
+// NOTE: Each item name is interned to a TelemetryNameId when it is added
+//       first, and the ID is kept until the dictionary is cleaned up.
+//       Removing an item doesn't release its ID, so the cached items
+//       remain valid across reconfiguration and an item which is added
+//       again gets the same ID.
+
+// Search the dictionary
+extern TelemetryNameId	TelemetryItems_FindNameId(const char* itemName);
+extern const char*	TelemetryItems_GetName(TelemetryNameId nameId);
+extern TelemetryValueType	TelemetryItems_GetValueType(TelemetryNameId nameId);
+extern bool	TelemetryItems_IsCaptureMark(TelemetryNameId nameId);
+extern bool	TelemetryItems_IsMark(TelemetryNameId nameId);
+//
+// NOTE: TelemetryItems_IsMark() is true for the capture time marks and the
+//       FLOAT_LO items, which are not values by themselves.
 
 // Initialization and cleanup
 extern TelemetryItems* TelemetryItems_New(void);
 extern void TelemetryItems_Destroy(TelemetryItems* me);
+extern bool	TelemetryItems_Reserve(TelemetryItems* me, int numItems);
+//
+// NOTE: TelemetryItems_Clear() keeps the capacity, so that adding up to
+//       the reserved or ever added number of items does not allocate memory.
 
 // Attribute
 extern int	TelemetryItems_Count(const TelemetryItems* me);
+extern int	TelemetryItems_CountValues(const TelemetryItems* me);
+extern int	TelemetryItems_GetCapacity(const TelemetryItems* me);
+//
+// NOTE: TelemetryItems_Count() includes the marks, which take a cache elem
+//       each, and TelemetryItems_CountValues() doesn't.
+
+// Capture time
+extern uint64_t	TelemetryItems_GetTimeMs(void);
+extern void	TelemetryItems_SetCaptureTime(TelemetryItems* me, uint64_t timeMs);
+extern uint64_t	TelemetryItems_GetCaptureTime(const TelemetryItems* me);
+extern void	TelemetryItems_SetCaptureBase(TelemetryItems* me, uint64_t timeMs);
+//
+// NOTE: The items added after TelemetryItems_SetCaptureTime() are stamped
+//       with the time [msec since the Epoch].  The time of the first value
+//       is the base, which TelemetryItems_GetCaptureTime() returns (0: not
+//       stamped) and the cache keeps in its frame header.  A value captured
+//       at another time is preceded by a CAPTURE mark holding the offset
+//       from the base [msec, int32], only when the time differs from the
+//       previous value's; so a frame stamped once has no mark, and the
+//       offsets are small numbers which the codec packs in a byte or two.
+//       Marks are put lazily on the next value, so a time which no value
+//       follows leaves no mark.
+//       TelemetryItems_SetCaptureBase() restores the base of a cleared
+//       object before its items are added from the cache.
 
 // Add and remove telemetry data item
-extern void TelemetryItems_Add(
-    TelemetryItems* me, const char* name, const char* value);
+extern void	TelemetryItems_AddUInt32(
+    TelemetryItems* me, TelemetryNameId nameId, uint32_t value);
+extern void	TelemetryItems_AddInt32(
+    TelemetryItems* me, TelemetryNameId nameId, int32_t value);
+extern void	TelemetryItems_AddFloat(
+    TelemetryItems* me, TelemetryNameId nameId, double value);
+extern void	TelemetryItems_AddBool(
+    TelemetryItems* me, TelemetryNameId nameId, bool value);
+extern void	TelemetryItems_AddItems(
+    TelemetryItems* me, const TelemetryItems* items);
 extern void TelemetryItems_Clear(TelemetryItems* me);
+//
+// NOTE: A float value takes one item as a float if it is put in the same
+//       "%f" text in single precision, as 23.4 or 0.1 is.  Otherwise (as
+//       123.45 or 16777217) the item holds the upper 32 bits of the
+//       double and a FLOAT_LO item with the lower 32 bits follows it, so
+//       the cache and its store and codec carry the value in full as two
+//       ordinary items, like the capture time marks.
+
+// predicate to select telemetry data items; the value is converted to double
+typedef bool	(*TelemetryItemPredicate)(
+    void* arg, TelemetryNameId nameId, double value);
+extern void	TelemetryItems_Retain(
+    TelemetryItems* me, TelemetryItemPredicate pred, void* arg);
+//
+// NOTE: TelemetryItems_Retain() removes the items which the predicate
+//       returns false for, in place and keeping the order of the rest.
+//       Capture time marks are not passed to the predicate; they are
+//       rewritten against the time of the first value left as the base.
 
 // Mutual conversion between cache elem
 extern TelemetryCacheElem* TelemetryItems_ConvToCacheElemAt(
-    const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem);
+    const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem,
+    TelemetryValueType* outType);
 extern void	TelemetryItems_AddFromCacheElem(TelemetryItems* me,
     const TelemetryCacheElem* cacheElem);
 
 // Convert to JSON text
 extern const char* TelemetryItems_ToJson(TelemetryItems* me);
+//
+// NOTE: When the values have different capture times, their offsets from
+//       TelemetryItems_GetCaptureTime() [msec] are appended as an object;
+//       {"name1":1,"name2":2,"captureOffsetMs":{"name2":350}}
 
 // Convert from JSON text
 extern bool TelemetryItems_LoadFromJson(
     TelemetryItems* me, const char* jsonStr);
+extern bool TelemetryItems_LoadFromJsonObject(
+    TelemetryItems* me, const struct _json_value* jsonObj);
 
 #endif  // _TELEMETRYITEMS_H_
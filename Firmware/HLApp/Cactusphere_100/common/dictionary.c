@@ -24,107 +24,344 @@
 
 #include "dictionary.h"
 
-#include "map.h"
+#include <errno.h>
+#include <string.h>
+
+// Open addressing hash table over the entries in insertion order.
+// Keys are in a vector, and values and hash values are in arrays parallel
+// to it; there is no allocation per entry.  A removed entry is only marked,
+// and the entries are compacted before the keys are referred or the table
+// is rebuilt.
+#define DICT_SLOT_EMPTY	(-1)
+#define DICT_SLOT_DELETED	(-2)
+#define DICT_MIN_SLOTS	8
+
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME	16777619u
+
+typedef struct dictionary_entry_info {
+    uint32_t	hash;	// hash value of the key
+    uint32_t	is_removed;	// removed, but not compacted yet
+} dictionary_entry_info;
 
 struct internal_dictionary {
-    map	body;
-    vector	keys;
+    vector	keys;	// keys in insertion order
+    unsigned char*	values;	// values parallel to keys
+    dictionary_entry_info*	infos;	// entry infos parallel to keys
+    int	capacity;	// allocated number of values and infos
+    int32_t*	slots;	// index of entry, or DICT_SLOT_EMPTY/DELETED
+    int	num_slots;	// number of slots (power of 2)
+    int	num_used_slots;	// slots not DICT_SLOT_EMPTY
+    int	num_removed;	// removed entries
     size_t	key_size;
+    size_t	value_size;
+    uint32_t(*hash)(const void *const key);
     int(*comparator)(const void *const one, const void *const two);
 };
 
+static inline void*
+dictionary_key_at(dictionary me, int index)
+{
+    return (unsigned char*)vector_get_data(me->keys) + index * me->key_size;
+}
+
+static inline void*
+dictionary_value_at(dictionary me, int index)
+{
+    return me->values + index * me->value_size;
+}
+
+static uint32_t
+dictionary_hash_key(dictionary me, const void *key)
+{
+    return (NULL != me->hash
+        ? me->hash(key) : dictionary_hash_bytes(key, me->key_size));
+}
+
+static int
+dictionary_find_slot(dictionary me, const void *key, uint32_t hash)
+{
+    // returns the slot position of the key, or -1 if not found
+    uint32_t	mask = (uint32_t)me->num_slots - 1;
+
+    for (uint32_t pos = hash & mask; ; pos = (pos + 1) & mask) {
+        int32_t	index = me->slots[pos];
+
+        if (DICT_SLOT_EMPTY == index) {
+            return -1;
+        } else if (0 <= index && hash == me->infos[index].hash
+            && 0 == me->comparator(key, dictionary_key_at(me, index))) {
+            return (int)pos;
+        }
+    }
+}
+
+static void
+dictionary_compact(dictionary me)
+{
+    // drop the removed entries keeping the order of the others
+    int	num_entries = vector_size(me->keys);
+    int	dst = 0;
+
+    for (int src = 0; src < num_entries; ++src) {
+        if (me->infos[src].is_removed) {
+            continue;
+        }
+        if (dst != src) {
+            memcpy(dictionary_key_at(me, dst), dictionary_key_at(me, src),
+                me->key_size);
+            memcpy(dictionary_value_at(me, dst), dictionary_value_at(me, src),
+                me->value_size);
+            me->infos[dst] = me->infos[src];
+        }
+        ++dst;
+    }
+    while (dst < vector_size(me->keys)) {
+        vector_remove_last(me->keys);
+    }
+    me->num_removed = 0;
+}
+
+static int
+dictionary_rebuild(dictionary me, int num_slots)
+{
+    // compact the entries and index them with the new number of slots
+    uint32_t	mask = (uint32_t)num_slots - 1;
+    int32_t*	new_slots;
+
+    if (num_slots != me->num_slots) {
+        new_slots = realloc(me->slots, num_slots * sizeof(int32_t));
+        if (NULL == new_slots) {
+            return -1;
+        }
+        me->slots     = new_slots;
+        me->num_slots = num_slots;
+    }
+    if (0 < me->num_removed) {
+        dictionary_compact(me);
+    }
+    for (int i = 0; i < num_slots; ++i) {
+        me->slots[i] = DICT_SLOT_EMPTY;
+    }
+    me->num_used_slots = vector_size(me->keys);
+    for (int i = 0, n = vector_size(me->keys); i < n; ++i) {
+        uint32_t	pos = me->infos[i].hash & mask;
+
+        while (DICT_SLOT_EMPTY != me->slots[pos]) {
+            pos = (pos + 1) & mask;
+        }
+        me->slots[pos] = i;
+    }
+
+    return 0;
+}
+
+static int
+dictionary_reserve(dictionary me, int num_entries)
+{
+    // Make room for the entries.  The load factor of the slots including
+    // the deleted ones is kept up to 1/2.
+    if (num_entries > me->capacity) {
+        int	new_capacity = (0 == me->capacity ? DICT_MIN_SLOTS / 2
+            : me->capacity * 2);
+        unsigned char*	new_values;
+        dictionary_entry_info*	new_infos;
+
+        if (new_capacity < num_entries) {
+            new_capacity = num_entries;
+        }
+        new_values = realloc(me->values, new_capacity * me->value_size);
+        if (NULL == new_values) {
+            return -1;
+        }
+        me->values = new_values;
+        new_infos  = realloc(me->infos,
+            new_capacity * sizeof(dictionary_entry_info));
+        if (NULL == new_infos) {
+            return -1;
+        }
+        me->infos    = new_infos;
+        me->capacity = new_capacity;
+        if (0 != vector_reserve(me->keys, new_capacity)) {
+            return -1;
+        }
+    }
+    if ((me->num_used_slots + 1) * 2 > me->num_slots) {
+        int	num_slots = DICT_MIN_SLOTS;
+
+        while (num_slots < (num_entries - me->num_removed) * 2) {
+            num_slots *= 2;
+        }
+        return dictionary_rebuild(me, num_slots);
+    }
+
+    return 0;
+}
+
 /* Starting */
 dictionary
 dictionary_init(size_t key_size,
     size_t value_size,
     int(*comparator)(const void *const one, const void *const two))
+{
+    return dictionary_init_hash(key_size, value_size, NULL, comparator);
+}
+
+dictionary
+dictionary_init_hash(size_t key_size,
+    size_t value_size,
+    uint32_t(*hash)(const void *const key),
+    int(*comparator)(const void *const one, const void *const two))
 {
     dictionary	newObj = (dictionary)malloc(
         sizeof(struct internal_dictionary));
 
     if (NULL != newObj) {
-        newObj->body = map_init(key_size, value_size, comparator);
-        if (NULL == newObj) {
-            free(newObj);
-            return NULL;
-        }
         newObj->keys = vector_init(key_size);
         if (NULL == newObj->keys) {
-            map_destroy(newObj->body);
             free(newObj);
             return NULL;
         }
-        newObj->comparator = comparator;
+        newObj->values     = NULL;
+        newObj->infos      = NULL;
+        newObj->capacity   = 0;
+        newObj->slots      = NULL;
+        newObj->num_slots  = 0;
+        newObj->num_used_slots = 0;
+        newObj->num_removed    = 0;
         newObj->key_size   = key_size;
+        newObj->value_size = value_size;
+        newObj->hash       = hash;
+        newObj->comparator = comparator;
+        if (0 != dictionary_rebuild(newObj, DICT_MIN_SLOTS)) {
+            vector_destroy(newObj->keys);
+            free(newObj);
+            return NULL;
+        }
     }
 
     return newObj;
 }
 
+/* Hashing */
+uint32_t
+dictionary_hash_bytes(const void *data, size_t size)
+{
+    // FNV-1a
+    const unsigned char*	curs = (const unsigned char*)data;
+    uint32_t	hash = FNV_OFFSET_BASIS;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ curs[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint32_t
+dictionary_hash_string(const char *str)
+{
+    // FNV-1a
+    uint32_t	hash = FNV_OFFSET_BASIS;
+
+    for (; '\0' != *str; ++str) {
+        hash = (hash ^ (unsigned char)*str) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
 /* Capacity */
 int
 dictionary_size(dictionary me)
 {
-    return vector_size(me->keys);
+    return vector_size(me->keys) - me->num_removed;
 }
 
 int
 dictionary_is_empty(dictionary me)
 {
-    return (0 == vector_is_empty(me->keys));
+    return (0 == dictionary_size(me));
 }
 
 /* Accessing */
 int
 dictionary_put(dictionary me, void *key, void *value)
 {
-    if (map_contains(me->body, key)) {
-        return map_put(me->body, key, value);
-    } else {
-        int	retVal = map_put(me->body, key, value);
+    uint32_t	hash = dictionary_hash_key(me, key);
+    int	pos = dictionary_find_slot(me, key, hash);
+    int	index;
+    uint32_t	mask;
 
-        if (0 == retVal) {
-            vector_add_last(me->keys, key);
-        }
-        return retVal;
+    if (0 <= pos) {
+        memcpy(dictionary_value_at(me, me->slots[pos]), value, me->value_size);
+        return 0;
+    }
+    if (0 != dictionary_reserve(me, vector_size(me->keys) + 1)) {
+        return -ENOMEM;
+    }
+    index = vector_size(me->keys);
+    if (0 != vector_add_last(me->keys, key)) {
+        return -ENOMEM;
+    }
+    memcpy(dictionary_value_at(me, index), value, me->value_size);
+    me->infos[index].hash       = hash;
+    me->infos[index].is_removed = 0;
+
+    mask = (uint32_t)me->num_slots - 1;
+    for (pos = (int)(hash & mask); 0 <= me->slots[pos];
+        pos = (int)((pos + 1) & mask)) {
+        ;
     }
+    if (DICT_SLOT_EMPTY == me->slots[pos]) {
+        ++me->num_used_slots;
+    }
+    me->slots[pos] = index;
+
+    return 0;
 }
 
 int
 dictionary_get(void *value, dictionary me, void *key)
 {
-    return map_get(value, me->body, key);
+    int	pos = dictionary_find_slot(me, key, dictionary_hash_key(me, key));
+
+    if (0 > pos) {
+        return 0;
+    }
+    memcpy(value, dictionary_value_at(me, me->slots[pos]), me->value_size);
+
+    return 1;
 }
 
 int
 dictionary_contains(dictionary me, void *key)
 {
-    return map_contains(me->body, key);
+    return (0 <= dictionary_find_slot(me, key, dictionary_hash_key(me, key)));
 }
 
 int
 dictionary_remove(dictionary me, void *key)
 {
-    if (map_remove(me->body, key)) {
-        const char*	keyCurs = (char*)vector_get_data(me->keys);
+    int	pos = dictionary_find_slot(me, key, dictionary_hash_key(me, key));
 
-        for (int i = 0, n = vector_size(me->keys); i < n; ++i) {
-            if (0 == me->comparator(key, keyCurs)) {
-                vector_remove_at(me->keys, i);
-                break;
-            }
-            keyCurs += me->key_size;
-        }
-
-        return 1;
-    } else {
+    if (0 > pos) {
         return 0;
     }
+    me->infos[me->slots[pos]].is_removed = 1;
+    me->slots[pos] = DICT_SLOT_DELETED;
+    ++me->num_removed;
+
+    return 1;
 }
 
 vector
 dictionary_get_keys(dictionary me)
 {
+    if (0 < me->num_removed) {
+        (void)dictionary_rebuild(me, me->num_slots);
+    }
+
     return me->keys;
 }
 
@@ -132,15 +369,18 @@ dictionary_get_keys(dictionary me)
 void
 dictionary_clear(dictionary me)
 {
-    map_clear(me->body);
     vector_clear(me->keys);
+    me->num_removed = 0;
+    (void)dictionary_rebuild(me, me->num_slots);
 }
 
 dictionary
 dictionary_destroy(dictionary me)
 {
-    map_destroy(me->body);
     vector_destroy(me->keys);
+    free(me->values);
+    free(me->infos);
+    free(me->slots);
     free(me);
 
     return NULL;
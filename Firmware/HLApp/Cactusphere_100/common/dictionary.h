@@ -25,6 +25,9 @@
 #ifndef _DICTIONARY_H_
 #define _DICTIONARY_H_
 
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
 #ifndef CONTAINERS_VECTOR_H
 #include "vector.h"
 #endif
@@ -35,6 +38,19 @@ typedef struct internal_dictionary	*dictionary;
 dictionary dictionary_init(size_t key_size,
     size_t value_size,
     int(*comparator)(const void *const one, const void *const two));
+dictionary dictionary_init_hash(size_t key_size,
+    size_t value_size,
+    uint32_t(*hash)(const void *const key),
+    int(*comparator)(const void *const one, const void *const two));
+//
+// NOTE: dictionary_init() hashes the whole bytes of a key.  Keys which are
+//       compared beyond their bytes (e.g. string pointers) or not in all
+//       of their bytes (e.g. strings in a fixed size array) need a hash
+//       function consistent with the comparator.
+
+/* Hashing */
+uint32_t dictionary_hash_bytes(const void *data, size_t size);
+uint32_t dictionary_hash_string(const char *str);
 
 /* Capacity */
 int dictionary_size(dictionary me);
@@ -46,6 +62,8 @@ int dictionary_get(void *value, dictionary me, void *key);
 int dictionary_contains(dictionary me, void *key);
 int dictionary_remove(dictionary me, void *key);
 vector	dictionary_get_keys(dictionary me);
+//
+// NOTE: Keys are kept in the order of insertion.
 
 /* Ending */
 void dictionary_clear(dictionary me);
@@ -41,6 +41,7 @@
 const struct _json_value json_value_none;
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
@@ -116,6 +117,85 @@ static void * json_alloc (json_state * state, unsigned long size, int zero)
    return state->settings.mem_alloc (size, zero, state->settings.user_data);
 }
 
+/* Hash index of the object keys; a table of (entry index + 1) by open
+ * addressing, put after the names in the block of the object entries.
+ */
+#define JSON_INDEX_MIN_LENGTH 8
+
+static unsigned int json_index_capacity (unsigned int length)
+{
+   unsigned int capacity = 16;
+
+   while (capacity < length * 2)
+      capacity <<= 1;
+
+   return capacity;
+}
+
+static unsigned long json_index_size (json_state * state, unsigned int length)
+{
+   if (! (state->settings.settings & json_enable_index)
+         || length < JSON_INDEX_MIN_LENGTH)
+   {
+      return 0;
+   }
+
+   /* with the padding for alignment */
+   return json_index_capacity (length) * sizeof (unsigned int)
+      + sizeof (unsigned int) - 1;
+}
+
+static unsigned int json_hash_key (const json_char * key, unsigned int length)
+{
+   unsigned int hash = 2166136261u;  /* FNV-1a */
+
+   while (length --)
+      hash = (hash ^ (unsigned char) *key ++) * 16777619u;
+
+   return hash;
+}
+
+static void json_index_object (json_state * state, json_value * value)
+{
+   unsigned int length = value->u.object.length;
+   unsigned int * index;
+   unsigned int mask;
+
+   if (!json_index_size (state, length))
+   {
+      value->_reserved.object_index = 0;
+      return;
+   }
+
+   index = (unsigned int *) (((uintptr_t) value->_reserved.object_mem
+      + sizeof (unsigned int) - 1) & ~ (uintptr_t) (sizeof (unsigned int) - 1));
+   mask = json_index_capacity (length) - 1;
+   memset (index, 0, (mask + 1) * sizeof (unsigned int));
+
+   for (unsigned int i = 0; i < length; ++ i)
+   {
+      json_object_entry * entry = &value->u.object.values [i];
+      unsigned int slot = json_hash_key (entry->name, entry->name_length) & mask;
+
+      while (index [slot])
+      {
+         json_object_entry * other = &value->u.object.values [index [slot] - 1];
+
+         if (other->name_length == entry->name_length
+               && !memcmp (other->name, entry->name, entry->name_length))
+         {
+            break;  /* the last one of a duplicate key */
+         }
+
+         slot = (slot + 1) & mask;
+      }
+
+      index [slot] = i + 1;
+   }
+
+   value->_reserved.object_index = index;
+}
+
 static int new_value (json_state * state,
                       json_value ** top, json_value ** root, json_value ** alloc,
                       json_type type)
@@ -155,7 +235,8 @@ static int new_value (json_state * state,
             values_size = (int)(sizeof (*value->u.object.values) * value->u.object.length);
 
             if (! (value->u.object.values = (json_object_entry *) json_alloc
-                  (state, (unsigned long) values_size + ((unsigned long) value->u.object.values), 0)) )
+                  (state, (unsigned long) values_size + ((unsigned long) value->u.object.values)
+                     + json_index_size (state, value->u.object.length), 0)) )
             {
                return 0;
             }
@@ -730,6 +811,9 @@ json_value * json_parse_ex (json_settings * settings,
                   
                   case '}':
 
+                     if (!state.first_pass)
+                        json_index_object (&state, top);
+
                      flags = (flags & ~ flag_need_comma) | flag_next;
                      break;
 
@@ -1042,6 +1126,24 @@ void json_value_free (json_value * value)
 json_value* 
 json_GetKeyJson(unsigned char* key, const json_value* jsonObj) {
     json_value* obj = NULL;
+
+    if (jsonObj->type == json_object && jsonObj->_reserved.object_index) {
+        unsigned int length = (unsigned int)strlen((const char*)key);
+        unsigned int mask = json_index_capacity(jsonObj->u.object.length) - 1;
+        unsigned int slot = json_hash_key((const json_char*)key, length) & mask;
+
+        while (jsonObj->_reserved.object_index[slot]) {
+            json_object_entry* entry = &jsonObj->u.object.values[
+                jsonObj->_reserved.object_index[slot] - 1];
+
+            if (entry->name_length == length
+                && 0 == memcmp(entry->name, key, length)) {
+                return entry->value;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return NULL;
+    }
     for (unsigned int i = 0, n = jsonObj->u.object.length; i < n; ++i) {
         if (0 == strcmp(key, jsonObj->u.object.values[i].name)) {
             obj = jsonObj->u.object.values[i].value;
@@ -1107,3 +1209,30 @@ bool json_GetIntValue(const json_value* jsonObj, uint32_t* value, int base) {
    }
    return ret;
 }
+
+bool json_GetDoubleValue(const json_value* jsonObj, double* value) {
+   bool ret = false;
+   if (jsonObj) {
+      switch (jsonObj->type)
+      {
+      case json_integer:
+         *value = (double)jsonObj->u.integer;
+         ret = true;
+         break;
+      case json_double:
+         *value = jsonObj->u.dbl;
+         ret = true;
+         break;
+      case json_string:
+         *value = strtod(jsonObj->u.string.ptr, NULL);
+         ret = true;
+         break;
+      case json_object:
+         ret = json_GetDoubleValue(jsonObj->u.object.values[0].value, value);
+         break;
+      default:
+         break;
+      }
+   }
+   return ret;
+}
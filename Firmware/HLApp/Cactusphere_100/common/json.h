@@ -76,6 +76,7 @@ typedef struct
 } json_settings;
 
 #define json_enable_comments  0x01
+#define json_enable_index     0x02  /* hash index of the object keys */
 
 typedef enum
 {
@@ -159,6 +160,7 @@ typedef struct _json_value
    {
       struct _json_value * next_alloc;
       void * object_mem;
+      unsigned int * object_index;  /* of a parsed object, or NULL */
 
    } _reserved;
 
@@ -278,6 +280,11 @@ void json_value_free_ex (json_settings * settings,
 
 json_value*
 json_GetKeyJson(unsigned char* key, const json_value* jsonObj);
+/*
+ * NOTE: Objects of 8 or more keys parsed with json_enable_index have a hash
+ *       index of the keys, so that json_GetKeyJson() doesn't scan them.
+ *       Either way, the last value of a duplicate key is returned.
+ */
 
 bool json_GetNumericValue(const json_value* jsonObj,
                           uint32_t* value, int base);
@@ -286,6 +293,8 @@ bool json_GetBoolValue(const json_value* jsonObj, bool* value);
 
 bool json_GetIntValue(const json_value* jsonObj, uint32_t* value, int base);
 
+bool json_GetDoubleValue(const json_value* jsonObj, double* value);
+
 #ifdef __cplusplus
    } /* extern "C" */
 #endif
@@ -328,6 +328,20 @@ int vector_remove_last(vector me)
     return 0;
 }
 
+/**
+ * Removes all the elements from the vector keeping its capacity, so that
+ * following additions up to the capacity do not allocate memory.
+ *
+ * @param me the vector to remove from
+ *
+ * @return 0 if no error
+ */
+int vector_remove_all(vector me)
+{
+    me->item_count = 0;
+    return 0;
+}
+
 /**
  * Sets the data for the first element in the vector. The pointer to the data
  * being passed in should point to the data type which this vector holds. For
@@ -53,6 +53,7 @@ int vector_add_last_multi(vector me, const void *dataArray, int count);
 int vector_remove_first(vector me);
 int vector_remove_at(vector me, int index);
 int vector_remove_last(vector me);
+int vector_remove_all(vector me);
 
 /* Setting */
 int vector_set_first(vector me, void *data);
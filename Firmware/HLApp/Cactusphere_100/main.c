@@ -83,6 +83,12 @@ typedef enum {
 
     ExitCode_SetUpSysEvent_EventLoop = 10,
 
+    ExitCode_FetchTimer_Consume = 11,
+    ExitCode_Init_FetchTimer = 12,
+
+    ExitCode_ReportTimer_Consume = 13,
+    ExitCode_Init_ReportTimer = 14,
+
     ExitCode_InterfaceConnectionStatus_Failed = 16,
 
     ExitCode_SetUpSysEvent_RegisterEvent,
@@ -103,12 +109,17 @@ typedef enum {
 static volatile sig_atomic_t exitCode = ExitCode_Success;
 
 #include "json.h"
+#include "JsonArena.h"
 
 #include "LibCloud.h"
 #include "DataFetchScheduler.h"
+#include "Metrics.h"
+#include "SendRateControl.h"
 #include "SendRTApp.h"
+#include "TelemetryCollector.h"
 #include "TelemetryItems.h"
 #include "PropertyItems.h"
+#include "ReportedState.h"
 
 #include "cactusphere_product.h"
 #include "cactusphere_eeprom.h"
@@ -129,6 +140,7 @@ static volatile sig_atomic_t exitCode = ExitCode_Success;
 #ifdef USE_MODBUS
 #include "ModbusConfigMgr.h"
 #include "ModbusFetchConfig.h"
+#include "ModbusFetchItem.h"
 #include "LibModbus.h"
 #include "ModbusDataFetchScheduler.h"
 #endif  // USE_MODBUS
@@ -150,6 +162,20 @@ static int ct_error = 0;
 
 // cache buffer size (telemetry data)
 #define CACHE_BUF_SIZE (50 * 1024)
+// persistent cache size on the mutable storage (0: not used)
+//   Opt-in; also request "MutableStorage" of this size in app_manifest.json.
+//   The store keeps frames over restart but holds fewer of them than the
+//   compressed memory cache, and accepts only the dropOldest eviction.
+#define CACHE_STORE_SIZE 0
+// byte budget of a batch message to resend cached telemetry (0: no batch)
+#define RESEND_BATCH_SIZE (16 * 1024)
+// maximum number of telemetry messages in flight (unconfirmed)
+#define SEND_WINDOW_SIZE 8
+// interval of the diagnostics telemetry of the metrics (0: not sent)
+#define DIAGNOSTICS_INTERVAL_SEC 0
+#define DIAGNOSTICS_MIN_INTERVAL_SEC 60
+// initial block size of the arena to parse the device twin in
+#define TWIN_ARENA_BLOCK_SIZE (8 * 1024)
 
 /// <summary>
 /// Connection types to use when connecting to the Azure IoT Hub.
@@ -199,6 +225,8 @@ static const int deviceIdForDaaCertUsage = 1; // A constant used to direct the I
                                               // the DAA cert under the hood.
 static const char wlan_networkInterface[] = "wlan0";
 static const char eth_networkInterface[] = "eth0";
+static uint32_t diagnosticsIntervalSec = DIAGNOSTICS_INTERVAL_SEC;
+static uint64_t diagnosticsSentMs = 0;
 
 // Application update events are received via an event loop.
 static EventRegistration *updateEventReg = NULL;
@@ -237,6 +265,8 @@ int ledGpioFd = -1;
 // Timer / polling
 static EventLoop *eventLoop = NULL;
 static EventLoopTimer *azureTimer = NULL;
+static EventLoopTimer *fetchTimer = NULL;
+static EventLoopTimer *reportTimer = NULL;
 static EventLoopTimer *watchdogLoopTimer = NULL;
 static EventLoopTimer *ledEventLoopTimer = NULL;
 
@@ -249,8 +279,18 @@ static int azureIoTPollPeriodSeconds = -1;
 
 #define MAX_SCHEDULER_NUM   3
 static DataFetchScheduler* mTelemetrySchedulerArr[MAX_SCHEDULER_NUM] = { NULL };
+static TelemetryCollector* mTelemetryCollector = NULL;
+static JsonArena* mTwinArena = NULL;
+static ReportedState* mReportedState = NULL;
+static bool isReportPending = false;
+#define REPORT_DELAY_MS 100     // coalescing delay of the reported properties
 
 static void AzureTimerEventHandler(EventLoopTimer *timer);
+static void FetchTimerEventHandler(EventLoopTimer *timer);
+static void RearmFetchTimer(void);
+static void ReportTimerEventHandler(EventLoopTimer *timer);
+static void ScheduleReport(void);
+static void PublishDiagnostics(void);
 static void WatchdogEventHandler(EventLoopTimer *timer);
 static void LedEventHandler(EventLoopTimer *timer);
 static ExitCode ValidateUserConfiguration(void);
@@ -373,6 +413,10 @@ int main(int argc, char *argv[])
     DI_ConfigMgr_Initialize();
 #endif  // USE_DI
 
+    mTelemetryCollector = TelemetryCollector_New();
+    mTwinArena = JsonArena_New(TWIN_ARENA_BLOCK_SIZE);
+    mReportedState = ReportedState_New();
+    Metrics_Reset();
     TelemetryItems_InitDictionary();
     SendRTApp_InitHandlers();
 
@@ -419,6 +463,7 @@ int main(int argc, char *argv[])
         }
     }
 
+    IoT_CentralLib_Cleanup();
     TelemetryItems_CleanupDictionary();
 #ifdef USE_MODBUS
     ModbusConfigMgr_Cleanup();
@@ -438,6 +483,9 @@ int main(int argc, char *argv[])
             DataFetchScheduler_Destroy(scheduler);
         }
     }
+    TelemetryCollector_Destroy(mTelemetryCollector);
+    JsonArena_Destroy(mTwinArena);
+    Metrics_Cleanup();
 
     SendRTApp_CloseHandlers();
 
@@ -450,6 +498,7 @@ int main(int argc, char *argv[])
         }
     }
     ClosePeripheralsAndHandlers();
+    ReportedState_Destroy(mReportedState);
 
     Log_Debug("Application exiting.\n");
 
@@ -457,7 +506,7 @@ int main(int argc, char *argv[])
 }
 
 /// <summary>
-/// Azure timer event:  Check connection status and send telemetry
+/// Azure timer event:  Check connection status and process IoT Hub I/O
 /// </summary>
 static void AzureTimerEventHandler(EventLoopTimer *timer)
 {
@@ -476,10 +525,13 @@ static void AzureTimerEventHandler(EventLoopTimer *timer)
         (ret_wlan_status == 0 && (wlan_status & Networking_InterfaceConnectionStatus_ConnectedToInternet))) {
         if (sphereStatus.IoTHubClientAuthState == IoTHubClientAuthenticationState_NotAuthenticated) {
             SetupAzureClient();
-            IoT_CentralLib_Initialize(CACHE_BUF_SIZE, false);
+            IoT_CentralLib_Initialize(CACHE_BUF_SIZE, CACHE_STORE_SIZE, false);
+            IoT_CentralLib_SetResendBatchSize(RESEND_BATCH_SIZE);
+            IoT_CentralLib_SetSendWindow(SEND_WINDOW_SIZE);
         }
         sphereStatus.isNetworkConnected = true;
         ChangeLedStatus(LED_ON);
+        PublishDiagnostics();
     }
     else {
         sphereStatus.isNetworkConnected = false;
@@ -492,23 +544,148 @@ static void AzureTimerEventHandler(EventLoopTimer *timer)
         }
     }
 
+    if (iothubClientHandle != NULL) {
+        IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
+    }
+}
+
+/// <summary>
+/// Fetch timer event:  Acquire the telemetry items whose interval has
+/// expired, send them and rearm for the next deadline
+/// </summary>
+static void FetchTimerEventHandler(EventLoopTimer *timer)
+{
+    if (ConsumeEventLoopTimerEvent(timer) != 0) {
+        exitCode = ExitCode_FetchTimer_Consume;
+        return;
+    }
 
     if (ct_error < 0) {
-        goto dowork;
+        return;
     }
 
+    uint64_t nowMs = FetchTimers_GetTimeMs();
+    uint64_t tickStartUs = Metrics_GetTimeUs();
+    SendRateStats sendStats;
+
     for (int i = 0; i < MAX_SCHEDULER_NUM; i++) {
         DataFetchScheduler* scheduler = mTelemetrySchedulerArr[i];
 
         if (NULL != scheduler) {
-            DataFetchScheduler_Schedule(scheduler);
+            uint64_t startUs = Metrics_GetTimeUs();
+            const TelemetryItems* items;
+
+            DataFetchScheduler_Schedule(scheduler, nowMs);
+            Metrics_RecordSince(MetricsLatency_Schedule, startUs);
+            items = DataFetchScheduler_GetTelemetryItems(scheduler);
+            Metrics_AddCount(MetricsCounter_ItemsAcquired,
+                (uint32_t)TelemetryItems_CountValues(items));
+            TelemetryCollector_AddItems(mTelemetryCollector, items);
         }
     }
+    TelemetryCollector_Flush(mTelemetryCollector);
 
-dowork:
     if (iothubClientHandle != NULL) {
         IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
     }
+
+    Metrics_AddCount(MetricsCounter_Ticks, 1);
+    Metrics_SetGauge(MetricsGauge_CacheFrames, IoT_CentralLib_CountCachedFrames());
+    Metrics_SetGauge(MetricsGauge_InFlightMsgs, IoT_CentralLib_CountInFlightMsgs());
+    if (IoT_CentralLib_GetSendRateStats(&sendStats)) {
+        Metrics_SetGauge(MetricsGauge_SendWindow, sendStats.window);
+    }
+    Metrics_RecordSince(MetricsLatency_Tick, tickStartUs);
+
+    RearmFetchTimer();
+}
+
+/// <summary>
+/// Send the metrics as diagnostics telemetry at the configured interval
+/// </summary>
+static void PublishDiagnostics(void)
+{
+    uint64_t nowMs = FetchTimers_GetTimeMs();
+    uint32_t timeStamp;
+
+    if (0 == diagnosticsIntervalSec || ! IsAuthenticationDone() ||
+        nowMs - diagnosticsSentMs < (uint64_t)diagnosticsIntervalSec * 1000) {
+        return;
+    }
+    if (! IoT_CentralLib_IsSendWindowFull() &&
+        IoT_CentralLib_SendTelemetry(Metrics_ToJson("diagnostics"), &timeStamp)) {
+        diagnosticsSentMs = nowMs;
+    }
+}
+
+/// <summary>
+/// Arm the fetch timer for the earliest deadline of all schedulers
+/// </summary>
+static void RearmFetchTimer(void)
+{
+    uint64_t nextMs = UINT64_MAX;
+
+    for (int i = 0; i < MAX_SCHEDULER_NUM; i++) {
+        DataFetchScheduler* scheduler = mTelemetrySchedulerArr[i];
+        uint64_t deadlineMs;
+
+        if (NULL != scheduler &&
+            DataFetchScheduler_GetNextDeadline(scheduler, &deadlineMs) &&
+            deadlineMs < nextMs) {
+            nextMs = deadlineMs;
+        }
+    }
+    if (nextMs == UINT64_MAX) {
+        DisarmEventLoopTimer(fetchTimer);
+        return;
+    }
+
+    uint64_t nowMs = FetchTimers_GetTimeMs();
+    uint64_t delayMs = (nextMs > nowMs) ? nextMs - nowMs : 1;
+    struct timespec delay = {
+        .tv_sec = (time_t)(delayMs / 1000),
+        .tv_nsec = (long)(delayMs % 1000) * 1000 * 1000};
+
+    SetEventLoopTimerOneShot(fetchTimer, &delay);
+}
+
+/// <summary>
+/// Report timer event:  Send the properties set since the timer was armed
+/// as one reported state patch
+/// </summary>
+static void ReportTimerEventHandler(EventLoopTimer *timer)
+{
+    if (ConsumeEventLoopTimerEvent(timer) != 0) {
+        exitCode = ExitCode_ReportTimer_Consume;
+        return;
+    }
+
+    isReportPending = false;
+    if (! IsAuthenticationDone()) {
+        return;     // kept to be reported with the versions on reconnection
+    }
+    if (ReportedState_Flush(mReportedState)) {
+        if (iothubClientHandle != NULL) {
+            IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
+        }
+    } else {
+        ScheduleReport();   // retry the properties kept on a failure
+    }
+}
+
+/// <summary>
+/// Arm the report timer when the first property is set after a report, so
+/// that the properties set in a short while are merged into one patch
+/// </summary>
+static void ScheduleReport(void)
+{
+    static const struct timespec delay = {
+        .tv_sec = 0, .tv_nsec = REPORT_DELAY_MS * 1000 * 1000};
+
+    if (! isReportPending && ! ReportedState_IsEmpty(mReportedState)) {
+        SetEventLoopTimerOneShot(reportTimer, &delay);
+        isReportPending = true;
+    }
 }
 
 /// <summary>
@@ -833,6 +1010,13 @@ static ExitCode InitPeripheralsAndHandlers(void)
         return ExitCode_SetUpSysEvent_EventLoop;
     }
 
+    // open the telemetry cache and recover the frames stored before restart
+    // independently of the hub connection, so that the data acquired before
+    // the first connection is kept as well
+    if (! IoT_CentralLib_InitializeCache(CACHE_BUF_SIZE, CACHE_STORE_SIZE)) {
+        Log_Debug("WARNING: failed to initialize the telemetry cache.\n");
+    }
+
     SetupWatchdog();
     struct timespec watchdogKickPeriod = {.tv_sec = 0, .tv_nsec = 500 * 1000 * 1000};
     watchdogLoopTimer =
@@ -849,6 +1033,18 @@ static ExitCode InitPeripheralsAndHandlers(void)
         return ExitCode_Init_AzureTimer;
     }
 
+    // armed on demand for the next data acquisition deadline
+    fetchTimer = CreateEventLoopDisarmedTimer(eventLoop, &FetchTimerEventHandler);
+    if (fetchTimer == NULL) {
+        return ExitCode_Init_FetchTimer;
+    }
+
+    // armed on demand when a property is set to be reported
+    reportTimer = CreateEventLoopDisarmedTimer(eventLoop, &ReportTimerEventHandler);
+    if (reportTimer == NULL) {
+        return ExitCode_Init_ReportTimer;
+    }
+
     updateEventReg = SysEvent_RegisterForEventNotifications(
         eventLoop, SysEvent_Events_UpdateReadyForInstall, UpdateCallback, NULL);
     if (updateEventReg == NULL) {
@@ -886,6 +1082,8 @@ static void ClosePeripheralsAndHandlers(void)
     Log_Debug("Closing file descriptors\n");
 
     DisposeEventLoopTimer(azureTimer);
+    DisposeEventLoopTimer(fetchTimer);
+    DisposeEventLoopTimer(reportTimer);
     DisposeEventLoopTimer(watchdogLoopTimer);
     DisposeEventLoopTimer(ledEventLoopTimer);
 
@@ -928,13 +1126,9 @@ static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
             cactusphere_error_notify(EEPROM_READ_ERROR);
             exitCode = ExitCode_TermHandler_SigTerm;
         } else {
-            static const char* EventMsgTemplate = "{ \"%s\": \"%s\" }";
-            static char propertyStr[280] = { 0 };
-
             // Send App version
             // HLApp
-            snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, "HLAppVersion", HLAPP_VERSION);
-            IoT_CentralLib_SendProperty(propertyStr);
+            ReportedState_SetString(mReportedState, "HLAppVersion", HLAPP_VERSION);
             // RTApp
             char rtAppVersion[256] = { 0 };
             bool ret = false;
@@ -944,8 +1138,7 @@ static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
             ret = Libmodbus_GetRTAppVersion(rtAppVersion);
 #endif
             if (ret) {
-                snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, "RTAppVersion", rtAppVersion);
-                IoT_CentralLib_SendProperty(propertyStr);
+                ReportedState_SetString(mReportedState, "RTAppVersion", rtAppVersion);
             }
 
             sphereStatus.isEepromReadSuccess = true;
@@ -967,11 +1160,11 @@ static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
             setEepromString(eepromProperty[4].value, eeprom.wlanMac, sizeof(eeprom.wlanMac));
             setEepromString(eepromProperty[5].value, eeprom.generation, sizeof(eeprom.generation));
 
-            // Send Property
+            // Send Property; together with the versions as one patch
             for (int i = 0; i < (sizeof(eepromProperty) / sizeof(eepromProperty[0])); i++) {
-                snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, eepromProperty[i].name, eepromProperty[i].value);
-                IoT_CentralLib_SendProperty(propertyStr);
+                ReportedState_SetString(mReportedState, eepromProperty[i].name, eepromProperty[i].value);
             }
+            ScheduleReport();
             if ((eeprom.venderId[0] | ((eeprom.venderId[1] << 8) & 0xFF00)) != APP_VENDOR_ID) {
                 Log_Debug("ERROR: Illegal vendor id.\n");
                 ct_error = -ILLEGAL_PACKAGE;
@@ -1117,73 +1310,23 @@ static bool SetupAzureIoTHubClientWithDps(void)
 
 /// <summary>
 ///    Send property response.
+///    The responses of a twin update are merged into one reported state
+///    patch, which is sent by the report timer.
 /// </summary>
-#define JSON_FORMAT_NUM 50
 static void SendPropertyResponse(vector Send_PropertyItem)
 {
-    static const char* EventMsgTemplate_bool = "{ \"%s\": %s }";
-    static const char* EventMsgTemplate_num  = "{ \"%s\": %u }";
-    static const char* EventMsgTemplate_str  = "{ \"%s\": \"%s\" }";
-    static const char* EventMsgTemplate_null = "{ \"%s\": null }";
-    char* propertyStr = NULL;
-    size_t propertyStr_len = 0;
-
-    if (! vector_is_empty(Send_PropertyItem)) {
-        ResponsePropertyItem* curs = (ResponsePropertyItem*)vector_get_data(Send_PropertyItem);
-        for (int i = 0; i < vector_size(Send_PropertyItem); i++){
-            switch (curs->type)
-            {
-            case TYPE_BOOL:
-                propertyStr_len = strlen(curs->propertyName) + JSON_FORMAT_NUM;
-                propertyStr = (char *)malloc(propertyStr_len);
-                if (propertyStr) {
-                    memset(propertyStr, 0, propertyStr_len);
-                    snprintf(propertyStr, propertyStr_len, EventMsgTemplate_bool,
-                             curs->propertyName, (curs->value.b ? "true" : "false"));
-                }
-                break;
-            case TYPE_NUM:
-                propertyStr_len = strlen(curs->propertyName) + JSON_FORMAT_NUM;
-                propertyStr = (char *)malloc(propertyStr_len);
-                if (propertyStr) {
-                    memset(propertyStr, 0, propertyStr_len);
-                    snprintf(propertyStr, propertyStr_len, EventMsgTemplate_num,
-                             curs->propertyName, curs->value.ul);
-                }
-                break;
-            case TYPE_STR:
-                propertyStr_len = strlen(curs->propertyName) + strlen(curs->value.str) + JSON_FORMAT_NUM;
-                propertyStr = (char *)malloc(propertyStr_len);
-                if(propertyStr) {
-                    memset(propertyStr, 0, propertyStr_len);
-                    snprintf(propertyStr, strlen(curs->propertyName)+strlen(curs->value.str) + JSON_FORMAT_NUM, EventMsgTemplate_str,
-                             curs->propertyName, curs->value.str);
-                }
-                free(curs->value.str);
-                break;
-            case TYPE_NULL:
-                propertyStr_len = strlen(curs->propertyName) + JSON_FORMAT_NUM;
-                propertyStr = (char *)malloc(propertyStr_len);
-                if (propertyStr) {
-                    memset(propertyStr, 0, propertyStr_len);
-                    snprintf(propertyStr, propertyStr_len, EventMsgTemplate_null,
-                             curs->propertyName, curs->value.ul);
-                }
-                break;
-            default:
-                continue;
-            }
-            if (propertyStr) {
-                IoT_CentralLib_SendProperty(propertyStr);
-                free(propertyStr);
-                propertyStr = NULL;
-            }
-            curs++;
+    ResponsePropertyItem* curs = (ResponsePropertyItem*)vector_get_data(Send_PropertyItem);
+
+    ReportedState_AddPropertyItems(mReportedState, Send_PropertyItem);
+    for (int i = 0; i < vector_size(Send_PropertyItem); i++, curs++) {
+        if (curs->type == TYPE_STR) {
+            free(curs->value.str);
         }
     }
+    ScheduleReport();
 }
 
-static void ParseDeferredUpdateConfig(json_value* json,
+static void ParseDeferredUpdateConfig(json_value* json, JsonArena* arena,
     DeferredUpdateConfig* config, const char* key, vector item)
 {
     if (! json) {
@@ -1193,8 +1336,14 @@ static void ParseDeferredUpdateConfig(json_value* json,
     if (json->type != json_string) {
         json = json_GetKeyJson("value", json);
     }
+    if (! json) {
+        return;
+    }
     PropertyItems_AddItem(item, key, TYPE_STR, json->u.string.ptr);
-    json = json_parse(json->u.string.ptr, json->u.string.length);
+    json = JsonArena_ParseString(arena, json);
+    if (! json) {
+        return;
+    }
 
     for (unsigned int i = 0; i < json->u.object.length; i++) {
         char* propertyName = json->u.object.values[i].name;
@@ -1210,10 +1359,9 @@ static void ParseDeferredUpdateConfig(json_value* json,
     }
 }
 
-static bool CheckDeferredUpdateConfig(const unsigned char* payload,
-    unsigned int payloadSize, vector item)
+static bool CheckDeferredUpdateConfig(json_value* jsonObj, JsonArena* arena,
+    vector item)
 {
-    json_value* jsonObj = json_parse(payload, payloadSize);
     json_value* desiredObj = NULL;
     json_value* osUpdateObj = NULL;
     json_value* fwUpdateObj = NULL;
@@ -1221,7 +1369,6 @@ static bool CheckDeferredUpdateConfig(const unsigned char* payload,
     bool doResume = false;
 
     updateDeferring = true;
-    Log_Debug("payload=%s", payload);
     desiredObj = json_GetKeyJson("desired", jsonObj);
     if (desiredObj == NULL) {
         osUpdateObj = json_GetKeyJson("OSUpdateTime", jsonObj);
@@ -1236,7 +1383,7 @@ static bool CheckDeferredUpdateConfig(const unsigned char* payload,
             memset(&osUpdate, 0, sizeof(DeferredUpdateConfig));
             doResume = true;
         } else {
-            ParseDeferredUpdateConfig(osUpdateObj, &osUpdate, "OSUpdateTime", item);
+            ParseDeferredUpdateConfig(osUpdateObj, arena, &osUpdate, "OSUpdateTime", item);
         }
         ret = true;
     }
@@ -1246,7 +1393,7 @@ static bool CheckDeferredUpdateConfig(const unsigned char* payload,
             memset(&fwUpdate, 0, sizeof(DeferredUpdateConfig));
             doResume = true;
         } else {
-            ParseDeferredUpdateConfig(fwUpdateObj, &fwUpdate, "FWUpdateTime", item);
+            ParseDeferredUpdateConfig(fwUpdateObj, arena, &fwUpdate, "FWUpdateTime", item);
         }
         ret = true;
     }
@@ -1258,6 +1405,44 @@ static bool CheckDeferredUpdateConfig(const unsigned char* payload,
     return ret;
 }
 
+#ifdef USE_MODBUS
+/// <summary>
+///     Applies the cache eviction policy of the Modbus configuration.
+///     "cacheEviction" other than dropOldest and "cachePriority" are not
+///     applicable with the persistent store (CACHE_STORE_SIZE), which keeps
+///     dropping the oldest frames; they are ignored with a warning, as the
+///     configuration is still valid for the memory cache, and "cacheTtl" is
+///     applied alone.
+/// </summary>
+static void ApplyModbusCachePolicy(ModbusFetchConfig* config)
+{
+    vector fetchItems = ModbusFetchConfig_GetFetchItems(config);
+    bool isApplied =
+        IoT_CentralLib_SetCacheEviction(ModbusFetchConfig_GetCacheEviction(config));
+
+    IoT_CentralLib_ClearCacheItemPolicies();
+    if (! vector_is_empty(fetchItems)) {
+        ModbusFetchItem* curs = (ModbusFetchItem*)vector_get_data(fetchItems);
+
+        for (int i = 0, n = vector_size(fetchItems); i < n; ++i, ++curs) {
+            if ((0 < curs->cachePriority || 0 < curs->cacheTtlSec) &&
+                ! IoT_CentralLib_SetCacheItemPolicy(
+                    curs->nameId, curs->cachePriority, curs->cacheTtlSec)) {
+                if (0 < curs->cacheTtlSec) {
+                    // keep the TTL without the priority
+                    (void)IoT_CentralLib_SetCacheItemPolicy(
+                        curs->nameId, 0, curs->cacheTtlSec);
+                }
+                isApplied = false;
+            }
+        }
+    }
+    if (! isApplied) {
+        Log_Debug("WARNING: Cache policy not applicable to the persistent cache.\n");
+    }
+}
+#endif  // USE_MODBUS
+
 /// <summary>
 ///     Callback invoked when a Device Twin update is received from IoT Hub.
 ///     Updates local state for 'showEvents' (bool).
@@ -1273,10 +1458,15 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
 
     vector Send_PropertyItem = vector_init(sizeof(ResponsePropertyItem));
 
-    bool defupderr = CheckDeferredUpdateConfig(payload, payloadSize, Send_PropertyItem);
+    // parse the twin once; all the consumers share the values in the arena,
+    // which are released together at the end
+    Log_Debug("payload=%.*s", (int)payloadSize, payload);
+    json_value* twinJson = JsonArena_Parse(mTwinArena, payload, payloadSize);
+
+    bool defupderr = CheckDeferredUpdateConfig(twinJson, mTwinArena, Send_PropertyItem);
 
 #ifdef USE_MODBUS
-    SphereWarning err = ModbusConfigMgr_LoadAndApplyIfChanged(payload, payloadSize, Send_PropertyItem);
+    SphereWarning err = ModbusConfigMgr_LoadAndApplyIfChanged(twinJson, mTwinArena, Send_PropertyItem);
     if (defupderr && err == UNSUPPORTED_PROPERTY) {
         err = NO_ERROR;
     }
@@ -1284,7 +1474,11 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
     {
     case NO_ERROR:
     case ILLEGAL_PROPERTY:
-        DataFetchScheduler_Init(
+        DataFetchScheduler_SetPhasePolicy(
+            mTelemetrySchedulerArr[MODBUS_RTU],
+            ModbusFetchConfig_GetPhasePolicy(ModbusConfigMgr_GetModbusFetchConfig()));
+        ApplyModbusCachePolicy(ModbusConfigMgr_GetModbusFetchConfig());
+        DataFetchScheduler_Update(
             mTelemetrySchedulerArr[MODBUS_RTU],
             ModbusFetchConfig_GetFetchItemPtrs(ModbusConfigMgr_GetModbusFetchConfig()));
 
@@ -1316,14 +1510,14 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
 #endif  // USE_MODBUS
 
 #ifdef USE_MODBUS_TCP
-    ModbusTcpConfigMgr_LoadAndApplyIfChanged(payload, payloadSize);
-    DataFetchScheduler_Init(
+    ModbusTcpConfigMgr_LoadAndApplyIfChanged(twinJson, mTwinArena);
+    DataFetchScheduler_Update(
         mTelemetrySchedulerArr[MODBUS_TCP],
         ModbusTcpFetchConfig_GetFetchItemPtrs(ModbusTcpConfigMgr_GetModbusFetchConfig()));
 #endif // USE_MODBUS_TCP
 
 #ifdef USE_DI
-    SphereWarning err = DI_ConfigMgr_LoadAndApplyIfChanged(payload, payloadSize, Send_PropertyItem);
+    SphereWarning err = DI_ConfigMgr_LoadAndApplyIfChanged(twinJson, Send_PropertyItem);
     if (defupderr && err == UNSUPPORTED_PROPERTY) {
         err = NO_ERROR;
     }
@@ -1331,7 +1525,7 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
     {
     case NO_ERROR:
     case ILLEGAL_PROPERTY:
-        DI_DataFetchScheduler_Init(
+        DI_DataFetchScheduler_Update(
             mTelemetrySchedulerArr[DIGITAL_IN],
             DI_FetchConfig_GetFetchItemPtrs(DI_ConfigMgr_GetFetchConfig()),
             DI_WatchConfig_GetFetchItems(DI_ConfigMgr_GetWatchConfig()));
@@ -1364,6 +1558,10 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
 
 #endif  // USE_DI
     vector_destroy(Send_PropertyItem);
+    JsonArena_Reset(mTwinArena);
+
+    // the acquisition intervals may have been changed
+    RearmFetchTimer();
 
     if (ct_error < 0) {
         // hang
@@ -1376,17 +1574,66 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
 
 static int CommandCallback(const char* method_name, const unsigned char* payload, size_t size,
     unsigned char** response, size_t* response_size, void* userContextCallback) {
+    int status = 200;
 
     if (ct_error < 0) {
         goto end;
     }
 
     char deviceMethodResponse[100];
-    char reportedPropertiesString[100];
 
-#ifdef USE_MODBUS
-    static const char* ReportMsgTemplate = "{ \"ModbusWriteRegisterResult\": \"%s\" }";
+    // pipeline metrics, common to all products
+    if (0 == strcmp(method_name, "GetMetrics")) {
+        const char* metrics = Metrics_ToJson(NULL);
 
+        if (NULL == metrics) {
+            metrics = "\"Error\"";
+        }
+        *response_size = strlen(metrics);
+        *response = malloc(*response_size);
+        if (NULL != *response) {
+            (void)memcpy(*response, metrics, *response_size);
+        }
+        goto end;
+    }
+    if (0 == strcmp(method_name, "SetDiagnosticsInterval")) {
+        // the interval in seconds, a JSON number or a string of digits
+        json_value* jsonObj = json_parse(payload, size);
+        uint32_t intervalSec = 0;
+        bool isValid = json_GetNumericValue(jsonObj, &intervalSec, 10);
+
+        if (isValid && json_integer == jsonObj->type) {
+            isValid = (0 <= jsonObj->u.integer &&
+                jsonObj->u.integer <= (json_int_t)UINT32_MAX);
+        } else if (isValid) {   // json_string
+            const char* digits = jsonObj->u.string.ptr;
+
+            isValid = (0 < jsonObj->u.string.length &&
+                strspn(digits, "0123456789") == jsonObj->u.string.length);
+        }
+        json_value_free(jsonObj);
+
+        if (isValid) {
+            if (0 < intervalSec && intervalSec < DIAGNOSTICS_MIN_INTERVAL_SEC) {
+                intervalSec = DIAGNOSTICS_MIN_INTERVAL_SEC;
+            }
+            diagnosticsIntervalSec = intervalSec;
+            diagnosticsSentMs = 0;
+            strcpy(deviceMethodResponse, "\"Success\"");
+        } else {
+            Log_Debug("ERROR: Illegal diagnostics interval.\n");
+            strcpy(deviceMethodResponse, "\"Illegal interval\"");
+            status = 400;
+        }
+        *response_size = strlen(deviceMethodResponse);
+        *response = malloc(*response_size);
+        if (NULL != *response) {
+            (void)memcpy(*response, deviceMethodResponse, *response_size);
+        }
+        goto end;
+    }
+
+#ifdef USE_MODBUS
     ModbusOneshotcommand(payload, size, deviceMethodResponse);
 
     // send result
@@ -1395,20 +1642,24 @@ static int CommandCallback(const char* method_name, const unsigned char* payload
     if (NULL != response) {
         (void)memcpy(*response, deviceMethodResponse, *response_size);
     }
-    snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, deviceMethodResponse);
-    IoT_CentralLib_SendProperty(reportedPropertiesString);
+    // the response is a JSON string already
+    ReportedState_SetJson(mReportedState, "ModbusWriteRegisterResult", deviceMethodResponse);
+    ScheduleReport();
 #endif
 
 #ifdef USE_DI
     const char ClearCounterDIKey[] = "ClearCounter_DI";
     const size_t ClearCounterDiLen = strlen(ClearCounterDIKey);
-    static const char* ReportMsgTemplate = "{ \"ClearCounterResult_DI%d\": \"%s\" }";
+    static const char* ReportNameTemplate = "ClearCounterResult_DI%d";
+    char reportedPropertyName[PROPERTY_NAME_MAX_LEN + 1];
+    const char* reportedResult = NULL;
 
     if (0 == strncmp(method_name, ClearCounterDIKey, ClearCounterDiLen)) {
         int pinId = strtol(&method_name[ClearCounterDiLen], NULL, 10) - DI_PORT_OFFSET;
         if (pinId < 0) {
             goto err;
         }
+        snprintf(reportedPropertyName, sizeof(reportedPropertyName), ReportNameTemplate, pinId + DI_PORT_OFFSET);
 
         if (0 != strncmp(payload, "null", strlen("null"))) {
             char *cmdPayload = (char *)calloc(size + 1, sizeof(char));
@@ -1425,10 +1676,10 @@ static int CommandCallback(const char* method_name, const unsigned char* payload
             if (!DI_Lib_ResetPulseCount((unsigned long)pinId, (unsigned long)initVal)) {
                 Log_Debug("DI_Lib_ResetPulseCount() error");
                 strcpy(deviceMethodResponse, "\"Reset Error\"");
-                snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Reset Error");
+                reportedResult = "Reset Error";
             } else {
                 strcpy(deviceMethodResponse, "\"Success\"");
-                snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Success");
+                reportedResult = "Success";
             }
 
             free(cmdPayload);
@@ -1436,7 +1687,7 @@ static int CommandCallback(const char* method_name, const unsigned char* payload
 err_value:
             //init value error
             strcpy(deviceMethodResponse, "\"Illegal init value\"");
-            snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Illegal init value");
+            reportedResult = "Illegal init value";
         }
     } else {
 err:
@@ -1449,11 +1700,14 @@ err:
     if (NULL != response) {
         (void)memcpy(*response, deviceMethodResponse, *response_size);
     }
-    IoT_CentralLib_SendProperty(reportedPropertiesString);
+    if (NULL != reportedResult) {
+        ReportedState_SetString(mReportedState, reportedPropertyName, reportedResult);
+        ScheduleReport();
+    }
 
 #endif  // USE_DI
 end:
-    return 200;
+    return status;
 }
 
 /// <summary>